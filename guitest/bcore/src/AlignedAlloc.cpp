@@ -0,0 +1,124 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AlignedAlloc.h"
+#include "Thread.h"
+#include <hash_map>
+#include <new>
+#ifndef _MSC_VER
+#include <stdlib.h>
+#endif
+
+namespace {
+
+Mutex	g_poolLock;
+bool	g_bPooling = false;
+size_t	g_maxPoolBytes = 0;
+size_t	g_poolBytes = 0;
+stdext::hash_map<size_t, std::vector<void*> >	g_pool;	// free blocks by size
+
+void* allocAligned(size_t bytes)
+{
+#ifdef _MSC_VER
+	return _aligned_malloc(bytes, AlignedAlloc::ALIGNMENT);
+#else
+	void *p = 0;
+	if (posix_memalign(&p, AlignedAlloc::ALIGNMENT, bytes) != 0)
+		return 0;
+	return p;
+#endif
+}
+
+void freeAligned(void *p)
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	::free(p);
+#endif
+}
+
+};
+
+void* AlignedAlloc::alloc(size_t bytes)
+{
+	if (bytes == 0)
+		return 0;
+
+	if (g_bPooling) {
+		ScopedLock lock(g_poolLock);
+		stdext::hash_map<size_t, std::vector<void*> >::iterator it = g_pool.find(bytes);
+		if (it != g_pool.end() && !it->second.empty()) {
+			void *p = it->second.back();
+			it->second.pop_back();
+			g_poolBytes -= bytes;
+			return p;
+		}
+	}
+
+	void *p = allocAligned(bytes);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void AlignedAlloc::free(void *p, size_t bytes)
+{
+	if (!p)
+		return;
+
+	if (g_bPooling) {
+		ScopedLock lock(g_poolLock);
+		if (g_poolBytes + bytes <= g_maxPoolBytes) {
+			g_pool[bytes].push_back(p);
+			g_poolBytes += bytes;
+			return;
+		}
+	}
+	freeAligned(p);
+}
+
+void AlignedAlloc::setPooling(bool bEnable, size_t maxPoolBytes)
+{
+	{
+		ScopedLock lock(g_poolLock);
+		g_bPooling = bEnable;
+		g_maxPoolBytes = maxPoolBytes;
+	}
+	if (!bEnable)
+		releasePool();
+}
+
+bool AlignedAlloc::isPooling()
+{
+	return g_bPooling;
+}
+
+void AlignedAlloc::releasePool()
+{
+	ScopedLock lock(g_poolLock);
+	stdext::hash_map<size_t, std::vector<void*> >::iterator it;
+	for (it = g_pool.begin(); it != g_pool.end(); ++it)
+		for (size_t i=0; i<it->second.size(); ++i)
+			freeAligned(it->second[i]);
+	g_pool.clear();
+	g_poolBytes = 0;
+}
@@ -0,0 +1,52 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ALIGNEDALLOC_H45631_INCLUDED_
+#define _ALIGNEDALLOC_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * AlignedAlloc: allocation of memory blocks aligned to 64 bytes (a cache line,
+ *		and enough for any SIMD load).
+ *
+ *		Optionally, freed blocks can be kept in a pool and handed out again to
+ *		allocations of the same size, which saves the allocator round trips of
+ *		code that creates and drops buffers of the same size over and over (f.e.
+ *		image filters working on Matrix objects). The pool is shared by all
+ *		threads, and keeps up to a given number of bytes.
+ */
+class AlignedAlloc
+{
+public:
+	enum { ALIGNMENT = 64 };
+
+	static void*	alloc(size_t bytes);			// 0 if bytes == 0
+	static void		free(void *p, size_t bytes);	// bytes: the size passed to alloc
+
+	static void		setPooling(bool bEnable, size_t maxPoolBytes = 64*1024*1024);
+	static bool		isPooling();
+	static void		releasePool();					// free all pooled blocks
+};
+
+#endif
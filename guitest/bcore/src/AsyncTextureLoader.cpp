@@ -0,0 +1,389 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "AsyncTextureLoader.h"
+#include "Timer.h"
+#include "Profiler.h"
+
+AsyncTextureLoader *AsyncTextureLoader::m_pInst = 0;
+
+AsyncTextureLoader::AsyncTextureLoader() : m_pUploading(0),
+	m_maxInFlight(8),
+	m_nInFlight(0),
+	m_chunkSize(1024*1024),
+	m_pPlaceholder(0),
+	m_curPBO(0),
+	m_bUsePBO(false)
+{
+	m_pbo[0] = m_pbo[1] = 0;
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+	free();
+}
+
+AsyncTextureLoader* AsyncTextureLoader::inst()
+{
+	if (!m_pInst)
+		m_pInst = new AsyncTextureLoader();
+	return m_pInst;
+}
+
+AsyncTextureLoader::Handle AsyncTextureLoader::load(const std::string &filename, bool bKeepImage, bool bCompress)
+{
+	Request *pReq = new Request();
+	pReq->m_pLoader = this;
+	pReq->m_filename = filename;
+	pReq->m_bKeepImage = bKeepImage;
+	pReq->m_bCompress = bCompress;
+	pReq->addRef();		// the loader's reference, released when the request is finished
+	m_pending.push_back(pReq);
+
+	Handle h(pReq);
+	submitPending();
+	return h;
+}
+
+void AsyncTextureLoader::submitPending()
+{
+	while (m_nInFlight < m_maxInFlight && !m_pending.empty())
+	{
+		Request *pReq = m_pending.front();
+		m_pending.pop_front();
+
+		pReq->m_state = DECODING;
+		m_decoding.push_back(pReq);
+		m_nInFlight++;
+		ThreadPool::inst()->submit(pReq);
+	}
+}
+
+void AsyncTextureLoader::Request::run()
+{
+	// runs on a worker thread: only touch the image, never GL
+	bool bOk = true;
+	if (!m_bCancelRequested)
+	{
+		// the image is only decoded if it is needed, or if it cannot be compressed
+		if (m_bCompress)
+			m_bCompress = m_compressed.loadCached(m_filename, false, false, (m_bKeepImage) ? &m_image : 0);
+		if (!m_bCompress && m_image.isEmpty())
+			bOk = m_image.load(m_filename);
+	}
+	// the request stays in flight until update() finishes it, also if decoding failed
+	m_bDecodeOk = bOk;
+	m_state = DECODED;
+	m_pLoader->onDecoded(this);
+}
+
+void AsyncTextureLoader::onDecoded(Request *pReq)
+{
+	ScopedLock lock(m_decodedLock);
+	m_decoded.push_back(pReq);
+}
+
+void AsyncTextureLoader::update(double timeBudget)
+{
+	PROFILE_ZONE("AsyncTextureLoader::update");
+	submitPending();
+
+	Timer timer;
+	while (timer.elapsedMsec() < timeBudget)
+	{
+		// pick the next decoded image to upload
+		if (!m_pUploading)
+		{
+			Request *pReq = 0;
+			{
+				ScopedLock lock(m_decodedLock);
+				if (!m_decoded.empty()) {
+					pReq = m_decoded.front();
+					m_decoded.pop_front();
+				}
+			}
+			if (!pReq)
+				break;
+			m_decoding.remove(pReq);
+
+			if (pReq->m_bCancelRequested)
+				finish(pReq, CANCELLED);
+			else if (!pReq->m_bDecodeOk) {
+				Console::error("AsyncTextureLoader: failed to load %s\n", pReq->m_filename.c_str());
+				finish(pReq, FAILED);
+			}
+			else if (!beginUpload(pReq))
+				finish(pReq, FAILED);
+			else
+				m_pUploading = pReq;
+			continue;
+		}
+
+		// upload the next chunk of rows
+		if (uploadChunk(m_pUploading)) {
+			Request *pReq = m_pUploading;
+			m_pUploading = 0;
+			finish(pReq, READY);
+		}
+	}
+
+	// requests that finished free up slots for new ones
+	submitPending();
+}
+
+bool AsyncTextureLoader::beginUpload(Request *pReq)
+{
+	if (pReq->m_bCompress)
+	{
+		pReq->m_state = UPLOADING;
+		pReq->m_pTexture = new Texture();
+		pReq->m_pTexture->create(pReq->m_compressed);
+		pReq->m_compressed.free();
+		return pReq->m_pTexture->isLoaded();
+	}
+
+	if (!Texture::getImageFormat(pReq->m_image, pReq->m_glFormat, pReq->m_glPixelFormat, pReq->m_glDataType))
+	{
+		Console::error("AsyncTextureLoader: image format of %s is not supported\n", pReq->m_filename.c_str());
+		return false;
+	}
+
+	// allocate the texture storage; the data follows in chunks
+	pReq->m_state = UPLOADING;
+	pReq->m_uploadedRows = 0;
+	pReq->m_pTexture = new Texture();
+	pReq->m_pTexture->create((int)pReq->m_image.getWidth(), (int)pReq->m_image.getHeight(), pReq->m_glFormat, 0);
+	if (!pReq->m_pTexture->isLoaded())
+		return false;
+
+	// check once if we can stream through pixel buffer objects
+	if (!m_pbo[0] && GLEW_ARB_pixel_buffer_object) {
+		glGenBuffersARB(2, m_pbo);
+		m_bUsePBO = (m_pbo[0] != 0);
+	}
+
+	return true;
+}
+
+bool AsyncTextureLoader::uploadChunk(Request *pReq)
+{
+	if (pReq->m_bCompress)
+		return true;	// uploaded all at once in beginUpload
+
+	const Image &img = pReq->m_image;
+	size_t rowBytes = img.getWidth()*img.getBytesPerPixel();
+	size_t nRows = m_chunkSize / rowBytes;
+	if (nRows < 1)
+		nRows = 1;
+	if (pReq->m_uploadedRows + nRows > img.getHeight())
+		nRows = img.getHeight() - pReq->m_uploadedRows;
+	const unsigned char *src = img(0, pReq->m_uploadedRows);
+
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+	PROFILE_COUNT(UPLOAD_BYTES, (int)(nRows*rowBytes));
+
+	glBindTexture(GL_TEXTURE_2D, pReq->m_pTexture->getGLTex());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	bool bUploaded = false;
+	if (m_bUsePBO)
+	{
+		// copy the rows to a pbo and let the driver transfer them asynchronously.
+		// Alternate between two pbos, and orphan the old storage, so that we never
+		// wait for the previous transfer to complete
+		glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, m_pbo[m_curPBO]);
+		glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, nRows*rowBytes, 0, GL_STREAM_DRAW_ARB);
+		void *dst = glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+		if (dst) {
+			memcpy(dst, src, nRows*rowBytes);
+			glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)pReq->m_uploadedRows, (GLsizei)img.getWidth(), (GLsizei)nRows,
+							pReq->m_glPixelFormat, pReq->m_glDataType, 0);
+			bUploaded = true;
+		}
+		glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		m_curPBO = 1 - m_curPBO;
+	}
+	if (!bUploaded)
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, (GLint)pReq->m_uploadedRows, (GLsizei)img.getWidth(), (GLsizei)nRows,
+						pReq->m_glPixelFormat, pReq->m_glDataType, src);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	pReq->m_uploadedRows += nRows;
+	return pReq->m_uploadedRows >= img.getHeight();
+}
+
+void AsyncTextureLoader::finish(Request *pReq, State state)
+{
+	if (pReq->m_state == DECODING || pReq->m_state == DECODED || pReq->m_state == UPLOADING) {
+		ASSERT(m_nInFlight > 0);
+		m_nInFlight--;
+	}
+
+	pReq->m_state = state;
+	if (state != READY) {
+		SAFE_DELETE(pReq->m_pTexture);
+	}
+	else if (Texture::getKeepShadowCopies() && !pReq->m_bCompress)	// compressed textures made their own
+		pReq->m_pTexture->updateShadow(pReq->m_image, 0, 0, (int)pReq->m_image.getWidth(), (int)pReq->m_image.getHeight());
+	if (state != READY || !pReq->m_bKeepImage)
+		pReq->m_image.clear();
+	pReq->m_compressed.free();
+
+	// drop the loader's reference
+	pReq->release();
+}
+
+void AsyncTextureLoader::cancel(Request *pReq)
+{
+	switch (pReq->m_state)
+	{
+	case PENDING:
+		m_pending.remove(pReq);
+		finish(pReq, CANCELLED);
+		break;
+	case DECODING:
+		if (ThreadPool::inst()->cancel(pReq)) {
+			m_decoding.remove(pReq);
+			finish(pReq, CANCELLED);
+		}
+		else
+			pReq->m_bCancelRequested = true;	// finished in update(), when the worker is done with it
+		break;
+	case DECODED:
+		pReq->m_bCancelRequested = true;
+		break;
+	case UPLOADING:
+		ASSERT(m_pUploading == pReq);
+		m_pUploading = 0;
+		finish(pReq, CANCELLED);
+		break;
+	default:
+		break;
+	}
+}
+
+void AsyncTextureLoader::cancelAll()
+{
+	while (!m_pending.empty())
+		cancel(m_pending.front());
+	std::list<Request*> decoding = m_decoding;
+	for (std::list<Request*>::iterator it = decoding.begin(); it != decoding.end(); ++it)
+		cancel(*it);
+	if (m_pUploading)
+		cancel(m_pUploading);
+}
+
+void AsyncTextureLoader::free()
+{
+	cancelAll();
+
+	// wait for the requests that are being decoded right now
+	while (!m_decoding.empty()) {
+		Request *pReq = 0;
+		{
+			ScopedLock lock(m_decodedLock);
+			if (!m_decoded.empty()) {
+				pReq = m_decoded.front();
+				m_decoded.pop_front();
+			}
+		}
+		if (!pReq) {
+			Thread::sleep(1);
+			continue;
+		}
+		m_decoding.remove(pReq);
+		finish(pReq, CANCELLED);
+	}
+
+	if (m_pbo[0])
+		glDeleteBuffersARB(2, m_pbo);
+	m_pbo[0] = m_pbo[1] = 0;
+	m_bUsePBO = false;
+	SAFE_DELETE(m_pPlaceholder);
+}
+
+Texture* AsyncTextureLoader::getPlaceholder()
+{
+	if (!m_pPlaceholder) {
+		// a small neutral grey texture
+		unsigned char data[2*2*4];
+		for (int i=0; i<2*2*4; ++i)
+			data[i] = ((i%4) == 3) ? 255 : 128;
+		m_pPlaceholder = new Texture();
+		m_pPlaceholder->create(2, 2, GL_RGBA8, data);
+	}
+	return m_pPlaceholder;
+}
+
+//--------------------------------
+
+AsyncTextureLoader::Handle& AsyncTextureLoader::Handle::operator = (const Handle &h)
+{
+	if (h.m_pReq)
+		h.m_pReq->addRef();
+	if (m_pReq)
+		m_pReq->release();
+	m_pReq = h.m_pReq;
+	return *this;
+}
+
+const std::string& AsyncTextureLoader::Handle::getFilename() const
+{
+	static const std::string empty;
+	return (m_pReq) ? m_pReq->m_filename : empty;
+}
+
+Texture* AsyncTextureLoader::Handle::getTexture() const
+{
+	if (m_pReq && m_pReq->m_state == READY && m_pReq->m_pTexture)
+		return m_pReq->m_pTexture;
+	if (m_pReq)
+		return m_pReq->m_pLoader->getPlaceholder();
+	return AsyncTextureLoader::inst()->getPlaceholder();
+}
+
+const Image* AsyncTextureLoader::Handle::getImage() const
+{
+	if (!m_pReq)
+		return 0;
+	State st = m_pReq->m_state;
+	if ((st == DECODED && m_pReq->m_bDecodeOk) || st == UPLOADING || (st == READY && m_pReq->m_bKeepImage))
+		return &m_pReq->m_image;
+	return 0;
+}
+
+Texture* AsyncTextureLoader::Handle::releaseTexture()
+{
+	if (!m_pReq || m_pReq->m_state != READY)
+		return 0;
+	Texture *pTex = m_pReq->m_pTexture;
+	m_pReq->m_pTexture = 0;
+	return pTex;
+}
+
+void AsyncTextureLoader::Handle::cancel()
+{
+	if (m_pReq)
+		m_pReq->m_pLoader->cancel(m_pReq);
+}
@@ -0,0 +1,189 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ASYNCTEXTURELOADER_H45631_INCLUDED_
+#define _ASYNCTEXTURELOADER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Thread.h"
+#include "ThreadPool.h"
+#include "Texture.h"
+#include "Image.h"
+#include "BlockCompression.h"
+
+/**
+ * AsyncTextureLoader: loads image files to textures without blocking the
+ *		rendering thread.
+ *
+ *		Image files are decoded on the worker threads of the ThreadPool. Decoded
+ *		images are then uploaded from the GL thread, in update(), which should be
+ *		called once per frame. Uploads are streamed in chunks of rows (through
+ *		pixel buffer objects, when available), and each update() call uploads
+ *		only as many chunks as fit in its time budget, so that loading a large
+ *		number of images does not stall the frame.
+ *
+ *		load(..) returns a Handle immediately. Until the texture is ready,
+ *		Handle::getTexture() returns a placeholder texture. At most
+ *		getMaxInFlight() requests are decoded/uploaded at the same time - the
+ *		rest wait in a queue, in the order they were requested. Requests can be
+ *		cancelled at any point through their handle.
+ *
+ *		Requests with bCompress get block compressed textures. The workers load
+ *		them from the compressed image cache, or compress them (see
+ *		CompressedImage::loadCached), and they are uploaded in one go, since
+ *		they are several times smaller.
+ *
+ *		TextureManager::loadTextureAsync(..) and the resource manager of the GUI
+ *		load through it too, and share the results with their synchronous loads.
+ *
+ *		Handles, textures and the loader itself must only be used from the
+ *		GL thread.
+ */
+class AsyncTextureLoader
+{
+public:
+	enum State {
+		PENDING,	// waiting in the queue
+		DECODING,	// submitted to the worker threads
+		DECODED,	// image decoded, waiting for upload
+		UPLOADING,	// being uploaded to the texture
+		READY,
+		FAILED,
+		CANCELLED
+	};
+
+private:
+	class Request : public ThreadPool::Job {
+	public:
+		AsyncTextureLoader	*m_pLoader;
+		std::string		m_filename;
+		volatile long	m_nRefs;
+		volatile State	m_state;
+		volatile bool	m_bCancelRequested;
+		bool			m_bDecodeOk;	// set by the worker, along with the DECODED state
+		bool			m_bKeepImage;
+		bool			m_bCompress;
+		Image			m_image;
+		CompressedImage	m_compressed;
+		Texture			*m_pTexture;
+		size_t			m_uploadedRows;
+		GLenum			m_glFormat, m_glPixelFormat, m_glDataType;
+
+		Request() : m_pLoader(0), m_nRefs(0), m_state(PENDING), m_bCancelRequested(false), m_bDecodeOk(false), m_bKeepImage(false), m_bCompress(false),
+			m_pTexture(0), m_uploadedRows(0), m_glFormat(0), m_glPixelFormat(0), m_glDataType(0) { }
+		virtual ~Request() { SAFE_DELETE(m_pTexture); }
+
+		void addRef()	{ atomicIncrement(&m_nRefs); }
+		void release()	{ if (atomicDecrement(&m_nRefs) == 0) delete this; }
+
+		virtual void run();		// decode (runs on a worker thread)
+	};
+
+public:
+	/**
+	 * Handle: a reference to a load request. Copying a handle is cheap; the
+	 *		request (and its texture) lives as long as there are handles to it.
+	 */
+	class Handle {
+		friend class AsyncTextureLoader;
+	private:
+		Request	*m_pReq;
+		Handle(Request *pReq) : m_pReq(pReq)	{ if (m_pReq) m_pReq->addRef(); }
+	public:
+		Handle() : m_pReq(0) { }
+		Handle(const Handle &h) : m_pReq(h.m_pReq)	{ if (m_pReq) m_pReq->addRef(); }
+		~Handle()									{ if (m_pReq) m_pReq->release(); }
+		Handle& operator = (const Handle &h);
+
+		bool		isValid() const		{ return m_pReq != 0; }
+		State		getState() const	{ return (m_pReq) ? m_pReq->m_state : FAILED; }
+		bool		isReady() const		{ return getState() == READY; }
+		bool		isDone() const		{ State st = getState(); return st == READY || st == FAILED || st == CANCELLED; }
+		const std::string&	getFilename() const;
+
+		// the loaded texture, or the placeholder texture if it is not ready yet
+		Texture*	getTexture() const;
+
+		// the decoded image. Only available after the image has been decoded, and after the
+		// upload is complete only if the request was created with bKeepImage
+		const Image*	getImage() const;
+
+		// take ownership of the loaded texture. Returns 0 if the texture is not ready.
+		Texture*	releaseTexture();
+
+		void		cancel();
+		void		reset()		{ *this = Handle(); }
+	};
+
+private:
+	std::list<Request*>	m_pending;		// waiting to be submitted
+	std::list<Request*>	m_decoding;		// submitted to the thread pool
+	std::list<Request*>	m_decoded;		// decoded, waiting for upload (in order of completion)
+	Mutex				m_decodedLock;	// guards m_decoded (filled by the workers)
+	Request				*m_pUploading;
+	size_t				m_maxInFlight;
+	size_t				m_nInFlight;
+	size_t				m_chunkSize;	// upload chunk size, in bytes
+	Texture				*m_pPlaceholder;
+	GLuint				m_pbo[2];
+	int					m_curPBO;
+	bool				m_bUsePBO;
+
+	static AsyncTextureLoader	*m_pInst;
+
+public:
+	AsyncTextureLoader();
+	virtual ~AsyncTextureLoader();
+
+	static AsyncTextureLoader* inst();
+
+	// queue an image file for loading. If bKeepImage is set, the decoded image stays
+	// available through the handle after the upload. With bCompress, the texture is
+	// block compressed, if the image can be.
+	Handle	load(const std::string &filename, bool bKeepImage = false, bool bCompress = false);
+
+	// Upload decoded images and submit queued requests. Call once per frame, from the
+	// GL thread. Stops uploading when timeBudget (in msec) is exceeded.
+	void	update(double timeBudget = 4.0);
+
+	void	cancelAll();
+	void	free();		// cancel everything and release the GL resources of the loader
+
+	void	setMaxInFlight(size_t n)	{ ASSERT(n > 0); m_maxInFlight = n; }
+	size_t	getMaxInFlight() const		{ return m_maxInFlight; }
+	void	setChunkSize(size_t bytes)	{ ASSERT(bytes > 0); m_chunkSize = bytes; }
+	size_t	getChunkSize() const		{ return m_chunkSize; }
+	size_t	getQueuedNum() const		{ return m_pending.size() + m_nInFlight; }
+
+	Texture*	getPlaceholder();
+
+private:
+	void	cancel(Request *pReq);
+	void	submitPending();
+	void	onDecoded(Request *pReq);	// called by the workers
+	bool	beginUpload(Request *pReq);
+	bool	uploadChunk(Request *pReq);	// returns true when the upload is complete
+	void	finish(Request *pReq, State state);
+};
+
+#endif
@@ -20,11 +20,8 @@
 */
 
 #include "BaseTextFile.h"
-#include <ctype.h>
-#include <stdlib.h>
 
-BaseTextFile::BaseTextFile() : m_fp(0), m_nLines(0),
-	m_bReadWholeLines(false), m_bSkipComments(true)
+BaseTextFile::BaseTextFile() : m_fp(0)
 {
 }
 
@@ -37,10 +34,10 @@ bool BaseTextFile::loadFile(const std::string &filename, bool bBin)
 {
 	close();
 
-	m_nLines = 0;
-	m_fp = fopen(filename.c_str(), (bBin)?"rb":"r");
+	m_fp = fopen(filename.c_str(), "rb");
 	if (!m_fp)
 		return false;
+	m_tokenizer.setInput(m_fp);
 
 	return true;
 }
@@ -61,126 +58,79 @@ bool BaseTextFile::isOpen() const
 bool BaseTextFile::eof() const
 {
 	ASSERT(m_fp);
-	return feof(m_fp)!=0;
+	return m_tokenizer.eof();
 }
 
-std::string BaseTextFile::getline()
+FILE* BaseTextFile::getFP()
 {
-	std::string str;
-	char ch = fgetc(m_fp);
-	while (!eof() && ch!='\n')
-	{
-		str += ch;
-		ch = fgetc(m_fp);
+	// the tokenizer has read ahead: move the file back to where it stopped
+	if (m_fp) {
+		fseek(m_fp, m_tokenizer.getFilePos(), SEEK_SET);
+		m_tokenizer.reset();
 	}
-	return str;
+	return m_fp;
 }
 
-BaseTextFile& BaseTextFile::operator >> (std::string& str)
+void BaseTextFile::goToStart()
 {
-	ASSERT(m_fp);
-	
-	unsigned char ch;
-
-	while (true) {
-		str = "";
-
-		// read whitespace before string
-		ch = fgetc(m_fp);
-		while (!eof() && isspace(ch)) {
-			if (ch == '\n') {
-				m_nLines++;
-				if (str.length() > 0)
-					return *this;
-			}
-			ch = fgetc(m_fp);
-		}
-		
-		// read string
-		while (!eof() && !isspace(ch)) {
-			// check if we found a character that indicates a word break
-			bool bWordBreak = false;
-			for (size_t i=0; i<m_wordBreakChars.size(); ++i)
-				if (ch == m_wordBreakChars[i]) {
-					bWordBreak = true;
-					if (str.length() == 0)
-						str += ch;
-					else
-						ungetc(ch, m_fp);
-					break;
-				}
-			if (bWordBreak) break;
-			
-			str += ch;
-			ch = fgetc(m_fp);
-		}
-
-		// check if this is a comment.
-		bool bIsComment = false;
-		// single-line comments
-		for (size_t i=0; i<m_lineCommentPrefixes.size(); ++i)
-		{
-			if (strncmp(m_lineCommentPrefixes[i].c_str(), str.c_str(), m_lineCommentPrefixes[i].length()) == 0)
-			{
-				// this is a comment.
-				bIsComment = true;
-
-				// read out the rest of the line.
-				while (!eof() && ch != '\n')
-					ch = fgetc(m_fp);
-
-				break;
-			}
-		}
-		// TODO: block comments
-
-		if (!bIsComment)
-			break;
-	}
+	fseek(m_fp, 0, SEEK_SET);
+	m_tokenizer.reset();
+}
 
-	// skip whitespace after string until new line
-	while (!eof() && ch != '\n') {
-		ch = fgetc(m_fp);
-		if (!isspace(ch) && !m_bReadWholeLines)
-		{
-			ungetc(ch, m_fp);
-			break;
-		}
-	}
-	if (ch == '\n')
-		m_nLines++;
+void BaseTextFile::goToEnd()
+{
+	fseek(m_fp, 0, SEEK_END);
+	m_tokenizer.reset();
+}
+
+std::string BaseTextFile::getline()
+{
+	Tokenizer::Token line;
+	m_tokenizer.nextLine(line);
+	return line.toString();
+}
 
+BaseTextFile& BaseTextFile::operator >> (Tokenizer::Token& token)
+{
+	ASSERT(m_fp);
+	m_tokenizer.next(token);
+	return *this;
+}
+
+BaseTextFile& BaseTextFile::operator >> (std::string& str)
+{
+	ASSERT(m_fp);
+	Tokenizer::Token token;
+	m_tokenizer.next(token);
+	str.assign(token.str ? token.str : "", token.len);
 	return *this;
 }
 
-//WARNING: not thread-safe at all.
 BaseTextFile& BaseTextFile::operator >> (double& n)
 {
-	static std::string buf;
-	*this >> buf;
-	n = atof(buf.c_str());
+	Tokenizer::Token token;
+	*this >> token;
+	n = Tokenizer::toDouble(token);
 	return *this;
 }
 
-//WARNING: not thread-safe at all.
 BaseTextFile& BaseTextFile::operator >> (float& n)
 {
-	static std::string buf;
-	*this >> buf;
-	n = (float)atof(buf.c_str());
+	Tokenizer::Token token;
+	*this >> token;
+	n = (float)Tokenizer::toDouble(token);
 	return *this;
 }
 
-//WARNING: not thread-safe at all.
 BaseTextFile& BaseTextFile::operator >> (int& n)
 {
-	static std::string buf;
-	*this >> buf;
-	n = atoi(buf.c_str());
+	Tokenizer::Token token;
+	*this >> token;
+	n = Tokenizer::toInt(token);
 	return *this;
 }
 
 void BaseTextFile::addLineCommentDef(const std::string& commentStart)
 {
-	m_lineCommentPrefixes.push_back(commentStart);
-}
\ No newline at end of file
+	m_tokenizer.addLineCommentDef(commentStart);
+}
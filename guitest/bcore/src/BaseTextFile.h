@@ -25,19 +25,19 @@
 #pragma once
 
 #include "common.h"
+#include "Tokenizer.h"
 #include <stdio.h>
 
+/**
+ * BaseTextFile: reads words and numbers from a text file, through a Tokenizer.
+ *		Files are always read in binary mode, so that the position of the FILE can
+ *		be synchronized with the tokenizer; '\r' is whitespace like any other.
+ */
 class BaseTextFile
 {
 private:
-	FILE *m_fp;
-	int	 m_nLines;
-
-	bool m_bReadWholeLines;
-	bool m_bSkipComments;
-	std::vector<std::string> m_lineCommentPrefixes;
-
-	std::vector<char> m_wordBreakChars;	// characters that indicate the beginning of a new word
+	FILE		*m_fp;
+	Tokenizer	m_tokenizer;
 
 public:
 	BaseTextFile();
@@ -49,18 +49,19 @@ public:
 	bool	isOpen() const;
 	bool	eof() const;
 	std::string getline();
-	int		getCurLine() const	{ return m_nLines+1; }
-	FILE*	getFP() { return m_fp; }	// OK, architectural mistake.
+	int		getCurLine() const	{ return m_tokenizer.getLinesNum()+1; }
+	FILE*	getFP();	// OK, architectural mistake. Positioned after the last word read
 
-	void	goToStart()		{ fseek(m_fp, 0, SEEK_SET); }
-	void	goToEnd()		{ fseek(m_fp, 0, SEEK_END); }
+	void	goToStart();
+	void	goToEnd();
 
-	void	setReadWholeLines(bool bEnable)	{ m_bReadWholeLines = bEnable; }
+	void	setReadWholeLines(bool bEnable)	{ m_tokenizer.setReadWholeLines(bEnable); }
 	void	addCommentBlockDef(const std::string& commentStart, const std::string& commentEnd);
 	void	addLineCommentDef(const std::string& commentStart);
-	void	skipComments(bool bSkip)	{ m_bSkipComments = bSkip; };
-	void	addWordBreakChar(char c)	{ m_wordBreakChars.push_back(c); }
+	void	skipComments(bool bSkip)	{ m_tokenizer.setSkipComments(bSkip); };
+	void	addWordBreakChar(char c)	{ m_tokenizer.addWordBreakChar(c); }
 
+	BaseTextFile& operator >> (Tokenizer::Token&);	// no copy, valid until the next read
 	BaseTextFile& operator >> (std::string&);
 	BaseTextFile& operator >> (double&);
 	BaseTextFile& operator >> (float&);
@@ -21,11 +21,13 @@
 
 #include "BaseTexture.h"
 #include "TextureManager.h"
+#include "TextureBudget.h"
 
 void BaseTexture::free()
  {
 	if (m_texture && !m_bIsManaged)
 	{
+		TextureBudget::inst()->remove(m_texture);
 		glDeleteTextures(1, &m_texture);
 		m_texture = 0;
 	}
@@ -39,6 +41,8 @@ void BaseTexture::free()
 
 void BaseTexture::setPriority(double priority)
 {
+	m_priority = priority;
 	GLclampf pr = (float)priority;
 	glPrioritizeTextures(1, &m_texture, &pr);
+	TextureBudget::inst()->setPriority(m_texture, priority);
 }
\ No newline at end of file
@@ -45,6 +45,7 @@
 class BaseTexture
 {
 	friend class TextureManager;
+	friend class TextureBudget;
 protected:
 	GLuint	m_texture;
 	int		m_width, m_height, m_depth;
@@ -54,14 +55,17 @@ private:
 	double	m_priority;
 
 public:
-	BaseTexture() : m_texture(0), m_width(0), m_height(0), m_depth(0), m_bIsManaged(false), m_priority(1.0) { };
-	BaseTexture(const BaseTexture& t) : m_texture(t.m_texture), m_width(t.m_width), m_height(t.m_height), m_depth(t.m_depth), m_bIsManaged(false), m_priority(1.0) { }
-	BaseTexture(GLuint texid, int w, int h=0, int d=0) : m_texture(texid), m_width(w), m_height(h), m_depth(d), m_bIsManaged(false), m_priority(1.0) { }
+	BaseTexture() : m_texture(0), m_width(0), m_height(0), m_depth(0), m_bIsManaged(false), m_priority(0.5) { };
+	BaseTexture(const BaseTexture& t) : m_texture(t.m_texture), m_width(t.m_width), m_height(t.m_height), m_depth(t.m_depth), m_bIsManaged(false), m_priority(0.5) { }
+	BaseTexture(GLuint texid, int w, int h=0, int d=0) : m_texture(texid), m_width(w), m_height(h), m_depth(d), m_bIsManaged(false), m_priority(0.5) { }
 	virtual ~BaseTexture() { free(); }
 
 	virtual void free();
 
-	void setPriority(double priority);	// set a priority from 0 to 1, to keep this texture in vidmem
+	// set a priority from 0 to 1, to keep this texture in vidmem. Textures with lower priority are
+	// evicted first by the TextureBudget, and a priority of 1 keeps the texture always resident.
+	void setPriority(double priority);
+	double getPriority() const		{ return m_priority; }
 
 	inline bool isLoaded() const	{ return m_texture != 0; }
 	inline bool isManaged() const	{ return m_bIsManaged; }
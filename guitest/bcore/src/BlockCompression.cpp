@@ -0,0 +1,696 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BlockCompression.h"
+#include "Image.h"
+#include "MipChain.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+std::string CompressedImage::m_cacheDir;
+
+namespace {
+
+// the 16 pixels of a block, as RGBA (missing channels are 255)
+typedef unsigned char Block[16][4];
+
+void fetchBlock(const Image &image, size_t bx, size_t by, Block &px)
+{
+	size_t nChannels = image.getChannelsNum();
+	if (nChannels > 4)
+		nChannels = 4;
+	for (size_t j=0; j<4; ++j) {
+		size_t y = by*4 + j;
+		if (y >= image.getHeight())
+			y = image.getHeight()-1;
+		for (size_t i=0; i<4; ++i) {
+			size_t x = bx*4 + i;
+			if (x >= image.getWidth())
+				x = image.getWidth()-1;
+			const unsigned char *src = image(x, y);
+			unsigned char *dst = px[j*4+i];
+			dst[0] = dst[1] = dst[2] = dst[3] = 255;
+			for (size_t c=0; c<nChannels; ++c)
+				dst[c] = src[c];
+		}
+	}
+}
+
+inline void unpack565(uint16_t c, int rgb[3])
+{
+	int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+inline int quantize(float v, int maxVal)
+{
+	int q = (int)(v*maxVal/255.0f + 0.5f);
+	return (q < 0) ? 0 : ((q > maxVal) ? maxVal : q);
+}
+
+inline uint16_t pack565(const float rgb[3])
+{
+	return (uint16_t)((quantize(rgb[0], 31) << 11) | (quantize(rgb[1], 63) << 5) | quantize(rgb[2], 31));
+}
+
+// the colors of a BC1 block. The 3 color mode (c0 <= c1, with transparent black)
+// is never used in BC3, and never written by the encoder.
+void colorPalette(uint16_t c0, uint16_t c1, bool b4Colors, int pal[4][4])
+{
+	unpack565(c0, pal[0]);
+	unpack565(c1, pal[1]);
+	pal[0][3] = pal[1][3] = pal[2][3] = pal[3][3] = 255;
+	for (int k=0; k<3; ++k) {
+		if (b4Colors) {
+			pal[2][k] = (2*pal[0][k] + pal[1][k]) / 3;
+			pal[3][k] = (pal[0][k] + 2*pal[1][k]) / 3;
+		}
+		else {
+			pal[2][k] = (pal[0][k] + pal[1][k]) / 2;
+			pal[3][k] = 0;
+		}
+	}
+	if (!b4Colors)
+		pal[3][3] = 0;
+}
+
+// pick the closest palette color for each pixel. Returns the total squared error.
+int matchColors(const Block &px, uint16_t c0, uint16_t c1, unsigned char idx[16])
+{
+	int pal[4][4];
+	colorPalette(c0, c1, true, pal);
+	int err = 0;
+	for (int i=0; i<16; ++i) {
+		int best = 0, bestErr = 0x7fffffff;
+		for (int p=0; p<4; ++p) {
+			int dr = px[i][0]-pal[p][0], dg = px[i][1]-pal[p][1], db = px[i][2]-pal[p][2];
+			int e = dr*dr + dg*dg + db*db;
+			if (e < bestErr) { bestErr = e; best = p; }
+		}
+		idx[i] = (unsigned char)best;
+		err += bestErr;
+	}
+	return err;
+}
+
+// least squares end points for the given indices. Returns false if they cannot be solved.
+bool refineColors(const Block &px, const unsigned char idx[16], uint16_t &c0, uint16_t &c1)
+{
+	static const float w0[4] = { 1.0f, 0.0f, 2.0f/3, 1.0f/3 };	// weight of c0 for each index
+
+	float aa = 0, ab = 0, bb = 0;
+	float ax[3] = { 0, 0, 0 }, bx[3] = { 0, 0, 0 };
+	for (int i=0; i<16; ++i) {
+		float a = w0[idx[i]], b = 1-a;
+		aa += a*a; ab += a*b; bb += b*b;
+		for (int k=0; k<3; ++k) {
+			ax[k] += a*px[i][k];
+			bx[k] += b*px[i][k];
+		}
+	}
+	float det = aa*bb - ab*ab;
+	if (fabs(det) < 1e-6f)
+		return false;
+
+	float e0[3], e1[3];
+	for (int k=0; k<3; ++k) {
+		e0[k] = (ax[k]*bb - bx[k]*ab) / det;
+		e1[k] = (bx[k]*aa - ax[k]*ab) / det;
+	}
+	c0 = pack565(e0);
+	c1 = pack565(e1);
+	return true;
+}
+
+void encodeColorBlock(const Block &px, unsigned char *out)
+{
+	// mean and covariance of the colors
+	float mean[3] = { 0, 0, 0 };
+	int minC[3] = { 255, 255, 255 }, maxC[3] = { 0, 0, 0 };
+	for (int i=0; i<16; ++i)
+		for (int k=0; k<3; ++k) {
+			mean[k] += px[i][k];
+			if (px[i][k] < minC[k]) minC[k] = px[i][k];
+			if (px[i][k] > maxC[k]) maxC[k] = px[i][k];
+		}
+	for (int k=0; k<3; ++k)
+		mean[k] /= 16;
+
+	uint16_t c0, c1;
+	unsigned char idx[16];
+	if (minC[0] == maxC[0] && minC[1] == maxC[1] && minC[2] == maxC[2])
+	{
+		// a single color
+		c0 = c1 = pack565(mean);
+		memset(idx, 0, sizeof(idx));
+	}
+	else
+	{
+		float cov[6] = { 0, 0, 0, 0, 0, 0 };	// rr, rg, rb, gg, gb, bb
+		for (int i=0; i<16; ++i) {
+			float r = px[i][0]-mean[0], g = px[i][1]-mean[1], b = px[i][2]-mean[2];
+			cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+			cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+		}
+
+		// principal axis by power iteration, starting from the bounding box diagonal
+		float v[3] = { (float)(maxC[0]-minC[0]), (float)(maxC[1]-minC[1]), (float)(maxC[2]-minC[2]) };
+		for (int it=0; it<4; ++it) {
+			float r = v[0]*cov[0] + v[1]*cov[1] + v[2]*cov[2];
+			float g = v[0]*cov[1] + v[1]*cov[3] + v[2]*cov[4];
+			float b = v[0]*cov[2] + v[1]*cov[4] + v[2]*cov[5];
+			float m = std::max(fabs(r), std::max(fabs(g), fabs(b)));
+			if (m < 1e-6f)
+				break;
+			v[0] = r/m; v[1] = g/m; v[2] = b/m;
+		}
+		float len2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+
+		// the extent of the colors along the axis, inset a little, since the end points
+		// are rarely used exactly
+		float tMin = 0, tMax = 0;
+		for (int i=0; i<16; ++i) {
+			float t = ((px[i][0]-mean[0])*v[0] + (px[i][1]-mean[1])*v[1] + (px[i][2]-mean[2])*v[2]) / len2;
+			if (t < tMin) tMin = t;
+			if (t > tMax) tMax = t;
+		}
+		float inset = (tMax-tMin)/16;
+		tMin += inset;
+		tMax -= inset;
+		float e0[3], e1[3];
+		for (int k=0; k<3; ++k) {
+			e0[k] = mean[k] + tMax*v[k];
+			e1[k] = mean[k] + tMin*v[k];
+		}
+		c0 = pack565(e0);
+		c1 = pack565(e1);
+		int err = matchColors(px, c0, c1, idx);
+
+		// refine the end points, and keep them if they are better
+		for (int it=0; it<2 && err > 0; ++it) {
+			uint16_t r0, r1;
+			unsigned char ridx[16];
+			if (!refineColors(px, idx, r0, r1))
+				break;
+			int rerr = matchColors(px, r0, r1, ridx);
+			if (rerr >= err)
+				break;
+			c0 = r0; c1 = r1; err = rerr;
+			memcpy(idx, ridx, sizeof(idx));
+		}
+	}
+
+	// 4 color mode needs c0 > c1. Swapping them swaps indices 0<->1 and 2<->3
+	if (c0 < c1) {
+		std::swap(c0, c1);
+		for (int i=0; i<16; ++i)
+			idx[i] ^= 1;
+	}
+	else if (c0 == c1)
+		memset(idx, 0, sizeof(idx));
+
+	out[0] = (unsigned char)(c0 & 0xff);
+	out[1] = (unsigned char)(c0 >> 8);
+	out[2] = (unsigned char)(c1 & 0xff);
+	out[3] = (unsigned char)(c1 >> 8);
+	for (int j=0; j<4; ++j)
+		out[4+j] = (unsigned char)(idx[j*4] | (idx[j*4+1] << 2) | (idx[j*4+2] << 4) | (idx[j*4+3] << 6));
+}
+
+void alphaPalette(int a0, int a1, int pal[8])
+{
+	pal[0] = a0;
+	pal[1] = a1;
+	if (a0 > a1) {
+		for (int k=1; k<7; ++k)
+			pal[k+1] = ((7-k)*a0 + k*a1) / 7;
+	}
+	else {
+		for (int k=1; k<5; ++k)
+			pal[k+1] = ((5-k)*a0 + k*a1) / 5;
+		pal[6] = 0;
+		pal[7] = 255;
+	}
+}
+
+int matchAlpha(const unsigned char v[16], int a0, int a1, unsigned char idx[16])
+{
+	int pal[8];
+	alphaPalette(a0, a1, pal);
+	int err = 0;
+	for (int i=0; i<16; ++i) {
+		int best = 0, bestErr = 0x7fffffff;
+		for (int p=0; p<8; ++p) {
+			int e = (v[i]-pal[p])*(v[i]-pal[p]);
+			if (e < bestErr) { bestErr = e; best = p; }
+		}
+		idx[i] = (unsigned char)best;
+		err += bestErr;
+	}
+	return err;
+}
+
+// a BC4 block (also the alpha of BC3)
+void encodeAlphaBlock(const unsigned char v[16], unsigned char *out)
+{
+	int minV = 255, maxV = 0;			// of all values
+	int minIn = 255, maxIn = 0;			// of the values other than 0 and 255
+	for (int i=0; i<16; ++i) {
+		if (v[i] < minV) minV = v[i];
+		if (v[i] > maxV) maxV = v[i];
+		if (v[i] > 0 && v[i] < 255) {
+			if (v[i] < minIn) minIn = v[i];
+			if (v[i] > maxIn) maxIn = v[i];
+		}
+	}
+
+	// 8 interpolated values between the extremes, or 6 between the inner values plus
+	// exact 0 and 255, which is better for blocks on the edges of masks and glyphs
+	int a0 = maxV, a1 = minV;
+	unsigned char idx[16];
+	int err = matchAlpha(v, a0, a1, idx);
+	if (err > 0 && minIn <= maxIn && (minV == 0 || maxV == 255)) {
+		unsigned char idx6[16];
+		int err6 = matchAlpha(v, minIn, maxIn, idx6);
+		if (err6 < err) {
+			a0 = minIn; a1 = maxIn;
+			memcpy(idx, idx6, sizeof(idx));
+		}
+	}
+
+	out[0] = (unsigned char)a0;
+	out[1] = (unsigned char)a1;
+	uint64_t bits = 0;
+	for (int i=0; i<16; ++i)
+		bits |= (uint64_t)idx[i] << (3*i);
+	for (int k=0; k<6; ++k)
+		out[2+k] = (unsigned char)(bits >> (8*k));
+}
+
+void decodeColorBlock(const unsigned char *in, bool b4Colors, Block &px)
+{
+	uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+	uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+	int pal[4][4];
+	colorPalette(c0, c1, b4Colors || c0 > c1, pal);
+	for (int i=0; i<16; ++i) {
+		int p = (in[4 + i/4] >> (2*(i%4))) & 3;
+		for (int k=0; k<4; ++k)
+			px[i][k] = (unsigned char)pal[p][k];
+	}
+}
+
+void decodeAlphaBlock(const unsigned char *in, Block &px, int channel)
+{
+	int pal[8];
+	alphaPalette(in[0], in[1], pal);
+	uint64_t bits = 0;
+	for (int k=0; k<6; ++k)
+		bits |= (uint64_t)in[2+k] << (8*k);
+	for (int i=0; i<16; ++i)
+		px[i][channel] = (unsigned char)pal[(bits >> (3*i)) & 7];
+}
+
+void encodeBlock(const Block &px, BlockCompression::Format format, unsigned char *out)
+{
+	unsigned char v[16];
+	switch (format)
+	{
+	case BlockCompression::BC1:
+		encodeColorBlock(px, out);
+		break;
+	case BlockCompression::BC3:
+		for (int i=0; i<16; ++i)
+			v[i] = px[i][3];
+		encodeAlphaBlock(v, out);
+		encodeColorBlock(px, out+8);
+		break;
+	case BlockCompression::BC4:
+	case BlockCompression::BC5:
+		for (int i=0; i<16; ++i)
+			v[i] = px[i][0];
+		encodeAlphaBlock(v, out);
+		if (format == BlockCompression::BC5) {
+			for (int i=0; i<16; ++i)
+				v[i] = px[i][1];
+			encodeAlphaBlock(v, out+8);
+		}
+		break;
+	default:
+		ASSERT(0);
+		break;
+	}
+}
+
+void decodeBlock(const unsigned char *in, BlockCompression::Format format, Block &px)
+{
+	switch (format)
+	{
+	case BlockCompression::BC1:
+		decodeColorBlock(in, false, px);
+		break;
+	case BlockCompression::BC3:
+		decodeColorBlock(in+8, true, px);
+		decodeAlphaBlock(in, px, 3);
+		break;
+	case BlockCompression::BC4:
+		decodeAlphaBlock(in, px, 0);
+		break;
+	case BlockCompression::BC5:
+		decodeAlphaBlock(in, px, 0);
+		decodeAlphaBlock(in+8, px, 1);
+		break;
+	default:
+		ASSERT(0);
+		break;
+	}
+}
+
+// encodes rows of blocks
+class EncodeJob : public ThreadPool::RangeJob
+{
+	const Image		&m_image;
+	BlockCompression::Format	m_format;
+	unsigned char	*m_pOut;
+	size_t			m_blocksX;
+public:
+	EncodeJob(const Image &image, BlockCompression::Format format, unsigned char *pOut) :
+		m_image(image), m_format(format), m_pOut(pOut), m_blocksX((image.getWidth()+3)/4) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		size_t blockBytes = BlockCompression::getBlockBytes(m_format);
+		Block px;
+		for (size_t by=begin; by<end; ++by)
+			for (size_t bx=0; bx<m_blocksX; ++bx) {
+				fetchBlock(m_image, bx, by, px);
+				encodeBlock(px, m_format, m_pOut + (by*m_blocksX + bx)*blockBytes);
+			}
+	}
+};
+
+// the header of cache files, followed by the data of all levels
+struct CacheHeader {
+	char	magic[4];
+	int32_t	version;
+	int32_t	format;
+	int32_t	width, height;
+	int32_t	levels;
+	int32_t	flags;
+	int32_t	reserved;
+	int64_t	srcSize;		// of the image file it was made from (0 if none)
+	int64_t	srcTime;
+};
+
+const char		CACHE_MAGIC[4] = { 'B', 'T', 'E', 'X' };
+const int32_t	CACHE_VERSION = 1;
+const int32_t	CACHE_SRGB = 1;
+
+// FNV-1a, to tell apart images with the same name in the cache directory
+uint32_t hashString(const std::string &s)
+{
+	uint32_t h = 2166136261u;
+	for (size_t i=0; i<s.size(); ++i) {
+		h ^= (unsigned char)s[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+};
+
+size_t BlockCompression::getChannelsNum(Format format)
+{
+	switch (format) {
+		case BC1:	return 3;
+		case BC3:	return 4;
+		case BC4:	return 1;
+		case BC5:	return 2;
+		default:	ASSERT(0);	break;
+	}
+	return 0;
+}
+
+GLenum BlockCompression::getGLFormat(Format format)
+{
+	switch (format) {
+		case BC1:	return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BC3:	return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		case BC4:	return GL_COMPRESSED_LUMINANCE_LATC1_EXT;
+		case BC5:	return GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT;
+		default:	ASSERT(0);	break;
+	}
+	return 0;
+}
+
+bool BlockCompression::isSupported(Format format)
+{
+	if (format == BC1 || format == BC3)
+		return GLEW_EXT_texture_compression_s3tc != 0;
+	return GLEW_EXT_texture_compression_latc != 0;
+}
+
+bool BlockCompression::chooseFormat(const Image &image, Format &format)
+{
+	if (image.getFormat() != Image::I8BITS || image.isEmpty())
+		return false;
+
+	switch (image.getChannelsNum())
+	{
+	case 1:
+		format = BC4;
+		return true;
+	case 2:
+		format = BC5;
+		return true;
+	case 3:
+		format = BC1;
+		return true;
+	case 4:
+		// use the 6:1 format if the alpha channel is not needed
+		for (size_t y=0; y<image.getHeight(); ++y) {
+			const unsigned char *p = image(0, y);
+			for (size_t x=0; x<image.getWidth(); ++x, p+=4)
+				if (p[3] != 255) {
+					format = BC3;
+					return true;
+				}
+		}
+		format = BC1;
+		return true;
+	}
+	return false;
+}
+
+bool BlockCompression::encode(const Image &image, Format format, unsigned char *out)
+{
+	if (image.getFormat() != Image::I8BITS || image.isEmpty() || image.getChannelsNum() < getChannelsNum(format))
+		return false;
+
+	EncodeJob job(image, format, out);
+	ThreadPool::inst()->parallelFor(job, 0, (image.getHeight()+3)/4, 4);
+	return true;
+}
+
+void BlockCompression::decode(const unsigned char *data, Format format, size_t width, size_t height, Image &out)
+{
+	size_t nChannels = getChannelsNum(format);
+	size_t blocksX = (width+3)/4, blocksY = (height+3)/4;
+	size_t blockBytes = getBlockBytes(format);
+	out.create(width, height, (unsigned char)nChannels);
+
+	Block px;
+	for (size_t by=0; by<blocksY; ++by)
+		for (size_t bx=0; bx<blocksX; ++bx) {
+			decodeBlock(data + (by*blocksX + bx)*blockBytes, format, px);
+			for (size_t j=0; j<4 && by*4+j<height; ++j)
+				for (size_t i=0; i<4 && bx*4+i<width; ++i)
+					memcpy(out(bx*4+i, by*4+j), px[j*4+i], nChannels);
+		}
+}
+
+CompressedImage::CompressedImage() : m_format(BlockCompression::BC1), m_width(0), m_height(0), m_bSRGB(false)
+{
+}
+
+CompressedImage::~CompressedImage()
+{
+}
+
+bool CompressedImage::create(const Image &image, BlockCompression::Format format, bool bMipMaps, bool bSRGB)
+{
+	free();
+	if (image.getFormat() != Image::I8BITS || image.isEmpty() ||
+		image.getChannelsNum() < BlockCompression::getChannelsNum(format))
+		return false;
+
+	m_format = format;
+	m_width = image.getWidth();
+	m_height = image.getHeight();
+	m_bSRGB = bSRGB;
+
+	MipChain chain;
+	if (bMipMaps)
+		chain.create(image, bSRGB);
+	size_t levelsNum = (bMipMaps) ? chain.getLevelsNum() : 1;
+
+	m_offsets.resize(levelsNum+1);
+	m_offsets[0] = 0;
+	for (size_t i=0; i<levelsNum; ++i)
+		m_offsets[i+1] = m_offsets[i] + BlockCompression::getCompressedSize(format, getLevelWidth(i), getLevelHeight(i));
+	m_data.resize(m_offsets.back());
+
+	for (size_t i=0; i<levelsNum; ++i)
+		BlockCompression::encode((bMipMaps) ? chain.getLevel(i) : image, format, &m_data[m_offsets[i]]);
+	return true;
+}
+
+void CompressedImage::free()
+{
+	m_width = m_height = 0;
+	m_data.clear();
+	m_offsets.clear();
+}
+
+void CompressedImage::decode(Image &out, size_t level) const
+{
+	BlockCompression::decode(getLevelData(level), m_format, getLevelWidth(level), getLevelHeight(level), out);
+}
+
+bool CompressedImage::save(const std::string &filename) const
+{
+	return save(filename, 0, 0);
+}
+
+bool CompressedImage::load(const std::string &filename)
+{
+	return load(filename, -1, -1);
+}
+
+bool CompressedImage::save(const std::string &filename, int64_t srcSize, int64_t srcTime) const
+{
+	if (isEmpty())
+		return false;
+
+	CacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CACHE_MAGIC, 4);
+	header.version = CACHE_VERSION;
+	header.format = (int32_t)m_format;
+	header.width = (int32_t)m_width;
+	header.height = (int32_t)m_height;
+	header.levels = (int32_t)getLevelsNum();
+	header.flags = (m_bSRGB) ? CACHE_SRGB : 0;
+	header.srcSize = srcSize;
+	header.srcTime = srcTime;
+
+	FILE *fp = fopen(filename.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool bOk = (fwrite(&header, sizeof(header), 1, fp) == 1 &&
+				fwrite(&m_data[0], 1, m_data.size(), fp) == m_data.size());
+	fclose(fp);
+	return bOk;
+}
+
+bool CompressedImage::load(const std::string &filename, int64_t srcSize, int64_t srcTime)
+{
+	free();
+
+	MappedFile file;
+	if (!file.open(filename) || file.getSize() < sizeof(CacheHeader))
+		return false;
+	CacheHeader header;
+	memcpy(&header, file.getData(), sizeof(header));
+	if (memcmp(header.magic, CACHE_MAGIC, 4) != 0 || header.version != CACHE_VERSION ||
+		header.format < 0 || header.format >= BlockCompression::FORMATS_NUM ||
+		header.width <= 0 || header.height <= 0 || header.levels <= 0 ||
+		header.levels > (int32_t)MipChain::getFullLevelsNum(header.width, header.height))
+		return false;
+	if (srcTime >= 0 && (header.srcSize != srcSize || header.srcTime != srcTime))
+		return false;	// made from an older version of the file
+
+	m_format = (BlockCompression::Format)header.format;
+	m_width = header.width;
+	m_height = header.height;
+	m_bSRGB = (header.flags & CACHE_SRGB) != 0;
+	m_offsets.resize(header.levels+1);
+	m_offsets[0] = 0;
+	for (int32_t i=0; i<header.levels; ++i)
+		m_offsets[i+1] = m_offsets[i] + BlockCompression::getCompressedSize(m_format, getLevelWidth(i), getLevelHeight(i));
+	if (file.getSize() != sizeof(header) + m_offsets.back()) {
+		free();
+		return false;
+	}
+	m_data.assign(file.getData() + sizeof(header), file.getData() + file.getSize());
+	return true;
+}
+
+bool CompressedImage::loadCached(const std::string &imageFile, bool bMipMaps, bool bSRGB, Image *pImage)
+{
+	struct _stat st;
+	if (_stat(imageFile.c_str(), &st) != 0)
+		return false;
+
+	// the cached levels must be the ones asked for
+	std::string cacheFile = getCacheFilename(imageFile);
+	bool bCached = load(cacheFile, (int64_t)st.st_size, (int64_t)st.st_mtime);
+	if (bCached) {
+		size_t levelsNum = (bMipMaps) ? MipChain::getFullLevelsNum(m_width, m_height) : 1;
+		bCached = (getLevelsNum() == levelsNum && (!bMipMaps || m_bSRGB == bSRGB));
+	}
+	if (bCached && !pImage)
+		return true;
+
+	Image tmp;
+	Image &image = (pImage) ? *pImage : tmp;
+	if (!image.load(imageFile))
+		return false;
+	if (bCached)
+		return true;
+
+	BlockCompression::Format format;
+	if (!BlockCompression::chooseFormat(image, format) || !create(image, format, bMipMaps, bSRGB))
+		return false;
+
+	// the cache is only an optimization: if it cannot be written, the image is compressed again next time
+	save(cacheFile, (int64_t)st.st_size, (int64_t)st.st_mtime);
+	return true;
+}
+
+std::string CompressedImage::getCacheFilename(const std::string &imageFile)
+{
+	if (m_cacheDir.empty())
+		return imageFile + ".btc";
+
+	size_t slash = imageFile.find_last_of("/\\");
+	std::string name = (slash == std::string::npos) ? imageFile : imageFile.substr(slash+1);
+	char hash[16];
+	sprintf(hash, ".%08x", hashString(imageFile));
+
+	std::string dir = m_cacheDir;
+	if (dir[dir.size()-1] != '/' && dir[dir.size()-1] != '\\')
+		dir += '/';
+	return dir + name + hash + ".btc";
+}
@@ -0,0 +1,135 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BLOCKCOMPRESSION_H45631_INCLUDED_
+#define _BLOCKCOMPRESSION_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+class Image;
+
+/**
+ * BlockCompression: encoders and decoders for the block compressed texture
+ *		formats. Images are cut in 4x4 blocks, and each block is stored in a
+ *		fixed number of bytes, which the GPU samples directly:
+ *			BC1 (DXT1)	RGB, 8 bytes per block (6:1 for RGB8)
+ *			BC3 (DXT5)	RGBA, 16 bytes per block (4:1 for RGBA8)
+ *			BC4 (LATC1)	one channel, 8 bytes per block (2:1 for L8)
+ *			BC5 (LATC2)	two channels, 16 bytes per block
+ *		One channel images are uploaded as luminance (and two channel ones as
+ *		luminance-alpha), like the uncompressed textures, so BC4/BC5 use the
+ *		LATC formats, which store the blocks exactly like RGTC.
+ *
+ *		Only 8-bit images can be encoded. The encoders fit the colors of each block
+ *		to their principal axis and refine the end points by least squares. Blocks
+ *		are encoded in parallel, in rows of blocks.
+ */
+class BlockCompression
+{
+public:
+	enum Format {
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		FORMATS_NUM
+	};
+
+	static size_t	getBlockBytes(Format format)		{ return (format == BC1 || format == BC4) ? 8 : 16; }
+	static size_t	getCompressedSize(Format format, size_t width, size_t height)	{ return ((width+3)/4)*((height+3)/4)*getBlockBytes(format); }
+	static size_t	getChannelsNum(Format format);		// of the decoded image
+	static GLenum	getGLFormat(Format format);
+	static bool		isSupported(Format format);			// by the GL driver
+
+	// the format for an 8-bit image, by its number of channels. RGBA images with an opaque
+	// alpha channel get BC1. Returns false if the image cannot be compressed.
+	static bool		chooseFormat(const Image &image, Format &format);
+
+	// out must hold getCompressedSize(..) bytes. Edge blocks are padded by repeating the last
+	// row/column. The image needs at least the channels of the format (extra ones are ignored).
+	static bool		encode(const Image &image, Format format, unsigned char *out);
+
+	// decode to an 8-bit image with getChannelsNum(format) channels
+	static void		decode(const unsigned char *data, Format format, size_t width, size_t height, Image &out);
+};
+
+/**
+ * CompressedImage: an image, and optionally its mip levels, in a block compressed
+ *		format, as it is uploaded to a texture (see Texture::create(const CompressedImage&)).
+ *
+ *		Compressing large images takes a while, so the results can be cached on disk:
+ *		loadCached(..) uses the cache file of an image file if the image file did not
+ *		change since it was written, and otherwise loads and compresses the image and
+ *		writes the cache file for the next time. Cache files are kept next to the image
+ *		files (<file>.btc), or in the directory given to setCacheDir(..).
+ */
+class CompressedImage
+{
+private:
+	BlockCompression::Format	m_format;
+	size_t	m_width, m_height;
+	bool	m_bSRGB;						// mip levels were built in linear light
+	std::vector<unsigned char>	m_data;		// all levels, one after the other
+	std::vector<size_t>			m_offsets;	// of each level in m_data, plus the end
+
+	static std::string	m_cacheDir;
+
+public:
+	CompressedImage();
+	virtual ~CompressedImage();
+
+	// compress an 8-bit image, and if bMipMaps is set its mip chain (see MipChain for bSRGB)
+	bool	create(const Image &image, BlockCompression::Format format, bool bMipMaps = false, bool bSRGB = false);
+	void	free();
+
+	bool	isEmpty() const					{ return m_offsets.empty(); }
+	BlockCompression::Format	getFormat() const	{ return m_format; }
+	size_t	getWidth() const				{ return m_width; }
+	size_t	getHeight() const				{ return m_height; }
+	bool	isSRGB() const					{ return m_bSRGB; }
+	size_t	getLevelsNum() const			{ return (m_offsets.empty()) ? 0 : m_offsets.size()-1; }
+	size_t	getLevelWidth(size_t level) const	{ size_t w = m_width>>level; return (w > 0) ? w : 1; }
+	size_t	getLevelHeight(size_t level) const	{ size_t h = m_height>>level; return (h > 0) ? h : 1; }
+	const unsigned char*	getLevelData(size_t level) const	{ ASSERT(level < getLevelsNum()); return &m_data[m_offsets[level]]; }
+	size_t	getLevelBytes(size_t level) const	{ ASSERT(level < getLevelsNum()); return m_offsets[level+1] - m_offsets[level]; }
+	size_t	getSizeBytes() const			{ return m_data.size(); }
+
+	void	decode(Image &out, size_t level = 0) const;
+
+	bool	save(const std::string &filename) const;
+	bool	load(const std::string &filename);
+
+	// load the compressed image of an image file from its cache, or create it (with a format
+	// chosen by BlockCompression::chooseFormat) and update the cache. If pImage is given, the
+	// image file is always loaded to it, too.
+	bool	loadCached(const std::string &imageFile, bool bMipMaps = false, bool bSRGB = false, Image *pImage = 0);
+
+	static void	setCacheDir(const std::string &dir)		{ m_cacheDir = dir; }
+	static const std::string&	getCacheDir()			{ return m_cacheDir; }
+	static std::string	getCacheFilename(const std::string &imageFile);
+
+private:
+	bool	load(const std::string &filename, int64_t srcSize, int64_t srcTime);
+	bool	save(const std::string &filename, int64_t srcSize, int64_t srcTime) const;
+};
+
+#endif
@@ -0,0 +1,524 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BrickCache.h"
+#include "ThreadPool.h"
+#include "TextureBudget.h"
+#include "Profiler.h"
+#include <algorithm>
+
+namespace {
+
+// requests, most important first
+bool byPriority(const std::pair<float, BrickCache::BrickKey> &a, const std::pair<float, BrickCache::BrickKey> &b)
+{
+	return a.first > b.first;
+}
+
+// reads bricks to the slots of a CpuBrickCache
+class LoadJob : public ThreadPool::RangeJob
+{
+	const std::vector<std::pair<BrickCache::BrickKey, size_t> >	&m_loads;
+	std::vector<char>	&m_results;
+	const BrickedVolume	&m_volume;
+	std::vector<unsigned char>	&m_data;
+public:
+	LoadJob(const std::vector<std::pair<BrickCache::BrickKey, size_t> > &loads, std::vector<char> &results,
+			const BrickedVolume &volume, std::vector<unsigned char> &data) :
+		m_loads(loads), m_results(results), m_volume(volume), m_data(data) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t i=begin; i<end; ++i)
+			m_results[i] = m_volume.readBrick(m_loads[i].first, &m_data[m_loads[i].second*m_volume.getBrickBytes()]);
+	}
+};
+
+};
+
+BrickCache::BrickCache() : m_pVolume(0), m_frame(0), m_useCount(0), m_visibleMin(0), m_visibleMax(255)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+BrickCache::~BrickCache()
+{
+}
+
+void BrickCache::create(const BrickedVolume &volume, size_t slotsNum)
+{
+	m_pVolume = &volume;
+	Slot empty;
+	empty.key = 0;
+	empty.bUsed = false;
+	empty.lastFrame = 0;
+	empty.lastUse = 0;
+	empty.priority = 0;
+	m_slots.assign(slotsNum, empty);
+	m_resident.clear();
+	m_requests.clear();
+	m_frame = 0;
+	m_useCount = 0;
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+void BrickCache::free()
+{
+	m_slots.clear();
+	m_resident.clear();
+	m_requests.clear();
+	m_pVolume = 0;
+}
+
+bool BrickCache::isEmpty(BrickKey key) const
+{
+	unsigned char minVal, maxVal;
+	m_pVolume->getBrickRange(key, minVal, maxVal);
+	return maxVal < m_visibleMin || minVal > m_visibleMax;
+}
+
+void BrickCache::beginFrame()
+{
+	m_frame++;
+	m_requests.clear();
+	m_stats.requests = 0;
+	m_stats.hits = 0;
+}
+
+void BrickCache::request(BrickKey key, float priority)
+{
+	m_stats.requests++;
+	SlotMap::const_iterator it = m_resident.find(key);
+	if (it != m_resident.end())
+	{
+		Slot &slot = m_slots[it->second];
+		if (slot.lastFrame != m_frame || slot.priority < priority)
+			slot.priority = priority;
+		slot.lastFrame = m_frame;
+		slot.lastUse = ++m_useCount;
+		m_stats.hits++;
+		return;
+	}
+
+	RequestMap::iterator rit = m_requests.find(key);
+	if (rit == m_requests.end())
+		m_requests.insert(RequestMap::value_type(key, priority));
+	else if (rit->second < priority)
+		rit->second = priority;
+}
+
+void BrickCache::requestView(const Vector3 &eye, const Vector3 &viewDir, float lodScale)
+{
+	if (!m_pVolume || m_pVolume->getLevelsNum() == 0)
+		return;
+
+	Vector3 dir = viewDir;
+	dir.normalize();
+	int coarsest = (int)m_pVolume->getLevelsNum()-1;
+	const BrickedVolume::Level &lv = m_pVolume->getLevel(coarsest);
+	for (int z=0; z<lv.bricksZ; ++z)
+		for (int y=0; y<lv.bricksY; ++y)
+			for (int x=0; x<lv.bricksX; ++x)
+				requestBrick(coarsest, x, y, z, eye, dir, lodScale);
+}
+
+void BrickCache::requestBrick(int level, int x, int y, int z, const Vector3 &eye, const Vector3 &viewDir, float lodScale)
+{
+	BrickKey key = BrickedVolume::makeKey(level, x, y, z);
+	if (isEmpty(key))
+		return;
+
+	// the bounding sphere of the brick, in voxels of level 0
+	float scale = (float)(1 << level);
+	float extent = m_pVolume->getBrickSize()*scale;
+	Vector3 center((x+0.5f)*extent, (y+0.5f)*extent, (z+0.5f)*extent);
+	float radius = 0.87f*extent;
+	Vector3 toBrick = center - eye;
+	float dist = toBrick.length() - radius;
+	if (dist < 0)
+		dist = 0;
+
+	int levelsNum = (int)m_pVolume->getLevelsNum();
+	if (level < levelsNum-1 && toBrick.dot(viewDir) < -radius)
+		return;		// behind the viewer
+
+	request(key, (float)(levelsNum - level) + 1.0f/(1.0f + dist));
+
+	// refine while the voxels of this level are too large for the distance
+	if (level == 0 || scale <= lodScale*dist)
+		return;
+	const BrickedVolume::Level &child = m_pVolume->getLevel(level-1);
+	for (int dz=0; dz<2; ++dz)
+		for (int dy=0; dy<2; ++dy)
+			for (int dx=0; dx<2; ++dx)
+			{
+				int cx = 2*x+dx, cy = 2*y+dy, cz = 2*z+dz;
+				if (cx < child.bricksX && cy < child.bricksY && cz < child.bricksZ)
+					requestBrick(level-1, cx, cy, cz, eye, viewDir, lodScale);
+			}
+}
+
+int BrickCache::findVictim(float priority, unsigned int keepUsesAfter) const
+{
+	// free slots first, then the least recently used bricks that are not needed in this
+	// frame, and last the least important of the ones that are, no more important than
+	// the new one. Ties go to the least recently used.
+	int oldest = -1, leastImportant = -1;
+	for (size_t i=0; i<m_slots.size(); ++i)
+	{
+		const Slot &slot = m_slots[i];
+		if (!slot.bUsed)
+			return (int)i;
+		if (slot.lastUse > keepUsesAfter)
+			continue;
+		if (slot.lastFrame != m_frame) {
+			if (oldest < 0 || slot.lastUse < m_slots[oldest].lastUse)
+				oldest = (int)i;
+		}
+		else if (slot.priority <= priority) {
+			if (leastImportant < 0 || slot.priority < m_slots[leastImportant].priority ||
+				(slot.priority == m_slots[leastImportant].priority && slot.lastUse < m_slots[leastImportant].lastUse))
+				leastImportant = (int)i;
+		}
+	}
+	return (oldest >= 0) ? oldest : leastImportant;
+}
+
+int BrickCache::allocSlot(BrickKey key, float priority, unsigned int keepUsesAfter)
+{
+	int victim = findVictim(priority, keepUsesAfter);
+	if (victim < 0)
+		return -1;
+
+	Slot &slot = m_slots[victim];
+	if (slot.bUsed) {
+		m_resident.erase(slot.key);
+		m_stats.evictions++;
+		onEvict(slot.key, victim);
+	}
+	slot.key = key;
+	slot.bUsed = true;
+	slot.lastFrame = m_frame;
+	slot.lastUse = ++m_useCount;
+	slot.priority = priority;
+	m_resident[key] = victim;
+	return victim;
+}
+
+void BrickCache::releaseSlot(size_t slot)
+{
+	if (!m_slots[slot].bUsed)
+		return;
+	BrickKey key = m_slots[slot].key;
+	m_resident.erase(key);
+	m_slots[slot].bUsed = false;
+	onEvict(key, slot);		// the brick was resident since allocSlot(..), fe. in the indirection table
+}
+
+size_t BrickCache::update(size_t maxLoads)
+{
+	if (m_requests.empty() || maxLoads == 0)
+		return 0;
+
+	std::vector<std::pair<float, BrickKey> > order;
+	order.reserve(m_requests.size());
+	for (RequestMap::const_iterator it = m_requests.begin(); it != m_requests.end(); ++it)
+		if (!isResident(it->first))
+			order.push_back(std::pair<float, BrickKey>(it->second, it->first));
+	std::sort(order.begin(), order.end(), byPriority);
+
+	// assign the slots first, then load them all together (so they must not replace each other)
+	std::vector<std::pair<BrickKey, size_t> > loads;
+	unsigned int firstUse = m_useCount;
+	for (size_t i=0; i<order.size() && loads.size() < maxLoads; ++i)
+	{
+		int slot = allocSlot(order[i].second, order[i].first, firstUse);
+		if (slot < 0)
+			break;	// the rest are less important than everything in the cache
+		loads.push_back(std::pair<BrickKey, size_t>(order[i].second, (size_t)slot));
+	}
+
+	std::vector<char> results(loads.size(), 0);
+	loadBricks(loads, results);
+
+	size_t nLoaded = 0;
+	for (size_t i=0; i<loads.size(); ++i)
+	{
+		if (results[i]) {
+			m_stats.loads++;
+			nLoaded++;
+			onLoad(loads[i].first, loads[i].second);
+		}
+		else {
+			m_stats.failedLoads++;
+			releaseSlot(loads[i].second);
+		}
+		m_requests.erase(loads[i].first);
+	}
+	return nLoaded;
+}
+
+void BrickCache::loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results)
+{
+	for (size_t i=0; i<loads.size(); ++i)
+		results[i] = loadBrick(loads[i].first, loads[i].second);
+}
+
+CpuBrickCache::CpuBrickCache()
+{
+}
+
+CpuBrickCache::~CpuBrickCache()
+{
+}
+
+void CpuBrickCache::create(const BrickedVolume &volume, size_t slotsNum)
+{
+	BrickCache::create(volume, slotsNum);
+	m_data.resize(slotsNum*volume.getBrickBytes());
+}
+
+void CpuBrickCache::free()
+{
+	BrickCache::free();
+	std::vector<unsigned char>().swap(m_data);
+}
+
+const unsigned char* CpuBrickCache::fetch(BrickKey key, float priority)
+{
+	int slot = findSlot(key);
+	if (slot >= 0) {
+		request(key, priority);		// keeps it recently used
+		return getSlotData(slot);
+	}
+
+	slot = allocSlot(key, priority);
+	if (slot < 0)
+		return 0;
+	if (!loadBrick(key, slot)) {
+		m_stats.failedLoads++;
+		releaseSlot(slot);
+		return 0;
+	}
+	m_stats.loads++;
+	onLoad(key, slot);
+	return getSlotData(slot);
+}
+
+bool CpuBrickCache::sample(int x, int y, int z, unsigned char &val) const
+{
+	int b = m_pVolume->getBrickSize(), s = m_pVolume->getStoredBrickSize();
+	for (int level=0; level<(int)m_pVolume->getLevelsNum(); ++level)
+	{
+		int lx = x >> level, ly = y >> level, lz = z >> level;
+		int slot = findSlot(BrickedVolume::makeKey(level, lx/b, ly/b, lz/b));
+		if (slot < 0)
+			continue;
+		int border = m_pVolume->getBorder();
+		const unsigned char *data = getSlotData(slot);
+		val = data[((size_t)(lz%b + border)*s + (ly%b + border))*s + (lx%b + border)];
+		return true;
+	}
+	return false;
+}
+
+void CpuBrickCache::loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results)
+{
+	LoadJob job(loads, results, *m_pVolume, m_data);
+	ThreadPool::inst()->parallelFor(job, 0, loads.size(), 1);
+}
+
+bool CpuBrickCache::loadBrick(BrickKey key, size_t slot)
+{
+	return m_pVolume->readBrick(key, &m_data[slot*m_pVolume->getBrickBytes()]);
+}
+
+GpuBrickCache::GpuBrickCache() : m_pSource(0), m_atlas(0), m_indirection(0), m_slotsX(0), m_slotsY(0), m_slotsZ(0), m_bTableDirty(false)
+{
+}
+
+GpuBrickCache::~GpuBrickCache()
+{
+	free();
+}
+
+bool GpuBrickCache::create(CpuBrickCache &source, int slotsX, int slotsY, int slotsZ)
+{
+	free();
+	const BrickedVolume *pVolume = source.getVolume();
+	if (!pVolume || slotsX <= 0 || slotsY <= 0 || slotsZ <= 0 || slotsX > 255 || slotsY > 255 || slotsZ > 255)
+		return false;
+
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+	int s = pVolume->getStoredBrickSize();
+	const BrickedVolume::Level &lv = pVolume->getLevel(0);
+	if (slotsX*s > maxSize || slotsY*s > maxSize || slotsZ*s > maxSize ||
+		lv.bricksX > maxSize || lv.bricksY > maxSize || lv.bricksZ > maxSize)
+	{
+		Console::error("GpuBrickCache::create(): the atlas or the indirection table is larger than the maximum 3D texture size (%d)\n", maxSize);
+		return false;
+	}
+
+	BrickCache::create(*pVolume, (size_t)slotsX*slotsY*slotsZ);
+	m_pSource = &source;
+	m_slotsX = slotsX;
+	m_slotsY = slotsY;
+	m_slotsZ = slotsZ;
+
+	// the atlas: filtered, but never across bricks, since they have a border
+	glGenTextures(1, &m_atlas);
+	glBindTexture(GL_TEXTURE_3D, m_atlas);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_LUMINANCE8, getAtlasWidth(), getAtlasHeight(), getAtlasDepth(), 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+
+	// the indirection table, with no bricks yet
+	m_table.resize((size_t)lv.bricksX*lv.bricksY*lv.bricksZ*4);
+	for (size_t i=0; i<m_table.size(); i+=4) {
+		m_table[i] = m_table[i+1] = m_table[i+2] = 0;
+		m_table[i+3] = 255;
+	}
+	glGenTextures(1, &m_indirection);
+	glBindTexture(GL_TEXTURE_3D, m_indirection);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, lv.bricksX, lv.bricksY, lv.bricksZ, 0, GL_RGBA, GL_UNSIGNED_BYTE, &m_table[0]);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	m_bTableDirty = false;
+
+	// the cache manages its own memory, so the budget must not evict it
+	TextureBudget::inst()->add(m_atlas, GL_TEXTURE_3D);
+	TextureBudget::inst()->setPriority(m_atlas, 1.0);
+	TextureBudget::inst()->add(m_indirection, GL_TEXTURE_3D);
+	TextureBudget::inst()->setPriority(m_indirection, 1.0);
+
+	return m_atlas != 0 && m_indirection != 0;
+}
+
+void GpuBrickCache::free()
+{
+	if (m_atlas) {
+		TextureBudget::inst()->remove(m_atlas);
+		glDeleteTextures(1, &m_atlas);
+		m_atlas = 0;
+	}
+	if (m_indirection) {
+		TextureBudget::inst()->remove(m_indirection);
+		glDeleteTextures(1, &m_indirection);
+		m_indirection = 0;
+	}
+	m_table.clear();
+	m_pSource = 0;
+	BrickCache::free();
+}
+
+void GpuBrickCache::loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results)
+{
+	// read all the bricks of this update into the cpu cache at once (in parallel), then upload them
+	m_pSource->beginFrame();
+	for (size_t i=0; i<loads.size(); ++i)
+		m_pSource->request(loads[i].first, m_slots[loads[i].second].priority);
+	m_pSource->update(loads.size());
+
+	for (size_t i=0; i<loads.size(); ++i)
+		results[i] = loadBrick(loads[i].first, loads[i].second);
+}
+
+bool GpuBrickCache::loadBrick(BrickKey key, size_t slot)
+{
+	const unsigned char *data = m_pSource->fetch(key, m_slots[slot].priority);
+	if (!data)
+		return false;
+
+	int s = m_pVolume->getStoredBrickSize();
+	int sx = (int)(slot % m_slotsX), sy = (int)((slot / m_slotsX) % m_slotsY), sz = (int)(slot / (m_slotsX*m_slotsY));
+
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+	PROFILE_COUNT(UPLOAD_BYTES, (int)m_pVolume->getBrickBytes());
+	glBindTexture(GL_TEXTURE_3D, m_atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, sx*s, sy*s, sz*s, s, s, s, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	return true;
+}
+
+void GpuBrickCache::onEvict(BrickKey key, size_t slot)
+{
+	updateTable(key);
+}
+
+void GpuBrickCache::onLoad(BrickKey key, size_t slot)
+{
+	updateTable(key);
+}
+
+void GpuBrickCache::updateTable(BrickKey key)
+{
+	int level = BrickedVolume::keyLevel(key);
+	const BrickedVolume::Level &lv = m_pVolume->getLevel(0);
+	int x0 = BrickedVolume::keyX(key) << level, x1 = std::min((BrickedVolume::keyX(key)+1) << level, lv.bricksX);
+	int y0 = BrickedVolume::keyY(key) << level, y1 = std::min((BrickedVolume::keyY(key)+1) << level, lv.bricksY);
+	int z0 = BrickedVolume::keyZ(key) << level, z1 = std::min((BrickedVolume::keyZ(key)+1) << level, lv.bricksZ);
+
+	// each brick of level 0 under it points to its finest resident brick
+	int levelsNum = (int)m_pVolume->getLevelsNum();
+	for (int z=z0; z<z1; ++z)
+		for (int y=y0; y<y1; ++y)
+			for (int x=x0; x<x1; ++x)
+			{
+				unsigned char *entry = &m_table[(((size_t)z*lv.bricksY + y)*lv.bricksX + x)*4];
+				entry[0] = entry[1] = entry[2] = 0;
+				entry[3] = 255;
+				for (int l=0; l<levelsNum; ++l)
+				{
+					int slot = findSlot(BrickedVolume::makeKey(l, x >> l, y >> l, z >> l));
+					if (slot >= 0) {
+						entry[0] = (unsigned char)(slot % m_slotsX);
+						entry[1] = (unsigned char)((slot / m_slotsX) % m_slotsY);
+						entry[2] = (unsigned char)(slot / (m_slotsX*m_slotsY));
+						entry[3] = (unsigned char)l;
+						break;
+					}
+				}
+			}
+	m_bTableDirty = true;
+}
+
+void GpuBrickCache::updateIndirection()
+{
+	if (!m_bTableDirty || !m_indirection)
+		return;
+
+	const BrickedVolume::Level &lv = m_pVolume->getLevel(0);
+	PROFILE_COUNT(UPLOAD_BYTES, (int)m_table.size());
+	glBindTexture(GL_TEXTURE_3D, m_indirection);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, lv.bricksX, lv.bricksY, lv.bricksZ, GL_RGBA, GL_UNSIGNED_BYTE, &m_table[0]);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	m_bTableDirty = false;
+}
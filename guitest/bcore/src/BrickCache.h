@@ -0,0 +1,214 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BRICKCACHE_H45631_INCLUDED_
+#define _BRICKCACHE_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "BrickedVolume.h"
+#include <hash_map>
+#include <limits.h>
+
+/**
+ * BrickCache: keeps a fixed number of bricks of a BrickedVolume resident in
+ *		slots, and decides which bricks to load and which to evict.
+ *
+ *		Every frame, the bricks that are needed are requested with a priority
+ *		(between beginFrame() and update()), either one by one or for a view with
+ *		requestView(..). update(..) then loads the most important missing bricks,
+ *		replacing the least recently used bricks that were not requested in this
+ *		frame, or else the least important ones (the least recently used of them, if
+ *		their priorities are equal), and loads at most maxLoads bricks per call, so
+ *		that streaming a large volume is spread over several frames. Code that never
+ *		calls beginFrame() still gets the least recently used bricks replaced.
+ *
+ *		The cache itself does not store anything: subclasses load the bricks to
+ *		their slots (CpuBrickCache to memory, GpuBrickCache to a texture).
+ */
+class BrickCache
+{
+public:
+	typedef BrickedVolume::BrickKey BrickKey;
+
+	struct Stats {
+		size_t	requests;			// in the last frame
+		size_t	hits;				// requests of resident bricks, in the last frame
+		size_t	loads, evictions;	// since the start
+		size_t	failedLoads;
+	};
+
+protected:
+	struct Slot {
+		BrickKey		key;
+		bool			bUsed;
+		unsigned int	lastFrame;		// when it was last requested
+		unsigned int	lastUse;		// m_useCount then, to order the requests of one frame
+		float			priority;		// in that frame
+	};
+	typedef stdext::hash_map<BrickKey, size_t>	SlotMap;
+	typedef stdext::hash_map<BrickKey, float>	RequestMap;
+
+	const BrickedVolume	*m_pVolume;
+	std::vector<Slot>	m_slots;
+	SlotMap				m_resident;			// slot of each resident brick
+	RequestMap			m_requests;			// missing bricks requested in this frame
+	unsigned int		m_frame;
+	unsigned int		m_useCount;			// of slots, since the start
+	int					m_visibleMin, m_visibleMax;	// bricks outside this value range are empty
+	Stats				m_stats;
+
+public:
+	BrickCache();
+	virtual ~BrickCache();
+
+	void	create(const BrickedVolume &volume, size_t slotsNum);
+	virtual void	free();
+
+	const BrickedVolume*	getVolume() const	{ return m_pVolume; }
+	size_t	getSlotsNum() const					{ return m_slots.size(); }
+	size_t	getResidentNum() const				{ return m_resident.size(); }
+	const Stats&	getStats() const			{ return m_stats; }
+
+	int		findSlot(BrickKey key) const		{ SlotMap::const_iterator it = m_resident.find(key); return (it != m_resident.end()) ? (int)it->second : -1; }
+	bool	isResident(BrickKey key) const		{ return m_resident.find(key) != m_resident.end(); }
+	BrickKey	getSlotKey(size_t slot) const	{ return m_slots[slot].key; }
+
+	// voxel values that are drawn: bricks with no values in [minVal,maxVal] are never requested by requestView
+	void	setVisibleRange(int minVal, int maxVal)	{ m_visibleMin = minVal; m_visibleMax = maxVal; }
+	bool	isEmpty(BrickKey key) const;
+
+	void	beginFrame();
+	void	request(BrickKey key, float priority);
+
+	// request the bricks for a view from eye (in voxels of level 0), looking along viewDir.
+	// Each region is requested at the coarsest level with voxels no larger than
+	// lodScale*distance (fe. the angle of a pixel, in radians). Coarser bricks come first,
+	// so that there is always something to draw, then nearer ones. The coarsest level is
+	// always requested whole.
+	void	requestView(const Vector3 &eye, const Vector3 &viewDir, float lodScale);
+
+	// load up to maxLoads of the missing requested bricks. Returns the number loaded.
+	size_t	update(size_t maxLoads);
+
+protected:
+	// load a brick to a slot. The loads of one update() may be done in parallel.
+	virtual void	loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results);
+	virtual bool	loadBrick(BrickKey key, size_t slot) = 0;
+	virtual void	onEvict(BrickKey key, size_t slot) { }
+	virtual void	onLoad(BrickKey key, size_t slot) { }
+
+	// take a slot for a brick, evicting the brick in it. -1 if all slots hold more important bricks.
+	// Bricks used after keepUsesAfter are not evicted, fe. the ones loaded by the same update().
+	int		allocSlot(BrickKey key, float priority, unsigned int keepUsesAfter = UINT_MAX);
+	void	releaseSlot(size_t slot);	// fe. after a failed load; calls onEvict(..)
+
+private:
+	int		findVictim(float priority, unsigned int keepUsesAfter) const;
+	void	requestBrick(int level, int x, int y, int z, const Vector3 &eye, const Vector3 &viewDir, float lodScale);
+};
+
+/**
+ * CpuBrickCache: a brick cache in system memory. Works without GL, and is also
+ *		the source of the bricks of a GpuBrickCache. Bricks are read from the page
+ *		file in parallel.
+ */
+class CpuBrickCache : public BrickCache
+{
+private:
+	std::vector<unsigned char>	m_data;		// the bricks of all slots
+
+public:
+	CpuBrickCache();
+	virtual ~CpuBrickCache();
+
+	void	create(const BrickedVolume &volume, size_t slotsNum);
+	virtual void	free();
+
+	const unsigned char*	getSlotData(size_t slot) const	{ return &m_data[slot*m_pVolume->getBrickBytes()]; }
+
+	// the voxels of a brick, loaded now if it is not resident (0 if it fails). The
+	// pointer is valid until the next call that loads bricks.
+	const unsigned char*	fetch(BrickKey key, float priority = 1.0f);
+
+	// the voxel of level 0 at (x,y,z), if its brick is resident at any level (from the finest)
+	bool	sample(int x, int y, int z, unsigned char &val) const;
+
+protected:
+	virtual void	loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results);
+	virtual bool	loadBrick(BrickKey key, size_t slot);
+};
+
+/**
+ * GpuBrickCache: a brick cache in video memory, for rendering volumes that do not
+ *		fit in a 3D texture. Resident bricks are kept in the slots of an atlas
+ *		(a 3D texture of slotsX x slotsY x slotsZ bricks), and an indirection
+ *		texture with one texel per brick of level 0 points to the finest resident
+ *		brick that covers it: RGB is the slot (x, y, z) and A the level (255 if no
+ *		brick covering it is resident).
+ *
+ *		To sample the volume at p (in voxels of level 0), a shader reads the
+ *		indirection texel of brick floor(p/brickSize), and with level l and slot s
+ *		reads the atlas at
+ *			(s*storedBrickSize + border + frac(p/(brickSize*2^l))*brickSize) / atlasSize
+ *
+ *		Bricks come from a CpuBrickCache, which should be large enough to hold
+ *		the bricks of a few frames.
+ */
+class GpuBrickCache : public BrickCache
+{
+private:
+	CpuBrickCache	*m_pSource;
+	GLuint	m_atlas;
+	GLuint	m_indirection;
+	int		m_slotsX, m_slotsY, m_slotsZ;
+	std::vector<unsigned char>	m_table;	// the contents of the indirection texture
+	bool	m_bTableDirty;
+
+public:
+	GpuBrickCache();
+	virtual ~GpuBrickCache();
+
+	// slots are limited by the size of 3D textures. Returns false if the textures cannot be created.
+	bool	create(CpuBrickCache &source, int slotsX, int slotsY, int slotsZ);
+	virtual void	free();
+
+	// after update(): upload the changes of the indirection texture
+	void	updateIndirection();
+
+	GLuint	getAtlasTexture() const			{ return m_atlas; }
+	GLuint	getIndirectionTexture() const	{ return m_indirection; }
+	int		getAtlasWidth() const			{ return m_slotsX*m_pVolume->getStoredBrickSize(); }
+	int		getAtlasHeight() const			{ return m_slotsY*m_pVolume->getStoredBrickSize(); }
+	int		getAtlasDepth() const			{ return m_slotsZ*m_pVolume->getStoredBrickSize(); }
+
+protected:
+	virtual void	loadBricks(const std::vector<std::pair<BrickKey, size_t> > &loads, std::vector<char> &results);
+	virtual bool	loadBrick(BrickKey key, size_t slot);
+	virtual void	onEvict(BrickKey key, size_t slot);
+	virtual void	onLoad(BrickKey key, size_t slot);
+
+private:
+	void	updateTable(BrickKey key);	// the entries of the bricks of level 0 under this one
+};
+
+#endif
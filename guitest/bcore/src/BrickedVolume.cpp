@@ -0,0 +1,575 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BrickedVolume.h"
+#include "ThreadPool.h"
+#include <deque>
+#ifndef _WIN32
+#include <fcntl.h>
+#endif
+
+namespace {
+
+struct PageHeader {
+	char	magic[4];
+	int32_t	version;
+	int32_t	width, height, depth;
+	int32_t	brickSize;
+	int32_t	border;
+	int32_t	levelsNum;
+	uint64_t	dataOffset;
+	uint64_t	bricksNum;
+};
+
+struct LevelRecord {
+	int32_t	width, height, depth;
+	int32_t	bricksX, bricksY, bricksZ;
+	uint64_t	firstBrick;
+};
+
+const char		PAGE_MAGIC[4] = { 'B', 'V', 'O', 'L' };
+const int32_t	PAGE_VERSION = 1;
+const uint64_t	PAGE_ALIGNMENT = 4096;	// of the first brick
+
+inline int clampi(int v, int lo, int hi)	{ return (v < lo) ? lo : ((v > hi) ? hi : v); }
+
+// the bricks of every level must be within the brick tables, or brickIndex(..) would read
+// past them
+bool checkLevels(const PageHeader &header, const std::vector<LevelRecord> &records)
+{
+	for (size_t i=0; i<records.size(); ++i)
+	{
+		const LevelRecord &r = records[i];
+		if (r.bricksX <= 0 || r.bricksY <= 0 || r.bricksZ <= 0)
+			return false;
+		uint64_t n = (uint64_t)r.bricksX*r.bricksY*r.bricksZ;
+		if (r.firstBrick > header.bricksNum || n > header.bricksNum - r.firstBrick)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * P7Source: the slices of a P7 volume file, read in order
+ */
+class P7Source : public BrickedVolume::SliceSource
+{
+	FILE	*m_fp;
+	size_t	m_sliceBytes;
+public:
+	int		m_width, m_height, m_depth;
+
+	P7Source() : m_fp(0), m_sliceBytes(0), m_width(0), m_height(0), m_depth(0) { }
+	~P7Source()		{ if (m_fp) fclose(m_fp); }
+
+	bool open(const std::string &fname) {
+		m_fp = fopen(fname.c_str(), "rb");
+		if (!m_fp)
+			return false;
+
+		// the same header that Texture3D::load reads
+		char str[100], imageType[100];
+		if (!fgets(str, 100, m_fp) || sscanf(str, "%s", imageType) != 1 || strncmp(imageType, "P7", 2))
+			return false;
+		if (!fgets(str, 100, m_fp))
+			return false;
+		while (str[0] == '#')
+			if (!fgets(str, 100, m_fp))
+				return false;
+		if (sscanf(str, "%d %d %d", &m_width, &m_height, &m_depth) != 3 || m_width <= 0 || m_height <= 0 || m_depth <= 0)
+			return false;
+		if (!fgets(str, 100, m_fp))
+			return false;
+		m_sliceBytes = (size_t)m_width*m_height;
+		return true;
+	}
+
+	virtual bool readSlice(int z, unsigned char *dst) {
+		return fread(dst, 1, m_sliceBytes, m_fp) == m_sliceBytes;
+	}
+};
+
+class MemorySource : public BrickedVolume::SliceSource
+{
+	const unsigned char	*m_pVoxels;
+	size_t	m_sliceBytes;
+public:
+	MemorySource(const unsigned char *voxels, int width, int height) : m_pVoxels(voxels), m_sliceBytes((size_t)width*height) { }
+
+	virtual bool readSlice(int z, unsigned char *dst) {
+		memcpy(dst, m_pVoxels + z*m_sliceBytes, m_sliceBytes);
+		return true;
+	}
+};
+
+/**
+ * PageWriter: writes the bricks of all levels as the slices of level 0 come in.
+ *		Each level keeps only the slices that the next row of bricks needs, and
+ *		passes averaged pairs of slices on to the next level.
+ */
+class PageWriter
+{
+	struct LevelState {
+		std::deque<std::vector<unsigned char> >	slices;
+		int		firstZ;			// of slices[0]
+		int		received;
+		int		nextBrickZ;		// the next row of bricks to write
+		LevelState() : firstZ(0), received(0), nextBrickZ(0) { }
+	};
+
+	const std::vector<BrickedVolume::Level>	&m_levels;
+	int		m_brickSize, m_border, m_stored;
+	size_t	m_brickBytes;
+	FILE	*m_fp;
+	uint64_t	m_dataOffset;
+	std::vector<unsigned char>	&m_ranges;
+	std::vector<LevelState>		m_states;
+	std::vector<unsigned char>	m_row;		// a row of bricks along x
+	bool	m_bOk;
+
+	class FillJob : public ThreadPool::RangeJob {
+		PageWriter	&m_writer;
+		size_t		m_level;
+		int			m_by, m_bz;
+	public:
+		FillJob(PageWriter &writer, size_t level, int by, int bz) : m_writer(writer), m_level(level), m_by(by), m_bz(bz) { }
+		virtual void processRange(size_t begin, size_t end) {
+			for (size_t bx=begin; bx<end; ++bx)
+				m_writer.fillBrick(m_level, (int)bx, m_by, m_bz);
+		}
+	};
+
+public:
+	PageWriter(const std::vector<BrickedVolume::Level> &levels, int brickSize, int border, FILE *fp, uint64_t dataOffset, std::vector<unsigned char> &ranges) :
+		m_levels(levels), m_brickSize(brickSize), m_border(border), m_stored(brickSize + 2*border),
+		m_fp(fp), m_dataOffset(dataOffset), m_ranges(ranges), m_states(levels.size()), m_bOk(true)
+	{
+		m_brickBytes = (size_t)m_stored*m_stored*m_stored;
+	}
+
+	bool isOk() const {
+		for (size_t i=0; i<m_levels.size(); ++i)
+			if (m_states[i].nextBrickZ != m_levels[i].bricksZ)
+				return false;
+		return m_bOk;
+	}
+
+	void addSlice(size_t level, std::vector<unsigned char> &slice)
+	{
+		LevelState &st = m_states[level];
+		const BrickedVolume::Level &lv = m_levels[level];
+		int z = st.received++;
+		st.slices.push_back(std::vector<unsigned char>());
+		st.slices.back().swap(slice);
+
+		// the next level gets the average of each pair of slices (the last one alone, if the depth is odd)
+		if (level+1 < m_levels.size() && (z % 2 == 1 || z == lv.depth-1))
+		{
+			const std::vector<unsigned char> &a = st.slices[(z % 2 == 1) ? st.slices.size()-2 : st.slices.size()-1];
+			const std::vector<unsigned char> &b = st.slices.back();
+			std::vector<unsigned char> half;
+			downsample(a, b, lv.width, lv.height, half);
+			addSlice(level+1, half);
+		}
+
+		// write the rows of bricks that have all their slices
+		while (st.nextBrickZ < lv.bricksZ)
+		{
+			int zLast = std::min(lv.depth-1, (st.nextBrickZ+1)*m_brickSize + m_border - 1);
+			if (z < zLast)
+				break;
+			writeBrickRow(level, st.nextBrickZ);
+			st.nextBrickZ++;
+
+			int keepFrom = std::min(st.nextBrickZ*m_brickSize - m_border, z);
+			while (st.firstZ < keepFrom) {
+				st.slices.pop_front();
+				st.firstZ++;
+			}
+		}
+	}
+
+	void fillBrick(size_t level, int bx, int by, int bz)
+	{
+		const LevelState &st = m_states[level];
+		const BrickedVolume::Level &lv = m_levels[level];
+		unsigned char *dst = &m_row[bx*m_brickBytes];
+		int x0 = bx*m_brickSize - m_border;
+		bool bInside = (x0 >= 0 && x0 + m_stored <= lv.width);
+
+		for (int k=0; k<m_stored; ++k)
+		{
+			int z = clampi(bz*m_brickSize - m_border + k, 0, lv.depth-1);
+			const unsigned char *slice = &st.slices[z - st.firstZ][0];
+			for (int j=0; j<m_stored; ++j, dst += m_stored)
+			{
+				const unsigned char *row = slice + (size_t)clampi(by*m_brickSize - m_border + j, 0, lv.height-1)*lv.width;
+				if (bInside)
+					memcpy(dst, row + x0, m_stored);
+				else
+					for (int i=0; i<m_stored; ++i)
+						dst[i] = row[clampi(x0+i, 0, lv.width-1)];
+			}
+		}
+
+		// the value range, for empty space skipping
+		const unsigned char *p = &m_row[bx*m_brickBytes];
+		unsigned char minVal = 255, maxVal = 0;
+		for (size_t i=0; i<m_brickBytes; ++i) {
+			if (p[i] < minVal) minVal = p[i];
+			if (p[i] > maxVal) maxVal = p[i];
+		}
+		size_t index = lv.firstBrick + ((size_t)bz*lv.bricksY + by)*lv.bricksX + bx;
+		m_ranges[2*index] = minVal;
+		m_ranges[2*index+1] = maxVal;
+	}
+
+private:
+	void writeBrickRow(size_t level, int bz)
+	{
+		const BrickedVolume::Level &lv = m_levels[level];
+		m_row.resize(lv.bricksX*m_brickBytes);
+		for (int by=0; by<lv.bricksY; ++by)
+		{
+			FillJob job(*this, level, by, bz);
+			ThreadPool::inst()->parallelFor(job, 0, lv.bricksX, 1);
+
+			// the bricks of a row are consecutive in the file
+			uint64_t index = lv.firstBrick + ((uint64_t)bz*lv.bricksY + by)*lv.bricksX;
+			if (_fseeki64(m_fp, m_dataOffset + index*m_brickBytes, SEEK_SET) != 0 ||
+				fwrite(&m_row[0], 1, m_row.size(), m_fp) != m_row.size())
+				m_bOk = false;
+		}
+	}
+
+	static void downsample(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b, int width, int height,
+						   std::vector<unsigned char> &half)
+	{
+		int hw = (width+1)/2, hh = (height+1)/2;
+		half.resize((size_t)hw*hh);
+		for (int y=0; y<hh; ++y)
+		{
+			size_t r0 = (size_t)(2*y)*width, r1 = (size_t)std::min(2*y+1, height-1)*width;
+			unsigned char *dst = &half[(size_t)y*hw];
+			for (int x=0; x<hw; ++x)
+			{
+				int x0 = 2*x, x1 = std::min(2*x+1, width-1);
+				int sum = a[r0+x0] + a[r0+x1] + a[r1+x0] + a[r1+x1] +
+						  b[r0+x0] + b[r0+x1] + b[r1+x0] + b[r1+x1];
+				dst[x] = (unsigned char)((sum + 4) >> 3);
+			}
+		}
+	}
+};
+
+};
+
+BrickedVolume::BrickedVolume() : m_width(0), m_height(0), m_depth(0), m_brickSize(0), m_border(0), m_dataOffset(0),
+#ifdef _WIN32
+	m_hFile(INVALID_HANDLE_VALUE), m_hMapping(0), m_granularity(0)
+#else
+	m_fd(-1)
+#endif
+{
+}
+
+BrickedVolume::~BrickedVolume()
+{
+	close();
+}
+
+void BrickedVolume::computeLevels(int width, int height, int depth, int brickSize, std::vector<Level> &levels)
+{
+	levels.clear();
+	size_t firstBrick = 0;
+	for (;;)
+	{
+		Level lv;
+		lv.width = width;
+		lv.height = height;
+		lv.depth = depth;
+		lv.bricksX = (width + brickSize-1) / brickSize;
+		lv.bricksY = (height + brickSize-1) / brickSize;
+		lv.bricksZ = (depth + brickSize-1) / brickSize;
+		lv.firstBrick = firstBrick;
+		levels.push_back(lv);
+		firstBrick += (size_t)lv.bricksX*lv.bricksY*lv.bricksZ;
+
+		if (lv.bricksX == 1 && lv.bricksY == 1 && lv.bricksZ == 1)
+			break;
+		width = (width+1)/2;
+		height = (height+1)/2;
+		depth = (depth+1)/2;
+	}
+}
+
+bool BrickedVolume::build(const std::string &volumeFile, const std::string &pageFile, int brickSize, int border)
+{
+	P7Source src;
+	if (!src.open(volumeFile)) {
+		Console::error("BrickedVolume::build(): cannot read volume file %s\n", volumeFile.c_str());
+		return false;
+	}
+	return build(src, src.m_width, src.m_height, src.m_depth, pageFile, brickSize, border);
+}
+
+bool BrickedVolume::build(const unsigned char *voxels, int width, int height, int depth, const std::string &pageFile, int brickSize, int border)
+{
+	MemorySource src(voxels, width, height);
+	return build(src, width, height, depth, pageFile, brickSize, border);
+}
+
+bool BrickedVolume::build(SliceSource &src, int width, int height, int depth, const std::string &pageFile, int brickSize, int border)
+{
+	if (width <= 0 || height <= 0 || depth <= 0 || brickSize <= 0 || border < 0 || border > brickSize ||
+		(width-1)/brickSize > 0xffff || (height-1)/brickSize > 0xffff || (depth-1)/brickSize > 0xffff)
+	{
+		Console::error("BrickedVolume::build(): invalid volume size or brick size\n");
+		return false;
+	}
+
+	std::vector<Level> levels;
+	computeLevels(width, height, depth, brickSize, levels);
+	uint64_t bricksNum = levels.back().firstBrick + (uint64_t)levels.back().bricksX*levels.back().bricksY*levels.back().bricksZ;
+
+	PageHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PAGE_MAGIC, 4);
+	header.version = PAGE_VERSION;
+	header.width = width;
+	header.height = height;
+	header.depth = depth;
+	header.brickSize = brickSize;
+	header.border = border;
+	header.levelsNum = (int32_t)levels.size();
+	header.bricksNum = bricksNum;
+	uint64_t tablesEnd = sizeof(header) + levels.size()*sizeof(LevelRecord) + 2*bricksNum;
+	header.dataOffset = (tablesEnd + PAGE_ALIGNMENT-1) / PAGE_ALIGNMENT * PAGE_ALIGNMENT;
+
+	FILE *fp = fopen(pageFile.c_str(), "wb");
+	if (!fp) {
+		Console::error("BrickedVolume::build(): cannot create %s\n", pageFile.c_str());
+		return false;
+	}
+
+	// stream the slices through the writer
+	std::vector<unsigned char> ranges((size_t)(2*bricksNum));
+	PageWriter writer(levels, brickSize, border, fp, header.dataOffset, ranges);
+	bool bOk = true;
+	for (int z=0; z<depth && bOk; ++z)
+	{
+		std::vector<unsigned char> slice((size_t)width*height);
+		bOk = src.readSlice(z, &slice[0]);
+		if (bOk)
+			writer.addSlice(0, slice);
+	}
+	bOk = bOk && writer.isOk();
+
+	// the tables go before the bricks
+	if (bOk)
+	{
+		std::vector<LevelRecord> records(levels.size());
+		for (size_t i=0; i<levels.size(); ++i) {
+			records[i].width = levels[i].width;
+			records[i].height = levels[i].height;
+			records[i].depth = levels[i].depth;
+			records[i].bricksX = levels[i].bricksX;
+			records[i].bricksY = levels[i].bricksY;
+			records[i].bricksZ = levels[i].bricksZ;
+			records[i].firstBrick = levels[i].firstBrick;
+		}
+		bOk = (_fseeki64(fp, 0, SEEK_SET) == 0 &&
+			   fwrite(&header, sizeof(header), 1, fp) == 1 &&
+			   fwrite(&records[0], sizeof(LevelRecord), records.size(), fp) == records.size() &&
+			   fwrite(&ranges[0], 1, ranges.size(), fp) == ranges.size());
+	}
+	if (fclose(fp) != 0)
+		bOk = false;
+
+	if (!bOk) {
+		Console::error("BrickedVolume::build(): failed to write %s\n", pageFile.c_str());
+		remove(pageFile.c_str());
+	}
+	return bOk;
+}
+
+bool BrickedVolume::open(const std::string &pageFile)
+{
+	close();
+
+#ifdef _WIN32
+	m_hFile = CreateFileA(pageFile.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, 0);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	// read the tables
+	PageHeader header;
+	DWORD got = 0;
+	bool bOk = (ReadFile(m_hFile, &header, sizeof(header), &got, 0) && got == sizeof(header) &&
+				memcmp(header.magic, PAGE_MAGIC, 4) == 0 && header.version == PAGE_VERSION &&
+				header.levelsNum > 0 && header.levelsNum < 32 && header.brickSize > 0 && header.border >= 0);
+	std::vector<LevelRecord> records;
+	if (bOk) {
+		records.resize(header.levelsNum);
+		DWORD bytes = (DWORD)(records.size()*sizeof(LevelRecord));
+		bOk = (ReadFile(m_hFile, &records[0], bytes, &got, 0) && got == bytes &&
+				checkLevels(header, records));
+	}
+	if (bOk) {
+		m_ranges.resize((size_t)(2*header.bricksNum));
+		DWORD bytes = (DWORD)m_ranges.size();
+		bOk = (ReadFile(m_hFile, &m_ranges[0], bytes, &got, 0) && got == bytes);
+	}
+#else
+	m_fd = ::open(pageFile.c_str(), O_RDONLY);
+	if (m_fd < 0)
+		return false;
+	posix_fadvise(m_fd, 0, 0, POSIX_FADV_RANDOM);
+
+	// read the tables
+	PageHeader header;
+	bool bOk = (::read(m_fd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+				memcmp(header.magic, PAGE_MAGIC, 4) == 0 && header.version == PAGE_VERSION &&
+				header.levelsNum > 0 && header.levelsNum < 32 && header.brickSize > 0 && header.border >= 0);
+	std::vector<LevelRecord> records;
+	if (bOk) {
+		records.resize(header.levelsNum);
+		size_t bytes = records.size()*sizeof(LevelRecord);
+		bOk = (::read(m_fd, &records[0], bytes) == (ssize_t)bytes &&
+				checkLevels(header, records));
+	}
+	if (bOk) {
+		m_ranges.resize((size_t)(2*header.bricksNum));
+		size_t bytes = m_ranges.size();
+		bOk = (::read(m_fd, &m_ranges[0], bytes) == (ssize_t)bytes);
+	}
+#endif
+
+	m_width = header.width;
+	m_height = header.height;
+	m_depth = header.depth;
+	m_brickSize = header.brickSize;
+	m_border = header.border;
+	m_dataOffset = header.dataOffset;
+	m_levels.resize(records.size());
+	for (size_t i=0; i<records.size(); ++i) {
+		m_levels[i].width = records[i].width;
+		m_levels[i].height = records[i].height;
+		m_levels[i].depth = records[i].depth;
+		m_levels[i].bricksX = records[i].bricksX;
+		m_levels[i].bricksY = records[i].bricksY;
+		m_levels[i].bricksZ = records[i].bricksZ;
+		m_levels[i].firstBrick = (size_t)records[i].firstBrick;
+	}
+
+	// all the bricks must be there
+#ifdef _WIN32
+	LARGE_INTEGER sz;
+	if (bOk)
+		bOk = (GetFileSizeEx(m_hFile, &sz) != 0 && (uint64_t)sz.QuadPart >= m_dataOffset + header.bricksNum*getBrickBytes());
+	if (bOk) {
+		m_hMapping = CreateFileMapping(m_hFile, 0, PAGE_READONLY, 0, 0, 0);
+		bOk = (m_hMapping != 0);
+	}
+#else
+	struct stat st;
+	if (bOk)
+		bOk = (fstat(m_fd, &st) == 0 && (uint64_t)st.st_size >= m_dataOffset + header.bricksNum*getBrickBytes());
+#endif
+	if (!bOk) {
+		Console::error("BrickedVolume::open(): %s is not a valid page file\n", pageFile.c_str());
+		close();
+		return false;
+	}
+
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	m_granularity = info.dwAllocationGranularity;
+#endif
+	return true;
+}
+
+void BrickedVolume::close()
+{
+#ifdef _WIN32
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+	m_hMapping = 0;
+	m_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_fd >= 0)
+		::close(m_fd);
+	m_fd = -1;
+#endif
+	m_levels.clear();
+	m_ranges.clear();
+	m_width = m_height = m_depth = 0;
+}
+
+bool BrickedVolume::isValid(BrickKey key) const
+{
+	int level = keyLevel(key);
+	if (level >= (int)m_levels.size())
+		return false;
+	const Level &lv = m_levels[level];
+	return keyX(key) < lv.bricksX && keyY(key) < lv.bricksY && keyZ(key) < lv.bricksZ;
+}
+
+size_t BrickedVolume::brickIndex(BrickKey key) const
+{
+	ASSERT(isValid(key));
+	const Level &lv = m_levels[keyLevel(key)];
+	return lv.firstBrick + ((size_t)keyZ(key)*lv.bricksY + keyY(key))*lv.bricksX + keyX(key);
+}
+
+void BrickedVolume::getBrickRange(BrickKey key, unsigned char &minVal, unsigned char &maxVal) const
+{
+	size_t index = brickIndex(key);
+	minVal = m_ranges[2*index];
+	maxVal = m_ranges[2*index+1];
+}
+
+bool BrickedVolume::readBrick(BrickKey key, unsigned char *dst) const
+{
+	if (!isOpen() || !isValid(key))
+		return false;
+
+#ifndef _WIN32
+	// pread does not move a shared file position, so bricks can be read from many threads
+	off_t offset = (off_t)(m_dataOffset + (uint64_t)brickIndex(key)*getBrickBytes());
+	return pread(m_fd, dst, getBrickBytes(), offset) == (ssize_t)getBrickBytes();
+#else
+	// views must start at a multiple of the allocation granularity
+	uint64_t offset = m_dataOffset + (uint64_t)brickIndex(key)*getBrickBytes();
+	uint64_t viewStart = offset - offset % m_granularity;
+	size_t delta = (size_t)(offset - viewStart);
+	const unsigned char *pView = (const unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_READ,
+		(DWORD)(viewStart >> 32), (DWORD)(viewStart & 0xffffffff), delta + getBrickBytes());
+	if (!pView)
+		return false;
+	memcpy(dst, pView + delta, getBrickBytes());
+	UnmapViewOfFile(pView);
+	return true;
+#endif
+}
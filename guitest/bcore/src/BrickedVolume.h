@@ -0,0 +1,135 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BRICKEDVOLUME_H45631_INCLUDED_
+#define _BRICKEDVOLUME_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * BrickedVolume: a volume (8-bit voxels) stored in a page file as fixed-size
+ *		bricks, so that volumes much larger than memory, or than the 3D texture
+ *		size limit, can be accessed a brick at a time.
+ *
+ *		Each brick holds brickSize^3 voxels plus a ghost border of copies of the
+ *		neighbouring voxels, so that it can be filtered on its own. The volume is
+ *		stored at several levels of detail: level i+1 is level i averaged in 2x2x2
+ *		blocks, down to a level that fits in a single brick. A brick at level i
+ *		covers the same space as 2x2x2 bricks at level i-1.
+ *
+ *		build(..) writes the page file from a volume, streaming it a few slices
+ *		at a time, so the volume never has to fit in memory. open(..) maps the
+ *		page file, and readBrick(..) copies a brick out of it (and may be called
+ *		from several threads at once). Bricks are usually read through a
+ *		brick cache (see BrickCache).
+ *
+ *		The page file holds a header, the table of the levels, the value range
+ *		of each brick (for skipping empty space), and then the bricks, each
+ *		getBrickBytes() long, level by level and in x, y, z order in each level.
+ */
+class BrickedVolume
+{
+public:
+	typedef uint64_t BrickKey;		// level and brick coordinates, see makeKey
+
+	struct Level {
+		int	width, height, depth;				// in voxels
+		int	bricksX, bricksY, bricksZ;
+		size_t	firstBrick;						// index of its first brick in the page file
+	};
+
+	/**
+	 * SliceSource: provides the slices of a volume to build(..), in order
+	 */
+	class SliceSource {
+	public:
+		virtual ~SliceSource() { }
+		virtual bool readSlice(int z, unsigned char *dst) = 0;	// width*height voxels
+	};
+
+private:
+	int		m_width, m_height, m_depth;
+	int		m_brickSize;
+	int		m_border;
+	std::vector<Level>			m_levels;
+	std::vector<unsigned char>	m_ranges;		// min, max of each brick
+	uint64_t	m_dataOffset;					// of the first brick in the file
+#ifdef _WIN32
+	HANDLE		m_hFile;
+	HANDLE		m_hMapping;
+	size_t		m_granularity;					// of the offsets of mapped views
+#else
+	int			m_fd;							// bricks are read with pread
+#endif
+
+public:
+	BrickedVolume();
+	virtual ~BrickedVolume();
+
+	// build a page file from a volume file (the P7 format of Texture3D::load), from
+	// slices, or from voxels in memory
+	static bool	build(const std::string &volumeFile, const std::string &pageFile, int brickSize = 32, int border = 1);
+	static bool	build(SliceSource &src, int width, int height, int depth, const std::string &pageFile, int brickSize = 32, int border = 1);
+	static bool	build(const unsigned char *voxels, int width, int height, int depth, const std::string &pageFile, int brickSize = 32, int border = 1);
+
+	bool	open(const std::string &pageFile);
+	void	close();
+#ifdef _WIN32
+	bool	isOpen() const						{ return m_hMapping != 0; }
+#else
+	bool	isOpen() const						{ return m_fd >= 0; }
+#endif
+
+	int		getWidth() const					{ return m_width; }
+	int		getHeight() const					{ return m_height; }
+	int		getDepth() const					{ return m_depth; }
+	int		getBrickSize() const				{ return m_brickSize; }		// without the border
+	int		getBorder() const					{ return m_border; }
+	int		getStoredBrickSize() const			{ return m_brickSize + 2*m_border; }
+	size_t	getBrickBytes() const				{ size_t s = getStoredBrickSize(); return s*s*s; }
+	size_t	getLevelsNum() const				{ return m_levels.size(); }
+	const Level&	getLevel(size_t level) const	{ ASSERT(level < m_levels.size()); return m_levels[level]; }
+	size_t	getBricksNum() const				{ return m_ranges.size()/2; }
+
+	static BrickKey	makeKey(int level, int x, int y, int z)	{ return ((BrickKey)level << 48) | ((BrickKey)z << 32) | ((BrickKey)y << 16) | (BrickKey)x; }
+	static int		keyLevel(BrickKey key)		{ return (int)(key >> 48); }
+	static int		keyX(BrickKey key)			{ return (int)(key & 0xffff); }
+	static int		keyY(BrickKey key)			{ return (int)((key >> 16) & 0xffff); }
+	static int		keyZ(BrickKey key)			{ return (int)((key >> 32) & 0xffff); }
+	bool			isValid(BrickKey key) const;
+
+	// the range of values in a brick (including its border)
+	void	getBrickRange(BrickKey key, unsigned char &minVal, unsigned char &maxVal) const;
+
+	// copy the getBrickBytes() voxels of a brick to dst. Thread safe.
+	bool	readBrick(BrickKey key, unsigned char *dst) const;
+
+private:
+	size_t	brickIndex(BrickKey key) const;
+	static void	computeLevels(int width, int height, int depth, int brickSize, std::vector<Level> &levels);
+
+	BrickedVolume(const BrickedVolume&);			// not copyable
+	BrickedVolume& operator=(const BrickedVolume&);
+};
+
+#endif
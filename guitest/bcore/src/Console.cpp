@@ -22,12 +22,19 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "Console.h"
+#include <stdio.h>
+#include <stdarg.h>
+#ifdef _WIN32
 #include <windows.h>
 
 HANDLE g_hConsole = INVALID_HANDLE_VALUE;
+#endif
 
 bool Console::create()
 {
+#ifndef _WIN32
+	return true;	// the standard output is the console
+#else
 	free();
 
 	if (!AllocConsole())
@@ -42,18 +49,22 @@ bool Console::create()
 		return false;
 
 	return true;
+#endif
 }
 
 void Console::free()
 {
+#ifdef _WIN32
 	if (g_hConsole != INVALID_HANDLE_VALUE) {
 		FreeConsole();
 		g_hConsole = INVALID_HANDLE_VALUE;
 	}
+#endif
 }
 
 void Console::print(char* str, ...)
 {
+#ifdef _WIN32
 	if (g_hConsole != INVALID_HANDLE_VALUE)
 	{
 		char buf[1024];
@@ -76,6 +87,7 @@ void Console::print(char* str, ...)
 #endif
 	}
 	else
+#endif
 	{
 		va_list va;
 		va_start(va, str);
@@ -91,6 +103,7 @@ void Console::print(const std::string &s)
 
 void Console::error(char* str, ...)
 {
+#ifdef _WIN32
 	if (g_hConsole != INVALID_HANDLE_VALUE)
 	{
 		char buf[1024];
@@ -113,6 +126,7 @@ void Console::error(char* str, ...)
 #endif
 	}
 	else
+#endif
 	{
 		va_list va;
 		va_start(va, str);
@@ -0,0 +1,169 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CovarianceAccumulator.h"
+#include "Gemm.h"
+#include <math.h>
+
+namespace {
+
+// rows of the symmetric update computed per Gemm call
+const size_t SYRK_BLOCK = 128;
+
+};
+
+void CovarianceAccumulator::create(size_t nVars, size_t chunkSize)
+{
+	ASSERT(nVars > 0 && chunkSize > 0);
+	m_nVars = nVars;
+	m_chunkSize = chunkSize;
+	clear();
+}
+
+void CovarianceAccumulator::clear()
+{
+	m_count = 0;
+	m_mean.assign(m_nVars, 0);
+	m_m2.assign(m_nVars*m_nVars, 0);
+}
+
+void CovarianceAccumulator::add(const double *obs, size_t nObs)
+{
+	for (size_t i=0; i<nObs; i+=m_chunkSize)
+		addChunk(obs + i*m_nVars, (nObs-i < m_chunkSize) ? nObs-i : m_chunkSize);
+}
+
+void CovarianceAccumulator::add(Source &source)
+{
+	std::vector<double> buf(m_chunkSize*m_nVars);
+	size_t n;
+	while ((n = source.read(&buf[0], m_nVars, m_chunkSize)) > 0)
+		addChunk(&buf[0], n);
+}
+
+void CovarianceAccumulator::addChunk(const double *obs, size_t nObs)
+{
+	if (nObs == 0)
+		return;
+	size_t p = m_nVars;
+
+	// mean of the chunk
+	std::vector<double> mean(p, 0);
+	for (size_t k=0; k<nObs; ++k)
+		for (size_t i=0; i<p; ++i)
+			mean[i] += obs[k*p + i];
+	for (size_t i=0; i<p; ++i)
+		mean[i] /= nObs;
+
+	// deviations from it, in both layouts for the rank-k update
+	m_centered.resize(nObs*p);
+	m_centeredT.resize(nObs*p);
+	for (size_t k=0; k<nObs; ++k)
+		for (size_t i=0; i<p; ++i) {
+			double d = obs[k*p + i] - mean[i];
+			m_centered[k*p + i] = d;
+			m_centeredT[i*nObs + k] = d;
+		}
+
+	// m2 += Xc^T Xc, one block of rows at a time, only on and above the diagonal block
+	for (size_t i0=0; i0<p; i0+=SYRK_BLOCK)
+	{
+		size_t rows = (p-i0 < SYRK_BLOCK) ? p-i0 : SYRK_BLOCK;
+		Gemm::multiplyAdd(rows, p-i0, nObs, &m_centeredT[i0*nObs], nObs,
+							&m_centered[i0], p, &m_m2[i0*p + i0], p);
+	}
+
+	// merge with the totals (Chan et al.)
+	double na = (double)(int64_t)m_count;
+	double nb = (double)nObs;
+	double n = na + nb;
+	for (size_t i=0; i<p; ++i) {
+		double di = mean[i] - m_mean[i];
+		for (size_t j=i; j<p; ++j)
+			m_m2[i*p + j] += di*(mean[j] - m_mean[j])*na*nb/n;
+	}
+	for (size_t i=0; i<p; ++i)
+		m_mean[i] += (mean[i] - m_mean[i])*nb/n;
+	m_count += nObs;
+}
+
+void CovarianceAccumulator::merge(const CovarianceAccumulator &acc)
+{
+	ASSERT(acc.m_nVars == m_nVars);
+	if (acc.m_count == 0)
+		return;
+
+	size_t p = m_nVars;
+	double na = (double)(int64_t)m_count;
+	double nb = (double)(int64_t)acc.m_count;
+	double n = na + nb;
+	for (size_t i=0; i<p; ++i) {
+		double di = acc.m_mean[i] - m_mean[i];
+		for (size_t j=i; j<p; ++j)
+			m_m2[i*p + j] += acc.m_m2[i*p + j] + di*(acc.m_mean[j] - m_mean[j])*na*nb/n;
+	}
+	for (size_t i=0; i<p; ++i)
+		m_mean[i] += (acc.m_mean[i] - m_mean[i])*nb/n;
+	m_count += acc.m_count;
+}
+
+void CovarianceAccumulator::getCovariance(double *cov) const
+{
+	size_t p = m_nVars;
+	double n = (double)(int64_t)m_count;
+	for (size_t i=0; i<p; ++i)
+		for (size_t j=i; j<p; ++j)
+			cov[i*p + j] = cov[j*p + i] = (m_count > 0) ? m_m2[i*p + j]/n : 0;
+}
+
+void CovarianceAccumulator::getCorrelation(double *corr) const
+{
+	size_t p = m_nVars;
+	for (size_t i=0; i<p; ++i)
+		for (size_t j=i; j<p; ++j) {
+			double norm = sqrt(m_m2[i*p + i]*m_m2[j*p + j]);
+			corr[i*p + j] = corr[j*p + i] = (norm > 0) ? m_m2[i*p + j]/norm : 0;
+		}
+}
+
+//--------------------------------
+
+bool CovarianceAccumulator::FileSource::open(const std::string &filename)
+{
+	close();
+	m_fp = fopen(filename.c_str(), "rb");
+	return m_fp != 0;
+}
+
+void CovarianceAccumulator::FileSource::close()
+{
+	if (m_fp)
+		fclose(m_fp);
+	m_fp = 0;
+}
+
+size_t CovarianceAccumulator::FileSource::read(double *obs, size_t nVars, size_t maxObs)
+{
+	if (!m_fp)
+		return 0;
+	size_t nValues = fread(obs, sizeof(double), nVars*maxObs, m_fp);
+	return nValues / nVars;		// an incomplete last observation is dropped
+}
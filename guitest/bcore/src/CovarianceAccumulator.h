@@ -0,0 +1,99 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _COVARIANCEACCUMULATOR_H45631_INCLUDED_
+#define _COVARIANCEACCUMULATOR_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * CovarianceAccumulator: mean, covariance and correlation of a set of variables,
+ *		computed from observations that are added in chunks, so that the data never
+ *		has to be in memory all at once. Memory use depends only on the number of
+ *		variables (and the chunk size).
+ *
+ *		Each chunk is centered around its own mean, and its sum of squared deviations
+ *		is computed with a blocked symmetric rank-k update on top of Gemm (which runs
+ *		on the thread pool). It is then merged with the totals with the pairwise
+ *		update of Chan et al., which stays accurate when the mean is large compared
+ *		to the spread. Accumulators filled separately (f.e. on different threads) can
+ *		be combined with merge(..).
+ *
+ *		Covariances are population covariances (divided by the number of observations).
+ */
+class CovarianceAccumulator
+{
+public:
+	// a source of observations, f.e. a file or a generator
+	class Source {
+	public:
+		virtual ~Source() { }
+		// write up to maxObs observations of nVars values each to obs, and return how many were written (0: no more)
+		virtual size_t read(double *obs, size_t nVars, size_t maxObs) = 0;
+	};
+
+	// reads observations stored as consecutive raw doubles (nVars per observation)
+	class FileSource : public Source {
+		FILE	*m_fp;
+	public:
+		FileSource() : m_fp(0) { }
+		virtual ~FileSource()	{ close(); }
+		bool	open(const std::string &filename);
+		void	close();
+		virtual size_t read(double *obs, size_t nVars, size_t maxObs);
+	};
+
+private:
+	size_t				m_nVars;
+	uint64_t			m_count;
+	std::vector<double>	m_mean;
+	std::vector<double>	m_m2;		// sums of products of deviations, upper triangle (row-major nVars x nVars)
+	size_t				m_chunkSize;
+
+	// buffers for the current chunk
+	std::vector<double>	m_centered;		// observation by observation
+	std::vector<double>	m_centeredT;	// variable by variable
+
+	void	addChunk(const double *obs, size_t nObs);
+
+public:
+	CovarianceAccumulator() : m_nVars(0), m_count(0), m_chunkSize(4096) { }
+
+	void	create(size_t nVars, size_t chunkSize = 4096);
+	void	clear();		// forget all observations
+
+	// nObs observations of getVarsNum() values each, stored one after the other
+	void	add(const double *obs, size_t nObs);
+	void	add(Source &source);
+	void	merge(const CovarianceAccumulator &acc);
+
+	size_t		getVarsNum() const			{ return m_nVars; }
+	uint64_t	getCount() const			{ return m_count; }
+	double		getMean(size_t var) const	{ ASSERT(var < m_nVars); return m_mean[var]; }
+
+	// nVars x nVars row-major matrices
+	void	getCovariance(double *cov) const;
+	void	getCorrelation(double *corr) const;		// 0 for variables that do not vary
+};
+
+#endif
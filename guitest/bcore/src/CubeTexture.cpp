@@ -21,7 +21,125 @@
 
 #include "Texture.h"
 #include "BaseTextFile.h"
-#include "RNL/rgbe.h"		// HDR file IO
+#include "Image.h"
+#include "TextureBudget.h"
+#include "ThreadPool.h"
+#include "EnvironmentMap.h"
+
+namespace {
+
+// reads one face of a cube map from a ppm file, as RGB bytes
+bool loadPPMFace(const std::string &fname, int &width, int &height, std::vector<unsigned char> &data)
+{
+	// load data.
+	BaseTextFile file;
+	file.setReadWholeLines(false);
+	file.skipComments(true);
+	file.addLineCommentDef("#");
+
+	if (!file.loadFile(fname, true))
+		return false;
+
+	// read magic number
+	std::string word;
+	int maxColComp;	// maximum color component
+	std::vector<Color> pixels;
+	file >> word;
+	if (word == "P6")
+	{
+		// reading binary file
+		file >> width;
+		file >> height;
+		file >> maxColComp;
+
+		// we take it from here.
+		FILE *fp = file.getFP();
+		pixels.resize(width*height);
+		int nlast = width*height-1;
+		for (int j=0; j<height; ++j)
+			for (int i=0; i<width; ++i)
+			{
+				unsigned char val = fgetc(fp);
+				pixels[nlast - (j*width+i)].r = (float)val/maxColComp;
+				val = fgetc(fp);
+				pixels[nlast - (j*width+i)].g = (float)val/maxColComp;
+				val = fgetc(fp);
+				pixels[nlast - (j*width+i)].b = (float)val/maxColComp;
+			}
+	}
+	else if (word == "P3")
+	{
+		// reading ascii file
+		file >> width;
+		file >> height;
+		file >> maxColComp;
+		
+		pixels.resize(width*height);
+		int nlast = width*height-1;
+		for (int j=0; j<height; ++j)
+			for (int i=0; i<width; ++i)
+			{
+				file >> pixels[nlast - (j*width+i)].r;
+				file >> pixels[nlast - (j*width+i)].g;
+				file >> pixels[nlast - (j*width+i)].b;
+				pixels[j*width+i] /= (float)maxColComp;
+			}
+	}
+	else
+		return false;
+
+	// translate to bytes
+	data.resize(width*height*3);
+	for (int k=0; k<width; ++k)
+		for (int j=0; j<height; ++j)
+		{
+			data[j*width*3 + 3*k  ] = (unsigned char)(pixels[j*width + k].r*255);
+			data[j*width*3 + 3*k+1] = (unsigned char)(pixels[j*width + k].g*255);
+			data[j*width*3 + 3*k+2] = (unsigned char)(pixels[j*width + k].b*255);
+		}
+	return true;
+}
+
+// decodes the 6 faces of a cube map at the same time; the upload stays on the GL thread
+class PPMFacesJob : public ThreadPool::RangeJob
+{
+	const std::string	(&m_fnames)[6];
+public:
+	int		m_width[6], m_height[6];
+	std::vector<unsigned char>	m_data[6];
+	bool	m_bOk[6];
+
+	PPMFacesJob(const std::string (&fnames)[6]) : m_fnames(fnames) { }
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t i=begin; i<end; ++i)
+			m_bOk[i] = loadPPMFace(m_fnames[i], m_width[i], m_height[i], m_data[i]);
+	}
+};
+
+class HDRFacesJob : public ThreadPool::RangeJob
+{
+	const std::string	(&m_fnames)[6];
+public:
+	Image	m_faces[6];
+	bool	m_bOk[6];
+
+	HDRFacesJob(const std::string (&fnames)[6]) : m_fnames(fnames) { }
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t i=begin; i<end; ++i)
+			m_bOk[i] = m_faces[i].loadHDR(m_fnames[i], Image::F16BITS);	// decoded directly to half floats
+	}
+};
+
+void setCubeParams(bool bMipMaps)
+{
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MIN_FILTER, (bMipMaps) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+}
+
+};
 
 
 CubeTexture::CubeTexture()
@@ -36,6 +154,7 @@ CubeTexture::~CubeTexture()
 void CubeTexture::set()
 {
 	if (m_texture) {
+		TextureBudget::inst()->touch(m_texture);
 		glEnable(GL_TEXTURE_CUBE_MAP_ARB);
 		glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, m_texture);
 	}
@@ -43,109 +162,26 @@ void CubeTexture::set()
 
 bool CubeTexture::loadCubePPM(const std::string (&fnames)[6])
 {
+	// decode all faces of the cube in parallel
+	PPMFacesJob job(fnames);
+	ThreadPool::inst()->parallelFor(job, 0, 6, 1);
+	for (int i=0; i<6; ++i)
+		if (!job.m_bOk[i])
+			return false;
+
 	if (!m_texture) {
 		glGenTextures(1, &m_texture);
 	}
 	glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, m_texture);
 
-	// Load all faces of the cube
 	for (int i=0; i<6; ++i)
 	{
-		std::vector<unsigned char> data;
-
-		// load data.
-		BaseTextFile file;
-		file.setReadWholeLines(false);
-		file.skipComments(true);
-		file.addLineCommentDef("#");
-
-		if (!file.loadFile(fnames[i], true))
-			return false;
-
-		// read magic number
-		std::string word;
-		int width, height;
-		int maxColComp;	// maximum color component
-		std::vector<Color> pixels;
-		file >> word;
-		if (word == "P6")
-		{
-			Console::print("\tloading binary ppm file...\n");
-
-			// reading binary file
-			file >> width;
-			file >> height;
-			file >> maxColComp;
-
-			// we take it from here.
-			FILE *fp = file.getFP();
-			pixels.resize(width*height);
-			int nlast = width*height-1;
-			for (int j=0; j<height; ++j)
-				for (int i=0; i<width; ++i)
-				{
-					unsigned char val = fgetc(fp);
-					pixels[nlast - (j*width+i)].r = (float)val/maxColComp;
-					val = fgetc(fp);
-					pixels[nlast - (j*width+i)].g = (float)val/maxColComp;
-					val = fgetc(fp);
-					pixels[nlast - (j*width+i)].b = (float)val/maxColComp;
-				}
-		}
-		else if (word == "P3")
-		{
-			Console::print("\tloading ascii ppm file...\n");
-
-			// reading ascii file
-			file >> width;
-			file >> height;
-			file >> maxColComp;
-			
-			pixels.resize(width*height);
-			int nlast = width*height-1;
-			for (int j=0; j<height; ++j)
-				for (int i=0; i<width; ++i)
-				{
-					file >> pixels[nlast - (j*width+i)].r;
-					file >> pixels[nlast - (j*width+i)].g;
-					file >> pixels[nlast - (j*width+i)].b;
-					pixels[j*width+i] /= (float)maxColComp;
-				}
-		}
-		else
-			return false;
-
-		Console::print("\t-cubemap face loaded: width = %d, height = %d (%s)\n", width, height, fnames[i].c_str());
-
-		// translate to bytes
-		data.resize(width*height*3);
-		for (int k=0; k<width; ++k)
-			for (int j=0; j<height; ++j)
-			{
-				data[j*width*3 + 3*k  ] = (unsigned char)(pixels[j*width + k].r*255);
-				data[j*width*3 + 3*k+1] = (unsigned char)(pixels[j*width + k].g*255);
-				data[j*width*3 + 3*k+2] = (unsigned char)(pixels[j*width + k].b*255);
-			}
-		
-		// create the opengl texture object
-		int faceId = 0;
-		switch (i) {
-		case 0: faceId = GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB; break;
-		case 1: faceId = GL_TEXTURE_CUBE_MAP_NEGATIVE_X_ARB; break;
-		case 2: faceId = GL_TEXTURE_CUBE_MAP_POSITIVE_Y_ARB; break;
-		case 3: faceId = GL_TEXTURE_CUBE_MAP_NEGATIVE_Y_ARB; break;
-		case 4: faceId = GL_TEXTURE_CUBE_MAP_POSITIVE_Z_ARB; break;
-		case 5: faceId = GL_TEXTURE_CUBE_MAP_NEGATIVE_Z_ARB; break;
-		}
-		glTexImage2D(faceId, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, &data[0]);
-		
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		Console::print("\t-cubemap face loaded: width = %d, height = %d (%s)\n", job.m_width[i], job.m_height[i], fnames[i].c_str());
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB+i, 0, GL_RGB8, job.m_width[i], job.m_height[i], 0, GL_RGB, GL_UNSIGNED_BYTE, &job.m_data[i][0]);
 	}
+	setCubeParams(false);
 
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_CUBE_MAP_ARB);
 	Console::print("\tcubemap texture loaded ok.\n\n");
 
 	return true;
@@ -153,64 +189,62 @@ bool CubeTexture::loadCubePPM(const std::string (&fnames)[6])
 
 bool CubeTexture::loadCubeHDR(const std::string (&fnames)[6])
 {
-	if (!m_texture) {
-		glGenTextures(1, &m_texture);
-	}
-	glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, m_texture);
-	
-	// Load all faces of the cube
+	// Read in the HDR light probes, all faces in parallel
+	HDRFacesJob job(fnames);
+	ThreadPool::inst()->parallelFor(job, 0, 6, 1);
 	for (int i=0; i<6; ++i)
 	{
-		// Read in the HDR light probe.
-		FILE* fp = fopen(fnames[i].c_str(), "rb" );
-		if (!fp)
+		if (!job.m_bOk[i])
 			return false;
-
-		rgbe_header_info info;
-		int nWidth, nHeight;
-		RGBE_ReadHeader( fp, &nWidth, &nHeight, &info );
-
-		// We really don't need this
-		float fExposure = info.exposure;
-		float fGamma  = info.gamma;
-
-		// Create a float array to read in the RGB components
-		float* fHDRPixels = new float[3 * nWidth * nHeight];
-		memset(fHDRPixels, 0, 3 * nWidth * nHeight * sizeof(float));
-
-		RGBE_ReadPixels_RLE( fp, fHDRPixels, nWidth, nHeight );
-
-		// copy pixel data
-		std::vector<float> data(4*nWidth*nHeight);
-		for (int k=0; k<nWidth*nHeight; ++k)
-		{
-			data[k*4] = fHDRPixels[k*3];
-			data[k*4+1] = fHDRPixels[k*3+1];
-			data[k*4+2] = fHDRPixels[k*3+2];
-			data[k*4+3] = 0;
-		}
-
-		// copy the pixel data
-		if (nWidth != nHeight || (m_width>0 && nWidth != m_width))
+		int nWidth = (int)job.m_faces[i].getWidth();
+		int nHeight = (int)job.m_faces[i].getHeight();
+		if (nWidth != nHeight || nWidth != (int)job.m_faces[0].getWidth() || (m_width>0 && nWidth != m_width))
 		{
 			Console::print("ERROR: texture faces for cube texture are not square and of equal size!\n");
-			glDeleteTextures(1, &m_texture);
 			return false;
 		}
-		m_width = nWidth;
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB+i, 0, GL_RGBA16F_ARB, nWidth, nHeight, 0, GL_RGBA, GL_FLOAT, &data[0]);
-		//gluBuild2DMipmaps(faceId, GL_RGBA16F_ARB, nWidth, nHeight, GL_RGBA, GL_FLOAT, &data[0]);
-		
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-		glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	}
 
-		delete[] fHDRPixels;
+	if (!m_texture) {
+		glGenTextures(1, &m_texture);
 	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, m_texture);
+
+	m_width = (int)job.m_faces[0].getWidth();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int i=0; i<6; ++i)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB+i, 0, GL_RGBA16F_ARB, m_width, m_width, 0, GL_RGB, GL_HALF_FLOAT_ARB, job.m_faces[i](0,0));
+	setCubeParams(false);
 	
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_CUBE_MAP_ARB);
 	Console::print("\t-loaded HDR cubemap texture (size = %d)\n", m_width);
 
 	return true;
-}
\ No newline at end of file
+}
+
+bool CubeTexture::create(const EnvironmentMap &env)
+{
+	if (env.isEmpty())
+		return false;
+
+	if (!m_texture) {
+		glGenTextures(1, &m_texture);
+	}
+	glBindTexture(GL_TEXTURE_CUBE_MAP_ARB, m_texture);
+
+	// the specular chain as the mip levels, so that the shader picks the roughness with the lod
+	m_width = (int)env.getSize();
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t level=0; level<env.getLevelsNum(); ++level)
+		for (int i=0; i<6; ++i) {
+			const Image &face = env.getFace(level, i);
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB+i, (GLint)level, GL_RGB16F_ARB, (GLsizei)face.getWidth(), (GLsizei)face.getHeight(), 0,
+						GL_RGB, GL_HALF_FLOAT_ARB, face(0,0));
+		}
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_BASE_LEVEL, 0);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP_ARB, GL_TEXTURE_MAX_LEVEL, (GLint)env.getLevelsNum()-1);
+	setCubeParams(true);
+
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_CUBE_MAP_ARB);
+	return true;
+}
@@ -0,0 +1,138 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "DirtyRegion.h"
+
+DirtyRegion::DirtyRegion(size_t maxRects, int mergeSlack) : m_maxRects(maxRects), m_mergeSlack(mergeSlack)
+{
+	if (m_maxRects == 0)
+		m_maxRects = 1;
+}
+
+Rect<int> DirtyRegion::merged(const Rect<int> &a, const Rect<int> &b)
+{
+	return Rect<int>((a.left < b.left) ? a.left : b.left,
+					(a.top < b.top) ? a.top : b.top,
+					(a.right > b.right) ? a.right : b.right,
+					(a.bottom > b.bottom) ? a.bottom : b.bottom);
+}
+
+int DirtyRegion::overlap(const Rect<int> &a, const Rect<int> &b)
+{
+	int w = ((a.right < b.right) ? a.right : b.right) - ((a.left > b.left) ? a.left : b.left);
+	int h = ((a.bottom < b.bottom) ? a.bottom : b.bottom) - ((a.top > b.top) ? a.top : b.top);
+	if (w <= 0 || h <= 0)
+		return 0;
+	return w*h;
+}
+
+int DirtyRegion::mergeCost(const Rect<int> &a, const Rect<int> &b) const
+{
+	return area(merged(a,b)) - (area(a) + area(b) - overlap(a,b));
+}
+
+void DirtyRegion::add(const Rect<int> &rect)
+{
+	if (rect.getWidth() <= 0 || rect.getHeight() <= 0)
+		return;
+
+	// absorb every rect that is cheap to merge with the new one. Merging grows
+	// the new rect, so restart the scan until nothing else can be absorbed.
+	Rect<int> r = rect;
+	bool bMerged = true;
+	while (bMerged)
+	{
+		bMerged = false;
+		for (size_t i=0; i<m_rects.size(); ++i)
+		{
+			if (mergeCost(m_rects[i], r) <= m_mergeSlack) {
+				r = merged(m_rects[i], r);
+				m_rects[i] = m_rects.back();
+				m_rects.pop_back();
+				bMerged = true;
+				break;
+			}
+		}
+	}
+	m_rects.push_back(r);
+
+	// too many rects: merge the pairs that waste the least area
+	while (m_rects.size() > m_maxRects)
+	{
+		size_t bestI = 0, bestJ = 1;
+		int bestCost = mergeCost(m_rects[0], m_rects[1]);
+		for (size_t i=0; i<m_rects.size(); ++i)
+			for (size_t j=i+1; j<m_rects.size(); ++j) {
+				int cost = mergeCost(m_rects[i], m_rects[j]);
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestI = i;
+					bestJ = j;
+				}
+			}
+		m_rects[bestI] = merged(m_rects[bestI], m_rects[bestJ]);
+		m_rects[bestJ] = m_rects.back();
+		m_rects.pop_back();
+	}
+}
+
+void DirtyRegion::add(const DirtyRegion &region)
+{
+	for (size_t i=0; i<region.m_rects.size(); ++i)
+		add(region.m_rects[i]);
+}
+
+void DirtyRegion::clip(int width, int height)
+{
+	for (size_t i=0; i<m_rects.size(); )
+	{
+		Rect<int> &r = m_rects[i];
+		if (r.left < 0) r.left = 0;
+		if (r.top < 0) r.top = 0;
+		if (r.right > width) r.right = width;
+		if (r.bottom > height) r.bottom = height;
+		if (r.getWidth() <= 0 || r.getHeight() <= 0) {
+			m_rects[i] = m_rects.back();
+			m_rects.pop_back();
+		}
+		else
+			++i;
+	}
+}
+
+Rect<int> DirtyRegion::getBounds() const
+{
+	if (m_rects.empty())
+		return Rect<int>(0,0,0,0);
+	Rect<int> bounds = m_rects[0];
+	for (size_t i=1; i<m_rects.size(); ++i)
+		bounds = merged(bounds, m_rects[i]);
+	return bounds;
+}
+
+int DirtyRegion::getArea() const
+{
+	// rects may overlap after a forced merge; this is an upper bound of the covered area
+	int a = 0;
+	for (size_t i=0; i<m_rects.size(); ++i)
+		a += area(m_rects[i]);
+	return a;
+}
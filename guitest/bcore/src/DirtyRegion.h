@@ -0,0 +1,73 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _DIRTYREGION_H45631_INCLUDED_
+#define _DIRTYREGION_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Rect.h"
+
+/**
+ * DirtyRegion: a small set of rectangles that covers the changed parts of an
+ *		image (or any 2D buffer). Rectangles are half-open: [left,right) x [top,bottom).
+ *
+ *		Rectangles added close to each other are merged, when the merged rectangle
+ *		does not cover much more area than the two separately; a run of small
+ *		updates (e.g. the dabs of a brush stroke) ends up as a few larger ones,
+ *		which are much cheaper to upload than many tiny ones. The number of
+ *		rectangles is bounded: when it is exceeded, the pair that wastes the
+ *		least area is merged.
+ */
+class DirtyRegion
+{
+private:
+	std::vector<Rect<int> >	m_rects;
+	size_t					m_maxRects;
+	int						m_mergeSlack;	// extra area (in pixels) accepted when merging two rects
+
+public:
+	DirtyRegion(size_t maxRects = 8, int mergeSlack = 32*32);
+
+	void	add(const Rect<int> &rect);
+	void	add(int left, int top, int right, int bottom)	{ add(Rect<int>(left, top, right, bottom)); }
+	void	add(const DirtyRegion &region);
+	void	clip(int width, int height);
+	void	clear()								{ m_rects.clear(); }
+
+	bool	isEmpty() const						{ return m_rects.empty(); }
+	size_t	getRectsNum() const					{ return m_rects.size(); }
+	const Rect<int>&	getRect(size_t i) const	{ ASSERT(i < m_rects.size()); return m_rects[i]; }
+	Rect<int>	getBounds() const;
+	int		getArea() const;
+
+	void	setMaxRects(size_t n)				{ m_maxRects = (n > 0) ? n : 1; }
+	void	setMergeSlack(int slack)			{ m_mergeSlack = slack; }
+
+private:
+	static int	area(const Rect<int> &r)		{ return r.getWidth()*r.getHeight(); }
+	static Rect<int>	merged(const Rect<int> &a, const Rect<int> &b);
+	static int	overlap(const Rect<int> &a, const Rect<int> &b);
+	int			mergeCost(const Rect<int> &a, const Rect<int> &b) const;	// area wasted by merging a and b
+};
+
+#endif
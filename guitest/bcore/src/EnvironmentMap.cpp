@@ -0,0 +1,644 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "EnvironmentMap.h"
+#include "MipChain.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Half.h"
+#include <emmintrin.h>
+
+std::string EnvironmentMap::m_cacheDir;
+
+namespace {
+
+const char		ENV_MAGIC[4] = { 'B', 'E', 'N', 'V' };
+const int32_t	ENV_VERSION = 1;
+const size_t	MIN_LEVEL_SIZE = 4;		// of the last level of the specular chain
+const size_t	SH_SIZE = 64;			// the largest source level used for the harmonics
+
+struct EnvHeader {
+	char	magic[4];
+	int32_t	version;
+	int32_t	size;
+	int32_t	levels;
+	float	sh[EnvironmentMap::SH_COEFFS][3];
+};
+
+// the direction of a point (u,v) in [-1,1] on a face, in the GL cube map convention
+inline Vector3 faceDir(size_t face, float u, float v)
+{
+	switch (face) {
+		case 0:	return Vector3( 1, -v, -u);
+		case 1:	return Vector3(-1, -v,  u);
+		case 2:	return Vector3( u,  1,  v);
+		case 3:	return Vector3( u, -1, -v);
+		case 4:	return Vector3( u, -v,  1);
+		default: return Vector3(-u, -v, -1);
+	}
+}
+
+// the face of a direction, and the point on it in [0,1]
+inline size_t dirFace(const Vector3 &d, float &u, float &v)
+{
+	float ax = fabs(d.x), ay = fabs(d.y), az = fabs(d.z);
+	size_t face;
+	float sc, tc, ma;
+	if (ax >= ay && ax >= az) {
+		ma = ax;
+		if (d.x > 0) { face = 0; sc = -d.z; tc = -d.y; }
+		else		 { face = 1; sc =  d.z; tc = -d.y; }
+	}
+	else if (ay >= az) {
+		ma = ay;
+		if (d.y > 0) { face = 2; sc = d.x; tc =  d.z; }
+		else		 { face = 3; sc = d.x; tc = -d.z; }
+	}
+	else {
+		ma = az;
+		if (d.z > 0) { face = 4; sc =  d.x; tc = -d.y; }
+		else		 { face = 5; sc = -d.x; tc = -d.y; }
+	}
+	u = 0.5f*(sc/ma + 1);
+	v = 0.5f*(tc/ma + 1);
+	return face;
+}
+
+inline void shBasis(const Vector3 &n, float y[EnvironmentMap::SH_COEFFS])
+{
+	y[0] = 0.282095f;
+	y[1] = 0.488603f*n.y;
+	y[2] = 0.488603f*n.z;
+	y[3] = 0.488603f*n.x;
+	y[4] = 1.092548f*n.x*n.y;
+	y[5] = 1.092548f*n.y*n.z;
+	y[6] = 0.315392f*(3*n.z*n.z - 1);
+	y[7] = 1.092548f*n.x*n.z;
+	y[8] = 0.546274f*(n.x*n.x - n.y*n.y);
+}
+
+/**
+ * SourceCube: the source faces as RGBA floats, with all their mip levels, for
+ *		trilinear sampling
+ */
+class SourceCube
+{
+public:
+	std::vector<Image*>	m_levels;	// level*6 + face
+	size_t	m_size;
+
+	SourceCube() : m_size(0) { }
+	~SourceCube() {
+		for (size_t i=0; i<m_levels.size(); ++i)
+			SAFE_DELETE(m_levels[i]);
+	}
+
+	size_t	getLevelsNum() const	{ return m_levels.size()/6; }
+	const Image&	face(size_t level, size_t f) const	{ return *m_levels[level*6 + f]; }
+
+	__m128 sampleBilinear(const Image &img, float u, float v) const
+	{
+		int n = (int)img.getWidth();
+		float x = u*n - 0.5f, y = v*n - 0.5f;
+		if (x < 0) x = 0;
+		if (y < 0) y = 0;
+		int x0 = (int)x, y0 = (int)y;
+		if (x0 > n-1) x0 = n-1;
+		if (y0 > n-1) y0 = n-1;
+		int x1 = (x0+1 < n) ? x0+1 : n-1, y1 = (y0+1 < n) ? y0+1 : n-1;
+		__m128 fx = _mm_set1_ps(std::min(x - x0, 1.0f)), fy = _mm_set1_ps(std::min(y - y0, 1.0f));
+
+		__m128 c00 = _mm_loadu_ps((const float*)img(x0, y0)), c10 = _mm_loadu_ps((const float*)img(x1, y0));
+		__m128 c01 = _mm_loadu_ps((const float*)img(x0, y1)), c11 = _mm_loadu_ps((const float*)img(x1, y1));
+		__m128 top = _mm_add_ps(c00, _mm_mul_ps(fx, _mm_sub_ps(c10, c00)));
+		__m128 bottom = _mm_add_ps(c01, _mm_mul_ps(fx, _mm_sub_ps(c11, c01)));
+		return _mm_add_ps(top, _mm_mul_ps(fy, _mm_sub_ps(bottom, top)));
+	}
+
+	// trilinear, lod 0 being the source faces
+	__m128 sample(const Vector3 &dir, float lod) const
+	{
+		float u, v;
+		size_t f = dirFace(dir, u, v);
+		float maxLod = (float)(getLevelsNum()-1);
+		if (lod < 0) lod = 0;
+		if (lod > maxLod) lod = maxLod;
+		size_t l0 = (size_t)lod;
+		float t = lod - l0;
+		__m128 c = sampleBilinear(face(l0, f), u, v);
+		if (t > 0 && l0+1 < getLevelsNum()) {
+			__m128 c1 = sampleBilinear(face(l0+1, f), u, v);
+			c = _mm_add_ps(c, _mm_mul_ps(_mm_set1_ps(t), _mm_sub_ps(c1, c)));
+		}
+		return c;
+	}
+};
+
+// a row of channel values to floats, scaled as the pixel format traits do
+template <class S>
+void rowToFloat(const unsigned char *p, std::vector<float> &row)
+{
+	const typename S::Type *src = (const typename S::Type*)p;
+	for (size_t i=0; i<row.size(); ++i)
+		row[i] = (float)S::toUnit(src[i]);
+}
+
+// converts the faces to RGBA floats (linear)
+class ConvertJob : public ThreadPool::RangeJob
+{
+	const Image	(&m_faces)[6];
+	SourceCube	&m_cube;
+	float		m_srgbToLinear[256];
+public:
+	ConvertJob(const Image (&faces)[6], SourceCube &cube) : m_faces(faces), m_cube(cube) {
+		for (int i=0; i<256; ++i) {
+			double c = i/255.0;
+			m_srgbToLinear[i] = (float)((c <= 0.04045) ? c/12.92 : pow((c+0.055)/1.055, 2.4));
+		}
+	}
+
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t f=begin; f<end; ++f)
+		{
+			const Image &src = m_faces[f];
+			Image &dst = *m_cube.m_levels[f];
+			size_t nc = src.getChannelsNum();
+			std::vector<float> row(src.getWidth()*nc);
+			for (size_t y=0; y<src.getHeight(); ++y)
+			{
+				// one row to floats, then spread to RGBA
+				const unsigned char *p = src(0, y);
+				switch (src.getFormat()) {
+					case Image::I8BITS:
+						for (size_t i=0; i<row.size(); ++i)
+							row[i] = m_srgbToLinear[p[i]];
+						break;
+					case Image::I16BITS:
+						rowToFloat<PixelI16>(p, row);
+						break;
+					case Image::I32BITS:
+						rowToFloat<PixelI32>(p, row);
+						break;
+					case Image::F16BITS:
+						Half::toFloat((const float16_t*)p, &row[0], row.size());
+						break;
+					case Image::F32BITS:
+						memcpy(&row[0], p, row.size()*sizeof(float));
+						break;
+					case Image::F64BITS:
+						rowToFloat<PixelF64>(p, row);
+						break;
+				}
+				float *out = (float*)dst(0, y);
+				for (size_t x=0; x<src.getWidth(); ++x, out+=4) {
+					const float *c = &row[x*nc];
+					out[0] = c[0];
+					out[1] = (nc >= 3) ? c[1] : c[0];
+					out[2] = (nc >= 3) ? c[2] : c[0];
+					out[3] = 0;
+				}
+			}
+		}
+	}
+};
+
+// a GGX sample in tangent space (n = (0,0,1)), with its weight and source lod
+struct GGXSample {
+	float	x, y, z;
+	float	weight;
+	float	lod;
+};
+
+void ggxSamples(float roughness, size_t count, size_t srcSize, std::vector<GGXSample> &samples)
+{
+	samples.clear();
+	float a = roughness*roughness;
+	float a2 = a*a;
+	float texelAngle = 4*PI / (6.0f*srcSize*srcSize);
+	for (size_t i=0; i<count; ++i)
+	{
+		// Hammersley point
+		unsigned int bits = (unsigned int)i;
+		bits = (bits << 16) | (bits >> 16);
+		bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+		bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+		bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+		bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+		float xi1 = (float)i/count, xi2 = bits * 2.3283064365386963e-10f;
+
+		// importance sample the half vector, and reflect v = n about it
+		float phi = 2*PI*xi1;
+		float cosTheta = sqrtf((1 - xi2) / (1 + (a2 - 1)*xi2));
+		float sinTheta = sqrtf(1 - cosTheta*cosTheta);
+		float hx = sinTheta*cosf(phi), hy = sinTheta*sinf(phi), hz = cosTheta;
+		GGXSample s;
+		s.x = 2*cosTheta*hx;
+		s.y = 2*cosTheta*hy;
+		s.z = 2*cosTheta*hz - 1;
+		if (s.z <= 0)
+			continue;
+		s.weight = s.z;
+
+		// filtered importance sampling: read from the level whose texels cover the solid
+		// angle of the sample (pdf = D/4, since n = v)
+		float d = (cosTheta*cosTheta*(a2 - 1) + 1);
+		float pdf = a2 / (PI*d*d) / 4;
+		float sampleAngle = 1.0f / (count*pdf + 0.0001f);
+		s.lod = (roughness == 0) ? 0 : 0.5f*logf(sampleAngle/texelAngle)/logf(2.0f) + 1;
+		samples.push_back(s);
+	}
+}
+
+// one level of the specular chain, in parallel over rows
+class PrefilterJob : public ThreadPool::RangeJob
+{
+	const SourceCube	&m_src;
+	std::vector<Image*>	&m_out;		// the 6 faces, RGBA floats
+	const std::vector<GGXSample>	&m_samples;
+	float				m_baseLod;	// for level 0 (mirror reflection)
+public:
+	PrefilterJob(const SourceCube &src, std::vector<Image*> &out, const std::vector<GGXSample> &samples, float baseLod) :
+		m_src(src), m_out(out), m_samples(samples), m_baseLod(baseLod) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		size_t n = m_out[0]->getWidth();
+		for (size_t r=begin; r<end; ++r)
+		{
+			size_t f = r / n, y = r % n;
+			float *out = (float*)(*m_out[f])(0, y);
+			for (size_t x=0; x<n; ++x, out+=4)
+			{
+				Vector3 dir = faceDir(f, 2*(x+0.5f)/n - 1, 2*(y+0.5f)/n - 1);
+				dir.normalize();
+				if (m_samples.empty()) {
+					_mm_storeu_ps(out, m_src.sample(dir, m_baseLod));
+					continue;
+				}
+
+				// tangent frame around the direction
+				Vector3 up = (fabs(dir.z) < 0.999f) ? Vector3(0,0,1) : Vector3(1,0,0);
+				Vector3 t = up.cross(dir);
+				t.normalize();
+				Vector3 b = dir.cross(t);
+
+				__m128 sum = _mm_setzero_ps();
+				float wsum = 0;
+				for (size_t i=0; i<m_samples.size(); ++i) {
+					const GGXSample &s = m_samples[i];
+					Vector3 l = t*s.x + b*s.y + dir*s.z;
+					sum = _mm_add_ps(sum, _mm_mul_ps(m_src.sample(l, s.lod), _mm_set1_ps(s.weight)));
+					wsum += s.weight;
+				}
+				_mm_storeu_ps(out, _mm_mul_ps(sum, _mm_set1_ps(1.0f/wsum)));
+			}
+		}
+	}
+};
+
+// the radiance projected on the harmonics, weighted by the solid angle of each texel. Each
+// row writes its own sums, so that the result does not depend on the threads.
+class SHJob : public ThreadPool::RangeJob
+{
+	const SourceCube	&m_src;
+	size_t				m_level;
+	std::vector<float>	&m_rowSums;	// per row: 9 x RGB, then the total solid angle
+public:
+	enum { ROW_SUMS = EnvironmentMap::SH_COEFFS*3 + 1 };
+
+	SHJob(const SourceCube &src, size_t level, std::vector<float> &rowSums) : m_src(src), m_level(level), m_rowSums(rowSums) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		size_t n = m_src.face(m_level, 0).getWidth();
+		float y[EnvironmentMap::SH_COEFFS];
+		for (size_t r=begin; r<end; ++r)
+		{
+			size_t f = r / n, row = r % n;
+			const float *p = (const float*)m_src.face(m_level, f)(0, row);
+			__m128 acc[EnvironmentMap::SH_COEFFS];
+			for (int i=0; i<EnvironmentMap::SH_COEFFS; ++i)
+				acc[i] = _mm_setzero_ps();
+			float angleSum = 0;
+
+			float v = 2*(row+0.5f)/n - 1;
+			for (size_t x=0; x<n; ++x, p+=4)
+			{
+				float u = 2*(x+0.5f)/n - 1;
+				float d2 = 1 + u*u + v*v;
+				float angle = 4.0f/(n*n) / (d2*sqrtf(d2));
+				Vector3 dir = faceDir(f, u, v);
+				dir.normalize();
+				shBasis(dir, y);
+
+				__m128 c = _mm_mul_ps(_mm_loadu_ps(p), _mm_set1_ps(angle));
+				for (int i=0; i<EnvironmentMap::SH_COEFFS; ++i)
+					acc[i] = _mm_add_ps(acc[i], _mm_mul_ps(c, _mm_set1_ps(y[i])));
+				angleSum += angle;
+			}
+
+			float *out = &m_rowSums[r*ROW_SUMS];
+			for (int i=0; i<EnvironmentMap::SH_COEFFS; ++i) {
+				float tmp[4];
+				_mm_storeu_ps(tmp, acc[i]);
+				out[3*i] = tmp[0];
+				out[3*i+1] = tmp[1];
+				out[3*i+2] = tmp[2];
+			}
+			out[ROW_SUMS-1] = angleSum;
+		}
+	}
+};
+
+class FaceLoadJob : public ThreadPool::RangeJob
+{
+	const std::string	(&m_fnames)[6];
+	Image				(&m_faces)[6];
+public:
+	bool	m_bOk[6];
+
+	FaceLoadJob(const std::string (&fnames)[6], Image (&faces)[6]) : m_fnames(fnames), m_faces(faces) { }
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t f=begin; f<end; ++f)
+			m_bOk[f] = m_faces[f].load(m_fnames[f]);
+	}
+};
+
+// FNV-1a over the contents of the files, 8 bytes at a time
+bool hashFiles(const std::string (&fnames)[6], uint64_t &hash)
+{
+	hash = 14695981039346656037ull;
+	for (int f=0; f<6; ++f)
+	{
+		MappedFile file;
+		if (!file.open(fnames[f]))
+			return false;
+		const unsigned char *p = file.getData();
+		size_t size = file.getSize(), i = 0;
+		for (; i+8 <= size; i += 8) {
+			uint64_t w;
+			memcpy(&w, p+i, 8);
+			hash = (hash ^ w) * 1099511628211ull;
+		}
+		for (; i<size; ++i)
+			hash = (hash ^ p[i]) * 1099511628211ull;
+		hash = (hash ^ (uint64_t)size) * 1099511628211ull;
+	}
+	return true;
+}
+
+};
+
+EnvironmentMap::EnvironmentMap() : m_size(0)
+{
+	memset(m_sh, 0, sizeof(m_sh));
+}
+
+EnvironmentMap::~EnvironmentMap()
+{
+	free();
+}
+
+void EnvironmentMap::free()
+{
+	for (size_t i=0; i<m_levels.size(); ++i)
+		SAFE_DELETE(m_levels[i]);
+	m_levels.clear();
+	m_size = 0;
+	memset(m_sh, 0, sizeof(m_sh));
+}
+
+bool EnvironmentMap::loadFaces(const std::string (&fnames)[6], Image (&faces)[6])
+{
+	FaceLoadJob job(fnames, faces);
+	ThreadPool::inst()->parallelFor(job, 0, 6, 1);
+
+	for (int f=0; f<6; ++f)
+	{
+		if (!job.m_bOk[f]) {
+			Console::error("EnvironmentMap::loadFaces(): failed to load %s\n", fnames[f].c_str());
+			return false;
+		}
+		if (faces[f].getWidth() != faces[f].getHeight() || faces[f].getWidth() != faces[0].getWidth()) {
+			Console::error("EnvironmentMap::loadFaces(): the faces are not square and of equal size\n");
+			return false;
+		}
+	}
+	return true;
+}
+
+void EnvironmentMap::compute(const Image (&faces)[6], size_t size, size_t samples)
+{
+	free();
+	size_t srcSize = faces[0].getWidth();
+	if (srcSize == 0)
+		return;
+	if (size == 0)
+		size = srcSize;
+
+	// the source, with its mip levels
+	SourceCube src;
+	src.m_size = srcSize;
+	for (size_t n=srcSize; ; n/=2) {
+		for (int f=0; f<6; ++f) {
+			Image *pImg = new Image();
+			pImg->create(n, n, 4, Image::F32BITS);
+			src.m_levels.push_back(pImg);
+		}
+		if (n == 1)
+			break;
+	}
+	ConvertJob convert(faces, src);
+	ThreadPool::inst()->parallelFor(convert, 0, 6, 1);
+	for (size_t l=1; l<src.getLevelsNum(); ++l)
+		for (int f=0; f<6; ++f)
+			MipChain::downsample(src.face(l-1, f), *src.m_levels[l*6 + f]);	// in parallel
+
+	// irradiance
+	size_t shLevel = 0;
+	while (src.face(shLevel, 0).getWidth() > SH_SIZE)
+		shLevel++;
+	size_t shSize = src.face(shLevel, 0).getWidth();
+	std::vector<float> rowSums(6*shSize*SHJob::ROW_SUMS);
+	SHJob shJob(src, shLevel, rowSums);
+	ThreadPool::inst()->parallelFor(shJob, 0, 6*shSize, 8);
+
+	double sums[SH_COEFFS*3 + 1];
+	memset(sums, 0, sizeof(sums));
+	for (size_t r=0; r<6*shSize; ++r)
+		for (int i=0; i<SHJob::ROW_SUMS; ++i)
+			sums[i] += rowSums[r*SHJob::ROW_SUMS + i];
+	static const float bandScale[SH_COEFFS] = { PI, 2*PI/3, 2*PI/3, 2*PI/3, PI/4, PI/4, PI/4, PI/4, PI/4 };
+	double norm = 4*PI / sums[SH_COEFFS*3];		// the texel angles add up to about 4pi
+	for (int i=0; i<SH_COEFFS; ++i)
+		for (int c=0; c<3; ++c)
+			m_sh[i][c] = (float)(sums[3*i + c]*norm*bandScale[i]);
+
+	// the specular chain
+	size_t levelsNum = 1;
+	for (size_t n=size; n/2 >= MIN_LEVEL_SIZE; n/=2)
+		levelsNum++;
+	m_size = size;
+	std::vector<GGXSample> ggx;
+	std::vector<Image*> work(6);
+	for (int f=0; f<6; ++f)
+		work[f] = new Image();
+	for (size_t level=0; level<levelsNum; ++level)
+	{
+		size_t n = size >> level;
+		for (int f=0; f<6; ++f)
+			work[f]->create(n, n, 4, Image::F32BITS);
+
+		float roughness = (levelsNum > 1) ? (float)level/(levelsNum-1) : 0.0f;
+		if (level == 0)
+			ggx.clear();	// a mirror: only resampled
+		else
+			ggxSamples(roughness, samples, srcSize, ggx);
+		float baseLod = logf((float)srcSize/n)/logf(2.0f);
+		PrefilterJob job(src, work, ggx, baseLod);
+		ThreadPool::inst()->parallelFor(job, 0, 6*n, 4);
+
+		// store as RGB half floats
+		for (int f=0; f<6; ++f) {
+			Image *pFace = new Image();
+			pFace->create(n, n, 3, Image::F16BITS);
+			std::vector<float> rgb(3*n);
+			for (size_t y=0; y<n; ++y) {
+				const float *p = (const float*)(*work[f])(0, y);
+				for (size_t x=0; x<n; ++x) {
+					rgb[3*x] = p[4*x];
+					rgb[3*x+1] = p[4*x+1];
+					rgb[3*x+2] = p[4*x+2];
+				}
+				Half::fromFloat(&rgb[0], (float16_t*)(*pFace)(0, y), 3*n);
+			}
+			m_levels.push_back(pFace);
+		}
+	}
+	for (int f=0; f<6; ++f)
+		SAFE_DELETE(work[f]);
+}
+
+Color EnvironmentMap::evalIrradiance(const Vector3 &n) const
+{
+	float y[SH_COEFFS];
+	shBasis(n, y);
+	Color c;
+	for (int i=0; i<SH_COEFFS; ++i) {
+		c.r += m_sh[i][0]*y[i];
+		c.g += m_sh[i][1]*y[i];
+		c.b += m_sh[i][2]*y[i];
+	}
+	return c;
+}
+
+bool EnvironmentMap::load(const std::string (&fnames)[6], size_t size, size_t samples)
+{
+	// the cache file is named after the sources and the parameters
+	uint64_t hash;
+	if (!hashFiles(fnames, hash))
+		return false;
+	hash = (hash ^ (uint64_t)size) * 1099511628211ull;
+	hash = (hash ^ (uint64_t)samples) * 1099511628211ull;
+
+	std::string dir = m_cacheDir;
+	if (dir.empty()) {
+		size_t slash = fnames[0].find_last_of("/\\");
+		dir = (slash == std::string::npos) ? std::string(".") : fnames[0].substr(0, slash);
+	}
+	char name[32];
+	sprintf(name, "/%08x%08x.env", (unsigned int)(hash >> 32), (unsigned int)(hash & 0xffffffff));
+	std::string cacheFile = dir + name;
+	if (load(cacheFile))
+		return true;
+
+	Image faces[6];
+	if (!loadFaces(fnames, faces))
+		return false;
+	compute(faces, size, samples);
+	if (!save(cacheFile))
+		Console::print("EnvironmentMap: could not write the cache file %s\n", cacheFile.c_str());
+	return true;
+}
+
+bool EnvironmentMap::save(const std::string &filename) const
+{
+	if (isEmpty())
+		return false;
+
+	EnvHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, ENV_MAGIC, 4);
+	header.version = ENV_VERSION;
+	header.size = (int32_t)m_size;
+	header.levels = (int32_t)getLevelsNum();
+	memcpy(header.sh, m_sh, sizeof(m_sh));
+
+	FILE *fp = fopen(filename.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool bOk = (fwrite(&header, sizeof(header), 1, fp) == 1);
+	for (size_t i=0; i<m_levels.size() && bOk; ++i) {
+		const Image &img = *m_levels[i];
+		size_t bytes = img.getWidth()*img.getHeight()*img.getBytesPerPixel();
+		bOk = (fwrite(img(0,0), 1, bytes, fp) == bytes);
+	}
+	if (fclose(fp) != 0)
+		bOk = false;
+	return bOk;
+}
+
+bool EnvironmentMap::load(const std::string &filename)
+{
+	free();
+
+	MappedFile file;
+	if (!file.open(filename) || file.getSize() < sizeof(EnvHeader))
+		return false;
+	EnvHeader header;
+	memcpy(&header, file.getData(), sizeof(header));
+	if (memcmp(header.magic, ENV_MAGIC, 4) != 0 || header.version != ENV_VERSION ||
+		header.size <= 0 || header.levels <= 0 || header.levels > 32 || (header.size >> (header.levels-1)) == 0)
+		return false;
+
+	// check the size before reading the levels
+	size_t total = sizeof(header);
+	for (int32_t l=0; l<header.levels; ++l) {
+		size_t n = (size_t)header.size >> l;
+		total += 6*n*n*3*sizeof(float16_t);
+	}
+	if (file.getSize() != total)
+		return false;
+
+	m_size = header.size;
+	memcpy(m_sh, header.sh, sizeof(m_sh));
+	const unsigned char *p = file.getData() + sizeof(header);
+	for (int32_t l=0; l<header.levels; ++l)
+	{
+		size_t n = m_size >> l;
+		for (int f=0; f<6; ++f) {
+			Image *pFace = new Image();
+			pFace->create(n, n, 3, Image::F16BITS);
+			memcpy((*pFace)(0,0), p, n*n*3*sizeof(float16_t));
+			p += n*n*3*sizeof(float16_t);
+			m_levels.push_back(pFace);
+		}
+	}
+	return true;
+}
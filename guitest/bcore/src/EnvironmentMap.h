@@ -0,0 +1,97 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ENVIRONMENTMAP_H45631_INCLUDED_
+#define _ENVIRONMENTMAP_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+
+/**
+ * EnvironmentMap: the lighting of a cube map environment, precomputed on the CPU
+ *		for image based lighting:
+ *		- the irradiance, as 9 spherical harmonic coefficients (3 bands) per color
+ *		  channel, for diffuse lighting. evalIrradiance(n) is the irradiance of a
+ *		  surface with normal n (divide by PI for the outgoing radiance of a white
+ *		  lambertian surface).
+ *		- a specular chain: level i is the environment convolved with the GGX
+ *		  lobe of roughness i/(levels-1), with the "split sum" approximation
+ *		  (n = v = r), at half the size of level i-1. Upload it as the mip levels
+ *		  of a cube texture with CubeTexture::create(const EnvironmentMap&), and
+ *		  pick the level by roughness in the shader.
+ *
+ *		The faces are in the order of the GL cube map faces (+x, -x, +y, -y, +z, -z).
+ *		8-bit faces are taken to be sRGB, the other formats linear. Faces are decoded
+ *		in parallel, and the filtering runs on all threads, with SSE.
+ *
+ *		load(..) caches the results on disk, in a file named after a hash of the
+ *		contents of the 6 source files (and the filtering parameters), so that
+ *		loading the same environment again only reads the results back.
+ */
+class EnvironmentMap
+{
+public:
+	enum { SH_COEFFS = 9 };
+
+private:
+	size_t	m_size;						// of level 0
+	std::vector<Image*>	m_levels;		// level*6 + face, RGB F16
+	float	m_sh[SH_COEFFS][3];
+
+	static std::string	m_cacheDir;
+
+public:
+	EnvironmentMap();
+	virtual ~EnvironmentMap();
+
+	// decode the 6 faces in parallel. Faces must be square and of the same size.
+	static bool	loadFaces(const std::string (&fnames)[6], Image (&faces)[6]);
+
+	// compute everything from the faces. size is the size of level 0 of the specular
+	// chain (0 for the size of the faces), samples the GGX samples per texel.
+	void	compute(const Image (&faces)[6], size_t size = 128, size_t samples = 64);
+
+	// load from the cache, or load the faces and compute (and save to the cache)
+	bool	load(const std::string (&fnames)[6], size_t size = 128, size_t samples = 64);
+	bool	save(const std::string &filename) const;
+	bool	load(const std::string &filename);
+	void	free();
+
+	bool	isEmpty() const					{ return m_levels.empty(); }
+	size_t	getSize() const					{ return m_size; }
+	size_t	getLevelsNum() const			{ return m_levels.size()/6; }
+	const Image&	getFace(size_t level, size_t face) const	{ ASSERT(level < getLevelsNum() && face < 6); return *m_levels[level*6 + face]; }
+	float	getRoughness(size_t level) const	{ return (getLevelsNum() > 1) ? (float)level/(getLevelsNum()-1) : 0.0f; }
+
+	const float*	getSHCoeff(size_t i) const	{ ASSERT(i < SH_COEFFS); return m_sh[i]; }	// RGB
+	Color	evalIrradiance(const Vector3 &n) const;
+
+	static void	setCacheDir(const std::string &dir)		{ m_cacheDir = dir; }
+	static const std::string&	getCacheDir()			{ return m_cacheDir; }
+
+private:
+	EnvironmentMap(const EnvironmentMap&);			// not copyable
+	EnvironmentMap& operator=(const EnvironmentMap&);
+};
+
+#endif
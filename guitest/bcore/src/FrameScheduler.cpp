@@ -0,0 +1,156 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrameScheduler.h"
+#include "Timer.h"
+#include "Thread.h"
+#ifdef _WIN32
+#include <windows.h>
+#include <mmsystem.h>
+#endif
+
+FrameScheduler	*FrameScheduler::m_pInst = 0;
+
+namespace {
+	const double	MAX_DELTA = 0.25;	// longer frames are not caught up by the fixed steps
+	const double	SPIN_TIME = 0.002;	// secs that are not left to the OS scheduler
+};
+
+FrameScheduler::FrameScheduler() : m_targetFPS(0),
+	m_fixedStep(1.0/60),
+	m_maxSteps(8),
+	m_bIdleMode(false),
+	m_bFrameRequested(true),
+	m_bAnimating(false),
+	m_bWasIdle(true),
+	m_bHighResTimer(false),
+	m_frameStart(0),
+	m_frameDelta(0),
+	m_accumulator(0),
+	m_stepsNum(0),
+	m_windowStart(0),
+	m_windowFrames(0),
+	m_windowFrameTime(0),
+	m_windowMaxFrameTime(0),
+	m_windowWorkTime(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	setTargetFPS(60);
+}
+
+FrameScheduler::~FrameScheduler()
+{
+	setTargetFPS(0);
+}
+
+void FrameScheduler::setTargetFPS(double fps)
+{
+	ASSERT(fps >= 0);
+	m_targetFPS = fps;
+
+#ifdef _WIN32
+	// pacing needs sleeps shorter than the default 10-15 msec timer resolution of windows
+	bool bHighRes = (fps > 0);
+	if (bHighRes != m_bHighResTimer) {
+		if (bHighRes)
+			timeBeginPeriod(1);
+		else
+			timeEndPeriod(1);
+		m_bHighResTimer = bHighRes;
+	}
+#endif
+}
+
+double FrameScheduler::getWaitTime()
+{
+	if (m_bIdleMode && !m_bFrameRequested && !m_bAnimating) {
+		m_bWasIdle = true;
+		return -1;
+	}
+	if (m_targetFPS <= 0 || m_bWasIdle)
+		return 0;	// after idling, respond right away
+
+	double wait = m_frameStart + 1.0/m_targetFPS - Timer::now();
+	return (wait > 0) ? wait : 0;
+}
+
+void FrameScheduler::beginFrame()
+{
+	double now = Timer::now();
+	double sinceLast = (m_stats.frames > 0) ? now - m_frameStart : 0;
+	m_frameDelta = (m_bWasIdle) ? 0 : sinceLast;
+
+	// frame timing stats, over one second windows
+	if (m_windowStart == 0)
+		m_windowStart = now;
+	else if (!m_bWasIdle) {
+		m_windowFrameTime += sinceLast;
+		if (sinceLast > m_windowMaxFrameTime)
+			m_windowMaxFrameTime = sinceLast;
+	}
+	if (now - m_windowStart >= 1.0)
+	{
+		double secs = now - m_windowStart;
+		size_t timed = (m_windowFrames > 0) ? m_windowFrames : 1;
+		m_stats.fps = m_windowFrames / secs;
+		m_stats.avgFrameTime = 1000.0*m_windowFrameTime / timed;
+		m_stats.maxFrameTime = 1000.0*m_windowMaxFrameTime;
+		m_stats.avgWorkTime = 1000.0*m_windowWorkTime / timed;
+		m_stats.load = m_windowWorkTime / secs;
+		m_windowStart = now;
+		m_windowFrames = 0;
+		m_windowFrameTime = m_windowMaxFrameTime = m_windowWorkTime = 0;
+	}
+
+	// the fixed steps that fit in the time since the last frame
+	double delta = m_frameDelta;
+	if (delta > MAX_DELTA)
+		delta = MAX_DELTA;
+	m_accumulator += delta;
+	m_stepsNum = (size_t)(m_accumulator / m_fixedStep);
+	if (m_stepsNum > m_maxSteps) {
+		m_stats.droppedSteps += m_stepsNum - m_maxSteps;
+		m_stepsNum = m_maxSteps;
+		m_accumulator = m_stepsNum*m_fixedStep;
+	}
+	m_accumulator -= m_stepsNum*m_fixedStep;
+	m_stats.steps += m_stepsNum;
+
+	m_frameStart = now;
+	m_bFrameRequested = false;
+	m_bWasIdle = false;
+}
+
+void FrameScheduler::endFrame()
+{
+	m_windowWorkTime += Timer::now() - m_frameStart;
+	m_windowFrames++;
+	m_stats.frames++;
+}
+
+void FrameScheduler::sleep(double secs)
+{
+	double end = Timer::now() + secs;
+	if (secs > SPIN_TIME)
+		Thread::sleep((unsigned long)(1000*(secs - SPIN_TIME)));
+	while (Timer::now() < end)
+		Thread::sleep(0);
+}
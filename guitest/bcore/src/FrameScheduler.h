@@ -0,0 +1,134 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _FRAMESCHEDULER_H45631_INCLUDED_
+#define _FRAMESCHEDULER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * FrameScheduler: decides when the main loop renders a frame, based on the
+ *		(monotonic) Timer clock.
+ *		- frames are paced to a target frame rate; the loop waits (sleeps, or
+ *		  waits for OS events) for getWaitTime() seconds between frames, instead
+ *		  of spinning. A target of 0 renders as fast as possible (fe. when the
+ *		  swap is synchronized to the vertical retrace).
+ *		- in idle mode, no frames are rendered at all unless one is requested
+ *		  (fe. after input) or something is animating, in which case frames are
+ *		  paced as above until the animation ends.
+ *		- updates that need a constant time step (simulations, physics) are run
+ *		  getStepsNum() times per frame, with a step of getFixedStep() seconds,
+ *		  independently of the rendering rate. getStepAlpha() is how far the frame
+ *		  time is between the last step and the next, for interpolating.
+ *
+ *		The loop looks like:
+ *			while (..) {
+ *				// handle events, and requestFrame() if anything changed
+ *				double wait = sched.getWaitTime();
+ *				if (wait != 0) { <wait for events, up to wait secs (<0: no limit)>; continue; }
+ *				sched.beginFrame();
+ *				for (size_t i=0; i<sched.getStepsNum(); ++i)
+ *					fixedUpdate(sched.getFixedStep());
+ *				update(sched.getFrameDelta());
+ *				render();
+ *				sched.setAnimating(<anything still animating>);
+ *				sched.endFrame();
+ *			}
+ */
+class FrameScheduler
+{
+public:
+	struct Stats {
+		size_t	frames;			// rendered since the start
+		size_t	steps;			// fixed steps run since the start
+		size_t	droppedSteps;	// fixed steps skipped because the updates could not keep up
+		double	fps;			// the frames rendered in the last second
+		double	avgFrameTime;	// msec, from the start of a frame to the start of the next, over the last second
+		double	maxFrameTime;	// msec, the longest in the last second
+		double	avgWorkTime;	// msec, from beginFrame() to endFrame(), over the last second
+		double	load;			// the fraction of the last second spent in frames, not waiting
+	};
+
+private:
+	double	m_targetFPS;
+	double	m_fixedStep;		// secs
+	size_t	m_maxSteps;			// per frame
+	bool	m_bIdleMode;
+	bool	m_bFrameRequested;
+	bool	m_bAnimating;
+	bool	m_bWasIdle;			// the last wait was for an event, not for pacing
+	bool	m_bHighResTimer;
+
+	double	m_frameStart;		// of the current (or last) frame
+	double	m_frameDelta;
+	double	m_accumulator;		// time not yet consumed by fixed steps
+	size_t	m_stepsNum;
+
+	// the stats of the last complete second, and the one being measured
+	Stats	m_stats;
+	double	m_windowStart;
+	size_t	m_windowFrames;
+	double	m_windowFrameTime, m_windowMaxFrameTime, m_windowWorkTime;
+
+	static FrameScheduler	*m_pInst;
+
+public:
+	FrameScheduler();
+	virtual ~FrameScheduler();
+
+	static FrameScheduler* inst()	{ if (!m_pInst) m_pInst = new FrameScheduler(); return m_pInst; }
+
+	void	setTargetFPS(double fps);			// 0 for no pacing
+	double	getTargetFPS() const				{ return m_targetFPS; }
+	void	setIdleMode(bool bIdle)				{ m_bIdleMode = bIdle; }
+	bool	isIdleMode() const					{ return m_bIdleMode; }
+	void	setFixedStep(double secs)			{ ASSERT(secs > 0); m_fixedStep = secs; }
+	double	getFixedStep() const				{ return m_fixedStep; }
+	void	setMaxSteps(size_t n)				{ ASSERT(n > 0); m_maxSteps = n; }	// the rest is dropped
+
+	// wake up the idle loop: render a frame as soon as the pacing allows
+	void	requestFrame()						{ m_bFrameRequested = true; }
+	// while animating, frames are rendered even in idle mode. Set after each frame.
+	void	setAnimating(bool bAnimating)		{ m_bAnimating = bAnimating; }
+	bool	isAnimating() const					{ return m_bAnimating; }
+
+	// secs to wait before the next frame: 0 if a frame is due, <0 to wait for an event
+	double	getWaitTime();
+	bool	isFrameDue()						{ return getWaitTime() == 0; }
+
+	void	beginFrame();
+	void	endFrame();
+
+	// valid between beginFrame() and endFrame()
+	double	getFrameTime() const				{ return m_frameStart; }	// Timer::now() at the start of the frame
+	double	getFrameDelta() const				{ return m_frameDelta; }	// secs since the last frame (0 after idling)
+	size_t	getStepsNum() const					{ return m_stepsNum; }
+	double	getStepAlpha() const				{ return m_accumulator / m_fixedStep; }
+
+	const Stats&	getStats() const			{ return m_stats; }
+
+	// sleeps for a precise amount of time (the OS sleep granularity is coarse: spins for the rest)
+	static void	sleep(double secs);
+};
+
+#endif
@@ -0,0 +1,395 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Gemm.h"
+#include "AlignedAlloc.h"
+#include "ThreadPool.h"
+#include "Timer.h"
+#include <emmintrin.h>
+#include <math.h>
+
+// the AVX2/FMA intrinsics need VS2012 or a gcc/clang invoked with -mavx2 -mfma
+#if (defined(_MSC_VER) && _MSC_VER >= 1700) || (defined(__AVX2__) && defined(__FMA__))
+	#define BCORE_HAS_AVX2_INTRINSICS
+	#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace {
+
+// cache blocking: a KC x NR panel of B stays in L1, an MC x KC block of A in L2
+const size_t MC = 96;		// a multiple of every MR
+const size_t KC = 256;
+const size_t NC = 4096;
+
+// micro-kernel: c[MR x NR] (row stride ldc) += a[kc x MR] * b[kc x NR], both packed
+template <class T>
+struct Kernel
+{
+	typedef void (*Func)(size_t kc, const T *a, const T *b, T *c, size_t ldc);
+	Func	func;
+	size_t	mr, nr;
+};
+
+// SSE2, double, 4x4
+void kernelSSE2(size_t kc, const double *a, const double *b, double *c, size_t ldc)
+{
+	__m128d c00 = _mm_setzero_pd(), c01 = _mm_setzero_pd();
+	__m128d c10 = _mm_setzero_pd(), c11 = _mm_setzero_pd();
+	__m128d c20 = _mm_setzero_pd(), c21 = _mm_setzero_pd();
+	__m128d c30 = _mm_setzero_pd(), c31 = _mm_setzero_pd();
+	for (size_t p=0; p<kc; ++p, a+=4, b+=4)
+	{
+		__m128d b0 = _mm_load_pd(b), b1 = _mm_load_pd(b+2);
+		__m128d ar = _mm_set1_pd(a[0]);
+		c00 = _mm_add_pd(c00, _mm_mul_pd(ar, b0)); c01 = _mm_add_pd(c01, _mm_mul_pd(ar, b1));
+		ar = _mm_set1_pd(a[1]);
+		c10 = _mm_add_pd(c10, _mm_mul_pd(ar, b0)); c11 = _mm_add_pd(c11, _mm_mul_pd(ar, b1));
+		ar = _mm_set1_pd(a[2]);
+		c20 = _mm_add_pd(c20, _mm_mul_pd(ar, b0)); c21 = _mm_add_pd(c21, _mm_mul_pd(ar, b1));
+		ar = _mm_set1_pd(a[3]);
+		c30 = _mm_add_pd(c30, _mm_mul_pd(ar, b0)); c31 = _mm_add_pd(c31, _mm_mul_pd(ar, b1));
+	}
+	_mm_storeu_pd(c,         _mm_add_pd(_mm_loadu_pd(c),         c00));
+	_mm_storeu_pd(c+2,       _mm_add_pd(_mm_loadu_pd(c+2),       c01));
+	_mm_storeu_pd(c+ldc,     _mm_add_pd(_mm_loadu_pd(c+ldc),     c10));
+	_mm_storeu_pd(c+ldc+2,   _mm_add_pd(_mm_loadu_pd(c+ldc+2),   c11));
+	_mm_storeu_pd(c+2*ldc,   _mm_add_pd(_mm_loadu_pd(c+2*ldc),   c20));
+	_mm_storeu_pd(c+2*ldc+2, _mm_add_pd(_mm_loadu_pd(c+2*ldc+2), c21));
+	_mm_storeu_pd(c+3*ldc,   _mm_add_pd(_mm_loadu_pd(c+3*ldc),   c30));
+	_mm_storeu_pd(c+3*ldc+2, _mm_add_pd(_mm_loadu_pd(c+3*ldc+2), c31));
+}
+
+// SSE, float, 4x8
+void kernelSSE2(size_t kc, const float *a, const float *b, float *c, size_t ldc)
+{
+	__m128 c00 = _mm_setzero_ps(), c01 = _mm_setzero_ps();
+	__m128 c10 = _mm_setzero_ps(), c11 = _mm_setzero_ps();
+	__m128 c20 = _mm_setzero_ps(), c21 = _mm_setzero_ps();
+	__m128 c30 = _mm_setzero_ps(), c31 = _mm_setzero_ps();
+	for (size_t p=0; p<kc; ++p, a+=4, b+=8)
+	{
+		__m128 b0 = _mm_load_ps(b), b1 = _mm_load_ps(b+4);
+		__m128 ar = _mm_set1_ps(a[0]);
+		c00 = _mm_add_ps(c00, _mm_mul_ps(ar, b0)); c01 = _mm_add_ps(c01, _mm_mul_ps(ar, b1));
+		ar = _mm_set1_ps(a[1]);
+		c10 = _mm_add_ps(c10, _mm_mul_ps(ar, b0)); c11 = _mm_add_ps(c11, _mm_mul_ps(ar, b1));
+		ar = _mm_set1_ps(a[2]);
+		c20 = _mm_add_ps(c20, _mm_mul_ps(ar, b0)); c21 = _mm_add_ps(c21, _mm_mul_ps(ar, b1));
+		ar = _mm_set1_ps(a[3]);
+		c30 = _mm_add_ps(c30, _mm_mul_ps(ar, b0)); c31 = _mm_add_ps(c31, _mm_mul_ps(ar, b1));
+	}
+	_mm_storeu_ps(c,         _mm_add_ps(_mm_loadu_ps(c),         c00));
+	_mm_storeu_ps(c+4,       _mm_add_ps(_mm_loadu_ps(c+4),       c01));
+	_mm_storeu_ps(c+ldc,     _mm_add_ps(_mm_loadu_ps(c+ldc),     c10));
+	_mm_storeu_ps(c+ldc+4,   _mm_add_ps(_mm_loadu_ps(c+ldc+4),   c11));
+	_mm_storeu_ps(c+2*ldc,   _mm_add_ps(_mm_loadu_ps(c+2*ldc),   c20));
+	_mm_storeu_ps(c+2*ldc+4, _mm_add_ps(_mm_loadu_ps(c+2*ldc+4), c21));
+	_mm_storeu_ps(c+3*ldc,   _mm_add_ps(_mm_loadu_ps(c+3*ldc),   c30));
+	_mm_storeu_ps(c+3*ldc+4, _mm_add_ps(_mm_loadu_ps(c+3*ldc+4), c31));
+}
+
+#ifdef BCORE_HAS_AVX2_INTRINSICS
+// AVX2/FMA, double, 6x8: 12 accumulators + 2 for b + 1 for a
+void kernelAVX2(size_t kc, const double *a, const double *b, double *c, size_t ldc)
+{
+	__m256d acc[6][2];
+	for (int r=0; r<6; ++r)
+		acc[r][0] = acc[r][1] = _mm256_setzero_pd();
+	for (size_t p=0; p<kc; ++p, a+=6, b+=8)
+	{
+		__m256d b0 = _mm256_load_pd(b), b1 = _mm256_load_pd(b+4);
+		for (int r=0; r<6; ++r) {
+			__m256d ar = _mm256_broadcast_sd(a+r);
+			acc[r][0] = _mm256_fmadd_pd(ar, b0, acc[r][0]);
+			acc[r][1] = _mm256_fmadd_pd(ar, b1, acc[r][1]);
+		}
+	}
+	for (int r=0; r<6; ++r, c+=ldc) {
+		_mm256_storeu_pd(c,   _mm256_add_pd(_mm256_loadu_pd(c),   acc[r][0]));
+		_mm256_storeu_pd(c+4, _mm256_add_pd(_mm256_loadu_pd(c+4), acc[r][1]));
+	}
+}
+
+// AVX2/FMA, float, 6x16
+void kernelAVX2(size_t kc, const float *a, const float *b, float *c, size_t ldc)
+{
+	__m256 acc[6][2];
+	for (int r=0; r<6; ++r)
+		acc[r][0] = acc[r][1] = _mm256_setzero_ps();
+	for (size_t p=0; p<kc; ++p, a+=6, b+=16)
+	{
+		__m256 b0 = _mm256_load_ps(b), b1 = _mm256_load_ps(b+8);
+		for (int r=0; r<6; ++r) {
+			__m256 ar = _mm256_broadcast_ss(a+r);
+			acc[r][0] = _mm256_fmadd_ps(ar, b0, acc[r][0]);
+			acc[r][1] = _mm256_fmadd_ps(ar, b1, acc[r][1]);
+		}
+	}
+	for (int r=0; r<6; ++r, c+=ldc) {
+		_mm256_storeu_ps(c,   _mm256_add_ps(_mm256_loadu_ps(c),   acc[r][0]));
+		_mm256_storeu_ps(c+8, _mm256_add_ps(_mm256_loadu_ps(c+8), acc[r][1]));
+	}
+}
+#endif
+
+bool detectAVX2FMA()
+{
+#ifdef BCORE_HAS_AVX2_INTRINSICS
+	// AVX, FMA and OS support for the AVX registers (OSXSAVE + XCR0), then AVX2
+	int info[4];
+#ifdef _MSC_VER
+	__cpuid(info, 1);
+#else
+	__asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(1), "c"(0));
+#endif
+	const int needed = (1 << 28) | (1 << 27) | (1 << 12);
+	if ((info[2] & needed) != needed)
+		return false;
+	if ((_xgetbv(0) & 6) != 6)
+		return false;
+#ifdef _MSC_VER
+	__cpuidex(info, 7, 0);
+#else
+	__asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(7), "c"(0));
+#endif
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return false;
+#endif
+}
+
+template <class T>
+void selectKernel(Kernel<T> &kernel)
+{
+#ifdef BCORE_HAS_AVX2_INTRINSICS
+	if (Gemm::hasAVX2FMA()) {
+		kernel.func = &kernelAVX2;
+		kernel.mr = 6;
+		kernel.nr = 32/sizeof(T)*2;
+		return;
+	}
+#endif
+	kernel.func = &kernelSSE2;
+	kernel.mr = 4;
+	kernel.nr = 16/sizeof(T)*2;
+}
+
+// copy an mc x kc block of A to panels of mr rows, stored column by column;
+// the rows past the end of the block are zero
+template <class T>
+void packA(size_t mc, size_t kc, const T *A, size_t lda, size_t mr, T *out)
+{
+	for (size_t i=0; i<mc; i+=mr)
+	{
+		size_t rows = (mc-i < mr) ? mc-i : mr;
+		for (size_t p=0; p<kc; ++p) {
+			size_t r = 0;
+			for (; r<rows; ++r)
+				*out++ = A[(i+r)*lda + p];
+			for (; r<mr; ++r)
+				*out++ = 0;
+		}
+	}
+}
+
+// copy a kc x nc panel of B to panels of nr columns, stored row by row;
+// the columns past the end of the panel are zero
+template <class T>
+void packB(size_t kc, size_t nc, const T *B, size_t ldb, size_t nr, T *out)
+{
+	for (size_t j=0; j<nc; j+=nr)
+	{
+		size_t cols = (nc-j < nr) ? nc-j : nr;
+		for (size_t p=0; p<kc; ++p) {
+			const T *row = B + p*ldb + j;
+			size_t c = 0;
+			for (; c<cols; ++c)
+				*out++ = row[c];
+			for (; c<nr; ++c)
+				*out++ = 0;
+		}
+	}
+}
+
+// multiplies blocks of rows of A by a packed panel of B
+template <class T>
+class GemmJob : public ThreadPool::RangeJob
+{
+	const Kernel<T>	&m_kernel;
+	size_t		m_m, m_nc, m_kc, m_mc;
+	const T		*m_A;
+	size_t		m_lda;
+	const T		*m_Bp;
+	T			*m_C;
+	size_t		m_ldc;
+public:
+	GemmJob(const Kernel<T> &kernel, size_t m, size_t nc, size_t kc, size_t mc, const T *A, size_t lda, const T *Bp, T *C, size_t ldc) :
+		m_kernel(kernel), m_m(m), m_nc(nc), m_kc(kc), m_mc(mc), m_A(A), m_lda(lda), m_Bp(Bp), m_C(C), m_ldc(ldc) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		size_t mr = m_kernel.mr, nr = m_kernel.nr;
+		size_t apBytes = m_mc*m_kc*sizeof(T);
+		T *Ap = (T*)AlignedAlloc::alloc(apBytes);
+		T edge[8*32];	// a tile at the edges of C, at most 8x32 (the largest mr x nr)
+
+		for (size_t blk=begin; blk<end; ++blk)
+		{
+			size_t ic = blk*m_mc;
+			size_t mc = (m_m-ic < m_mc) ? m_m-ic : m_mc;
+			packA(mc, m_kc, m_A + ic*m_lda, m_lda, mr, Ap);
+
+			for (size_t jr=0; jr<m_nc; jr+=nr)
+			{
+				size_t cols = (m_nc-jr < nr) ? m_nc-jr : nr;
+				const T *bp = m_Bp + jr*m_kc;
+				for (size_t ir=0; ir<mc; ir+=mr)
+				{
+					size_t rows = (mc-ir < mr) ? mc-ir : mr;
+					const T *ap = Ap + ir*m_kc;
+					T *c = m_C + (ic+ir)*m_ldc + jr;
+					if (rows == mr && cols == nr)
+						m_kernel.func(m_kc, ap, bp, c, m_ldc);
+					else {
+						for (size_t i=0; i<mr*nr; ++i)
+							edge[i] = 0;
+						m_kernel.func(m_kc, ap, bp, edge, nr);
+						for (size_t r=0; r<rows; ++r)
+							for (size_t j=0; j<cols; ++j)
+								c[r*m_ldc + j] += edge[r*nr + j];
+					}
+				}
+			}
+		}
+		AlignedAlloc::free(Ap, apBytes);
+	}
+};
+
+template <class T>
+void gemm(size_t m, size_t n, size_t k, const T *A, size_t lda, const T *B, size_t ldb, T *C, size_t ldc)
+{
+	if (m == 0 || n == 0 || k == 0)
+		return;
+
+	Kernel<T> kernel;
+	selectKernel(kernel);
+
+	// smaller row blocks when there are too few of them to keep all threads busy
+	size_t nThreads = ThreadPool::inst()->getThreadsNum() + 1;
+	size_t mc = MC;
+	if ((m + mc-1)/mc < nThreads) {
+		size_t rows = (m + nThreads-1)/nThreads;
+		mc = (rows + kernel.mr-1)/kernel.mr*kernel.mr;
+	}
+	size_t nBlocks = (m + mc-1)/mc;
+
+	size_t ncMax = (n < NC) ? n : NC;
+	size_t bpBytes = KC*((ncMax + kernel.nr-1)/kernel.nr*kernel.nr)*sizeof(T);
+	T *Bp = (T*)AlignedAlloc::alloc(bpBytes);
+
+	for (size_t jc=0; jc<n; jc+=NC)
+	{
+		size_t nc = (n-jc < NC) ? n-jc : NC;
+		for (size_t pc=0; pc<k; pc+=KC)
+		{
+			size_t kc = (k-pc < KC) ? k-pc : KC;
+			packB(kc, nc, B + pc*ldb + jc, ldb, kernel.nr, Bp);
+
+			GemmJob<T> job(kernel, m, nc, kc, mc, A + pc, lda, Bp, C + jc, ldc);
+			ThreadPool::inst()->parallelFor(job, 0, nBlocks, 1);
+		}
+	}
+
+	AlignedAlloc::free(Bp, bpBytes);
+}
+
+// the plain triple loop that Matrix operator * used, for the benchmark
+template <class T>
+void naiveMultiply(size_t n, const T *A, const T *B, T *C)
+{
+	for (size_t i=0; i<n; ++i)
+		for (size_t j=0; j<n; ++j)
+			for (size_t k=0; k<n; ++k)
+				C[j*n + i] += A[j*n + k] * B[k*n + i];
+}
+
+template <class T>
+void benchmarkType(const char *name, size_t n)
+{
+	std::vector<T> A(n*n), B(n*n), C1(n*n, 0), C2(n*n, 0);
+	for (size_t i=0; i<n*n; ++i) {
+		A[i] = (T)(rand()/(double)RAND_MAX - 0.5);
+		B[i] = (T)(rand()/(double)RAND_MAX - 0.5);
+	}
+	double flops = 2.0*n*n*n;
+
+	Timer timer;
+	naiveMultiply(n, &A[0], &B[0], &C1[0]);
+	double tNaive = timer.elapsed();
+
+	timer.reset();
+	Gemm::multiplyAdd(n, n, n, &A[0], n, &B[0], n, &C2[0], n);
+	double tGemm = timer.elapsed();
+
+	double maxDiff = 0;
+	for (size_t i=0; i<n*n; ++i)
+		if (fabs((double)C1[i] - C2[i]) > maxDiff)
+			maxDiff = fabs((double)C1[i] - C2[i]);
+
+	Console::print("gemm %s %dx%d: naive %.2f GFLOPS (%.3fs), blocked %.2f GFLOPS (%.3fs), speedup %.1fx, max diff %g\n",
+		name, (int)n, (int)n, flops/tNaive*1e-9, tNaive, flops/tGemm*1e-9, tGemm, tNaive/tGemm, maxDiff);
+}
+
+};
+
+bool Gemm::hasAVX2FMA()
+{
+	static bool bInited = false;
+	static bool bHas = false;
+	if (!bInited) {
+		bHas = detectAVX2FMA();
+		bInited = true;
+	}
+	return bHas;
+}
+
+void Gemm::multiplyAdd(size_t m, size_t n, size_t k, const double *A, size_t lda,
+						const double *B, size_t ldb, double *C, size_t ldc)
+{
+	gemm(m, n, k, A, lda, B, ldb, C, ldc);
+}
+
+void Gemm::multiplyAdd(size_t m, size_t n, size_t k, const float *A, size_t lda,
+						const float *B, size_t ldb, float *C, size_t ldc)
+{
+	gemm(m, n, k, A, lda, B, ldb, C, ldc);
+}
+
+void Gemm::benchmark(size_t n)
+{
+	Console::print("gemm: %s kernels, %d threads\n", hasAVX2FMA() ? "AVX2/FMA" : "SSE2",
+		(int)ThreadPool::inst()->getThreadsNum()+1);
+	benchmarkType<float>("float", n);
+	benchmarkType<double>("double", n);
+}
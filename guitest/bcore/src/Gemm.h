@@ -0,0 +1,60 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _GEMM_H45631_INCLUDED_
+#define _GEMM_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * Gemm: general matrix multiplication, C += A*B, for float and double matrices
+ *		stored row by row (A is m x k, B is k x n, C is m x n, and lda, ldb, ldc
+ *		are the distances between consecutive rows).
+ *
+ *		The operands are multiplied in blocks that fit the L1/L2 caches. Each block
+ *		of A and panel of B is first packed into contiguous memory in the order the
+ *		micro-kernel reads it. The micro-kernel keeps a small tile of C in registers.
+ *		It uses AVX2/FMA when the compiler and the cpu support them, SSE2 otherwise.
+ *		Blocks of rows of C are computed in parallel on the thread pool.
+ *
+ *		Matrix<float> and Matrix<double> operator * use it for products of at least
+ *		MIN_FLOPS multiply-adds.
+ */
+class Gemm
+{
+public:
+	enum { MIN_FLOPS = 32*32*32 };
+
+	static void	multiplyAdd(size_t m, size_t n, size_t k, const double *A, size_t lda,
+							const double *B, size_t ldb, double *C, size_t ldc);
+	static void	multiplyAdd(size_t m, size_t n, size_t k, const float *A, size_t lda,
+							const float *B, size_t ldb, float *C, size_t ldc);
+
+	static bool	hasAVX2FMA();
+
+	// times the blocked multiply against a plain triple loop on random n x n float and
+	// double matrices, and prints GFLOPS and the largest difference to the console
+	static void	benchmark(size_t n = 1024);
+};
+
+#endif
@@ -0,0 +1,428 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "HDRCodec.h"
+#include "ThreadPool.h"
+#include <emmintrin.h>
+#include <string.h>
+
+namespace {
+
+// rgbe exponent to float scale, as ldexp(1, e-(128+8)). 0 is a black pixel. Built during
+// static initialization, as images are decoded on any thread
+struct RGBEScaleTable {
+	float v[256];
+	RGBEScaleTable() {
+		v[0] = 0;
+		for (int e=1; e<256; ++e)
+			v[e] = (float)ldexp(1.0, e-(128+8));
+	}
+};
+const RGBEScaleTable g_rgbeScale;
+
+// a scanline is run-length encoded if it starts with 2,2 and its width
+// (the encoding is only used for widths in [8, 0x7fff])
+inline bool isRLEScanline(const unsigned char *p, const unsigned char *end, int width)
+{
+	if (width < 8 || width > 0x7fff || end - p < 4)
+		return false;
+	return p[0] == 2 && p[1] == 2 && ((p[2] << 8) | p[3]) == width && !(p[2] & 0x80);
+}
+
+// skip over one scanline, checking that it is complete. Returns 0 on bad data.
+const unsigned char* skipScanline(const unsigned char *p, const unsigned char *end, int width)
+{
+	if (!isRLEScanline(p, end, width)) {
+		if ((size_t)(end - p) < 4*(size_t)width)
+			return 0;
+		return p + 4*width;
+	}
+
+	p += 4;
+	for (int c=0; c<4; ++c) {
+		int x = 0;
+		while (x < width) {
+			if (p >= end)
+				return 0;
+			int n = *p;
+			if (n > 128) {
+				n -= 128;
+				p += 2;
+			}
+			else
+				p += 1 + n;
+			if (n == 0 || x + n > width || p > end)
+				return 0;
+			x += n;
+		}
+	}
+	return p;
+}
+
+// decode an already validated RLE scanline to 4 planes of width bytes (R, G, B, E)
+void decodeRLEScanline(const unsigned char *p, int width, unsigned char *planes)
+{
+	p += 4;
+	for (int c=0; c<4; ++c) {
+		unsigned char *dst = planes + c*width;
+		unsigned char *dstEnd = dst + width;
+		while (dst < dstEnd) {
+			int n = *p++;
+			if (n > 128) {
+				memset(dst, *p++, n-128);
+				dst += n-128;
+			}
+			else {
+				memcpy(dst, p, n);
+				dst += n;
+				p += n;
+			}
+		}
+	}
+}
+
+// convert planar RGBE to interleaved float RGB
+void planesToFloat(const unsigned char *planes, int width, float *out)
+{
+	const unsigned char *R = planes, *G = planes+width, *B = planes+2*width, *E = planes+3*width;
+	const __m128i zero = _mm_setzero_si128();
+
+	int x = 0;
+	for (; x+4 <= width; x+=4, out+=12)
+	{
+		__m128 s = _mm_setr_ps(g_rgbeScale.v[E[x]], g_rgbeScale.v[E[x+1]], g_rgbeScale.v[E[x+2]], g_rgbeScale.v[E[x+3]]);
+		__m128 r = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(R+x)), zero), zero)), s);
+		__m128 g = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(G+x)), zero), zero)), s);
+		__m128 b = _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(*(const int*)(B+x)), zero), zero)), s);
+
+		// interleave 4 r, g, b to r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+		__m128 rg01 = _mm_unpacklo_ps(r, g);
+		__m128 rg23 = _mm_unpackhi_ps(r, g);
+		__m128 t0 = _mm_shuffle_ps(b, rg01, _MM_SHUFFLE(2,2,0,0));
+		__m128 t1 = _mm_shuffle_ps(rg01, b, _MM_SHUFFLE(1,1,3,3));
+		__m128 t2 = _mm_shuffle_ps(b, rg23, _MM_SHUFFLE(2,2,2,2));
+		__m128 t3 = _mm_shuffle_ps(rg23, b, _MM_SHUFFLE(3,3,3,3));
+		_mm_storeu_ps(out,   _mm_shuffle_ps(rg01, t0, _MM_SHUFFLE(2,0,1,0)));
+		_mm_storeu_ps(out+4, _mm_shuffle_ps(t1, rg23, _MM_SHUFFLE(1,0,2,0)));
+		_mm_storeu_ps(out+8, _mm_shuffle_ps(t2, t3, _MM_SHUFFLE(2,0,2,0)));
+	}
+	for (; x<width; ++x, out+=3) {
+		float s = g_rgbeScale.v[E[x]];
+		out[0] = R[x]*s;
+		out[1] = G[x]*s;
+		out[2] = B[x]*s;
+	}
+}
+
+class DecodeJob : public ThreadPool::RangeJob
+{
+	const std::vector<const unsigned char*>	&m_scanlines;
+	const unsigned char	*m_end;
+	Image				&m_image;
+	int					m_width;
+public:
+	DecodeJob(const std::vector<const unsigned char*> &scanlines, const unsigned char *end, Image &image) :
+		m_scanlines(scanlines), m_end(end), m_image(image), m_width((int)image.getWidth()) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		bool bHalf = (m_image.getFormat() == Image::F16BITS);
+		std::vector<unsigned char> planes(4*m_width);
+		std::vector<float> row(bHalf ? 3*m_width : 0);
+		for (size_t y=begin; y<end; ++y)
+		{
+			const unsigned char *p = m_scanlines[y];
+			float *out = (bHalf) ? &row[0] : (float*)m_image(0, y);
+			if (isRLEScanline(p, m_end, m_width)) {
+				decodeRLEScanline(p, m_width, &planes[0]);
+				planesToFloat(&planes[0], m_width, out);
+			}
+			else {
+				// flat scanline, rgbe pixels one after the other
+				for (int x=0; x<m_width; ++x, p+=4, out+=3) {
+					float s = g_rgbeScale.v[p[3]];
+					out[0] = p[0]*s;
+					out[1] = p[1]*s;
+					out[2] = p[2]*s;
+				}
+			}
+			if (bHalf)
+				Half::fromFloat(&row[0], (float16_t*)m_image(0, y), row.size());
+		}
+	}
+};
+
+// standard float to rgbe conversion (same as RNL/rgbe.cpp)
+inline void floatToRGBE(unsigned char rgbe[4], float red, float green, float blue)
+{
+	float v = red;
+	if (green > v) v = green;
+	if (blue > v) v = blue;
+	if (v < 1e-32) {
+		rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+	}
+	else {
+		int e;
+		v = (float)frexp(v, &e) * 256.0f/v;
+		rgbe[0] = (unsigned char)(red * v);
+		rgbe[1] = (unsigned char)(green * v);
+		rgbe[2] = (unsigned char)(blue * v);
+		rgbe[3] = (unsigned char)(e + 128);
+	}
+}
+
+// run-length encode one plane of a scanline, as in Ward's original code:
+// runs of at least 4 equal bytes are coded as runs, everything else as literals
+void encodePlane(const unsigned char *data, int n, std::vector<unsigned char> &out)
+{
+	const int MINRUN = 4;
+	int cur = 0;
+	while (cur < n)
+	{
+		// find the next run of at least MINRUN bytes
+		int begRun = cur;
+		int runCount = 0, oldRunCount = 0;
+		while (runCount < MINRUN && begRun < n) {
+			begRun += runCount;
+			oldRunCount = runCount;
+			runCount = 1;
+			while (begRun + runCount < n && runCount < 127 && data[begRun] == data[begRun + runCount])
+				runCount++;
+		}
+
+		// a short run just before the long one is written as a run too
+		if (oldRunCount > 1 && oldRunCount == begRun - cur) {
+			out.push_back((unsigned char)(128 + oldRunCount));
+			out.push_back(data[cur]);
+			cur = begRun;
+		}
+
+		// literals up to the start of the run
+		while (cur < begRun) {
+			int nonRun = begRun - cur;
+			if (nonRun > 128)
+				nonRun = 128;
+			out.push_back((unsigned char)nonRun);
+			out.insert(out.end(), data + cur, data + cur + nonRun);
+			cur += nonRun;
+		}
+
+		// the run
+		if (runCount >= MINRUN) {
+			out.push_back((unsigned char)(128 + runCount));
+			out.push_back(data[begRun]);
+			cur += runCount;
+		}
+	}
+}
+
+class EncodeJob : public ThreadPool::RangeJob
+{
+	const Image		&m_image;
+	std::vector< std::vector<unsigned char> >	&m_scanlines;
+public:
+	EncodeJob(const Image &image, std::vector< std::vector<unsigned char> > &scanlines) :
+		m_image(image), m_scanlines(scanlines) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		int width = (int)m_image.getWidth();
+		size_t nChannels = m_image.getChannelsNum();
+		bool bRLE = (width >= 8 && width <= 0x7fff);
+		bool bHalf = (m_image.getFormat() == Image::F16BITS);
+		std::vector<unsigned char> planes(4*width);
+		std::vector<float> row(bHalf ? width*nChannels : 0);
+		for (size_t y=begin; y<end; ++y)
+		{
+			std::vector<unsigned char> &out = m_scanlines[y];
+			const float *in = (const float*)m_image(0, y);
+			if (bHalf) {
+				Half::toFloat((const float16_t*)m_image(0, y), &row[0], row.size());
+				in = &row[0];
+			}
+			unsigned char rgbe[4];
+			if (!bRLE) {
+				out.resize(4*width);
+				for (int x=0; x<width; ++x, in+=nChannels) {
+					if (nChannels == 1)
+						floatToRGBE(&out[4*x], in[0], in[0], in[0]);
+					else
+						floatToRGBE(&out[4*x], in[0], in[1], in[2]);
+				}
+				continue;
+			}
+
+			for (int x=0; x<width; ++x, in+=nChannels) {
+				if (nChannels == 1)
+					floatToRGBE(rgbe, in[0], in[0], in[0]);
+				else
+					floatToRGBE(rgbe, in[0], in[1], in[2]);
+				for (int c=0; c<4; ++c)
+					planes[c*width + x] = rgbe[c];
+			}
+			out.reserve(4*width + 16);
+			out.push_back(2);
+			out.push_back(2);
+			out.push_back((unsigned char)(width >> 8));
+			out.push_back((unsigned char)(width & 0xFF));
+			for (int c=0; c<4; ++c)
+				encodePlane(&planes[c*width], width, out);
+		}
+	}
+};
+
+};
+
+bool HDRCodec::parseHeader(const unsigned char *&p, const unsigned char *end, Header &header)
+{
+	// header lines, up to an empty line
+	bool bFirst = true;
+	while (true)
+	{
+		const unsigned char *eol = (const unsigned char*)memchr(p, '\n', end - p);
+		if (!eol) {
+			Console::error("HDRCodec: unexpected end of header\n");
+			return false;
+		}
+		std::string line((const char*)p, eol - p);
+		p = eol + 1;
+		if (!line.empty() && line[line.size()-1] == '\r')
+			line.erase(line.size()-1);
+
+		if (line.empty()) {
+			if (bFirst)
+				continue;
+			break;
+		}
+		bFirst = false;
+
+		float val;
+		if (line.compare(0, 7, "FORMAT=") == 0) {
+			if (line != "FORMAT=32-bit_rle_rgbe") {
+				Console::error("HDRCodec: format not supported (%s)\n", line.c_str());
+				return false;
+			}
+		}
+		else if (sscanf(line.c_str(), "EXPOSURE=%g", &val) == 1)
+			header.exposure = val;
+		else if (sscanf(line.c_str(), "GAMMA=%g", &val) == 1)
+			header.gamma = val;
+		// anything else (#?RADIANCE, comments, other variables) is ignored
+	}
+
+	// resolution string
+	const unsigned char *eol = (const unsigned char*)memchr(p, '\n', end - p);
+	if (!eol) {
+		Console::error("HDRCodec: missing image size\n");
+		return false;
+	}
+	std::string line((const char*)p, eol - p);
+	p = eol + 1;
+	if (sscanf(line.c_str(), "-Y %d +X %d", &header.height, &header.width) != 2) {
+		Console::error("HDRCodec: image orientation not supported (%s)\n", line.c_str());
+		return false;
+	}
+	if (header.width <= 0 || header.height <= 0) {
+		Console::error("HDRCodec: bad image size (%d x %d)\n", header.width, header.height);
+		return false;
+	}
+	return true;
+}
+
+bool HDRCodec::decodeHeader(const unsigned char *data, size_t size, Header &header)
+{
+	const unsigned char *p = data;
+	return parseHeader(p, data + size, header);
+}
+
+bool HDRCodec::decode(const unsigned char *data, size_t size, Image &image, Header *pHeader, Image::Format format)
+{
+	if (format != Image::F32BITS && format != Image::F16BITS) {
+		Console::error("HDRCodec::decode(): format not supported (%d)\n", format);
+		return false;
+	}
+
+	const unsigned char *p = data;
+	const unsigned char *end = data + size;
+	Header header;
+	if (!parseHeader(p, end, header))
+		return false;
+
+	// find the start of each scanline. This also checks the
+	// data, so that the decoding pass does not need to.
+	std::vector<const unsigned char*> scanlines(header.height);
+	for (int y=0; y<header.height; ++y) {
+		scanlines[y] = p;
+		p = skipScanline(p, end, header.width);
+		if (!p) {
+			Console::error("HDRCodec: bad or truncated data at scanline %d\n", y);
+			return false;
+		}
+	}
+
+	image.create(header.width, header.height, 3, format);
+	DecodeJob job(scanlines, end, image);
+	ThreadPool::inst()->parallelFor(job, 0, header.height, 16);
+
+	if (pHeader)
+		*pHeader = header;
+	return true;
+}
+
+bool HDRCodec::encode(const Image &image, std::vector<unsigned char> &out, const Header *pHeader)
+{
+	if ((image.getFormat() != Image::F32BITS && image.getFormat() != Image::F16BITS) ||
+		(image.getChannelsNum() != 1 && image.getChannelsNum() != 3 && image.getChannelsNum() != 4))
+	{
+		Console::error("HDRCodec::encode(): only F32BITS/F16BITS images with 1, 3 or 4 channels are supported\n");
+		return false;
+	}
+	if (image.isEmpty())
+		return false;
+
+	// header
+	char buf[256];
+	std::string hdr = "#?RADIANCE\n";
+	if (pHeader && pHeader->gamma != 1) {
+		sprintf(buf, "GAMMA=%g\n", pHeader->gamma);
+		hdr += buf;
+	}
+	if (pHeader && pHeader->exposure != 1) {
+		sprintf(buf, "EXPOSURE=%g\n", pHeader->exposure);
+		hdr += buf;
+	}
+	sprintf(buf, "FORMAT=32-bit_rle_rgbe\n\n-Y %d +X %d\n", (int)image.getHeight(), (int)image.getWidth());
+	hdr += buf;
+	out.insert(out.end(), hdr.begin(), hdr.end());
+
+	// scanlines are encoded in parallel, then put together
+	std::vector< std::vector<unsigned char> > scanlines(image.getHeight());
+	EncodeJob job(image, scanlines);
+	ThreadPool::inst()->parallelFor(job, 0, image.getHeight(), 16);
+
+	size_t total = out.size();
+	for (size_t y=0; y<scanlines.size(); ++y)
+		total += scanlines[y].size();
+	out.reserve(total);
+	for (size_t y=0; y<scanlines.size(); ++y)
+		out.insert(out.end(), scanlines[y].begin(), scanlines[y].end());
+	return true;
+}
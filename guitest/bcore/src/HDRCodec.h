@@ -0,0 +1,70 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _HDRCODEC_H45631_INCLUDED_
+#define _HDRCODEC_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+
+/**
+ * HDRCodec: reads and writes Radiance .hdr (RGBE) images.
+ *
+ *		The decoder works on the whole file in memory. A first pass walks the
+ *		run-length encoded scanlines to find where each one starts, then bands
+ *		of scanlines are decoded in parallel on the ThreadPool. RGBE is turned
+ *		to float with a table of the 256 exponents and SSE2, giving the same
+ *		values as RNL/rgbe.cpp.
+ *
+ *		Only the standard orientation (-Y h +X w) and the 32-bit_rle_rgbe
+ *		format are supported.
+ */
+class HDRCodec
+{
+public:
+	struct Header {
+		int		width, height;
+		float	exposure;
+		float	gamma;
+
+		Header() : width(0), height(0), exposure(1), gamma(1) { }
+	};
+
+	// decode the contents of a .hdr file to an RGB image. The format can be F32BITS or
+	// F16BITS; half floats are converted from the decoded scanlines, without a float copy
+	// of the whole image.
+	static bool decode(const unsigned char *data, size_t size, Image &image, Header *pHeader = 0,
+						Image::Format format = Image::F32BITS);
+
+	// encode a F32BITS or F16BITS image with 1, 3 or 4 channels (alpha is dropped)
+	// using run-length encoded scanlines. The result is appended to out.
+	static bool encode(const Image &image, std::vector<unsigned char> &out, const Header *pHeader = 0);
+
+	// parse only the header, fe. to find the image size without decoding
+	static bool decodeHeader(const unsigned char *data, size_t size, Header &header);
+
+private:
+	static bool parseHeader(const unsigned char *&p, const unsigned char *end, Header &header);
+};
+
+#endif
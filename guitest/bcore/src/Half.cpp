@@ -0,0 +1,259 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Half.h"
+#include <emmintrin.h>
+#include <string.h>
+
+// the F16C intrinsics need VS2012 or a gcc/clang invoked with -mf16c
+#if (defined(_MSC_VER) && _MSC_VER >= 1700) || defined(__F16C__)
+	#define BCORE_HAS_F16C_INTRINSICS
+	#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace {
+
+inline uint32_t floatBits(float f)		{ uint32_t u; memcpy(&u, &f, 4); return u; }
+inline float bitsFloat(uint32_t u)		{ float f; memcpy(&f, &u, 4); return f; }
+
+// SSE2 half -> float for 4 values in the low 16 bits of each lane.
+// Denormals are handled by the scale with 2^112.
+inline __m128 halfToFloat4(__m128i h)
+{
+	const __m128i maskNoSign	= _mm_set1_epi32(0x7fff);
+	const __m128  magic			= _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+	const __m128i wasInfNan		= _mm_set1_epi32(0x7bff);
+	const __m128i expInfNan		= _mm_set1_epi32(255 << 23);
+
+	__m128i expmant		= _mm_and_si128(maskNoSign, h);
+	__m128i justsign	= _mm_xor_si128(h, expmant);
+	__m128 scaled		= _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), magic);
+	__m128i bInfNan		= _mm_cmpgt_epi32(expmant, wasInfNan);
+	__m128i sign		= _mm_slli_epi32(justsign, 16);
+	__m128i infnanexp	= _mm_and_si128(bInfNan, expInfNan);
+	return _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infnanexp)));
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// SSE2 float -> half for 4 values, result in the low 16 bits of each lane
+inline __m128i floatToHalf4(__m128 x)
+{
+	const __m128i signMask		= _mm_set1_epi32(0x80000000);
+	const __m128i f16max		= _mm_set1_epi32(((127 + 16) << 23) - 1);
+	const __m128i f32infty		= _mm_set1_epi32(255 << 23);
+	const __m128i minNormal		= _mm_set1_epi32(113 << 23);
+	const __m128i denormMagic	= _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i normBias		= _mm_set1_epi32(((uint32_t)(15 - 127) << 23) + 0xfff);
+	const __m128i one			= _mm_set1_epi32(1);
+
+	__m128i f = _mm_castps_si128(x);
+	__m128i sign = _mm_and_si128(f, signMask);
+	f = _mm_xor_si128(f, sign);
+
+	// too large: inf, or nan for nans
+	__m128i bInfNan = _mm_cmpgt_epi32(f, f16max);
+	__m128i infnan = select(_mm_cmpgt_epi32(f, f32infty), _mm_set1_epi32(0x7e00), _mm_set1_epi32(0x7c00));
+
+	// denormals: let the fp adder do the rounding
+	__m128i bDenorm = _mm_cmplt_epi32(f, minNormal);
+	__m128i denorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(f), _mm_castsi128_ps(denormMagic))), denormMagic);
+
+	// normals: rebias the exponent and round to nearest even
+	__m128i mantOdd = _mm_and_si128(_mm_srli_epi32(f, 13), one);
+	__m128i norm = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(f, normBias), mantOdd), 13);
+
+	__m128i res = select(bInfNan, infnan, select(bDenorm, denorm, norm));
+	return _mm_or_si128(res, _mm_srli_epi32(sign, 16));
+}
+
+// pack the low 16 bits of the lanes of a and b
+inline __m128i pack16(__m128i a, __m128i b)
+{
+	// sign extend first, so that the signed saturation of packs keeps the bits
+	a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+	b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+	return _mm_packs_epi32(a, b);
+}
+
+#ifdef BCORE_HAS_F16C_INTRINSICS
+void toFloatF16C(const float16_t *in, float *out, size_t n)
+{
+	for (size_t i=0; i+8<=n; i+=8) {
+		__m128i h = _mm_loadu_si128((const __m128i*)(in+i));
+		_mm256_storeu_ps(out+i, _mm256_cvtph_ps(h));
+	}
+}
+
+void fromFloatF16C(const float *in, float16_t *out, size_t n)
+{
+	for (size_t i=0; i+8<=n; i+=8) {
+		__m256 f = _mm256_loadu_ps(in+i);
+		_mm_storeu_si128((__m128i*)(out+i), _mm256_cvtps_ph(f, 0));	// 0: round to nearest even
+	}
+}
+#endif
+
+bool detectF16C()
+{
+#ifdef BCORE_HAS_F16C_INTRINSICS
+	// F16C, AVX and OS support for the AVX registers (OSXSAVE + XCR0)
+	int info[4];
+#ifdef _MSC_VER
+	__cpuid(info, 1);
+#else
+	__asm__ __volatile__("cpuid" : "=a"(info[0]), "=b"(info[1]), "=c"(info[2]), "=d"(info[3]) : "a"(1), "c"(0));
+#endif
+	const int needed = (1 << 29) | (1 << 28) | (1 << 27);
+	if ((info[2] & needed) != needed)
+		return false;
+	return (_xgetbv(0) & 6) == 6;
+#else
+	return false;
+#endif
+}
+
+// there are only 256 possible values. The table is built during static initialization,
+// before any worker thread can use it
+struct Uint8ToHalfTable {
+	float16_t v[256];
+	Uint8ToHalfTable() {
+		for (int i=0; i<256; ++i)
+			v[i] = Half::fromFloat((float)(i/255.0));
+	}
+};
+const Uint8ToHalfTable g_uint8ToHalf;
+
+};
+
+bool Half::hasF16C()
+{
+	static bool bInited = false;
+	static bool bHas = false;
+	if (!bInited) {
+		bHas = detectF16C();
+		bInited = true;
+	}
+	return bHas;
+}
+
+float Half::toFloat(float16_t h)
+{
+	uint32_t expmant = h & 0x7fff;
+	float f = bitsFloat(expmant << 13) * bitsFloat((254 - 15) << 23);
+	uint32_t o = floatBits(f);
+	if (expmant > 0x7bff)
+		o |= 255 << 23;		// inf or nan
+	o |= (uint32_t)(h & 0x8000) << 16;
+	return bitsFloat(o);
+}
+
+float16_t Half::fromFloat(float x)
+{
+	uint32_t f = floatBits(x);
+	uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+
+	uint32_t o;
+	if (f >= (127 + 16) << 23)
+		o = (f > (255u << 23)) ? 0x7e00 : 0x7c00;
+	else if (f < (113 << 23)) {
+		const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+		o = floatBits(bitsFloat(f) + bitsFloat(denormMagic)) - denormMagic;
+	}
+	else {
+		uint32_t mantOdd = (f >> 13) & 1;
+		f += ((uint32_t)(15 - 127) << 23) + 0xfff;
+		f += mantOdd;
+		o = f >> 13;
+	}
+	return (float16_t)(o | (sign >> 16));
+}
+
+void Half::toFloat(const float16_t *in, float *out, size_t n)
+{
+	size_t i = 0;
+#ifdef BCORE_HAS_F16C_INTRINSICS
+	if (hasF16C()) {
+		toFloatF16C(in, out, n);
+		i = n & ~(size_t)7;
+	}
+#endif
+	const __m128i zero = _mm_setzero_si128();
+	for (; i+8<=n; i+=8) {
+		__m128i h = _mm_loadu_si128((const __m128i*)(in+i));
+		_mm_storeu_ps(out+i,   halfToFloat4(_mm_unpacklo_epi16(h, zero)));
+		_mm_storeu_ps(out+i+4, halfToFloat4(_mm_unpackhi_epi16(h, zero)));
+	}
+	for (; i<n; ++i)
+		out[i] = toFloat(in[i]);
+}
+
+void Half::fromFloat(const float *in, float16_t *out, size_t n)
+{
+	size_t i = 0;
+#ifdef BCORE_HAS_F16C_INTRINSICS
+	if (hasF16C()) {
+		fromFloatF16C(in, out, n);
+		i = n & ~(size_t)7;
+	}
+#endif
+	for (; i+8<=n; i+=8) {
+		__m128i lo = floatToHalf4(_mm_loadu_ps(in+i));
+		__m128i hi = floatToHalf4(_mm_loadu_ps(in+i+4));
+		_mm_storeu_si128((__m128i*)(out+i), pack16(lo, hi));
+	}
+	for (; i<n; ++i)
+		out[i] = fromFloat(in[i]);
+}
+
+void Half::fromUint8(const uint8_t *in, float16_t *out, size_t n)
+{
+	for (size_t i=0; i<n; ++i)
+		out[i] = g_uint8ToHalf.v[in[i]];
+}
+
+void Half::toUint8(const float16_t *in, uint8_t *out, size_t n)
+{
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 vmax = _mm_set1_ps(255.0f);
+	const __m128 vmin = _mm_setzero_ps();
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i+8<=n; i+=8) {
+		__m128i h = _mm_loadu_si128((const __m128i*)(in+i));
+		__m128 lo = _mm_min_ps(_mm_max_ps(_mm_mul_ps(halfToFloat4(_mm_unpacklo_epi16(h, zero)), scale), vmin), vmax);
+		__m128 hi = _mm_min_ps(_mm_max_ps(_mm_mul_ps(halfToFloat4(_mm_unpackhi_epi16(h, zero)), scale), vmin), vmax);
+		// round to nearest, as the scalar path
+		__m128i w = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+		_mm_storel_epi64((__m128i*)(out+i), _mm_packus_epi16(w, zero));
+	}
+	for (; i<n; ++i) {
+		float v = toFloat(in[i])*255.0f;
+		out[i] = (v > 0) ? ((v < 255) ? (uint8_t)(v + 0.5f) : 255) : 0;	// nans go to 0
+	}
+}
@@ -0,0 +1,54 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _HALF_H45631_INCLUDED_
+#define _HALF_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * Half: conversions between IEEE 754 half precision floats (float16_t) and
+ *		float/8-bit values. Float to half rounds to nearest even; infinities and
+ *		NaNs are kept, values too large for a half become infinity.
+ *
+ *		The array versions use the F16C instructions when the compiler and the
+ *		cpu support them, SSE2 otherwise, and convert any remaining elements one
+ *		at a time.
+ */
+class Half
+{
+public:
+	static float		toFloat(float16_t h);
+	static float16_t	fromFloat(float f);
+
+	static void	toFloat(const float16_t *in, float *out, size_t n);
+	static void	fromFloat(const float *in, float16_t *out, size_t n);
+
+	// 8-bit values map to [0,1], as in Image::changeFormat
+	static void	fromUint8(const uint8_t *in, float16_t *out, size_t n);
+	static void	toUint8(const float16_t *in, uint8_t *out, size_t n);	// clamped to [0,255]
+
+	static bool	hasF16C();
+};
+
+#endif
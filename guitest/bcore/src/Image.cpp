@@ -21,7 +21,9 @@
 
 #include "Image.h"
 #include "Texture.h"
-#include "RNL/rgbe.h"		// HDR file IO
+#include "HDRCodec.h"		// HDR file IO
+#include "MappedFile.h"
+#include "ImageStatistics.h"
 #include "misc.h"
 #include "histogram.h"
 #include "BaseTextFile.h"
@@ -33,7 +35,9 @@ Image::Image() : m_width(0),
 	m_bytesPerPixel(0),
 	m_bytesPerChannel(0),
 	m_exposure(1.0),
-	m_gamma(1.0)
+	m_gamma(1.0),
+	m_generation(0),
+	m_fullChangeGen(0)
 {
 }
 
@@ -54,6 +58,7 @@ void Image::create(size_t width, size_t height, unsigned char num_channels, Form
 	m_bytesPerChannel = getFormatSize(format);
 	m_bytesPerPixel = num_channels * m_bytesPerChannel;
 	m_data.resize(m_width*m_height*m_bytesPerPixel);
+	markAllDirty();
 }
 
 void Image::clear()
@@ -62,6 +67,38 @@ void Image::clear()
 	m_height = 0;
 	m_nChannels = 0;
 	m_data.clear();
+	markAllDirty();
+}
+
+void Image::markDirty(size_t minX, size_t minY, size_t maxX, size_t maxY)
+{
+	// a viewer that falls behind by more than this many changes reloads all of the image
+	const size_t MAX_CHANGES = 64;
+
+	Change change;
+	change.generation = ++m_generation;
+	change.rect = Rect<int>((int)minX, (int)minY, (int)maxX, (int)maxY);
+	m_changes.push_back(change);
+	if (m_changes.size() > MAX_CHANGES) {
+		m_fullChangeGen = m_changes.front().generation;
+		m_changes.pop_front();
+	}
+}
+
+void Image::markAllDirty()
+{
+	m_changes.clear();
+	m_fullChangeGen = ++m_generation;
+}
+
+bool Image::getChangesSince(size_t generation, DirtyRegion &region) const
+{
+	if (generation < m_fullChangeGen)
+		return false;
+	for (size_t i=0; i<m_changes.size(); ++i)
+		if (m_changes[i].generation > generation)
+			region.add(m_changes[i].rect);
+	return true;
 }
 
 size_t Image::getFormatSize(Image::Format format)
@@ -91,101 +128,31 @@ void Image::copy(const Image &image)
 	m_data = image.m_data;
 	m_exposure = image.m_exposure;
 	m_gamma = image.m_gamma;
+	markAllDirty();		// every pixel may have changed
 }
 
 bool Image::loadPPM(const std::string &fname)
 {
-	clear();
-
-/*	BaseTextFile file;
-	file.addLineCommentDef("#");
-	file.loadFile(fname, false);
-	std::string type;
-	file >> type;
-	int nChannels;
-	if (type == "P5")
-		nChannels = 1;
-	else if (type == "P6")
-		nChannels = 3;
-	else
-		return false;
-	int w, h;
-	file >> w;
-	file >> h;
-	int dummy;
-	file >> dummy;
-
-	Console::print("%d %d %d\n", w, h, dummy);
-
-	// Create the image
-	create(w, h, nChannels, Image::I8BITS);
-
-	// read the image data
-	fread(&m_data[0], sizeof(unsigned char), m_data.size(), file.getFP());
-
-	return true;
-*/
-	FILE *fp;
-	char imageType[3],str[1024];
-
-	// Read PGM image file with filename "file"
-
-	// The PGM file format for a GREYLEVEL image is:
-	// P5 (2 ASCII characters) <CR>
-	// two ASCII numbers for nx ny (number of rows and columns <CR>
-	// 255 (ASCII number) <CR>
-	// binary pixel data with one byte per pixel
-
-	// The PGM file format for a COLOR image is:
-	// P6 (2 ASCII characters) <CR>
-	// two ASCII numbers for nx ny (number of rows and columns <CR>
-	// 255 (ASCII number) <CR>
-	// binary pixel data with three bytes per pixel (one byte for eacg RGB)
-
-	fp=fopen(fname.c_str(),"rb");
-	if (!fp)
-		return false;
-
-	// read the first ASCII line to find out if we read a color image or
-	// a greylevel image
-
-	fgets(str,100,fp);
-	sscanf(str,"%s",imageType);
-
-	Format format = Image::I8BITS;
-	int nChannels = 0;
-	if(!strncmp(imageType,"P5",2)) // greylevel image
-		nChannels = 1;
-	else if(!strncmp(imageType,"P6",2)) // color image 
-		nChannels = 3;
-	else
-		return false;
-
-	// skip comments embedded in header
-	fgets(str,1024,fp);  
-	while(str[0]=='#')
-		fgets(str,1024,fp);
-
-	// read image dimensions 
-	int w, h=-1;
-	sscanf(str,"%d %d", &w, &h);
-	if (h == -1)
-		fscanf(fp,"%d", &h);
-
-	// read the next line into dummy variable
-	fgets(str,1024,fp);
-
-	// Create the image
-	create(w, h, nChannels, format);
-		
-	// read the image data
-	fread(&m_data[0], sizeof(unsigned char), w*h*m_bytesPerPixel, fp);
-
-	fclose(fp);
+	return loadFile(fname, FILE_PPM);
+}
 
-	if (m_width==0 || m_height==0)
+bool Image::decodePPM(const unsigned char *data, size_t size, const Info &info)
+{
+	create(info.width, info.height, (unsigned char)info.nChannels, info.format);
+	if (info.dataOffset + m_data.size() > size) {
+		Console::error("Image::decodePPM(): truncated image data\n");
 		return false;
+	}
 
+	const unsigned char *src = data + info.dataOffset;
+	if (m_format == I8BITS)
+		memcpy(&m_data[0], src, m_data.size());
+	else {
+		// 16 bit samples are big endian
+		uint16_t *dst = (uint16_t*)&m_data[0];
+		for (size_t i=0; i<m_data.size()/2; ++i)
+			dst[i] = (uint16_t)((src[2*i] << 8) | src[2*i+1]);
+	}
 	return true;
 }
 
@@ -234,27 +201,45 @@ bool Image::savePPM(const std::string &fname) const
 	return true;
 }
 
-void Image::flip()
+bool Image::savePNG(const std::string &fname) const
 {
-	// create a temp swap space
-	size_t bpChannel = getBytesPerChannel();
-	unsigned char *buf = new unsigned char[bpChannel];
+	if (isEmpty() || (m_format != I8BITS && m_format != I16BITS) || m_nChannels < 1 || m_nChannels > 4) {
+		Console::error("Image::savePNG(): only 8 and 16-bit images with 1 to 4 channels can be saved as PNG\n");
+		return false;
+	}
 
-    for (size_t i=0; i<m_width; ++i)
-	{
-		for (size_t j=0; j<m_height/2; ++j)
-		{
-			for (size_t k=0; k<m_nChannels; ++k)
-			{
-				// swap pixels
-				memcpy(buf, &m_data[m_bytesPerPixel*(j*m_height + i) + bpChannel*k], bpChannel);
-				memcpy( &m_data[m_bytesPerPixel*(j*m_height + i) + bpChannel*k],
-						&m_data[m_bytesPerPixel*((m_height-1-j)*m_height + i) + bpChannel*k],
-						bpChannel);
-				memcpy(&m_data[m_bytesPerPixel*((m_height-1-j)*m_height + i) + bpChannel*k], buf, bpChannel);
-			}
+	// the file keeps the channels and bit depth of the image. PNG color types for 1 to 4
+	// channels: grey, grey+alpha, RGB, RGBA
+	static const unsigned colorTypes[4] = { 0, 4, 2, 6 };
+	LodePNG::Encoder encoder;
+	encoder.getSettings().autoLeaveOutAlphaChannel = 0;
+	encoder.getInfoRaw().color.colorType = encoder.getInfoPng().color.colorType = colorTypes[m_nChannels-1];
+	encoder.getInfoRaw().color.bitDepth = encoder.getInfoPng().color.bitDepth = (unsigned)m_bytesPerChannel*8;
+
+	std::vector<unsigned char> png;
+	if (m_format == I16BITS) {
+		// PNG stores 16-bit samples big-endian
+		std::vector<unsigned char> samples(m_data.size());
+		const uint16_t *src = (const uint16_t*)&m_data[0];
+		for (size_t i=0; i<samples.size()/2; ++i) {
+			samples[2*i] = (unsigned char)(src[i] >> 8);
+			samples[2*i+1] = (unsigned char)(src[i] & 0xff);
 		}
+		encoder.encode(png, samples, (unsigned)m_width, (unsigned)m_height);
 	}
+	else
+		encoder.encode(png, m_data, (unsigned)m_width, (unsigned)m_height);
+	if (encoder.hasError()) {
+		Console::error("Image::savePNG(): failed to encode %s (error %d)\n", fname.c_str(), encoder.getError());
+		return false;
+	}
+
+	FILE *fp = fopen(fname.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool bOk = (fwrite(&png[0], 1, png.size(), fp) == png.size());
+	fclose(fp);
+	return bOk;
 }
 
 void Image::convolution(double *matrix, int size)
@@ -298,29 +283,7 @@ void Image::convolution(double *matrix, int size)
 		}
 
 	m_data = tmpData;
-}
-
-void Image::crop(size_t minX, size_t minY, size_t maxX, size_t maxY)
-{
-	ASSERT(minX >= 0 && minY >= 0);
-	ASSERT(maxX < m_width && maxY < m_height);
-
-	size_t w = maxX - minX+1;
-	size_t h = maxY - minY+1;
-	std::vector<unsigned char> data(w*h*m_bytesPerPixel);
-
-	for (size_t i=minX; i<=maxX; ++i)
-	{
-		for (size_t j=minY; j<=maxY; ++j)
-		{
-			for (size_t c=0; c<m_bytesPerPixel; ++c)
-				data[m_bytesPerPixel*((j-minY)*w + (i-minX))+c] = (*this)(i,j)[c];
-		}
-	}
-
-	m_data = data;
-	m_width = w;
-	m_height = h;
+	markAllDirty();
 }
 
 std::ostream& operator << (std::ostream& stream, const Image& img)
@@ -356,6 +319,7 @@ std::istream& operator >> (std::istream& stream, Image& img)
 	img.m_data.resize(datasize);
 	if (datasize > 0)
 		stream.read((char*)&img.m_data[0], sizeof(unsigned char)*datasize);
+	img.markAllDirty();
 	Console::print("image %d x %d, %d bytespp, format: %d (%d bytes)\n", img.m_width, img.m_height, img.m_bytesPerPixel,
 		(int)img.m_format, (int)datasize);
 	return stream;
@@ -417,23 +381,38 @@ Color Image::sample_at(double fx, double fy) const
 bool Image::load(const std::string &fname)
 {
 	Console::print("loading %s\n", fname.c_str());
+	return loadFile(fname, FILE_UNKNOWN);
+}
 
+bool Image::loadFile(const std::string &fname, FileType type)
+{
 	clear();
-	size_t pos = fname.find_last_of(".");
-	std::string ext = fname.substr(pos+1);
-	std::transform(ext.begin(), ext.end(), ext.begin(), toupper);
-	if (ext == "BMP")
-		return loadBMP(fname);
-	else if (ext == "PPM")
-		return loadPPM(fname);
-	else if (ext == "HDR")
-		return loadHDR(fname);
-	else if (ext == "PNG")
-		return loadPNG(fname);
-	else {
-		Console::error("unsupported image file extension %s\n", ext.c_str());
+
+	// map the file once; the header tells which decoder to use
+	MappedFile file;
+	if (!file.open(fname)) {
+		Console::error("Image::load(): cannot open %s\n", fname.c_str());
+		return false;
+	}
+	Info info;
+	if (!probe(file.getData(), file.getSize(), info) || (type != FILE_UNKNOWN && info.fileType != type)) {
+		Console::error("Image::load(): %s is not a supported image file\n", fname.c_str());
 		return false;
 	}
+
+	bool bOk = false;
+	switch (info.fileType) {
+		case FILE_PPM:	bOk = decodePPM(file.getData(), file.getSize(), info); break;
+		case FILE_BMP:	bOk = decodeBMP(file.getData(), file.getSize(), info); break;
+		case FILE_PNG:	bOk = decodePNG(file.getData(), file.getSize()); break;
+		case FILE_HDR:	bOk = decodeHDR(file.getData(), file.getSize(), F32BITS); break;
+		default: break;
+	}
+	if (!bOk)
+		clear();
+	else
+		markAllDirty();
+	return bOk;
 }
 
 bool Image::loadWithAlpha(const std::string &img_fname, const std::string &alpha_fname)
@@ -480,132 +459,124 @@ bool Image::loadWithAlpha(const std::string &img_fname, const std::string &alpha
 				&alpha.m_data[alpha.m_bytesPerPixel*(j*m_width + i)],
 				m_bytesPerChannel);
 		}
+	markAllDirty();
 
 	return true;
 }
 
-bool Image::loadHDR(const std::string &filename)
+bool Image::loadHDR(const std::string &filename, Format format)
 {
-	// Read in the HDR light probe.
-	FILE* fp = fopen(filename.c_str(), "rb" );
-	if (!fp)
+	// the whole file is mapped and decoded from memory
+	clear();
+	MappedFile file;
+	if (!file.open(filename) || !decodeHDR(file.getData(), file.getSize(), format)) {
+		Console::error("Image::loadHDR(): failed to load %s\n", filename.c_str());
+		clear();
 		return false;
-
-	rgbe_header_info info;
-	int nWidth, nHeight;
-	RGBE_ReadHeader( fp, &nWidth, &nHeight, &info );
-
-	// Create a float array and read in the RGB components
-	float* fHDRPixels = new float[3 * nWidth * nHeight];
-	memset(fHDRPixels, 0, 3 * nWidth * nHeight * sizeof(float));
-	RGBE_ReadPixels_RLE( fp, fHDRPixels, nWidth, nHeight );
-
-	// copy the pixel data
-	m_width = nWidth;
-	m_height = nHeight;
-	m_bytesPerChannel = 4;
-	m_format = Image::F32BITS;
-	m_nChannels = 3;
-	m_bytesPerPixel = m_nChannels * m_bytesPerChannel;
-	m_data.resize(m_width*m_height*m_bytesPerPixel);
-	memcpy(&m_data[0], fHDRPixels, m_data.size());
-	
-	m_exposure = info.exposure;
-	m_gamma  = info.gamma;
-
-	// clean up
-	delete[] fHDRPixels;
+	}
 	
+	markAllDirty();
 	Console::print("\t-loaded hdr image %s (w = %d, h = %d)\n", filename.c_str(), m_width, m_height);
 
 	return true;
 }
 
+bool Image::decodeHDR(const unsigned char *data, size_t size, Format format)
+{
+	HDRCodec::Header header;
+	if (!HDRCodec::decode(data, size, *this, &header, format))
+		return false;
+	m_exposure = header.exposure;
+	m_gamma = header.gamma;
+	return true;
+}
+
+bool Image::saveHDR(const std::string &filename) const
+{
+	HDRCodec::Header header;
+	header.exposure = (float)m_exposure;
+	header.gamma = (float)m_gamma;
+
+	// encode to memory and write it with a single call
+	std::vector<unsigned char> data;
+	if (!HDRCodec::encode(*this, data, &header))
+		return false;
+
+	FILE *fp = fopen(filename.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool bOk = (fwrite(&data[0], 1, data.size(), fp) == data.size());
+	fclose(fp);
+	return bOk;
+}
+
+namespace {
+
+// stretches each channel from [min,max] to the full range of the format
+class NormalizeKernel
+{
+	std::vector<double>	m_min, m_range;
+public:
+	NormalizeKernel(const ImageStatistics &stats) {
+		for (size_t c=0; c<stats.getChannelsNum(); ++c) {
+			m_min.push_back(stats.getMin(c));
+			m_range.push_back(stats.getMax(c) - stats.getMin(c));
+		}
+	}
+
+	template <class S, class D, class C>
+	void operator() (S, D, C ch, const typename S::Type *src, typename D::Type *dst, size_t width, size_t y)
+	{
+		size_t n = ch.num();
+		for (size_t x=0; x<width; ++x, src+=n, dst+=n)
+			for (size_t c=0; c<n; ++c) {
+				if (m_range[c] > 0)		// uniform channels are left as they are
+					dst[c] = D::fromUnit(D::maxUnit()*(S::toUnit(src[c]) - m_min[c])/m_range[c]);
+				else
+					dst[c] = D::fromUnit(S::toUnit(src[c]));
+			}
+	}
+};
+
+class ConvertKernel
+{
+public:
+	template <class S, class D, class C>
+	void operator() (S, D, C ch, const typename S::Type *src, typename D::Type *dst, size_t width, size_t y)
+	{
+		PixelConvert<S,D>::row(src, dst, width*ch.num());
+	}
+};
+
+class HistogramKernel
+{
+	Histogram<double>	&m_hist;
+	size_t				m_channel;
+public:
+	HistogramKernel(Histogram<double> &hist, size_t channel) : m_hist(hist), m_channel(channel) { }
+
+	template <class S, class C>
+	void operator() (S, C ch, const typename S::Type *row, size_t width, size_t y)
+	{
+		size_t n = ch.num();
+		row += m_channel;
+		for (size_t x=0; x<width; ++x, row+=n)
+			m_hist.add(clamp((double)S::toUnit(*row), 0.0, 1.0));
+	}
+};
+
+};
+
 void Image::normalize()
 {
 	if (isEmpty())
 		return;
 
 	// normalize each channel separately
-	switch (m_format) {
-	case Image::I8BITS:
-		for (size_t c=0; c<m_nChannels; ++c) {
-			uint8_t minv = at<uint8_t>(0,0,c), maxv = at<uint8_t>(0,0,c);
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-			{
-				uint8_t val = at<uint8_t>(i,j,c);
-				if (val < minv) minv = val;
-				if (val > maxv) maxv = val;
-			}
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-				at<uint8_t>(i,j,c) = 255*(at<uint8_t>(i,j,c) - minv)/(maxv-minv);
-		}
-		break;
-	case Image::I16BITS:
-		for (size_t c=0; c<m_nChannels; ++c) {
-			uint16_t minv = at<uint16_t>(0,0,c), maxv = at<uint16_t>(0,0,c);
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-			{
-				uint16_t val = at<uint16_t>(i,j,c);
-				if (val < minv) minv = val;
-				if (val > maxv) maxv = val;
-			}
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-				at<uint16_t>(i,j,c) = 65535*(at<uint16_t>(i,j,c) - minv)/(maxv-minv);
-		}
-		break;
-	case Image::I32BITS:
-		for (size_t c=0; c<m_nChannels; ++c) {
-			uint32_t minv = at<uint32_t>(0,0,c), maxv = at<uint32_t>(0,0,c);
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-			{
-				uint32_t val = at<uint32_t>(i,j,c);
-				if (val < minv) minv = val;
-				if (val > maxv) maxv = val;
-			}
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-				at<uint32_t>(i,j,c) = 4294967295*(at<uint32_t>(i,j,c) - minv)/(maxv-minv);
-		}
-		break;
-	case Image::F32BITS:
-		for (size_t c=0; c<m_nChannels; ++c) {
-			float32_t minv = at<float32_t>(0,0,c), maxv = at<float32_t>(0,0,c);
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-			{
-				float32_t val = at<float32_t>(i,j,c);
-				if (val < minv) minv = val;
-				if (val > maxv) maxv = val;
-			}
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-				at<float32_t>(i,j,c) = (at<float32_t>(i,j,c) - minv)/(maxv-minv);
-		}
-		break;
-	case Image::F64BITS:
-		for (size_t c=0; c<m_nChannels; ++c) {
-			float64_t minv = at<float64_t>(0,0,c), maxv = at<float64_t>(0,0,c);
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-			{
-				float64_t val = at<float64_t>(i,j,c);
-				if (val < minv) minv = val;
-				if (val > maxv) maxv = val;
-			}
-			for (size_t i=0; i<m_width; ++i)
-			for (size_t j=0; j<m_height; ++j)
-				at<float64_t>(i,j,c) = (at<float64_t>(i,j,c) - minv)/(maxv-minv);
-		}
-		break;
-	default:
-		throw std::exception("format not supported");
-	}
+	ImageStatistics stats;
+	stats.compute(*this);
+	NormalizeKernel kernel(stats);
+	transform(*this, kernel, true);
 }
 
 void Image::changeFormat(Image::Format format)
@@ -614,37 +585,12 @@ void Image::changeFormat(Image::Format format)
 		return;
 
 	Image newimg;
-	newimg.create(m_width, m_height, m_nChannels, format);
+	newimg.create(m_width, m_height, (unsigned char)m_nChannels, format);
+	newimg.m_exposure = m_exposure;
+	newimg.m_gamma = m_gamma;
 
-	for (size_t x=0; x<m_width; ++x)
-		for (size_t y=0; y<m_height; ++y)
-		{
-			for (size_t c=0; c<m_nChannels; ++c)
-			{
-				// read the original format
-				double val;
-				switch (m_format) {
-					case Image::I8BITS: val = at<uint8_t>(x,y,c)/255.0; break;
-					case Image::I16BITS: val = at<uint16_t>(x,y,c)/255.0; break;
-					case Image::I32BITS: val = at<uint32_t>(x,y,c)/255.0; break;
-					case Image::F16BITS: throw std::exception("format not supported"); break;
-					case Image::F32BITS: val = at<float32_t>(x,y,c); break;
-					case Image::F64BITS: val = at<float64_t>(x,y,c); break;
-					default: throw std::exception("unknown destination image format");
-				}
-
-				// write it in the new format
-				switch (format) {
-					case Image::I8BITS: newimg.at<uint8_t>(x,y,c) = (uint8_t)(val*255); break;
-					case Image::I16BITS: newimg.at<uint16_t>(x,y,c) = (uint16_t)(val*255); break;
-					case Image::I32BITS: newimg.at<uint32_t>(x,y,c) = (uint32_t)(val*255); break;
-					case Image::F16BITS: throw std::exception("format not supported"); break;
-					case Image::F32BITS: newimg.at<float32_t>(x,y,c) = (float32_t)val; break;
-					case Image::F64BITS: newimg.at<float64_t>(x,y,c) = (float64_t)val; break;
-					default: throw std::exception("unknown target image format");
-				}
-			}
-		}
+	ConvertKernel kernel;
+	transform(newimg, kernel, true);
 
 	copy(newimg);
 }
@@ -656,55 +602,35 @@ void Image::getHistogram(Histogram<double> &hist, size_t channel, size_t nBins)
 	
 	// form a histogram of this channel of the image
 	hist.create(nBins, 0, 1);
-	for (size_t x=0; x<m_width; ++x)
-		for (size_t y=0; y<m_height; ++y)
-		{
-			double val;
-			switch (m_format) {
-				case Image::I8BITS: val = at<uint8_t>(x,y,channel)/255.0; break;
-				case Image::I16BITS: val = at<uint16_t>(x,y,channel)/255.0; break;
-				case Image::I32BITS: val = at<uint32_t>(x,y,channel)/255.0; break;
-				case Image::F16BITS: throw std::exception("F16 format not supported"); break;
-				case Image::F32BITS: val = at<float32_t>(x,y,channel); break;
-				case Image::F64BITS: val = at<float64_t>(x,y,channel); break;
-				default: throw std::exception("unknown destination image format");
-			}
-
-			val = clamp(val, 0.0, 1.0);
-			hist.add(val);
-		}
+	HistogramKernel kernel(hist, channel);
+	transform(kernel);
 }
 
 double Image::calcEntropy(size_t channel, size_t nBins) const
 {
-	// create a histogram of the image
-	Histogram<double> hist;
-	getHistogram(hist, channel, nBins);
-	ProbHistogram<double> phist(hist);
-
-	// for each bin, compute probability and entropy
-	double entropy = 0;
-	for (size_t i=0; i<phist.getBinsNum(); ++i)
-	{
-		double p = phist.probOfBin(i);
-		if (p > 0)
-			entropy += -p * log(p);
-	}
+	ASSERT(channel < m_nChannels);
 
-	return entropy/log(2.0);
+	ImageStatistics stats;
+	stats.compute(*this, nBins);
+	return stats.getEntropy(channel);
 }
 
 bool Image::loadPNG(const std::string &fname)
 {
-	std::vector<unsigned char> data;
+	return loadFile(fname, FILE_PNG);
+}
+
+bool Image::decodePNG(const unsigned char *data, size_t size)
+{
+	std::vector<unsigned char> pixels;
 	unsigned int w=0, h=0;
-	if (LodePNG::decode(data, w, h, fname) != 0)
+	if (LodePNG::decode(pixels, w, h, data, (unsigned int)size) != 0)
 		return false;
 	if (w==0||h==0)
 		return false;
 
 	create(w, h, 4, Image::I8BITS);
-	m_data = data;
+	m_data = pixels;	// keeps the storage of the image, if it is large enough
 
 	Console::print("loaded PNG file (%d x %d)\n", w, h);
 
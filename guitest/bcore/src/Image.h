@@ -28,7 +28,12 @@
 #include "Matrix.h"
 #include <fstream>
 #include "histogram.h"
+#include "DirtyRegion.h"
+#include "Half.h"
+#include "PixelFormat.h"
+#include "ThreadPool.h"
 #include <exception>
+#include <deque>
 
 class Image
 {
@@ -44,6 +49,28 @@ public:
 		F64BITS
 	};
 
+	enum FileType {
+		FILE_UNKNOWN,
+		FILE_BMP,
+		FILE_PPM,
+		FILE_HDR,
+		FILE_PNG
+	};
+
+	// what an image file holds, as read from its header (see probe(..)). Channels and
+	// format are those of the image load(..) creates, not those stored in the file.
+	struct Info {
+		FileType	fileType;
+		size_t		width;
+		size_t		height;
+		size_t		nChannels;
+		Format		format;
+		size_t		dataOffset;		// start of the pixels in the file (BMP and PPM only)
+
+		Info() : fileType(FILE_UNKNOWN), width(0), height(0), nChannels(0), format(I8BITS), dataOffset(0) { }
+		size_t	getDataSize() const		{ return width*height*nChannels*getFormatSize(format); }
+	};
+
 	enum Filter {
 		BOX = 0,
 		LINEAR,
@@ -65,9 +92,18 @@ protected:
 	double			m_exposure;	// for HDR only
 	double			m_gamma;	// for HDR only
 
+	// the latest changes, for the viewers of the image (see getChangesSince(..))
+	struct Change {
+		size_t		generation;
+		Rect<int>	rect;
+	};
+	std::deque<Change>	m_changes;			// oldest first
+	size_t			m_generation;		// bumped by every change
+	size_t			m_fullChangeGen;	// viewers that have seen less than this reload all of the image
+
 public:
 	Image();
-	Image(const Image& img) { copy(img); }
+	Image(const Image& img) : m_generation(0), m_fullChangeGen(0) { copy(img); }
 	virtual ~Image();	// gniah.. if not subclassed, spare the vfptr..
 
 	static void precomputeLUTs();
@@ -76,7 +112,7 @@ public:
 	void clear();
 	void copy(const Image& image);
 
-	void rawCopy(void *data)	{ memcpy(&m_data[0], data, m_data.size()); }
+	void rawCopy(void *data)	{ memcpy(&m_data[0], data, m_data.size()); markAllDirty(); }
 
 	Format		getFormat() const			{ return m_format; }
 	size_t		getChannelsNum() const	{ return m_nChannels; }
@@ -91,20 +127,45 @@ public:
 
 	static size_t	getFormatSize(Format format);
 
+	// change tracking, for any number of viewers (fe. textures kept up to date with the
+	// image). The methods of Image mark what they change; code that writes the pixels
+	// through getData() or operator () marks the changed area itself. Every change bumps
+	// the generation: a viewer keeps the generation it has shown, and asks for the area
+	// changed since then, so that only that part is uploaded again.
+	void	markDirty(size_t minX, size_t minY, size_t maxX, size_t maxY);	// [min,max)
+	void	markAllDirty();					// fe. the size or format changed
+	size_t	getGeneration() const			{ return m_generation; }
+	bool	getChangesSince(size_t generation, DirtyRegion &region) const;	// false: all of it may have changed
+
 	void changeFormat(Format format);
 	void normalize();
-	void flip();
 	void resize(double scale, Filter filter=CUBIC, double filter_stretch = 1.0);
 	void resize(size_t neww, size_t newh, Filter filter=CUBIC, double filter_stretch = 1.0);
-	void crop(size_t minX, size_t minY, size_t maxX, size_t maxY);
-	bool load(const std::string &fname);
+	void downsample2x(Image &out, bool bSRGB = false) const;	// half-size copy using a 2x2 box filter (any channels and format, see MipChain)
+	void crop(size_t minX, size_t minY, size_t maxX, size_t maxY);	// max inclusive
+
+	// geometric transforms, for every format. Rotations are clockwise. Square images are
+	// transposed and rotated in place, others through one temporary copy of the pixels.
+	void flip();		// vertical: the top row becomes the bottom one
+	void mirror();		// horizontal: the left column becomes the right one
+	void transpose();
+	void rotate90();
+	void rotate180();
+	void rotate270();
+	bool load(const std::string &fname);	// the file type is found from its contents
 	bool loadWithAlpha(const std::string &img_fname, const std::string &alpha_fname);
 	bool loadPPM(const std::string &fname);
 	bool loadBMP(const std::string& fname);
-	bool loadHDR(const std::string& fname);
+	bool loadHDR(const std::string& fname, Format format = F32BITS);	// format: F32BITS or F16BITS
 	bool loadPNG(const std::string& fname);
 	bool savePPM(const std::string &fname) const;
 	bool savePNG(const std::string &fname) const;
+	bool saveHDR(const std::string &fname) const;	// F16BITS/F32BITS images only, run-length encoded
+
+	// read only the header of an image file (the first few KB), fe. to list image sizes
+	// without decoding. False if the file is not a BMP, PPM, HDR or PNG that load(..) supports.
+	static bool probe(const std::string &fname, Info &info);
+	static bool probe(const unsigned char *data, size_t size, Info &info);
 	void convolution(double *matrix, int size);
 	void getHistogram(Histogram<double> &hist, size_t channel, size_t nBins=256) const;
 	double calcEntropy(size_t channel, size_t nBins=64) const;
@@ -126,6 +187,17 @@ public:
 
 	__forceinline Color	color(size_t x, size_t y) const;
 
+	// pixel kernels: call a kernel for every row of the image, specialised at compile time
+	// on the pixel format(s) (the traits classes of PixelFormat.h) and the number of channels
+	// (1 to 4, other counts are passed at runtime). The read-only version calls
+	//		kernel(S(), C(), const S::Type *row, size_t width, size_t y)
+	// and the version with a destination image calls
+	//		kernel(S(), D(), C(), const S::Type *src, D::Type *dst, size_t width, size_t y)
+	// dst must have the size and channels of this image, and may be this image itself.
+	// Kernels that keep no state between rows can have their rows run in parallel.
+	template <class Kernel> void transform(Kernel &kernel) const;
+	template <class Kernel> void transform(Image &dst, Kernel &kernel, bool bParallel=false) const;
+
 	// copy operator
 	Image& operator = (const Image& img) { copy(img); return *this; }
 	
@@ -135,6 +207,20 @@ public:
 
 private:
 	inline void interpolate(double x, double y, Filter filter, double filter_stretch, double out[3]);
+
+	// decoders for files mapped to memory, after probe(..) has checked the header
+	bool loadFile(const std::string &fname, FileType type);		// FILE_UNKNOWN: any type
+	bool decodePPM(const unsigned char *data, size_t size, const Info &info);
+	bool decodeBMP(const unsigned char *data, size_t size, const Info &info);
+	bool decodePNG(const unsigned char *data, size_t size);
+	bool decodeHDR(const unsigned char *data, size_t size, Format format);
+
+	template <class S> Color colorOf(const unsigned char *p) const;
+	template <class Kernel, class S> void visitRows(Kernel &kernel, S s) const;
+	template <class Kernel, class S, class C> void visitRows(Kernel &kernel, S s, C ch) const;
+	template <class Kernel, class S> void transformRows(Image &dst, Kernel &kernel, bool bParallel, S s) const;
+	template <class Kernel, class S, class D> void transformRows(Image &dst, Kernel &kernel, bool bParallel, S s, D d) const;
+	template <class Kernel, class S, class D, class C> void transformRows(Image &dst, Kernel &kernel, bool bParallel, S s, D d, C ch) const;
 };
 
 /**
@@ -155,50 +241,144 @@ public:
 
 Color Image::color(size_t x, size_t y) const
 {
-	Color cl;
+	const unsigned char *p = (*this)(x,y);
 	switch (m_format) {
-		case Image::I8BITS:
-			cl.r = (float)(at<uint8_t>(x,y,0) / 255.0);
-			if (m_nChannels > 1)
-				cl.g = (float)(at<uint8_t>(x,y,1) / 255.0);
-			if (m_nChannels > 2)
-				cl.b = (float)(at<uint8_t>(x,y,2) / 255.0);
-			break;
-		case Image::I16BITS:
-			cl.r = (float)(at<uint16_t>(x,y,0) / 255.0);
-			if (m_nChannels > 1)
-				cl.g = (float)(at<uint16_t>(x,y,1) / 255.0);
-			if (m_nChannels > 2)
-				cl.b = (float)(at<uint16_t>(x,y,2) / 255.0);
-			break;
-		case Image::I32BITS:
-			cl.r = (float)(at<uint32_t>(x,y,0) / 255.0);
-			if (m_nChannels > 1)
-				cl.g = (float)(at<uint32_t>(x,y,1) / 255.0);
-			if (m_nChannels > 2)
-				cl.b = (float)(at<uint32_t>(x,y,2) / 255.0);
-			break;
-		case Image::F16BITS:
-			Console::error("Image::color() : F16BITS not supported!!\n");
-			break;
-		case Image::F32BITS:
-			cl.r = (float)(at<float32_t>(x,y,0));
-			if (m_nChannels > 1)
-				cl.g = (float)(at<float32_t>(x,y,1));
-			if (m_nChannels > 2)
-				cl.b = (float)(at<float32_t>(x,y,2));
-			break;
-		case Image::F64BITS:
-			cl.r = (float)(at<float64_t>(x,y,0));
-			if (m_nChannels > 1)
-				cl.g = (float)(at<float64_t>(x,y,1));
-			if (m_nChannels > 2)
-				cl.b = (float)(at<float64_t>(x,y,2));
-			break;
+		case Image::I8BITS:		return colorOf<PixelI8>(p);
+		case Image::I16BITS:	return colorOf<PixelI16>(p);
+		case Image::I32BITS:	return colorOf<PixelI32>(p);
+		case Image::F16BITS:	return colorOf<PixelF16>(p);
+		case Image::F32BITS:	return colorOf<PixelF32>(p);
+		case Image::F64BITS:	return colorOf<PixelF64>(p);
 	}
+	return Color();
+}
+
+template <class S>
+Color Image::colorOf(const unsigned char *p) const
+{
+	const typename S::Type *v = (const typename S::Type*)p;
+	Color cl;
+	cl.r = (float)S::toUnit(v[0]);
+	if (m_nChannels > 1)
+		cl.g = (float)S::toUnit(v[1]);
+	if (m_nChannels > 2)
+		cl.b = (float)S::toUnit(v[2]);
 	return cl;
 }
 
+//--------------------------------
+
+template <class Kernel>
+void Image::transform(Kernel &kernel) const
+{
+	if (isEmpty())
+		return;
+	switch (m_format) {
+		case Image::I8BITS:		visitRows(kernel, PixelI8()); break;
+		case Image::I16BITS:	visitRows(kernel, PixelI16()); break;
+		case Image::I32BITS:	visitRows(kernel, PixelI32()); break;
+		case Image::F16BITS:	visitRows(kernel, PixelF16()); break;
+		case Image::F32BITS:	visitRows(kernel, PixelF32()); break;
+		case Image::F64BITS:	visitRows(kernel, PixelF64()); break;
+		default: throw std::runtime_error("image format not supported");
+	}
+}
+
+template <class Kernel, class S>
+void Image::visitRows(Kernel &kernel, S s) const
+{
+	switch (m_nChannels) {
+		case 1:	visitRows(kernel, s, PixelChannels<1>()); break;
+		case 2:	visitRows(kernel, s, PixelChannels<2>()); break;
+		case 3:	visitRows(kernel, s, PixelChannels<3>()); break;
+		case 4:	visitRows(kernel, s, PixelChannels<4>()); break;
+		default: visitRows(kernel, s, PixelChannels<0>(m_nChannels));
+	}
+}
+
+template <class Kernel, class S, class C>
+void Image::visitRows(Kernel &kernel, S s, C ch) const
+{
+	for (size_t y=0; y<m_height; ++y)
+		kernel(s, ch, (const typename S::Type*)(*this)(0,y), m_width, y);
+}
+
+template <class Kernel>
+void Image::transform(Image &dst, Kernel &kernel, bool bParallel) const
+{
+	ASSERT(dst.m_width == m_width && dst.m_height == m_height && dst.m_nChannels == m_nChannels);
+	if (isEmpty())
+		return;
+	switch (m_format) {
+		case Image::I8BITS:		transformRows(dst, kernel, bParallel, PixelI8()); break;
+		case Image::I16BITS:	transformRows(dst, kernel, bParallel, PixelI16()); break;
+		case Image::I32BITS:	transformRows(dst, kernel, bParallel, PixelI32()); break;
+		case Image::F16BITS:	transformRows(dst, kernel, bParallel, PixelF16()); break;
+		case Image::F32BITS:	transformRows(dst, kernel, bParallel, PixelF32()); break;
+		case Image::F64BITS:	transformRows(dst, kernel, bParallel, PixelF64()); break;
+		default: throw std::runtime_error("image format not supported");
+	}
+	dst.markAllDirty();
+}
+
+template <class Kernel, class S>
+void Image::transformRows(Image &dst, Kernel &kernel, bool bParallel, S s) const
+{
+	switch (dst.m_format) {
+		case Image::I8BITS:		transformRows(dst, kernel, bParallel, s, PixelI8()); break;
+		case Image::I16BITS:	transformRows(dst, kernel, bParallel, s, PixelI16()); break;
+		case Image::I32BITS:	transformRows(dst, kernel, bParallel, s, PixelI32()); break;
+		case Image::F16BITS:	transformRows(dst, kernel, bParallel, s, PixelF16()); break;
+		case Image::F32BITS:	transformRows(dst, kernel, bParallel, s, PixelF32()); break;
+		case Image::F64BITS:	transformRows(dst, kernel, bParallel, s, PixelF64()); break;
+		default: throw std::runtime_error("image format not supported");
+	}
+}
+
+template <class Kernel, class S, class D>
+void Image::transformRows(Image &dst, Kernel &kernel, bool bParallel, S s, D d) const
+{
+	switch (m_nChannels) {
+		case 1:	transformRows(dst, kernel, bParallel, s, d, PixelChannels<1>()); break;
+		case 2:	transformRows(dst, kernel, bParallel, s, d, PixelChannels<2>()); break;
+		case 3:	transformRows(dst, kernel, bParallel, s, d, PixelChannels<3>()); break;
+		case 4:	transformRows(dst, kernel, bParallel, s, d, PixelChannels<4>()); break;
+		default: transformRows(dst, kernel, bParallel, s, d, PixelChannels<0>(m_nChannels));
+	}
+}
+
+// runs a kernel on a range of rows, for the parallel version of Image::transform
+template <class Kernel, class S, class D, class C>
+class ImageTransformJob : public ThreadPool::RangeJob
+{
+	const Image	&m_src;
+	Image		&m_dst;
+	Kernel		&m_kernel;
+	C			m_ch;
+public:
+	ImageTransformJob(const Image &src, Image &dst, Kernel &kernel, C ch) : m_src(src), m_dst(dst), m_kernel(kernel), m_ch(ch) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		for (size_t y=begin; y<end; ++y)
+			m_kernel(S(), D(), m_ch, (const typename S::Type*)m_src(0,y), (typename D::Type*)m_dst(0,y), m_src.getWidth(), y);
+	}
+};
+
+template <class Kernel, class S, class D, class C>
+void Image::transformRows(Image &dst, Kernel &kernel, bool bParallel, S s, D d, C ch) const
+{
+	if (bParallel) {
+		ImageTransformJob<Kernel,S,D,C> job(*this, dst, kernel, ch);
+		ThreadPool::inst()->parallelFor(job, 0, m_height, 16);
+		return;
+	}
+	for (size_t y=0; y<m_height; ++y)
+		kernel(s, d, ch, (const typename S::Type*)(*this)(0,y), (typename D::Type*)dst(0,y), m_width, y);
+}
+
+//--------------------------------
+
 template <class T>
 void Image::fromMatrix(const Matrix<T> &mat, bool bScaleValues)
 {
@@ -237,57 +417,37 @@ void Image::fromMatrix(const Matrix<T> &mat, bool bScaleValues)
 				(*this)(x,y)[0] = (unsigned char)(255*(mat(x,y) - minV)/(maxV - minV));
 			}
 	}
+	markAllDirty();
 }
 
+// averages the channels of each pixel to a matrix element
+template <class T>
+class ImageToMatrixKernel
+{
+	Matrix<T>	&m_mat;
+public:
+	ImageToMatrixKernel(Matrix<T> &mat) : m_mat(mat) { }
+
+	template <class S, class C>
+	void operator() (S, C ch, const typename S::Type *row, size_t width, size_t y)
+	{
+		size_t n = ch.num();
+		for (size_t x=0; x<width; ++x, row+=n) {
+			double sum = 0;
+			for (size_t c=0; c<n; ++c)
+				sum += S::toUnit(row[c]);
+			m_mat(x,y) = (T)(sum / n);
+		}
+	}
+};
+
 template <class T>
 void Image::toMatrix(Matrix<T> &mat) const
 {
 	mat.create(m_width, m_height);
 
-	switch (m_format) {
-	case Image::I8BITS:
-		for (size_t x=0; x<m_width; ++x)
-			for (size_t y=0; y<m_height; ++y) {
-				mat(x,y) = 0;
-				for (size_t c=0; c<m_nChannels; ++c)
-					mat(x,y) += at<uint8_t>(x,y,c) / 255.0 / m_nChannels;
-			}
-		break;
-	case Image::I16BITS:
-		for (size_t x=0; x<m_width; ++x)
-			for (size_t y=0; y<m_height; ++y) {
-				mat(x,y) = 0;
-				for (size_t c=0; c<m_nChannels; ++c)
-					mat(x,y) += at<uint16_t>(x,y,c) / 255.0 / m_nChannels;
-			}
-		break;
-	case Image::I32BITS:
-		for (size_t x=0; x<m_width; ++x)
-			for (size_t y=0; y<m_height; ++y) {
-				mat(x,y) = 0;
-				for (size_t c=0; c<m_nChannels; ++c)
-					mat(x,y) += at<uint32_t>(x,y,c) / 255.0 / m_nChannels;
-			}
-		break;
-	case Image::F32BITS:
-		for (size_t x=0; x<m_width; ++x)
-			for (size_t y=0; y<m_height; ++y) {
-				mat(x,y) = 0;
-				for (size_t c=0; c<m_nChannels; ++c)
-					mat(x,y) += at<float32_t>(x,y,c) / m_nChannels;
-			}
-		break;
-	case Image::F64BITS:
-		for (size_t x=0; x<m_width; ++x)
-			for (size_t y=0; y<m_height; ++y) {
-				mat(x,y) = 0;
-				for (size_t c=0; c<m_nChannels; ++c)
-					mat(x,y) += at<float64_t>(x,y,c) / m_nChannels;
-			}
-		break;
-	default:
-		throw std::exception("image format not supported");
-	}
+	ImageToMatrixKernel<T> kernel(mat);
+	transform(kernel);
 }
 
 #endif
\ No newline at end of file
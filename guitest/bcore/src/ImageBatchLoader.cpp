@@ -0,0 +1,179 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ImageBatchLoader.h"
+
+namespace {
+
+class ProbeJob : public ThreadPool::RangeJob
+{
+	const std::vector<std::string>	&m_files;
+	std::vector<Image::Info>		&m_info;
+	std::vector<unsigned char>		&m_bValid;
+public:
+	ProbeJob(const std::vector<std::string> &files, std::vector<Image::Info> &info, std::vector<unsigned char> &bValid) :
+		m_files(files), m_info(info), m_bValid(bValid) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		for (size_t i=begin; i<end; ++i)
+			m_bValid[i] = Image::probe(m_files[i], m_info[i]) ? 1 : 0;
+	}
+};
+
+// an image whose storage can be reused, and its size in bytes
+struct PooledImage {
+	Image	*pImage;
+	size_t	bytes;
+};
+
+};
+
+ImageBatchLoader::ImageBatchLoader(size_t memoryBudget) : m_bProbed(false),
+	m_memoryBudget(memoryBudget)
+{
+}
+
+void ImageBatchLoader::add(const std::string &filename)
+{
+	m_files.push_back(filename);
+	m_bProbed = false;
+}
+
+void ImageBatchLoader::clear()
+{
+	m_files.clear();
+	m_info.clear();
+	m_bValid.clear();
+	m_bProbed = false;
+}
+
+void ImageBatchLoader::probe()
+{
+	m_info.assign(m_files.size(), Image::Info());
+	m_bValid.assign(m_files.size(), 0);
+
+	// mostly waiting for the disk, so small ranges keep all workers busy
+	ProbeJob job(m_files, m_info, m_bValid);
+	ThreadPool::inst()->parallelFor(job, 0, m_files.size(), 4);
+	m_bProbed = true;
+}
+
+void ImageBatchLoader::Request::run()
+{
+	// load(..) keeps the storage of the pre-sized image
+	m_bOk = m_pImage->load(m_pLoader->m_files[m_index]);
+	m_pLoader->onDone(this);
+}
+
+void ImageBatchLoader::onDone(Request *pReq)
+{
+	{
+		ScopedLock lock(m_doneLock);
+		m_done.push_back(pReq);
+	}
+	m_doneCount.post();
+}
+
+void ImageBatchLoader::load(Listener &listener)
+{
+	if (!m_bProbed)
+		probe();
+
+	size_t maxInFlight = 2*ThreadPool::inst()->getThreadsNum();
+	if (maxInFlight < 1)
+		maxInFlight = 1;
+
+	std::vector<PooledImage> pool;		// images of finished files
+	size_t poolBytes = 0;
+	size_t inFlightBytes = 0, nInFlight = 0;
+	size_t next = 0;
+	while (next < m_files.size() || nInFlight > 0)
+	{
+		// start decoding files while they fit in the budget
+		while (next < m_files.size() && nInFlight < maxInFlight)
+		{
+			if (!m_bValid[next]) {
+				listener.onImageFailed(next, m_files[next]);
+				++next;
+				continue;
+			}
+			size_t bytes = m_info[next].getDataSize();
+			if (nInFlight > 0 && inFlightBytes + bytes > m_memoryBudget)
+				break;
+
+			// reuse a finished image, dropping the pool if it is needed for the budget
+			Image *pImage = 0;
+			if (!pool.empty()) {
+				pImage = pool.back().pImage;
+				poolBytes -= pool.back().bytes;
+				pool.pop_back();
+			}
+			while (!pool.empty() && inFlightBytes + bytes + poolBytes > m_memoryBudget) {
+				delete pool.back().pImage;
+				poolBytes -= pool.back().bytes;
+				pool.pop_back();
+			}
+			if (!pImage)
+				pImage = new Image();
+			const Image::Info &info = m_info[next];
+			pImage->create(info.width, info.height, (unsigned char)info.nChannels, info.format);
+
+			Request *pReq = new Request();
+			pReq->m_pLoader = this;
+			pReq->m_index = next;
+			pReq->m_pImage = pImage;
+			pReq->m_bOk = false;
+			inFlightBytes += bytes;
+			nInFlight++;
+			++next;
+			ThreadPool::inst()->submit(pReq);
+		}
+		if (nInFlight == 0)
+			continue;
+
+		// wait for a file to finish
+		m_doneCount.wait();
+		Request *pReq = 0;
+		{
+			ScopedLock lock(m_doneLock);
+			ASSERT(!m_done.empty());
+			pReq = m_done.back();
+			m_done.pop_back();
+		}
+		size_t bytes = m_info[pReq->m_index].getDataSize();
+		inFlightBytes -= bytes;
+		nInFlight--;
+
+		if (pReq->m_bOk)
+			listener.onImageLoaded(pReq->m_index, m_files[pReq->m_index], *pReq->m_pImage);
+		else
+			listener.onImageFailed(pReq->m_index, m_files[pReq->m_index]);
+
+		PooledImage pooled = { pReq->m_pImage, bytes };
+		pool.push_back(pooled);
+		poolBytes += bytes;
+		delete pReq;
+	}
+
+	for (size_t i=0; i<pool.size(); ++i)
+		delete pool[i].pImage;
+}
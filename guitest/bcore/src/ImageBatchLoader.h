@@ -0,0 +1,94 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _IMAGEBATCHLOADER_H45631_INCLUDED_
+#define _IMAGEBATCHLOADER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+#include "Thread.h"
+#include "ThreadPool.h"
+
+/**
+ * ImageBatchLoader: loads many image files on the thread pool.
+ *		The headers of all files are probed first, which is cheap, so that the size
+ *		of every image is known before it is decoded. Files are then decoded
+ *		concurrently, as long as the images in flight fit in the memory budget
+ *		(one image is always allowed, however large). Each finished image goes to
+ *		a Listener on the thread that called load(), in the order the files finish.
+ *		Its buffer is then reused for later files.
+ */
+class ImageBatchLoader
+{
+public:
+	class Listener {
+	public:
+		virtual ~Listener() { }
+		// the image is reused when this returns: copy or swap out what should be kept
+		virtual void onImageLoaded(size_t index, const std::string &filename, Image &image) = 0;
+		virtual void onImageFailed(size_t index, const std::string &filename) { }
+	};
+
+private:
+	class Request : public ThreadPool::Job {
+	public:
+		ImageBatchLoader	*m_pLoader;
+		size_t				m_index;
+		Image				*m_pImage;
+		bool				m_bOk;
+
+		virtual void run();
+	};
+
+	std::vector<std::string>	m_files;
+	std::vector<Image::Info>	m_info;
+	std::vector<unsigned char>	m_bValid;	// the header was probed successfully
+	bool						m_bProbed;
+	size_t						m_memoryBudget;
+
+	Mutex					m_doneLock;
+	std::vector<Request*>	m_done;
+	Semaphore				m_doneCount;
+
+	void	onDone(Request *pReq);
+
+public:
+	ImageBatchLoader(size_t memoryBudget = 256*1024*1024);
+
+	void	add(const std::string &filename);
+	void	clear();
+	size_t	getFilesNum() const					{ return m_files.size(); }
+
+	// read the headers of all files, in parallel
+	void	probe();
+	bool	isValid(size_t i) const				{ ASSERT(m_bProbed && i < m_files.size()); return m_bValid[i] != 0; }
+	const Image::Info&	getInfo(size_t i) const	{ ASSERT(m_bProbed && i < m_files.size()); return m_info[i]; }
+
+	// probe (if not done yet) and decode all files. Returns when all have been passed to the listener
+	void	load(Listener &listener);
+
+	void	setMemoryBudget(size_t bytes)		{ m_memoryBudget = bytes; }
+	size_t	getMemoryBudget() const				{ return m_memoryBudget; }
+};
+
+#endif
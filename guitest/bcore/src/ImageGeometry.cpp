@@ -0,0 +1,345 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Image.h"
+#include "ThreadPool.h"
+#include <emmintrin.h>
+
+namespace {
+
+// side of the square tiles that transposes copy, in pixels
+const size_t TILE = 32;
+
+// pixels of a size known at compile time are moved as one struct
+template <size_t N>
+struct FixedPixel {
+	struct Bytes { unsigned char b[N]; };
+	static __forceinline void copy(unsigned char *dst, const unsigned char *src, size_t)	{ *(Bytes*)dst = *(const Bytes*)src; }
+	static __forceinline void swap(unsigned char *a, unsigned char *b, size_t)			{ Bytes t = *(Bytes*)a; *(Bytes*)a = *(Bytes*)b; *(Bytes*)b = t; }
+};
+
+// pixels with more than 4 channels
+struct AnyPixel {
+	static void copy(unsigned char *dst, const unsigned char *src, size_t bpp)	{ memcpy(dst, src, bpp); }
+	static void swap(unsigned char *a, unsigned char *b, size_t bpp) {
+		for (size_t i=0; i<bpp; ++i) {
+			unsigned char t = a[i]; a[i] = b[i]; b[i] = t;
+		}
+	}
+};
+
+// reverse the order of the pixels in a register
+template <size_t BPP> __m128i reverseRegister(__m128i v);
+template <> __forceinline __m128i reverseRegister<8>(__m128i v)	{ return _mm_shuffle_epi32(v, 0x4E); }
+template <> __forceinline __m128i reverseRegister<4>(__m128i v)	{ return _mm_shuffle_epi32(v, 0x1B); }
+template <> __forceinline __m128i reverseRegister<2>(__m128i v) {
+	v = _mm_shuffle_epi32(v, 0x1B);
+	v = _mm_shufflelo_epi16(v, 0xB1);
+	return _mm_shufflehi_epi16(v, 0xB1);
+}
+template <> __forceinline __m128i reverseRegister<1>(__m128i v) {
+	v = reverseRegister<2>(v);
+	return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+}
+
+template <class P>
+void reversePixels(unsigned char *p, size_t n, size_t bpp)
+{
+	if (n < 2)
+		return;
+	unsigned char *a = p, *b = p + (n-1)*bpp;
+	for (; a < b; a += bpp, b -= bpp)
+		P::swap(a, b, bpp);
+}
+
+// the registers at the two ends are loaded, reversed and stored swapped
+template <size_t BPP>
+void reversePixelsSIMD(unsigned char *p, size_t n)
+{
+	unsigned char *a = p, *b = p + n*BPP;
+	while (b - a >= 32) {
+		b -= 16;
+		__m128i va = _mm_loadu_si128((const __m128i*)a);
+		__m128i vb = _mm_loadu_si128((const __m128i*)b);
+		_mm_storeu_si128((__m128i*)a, reverseRegister<BPP>(vb));
+		_mm_storeu_si128((__m128i*)b, reverseRegister<BPP>(va));
+		a += 16;
+	}
+	reversePixels<FixedPixel<BPP> >(a, (b - a)/BPP, BPP);
+}
+
+void reverseRow(unsigned char *p, size_t n, size_t bpp)
+{
+	switch (bpp) {
+		case 1:		reversePixelsSIMD<1>(p, n); break;
+		case 2:		reversePixelsSIMD<2>(p, n); break;
+		case 4:		reversePixelsSIMD<4>(p, n); break;
+		case 8:		reversePixelsSIMD<8>(p, n); break;
+		case 3:		reversePixels<FixedPixel<3> >(p, n, bpp); break;
+		case 6:		reversePixels<FixedPixel<6> >(p, n, bpp); break;
+		case 12:	reversePixels<FixedPixel<12> >(p, n, bpp); break;
+		case 16:	reversePixels<FixedPixel<16> >(p, n, bpp); break;
+		case 24:	reversePixels<FixedPixel<24> >(p, n, bpp); break;
+		case 32:	reversePixels<FixedPixel<32> >(p, n, bpp); break;
+		default:	reversePixels<AnyPixel>(p, n, bpp);
+	}
+}
+
+// swaps the rows j and height-1-j (j in [begin, end)) and/or reverses the pixels in each row
+class RowJob : public ThreadPool::RangeJob
+{
+	unsigned char	*m_data;
+	size_t			m_width, m_height, m_bpp;
+	bool			m_bSwap, m_bReverse;
+public:
+	RowJob(unsigned char *data, size_t width, size_t height, size_t bpp, bool bSwap, bool bReverse) :
+		m_data(data), m_width(width), m_height(height), m_bpp(bpp), m_bSwap(bSwap), m_bReverse(bReverse) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		size_t rowBytes = m_width*m_bpp;
+		std::vector<unsigned char> tmp(m_bSwap ? rowBytes : 0);
+		for (size_t j=begin; j<end; ++j)
+		{
+			unsigned char *a = m_data + j*rowBytes;
+			unsigned char *b = m_data + (m_height-1-j)*rowBytes;
+			bool bPair = m_bSwap && a != b;
+			if (bPair) {
+				memcpy(&tmp[0], a, rowBytes);
+				memcpy(a, b, rowBytes);
+				memcpy(b, &tmp[0], rowBytes);
+			}
+			if (m_bReverse) {
+				reverseRow(a, m_width, m_bpp);
+				if (bPair)
+					reverseRow(b, m_width, m_bpp);
+			}
+		}
+	}
+};
+
+enum Orientation {
+	TRANSPOSE,
+	ROTATE90,		// clockwise
+	ROTATE270
+};
+
+// copies a width x height image to a height x width one, a tile at a time. The source
+// pixel (x,y) goes to column c0 + y*cs of row r0 + x*rs in the destination.
+template <class P>
+class TransposeJob : public ThreadPool::RangeJob
+{
+	const unsigned char	*m_src;
+	unsigned char		*m_dst;
+	size_t				m_width, m_height, m_bpp;
+	ptrdiff_t			m_r0, m_rs, m_c0, m_cs;
+public:
+	TransposeJob(const unsigned char *src, unsigned char *dst, size_t width, size_t height, size_t bpp, Orientation o) :
+		m_src(src), m_dst(dst), m_width(width), m_height(height), m_bpp(bpp),
+		m_r0(0), m_rs(1), m_c0(0), m_cs(1)
+	{
+		if (o == ROTATE90) {
+			m_c0 = (ptrdiff_t)height - 1;
+			m_cs = -1;
+		}
+		else if (o == ROTATE270) {
+			m_r0 = (ptrdiff_t)width - 1;
+			m_rs = -1;
+		}
+	}
+
+	virtual void processRange(size_t begin, size_t end)	// rows of tiles
+	{
+		ptrdiff_t h = (ptrdiff_t)m_height, bpp = (ptrdiff_t)m_bpp;
+		ptrdiff_t step = m_rs*h*bpp;
+		for (size_t ty=begin; ty<end; ++ty)
+		{
+			size_t y0 = ty*TILE;
+			size_t y1 = (y0+TILE < m_height) ? y0+TILE : m_height;
+			for (size_t x0=0; x0<m_width; x0+=TILE)
+			{
+				size_t n = (x0+TILE < m_width) ? TILE : m_width-x0;
+				for (size_t y=y0; y<y1; ++y)
+				{
+					const unsigned char *s = m_src + (y*m_width + x0)*m_bpp;
+					unsigned char *d = m_dst + ((m_r0 + (ptrdiff_t)x0*m_rs)*h + m_c0 + (ptrdiff_t)y*m_cs)*bpp;
+					for (size_t x=0; x<n; ++x, s+=m_bpp, d+=step)
+						P::copy(d, s, m_bpp);
+				}
+			}
+		}
+	}
+};
+
+// transposes a square image in place, swapping tiles across the diagonal
+template <class P>
+class SquareTransposeJob : public ThreadPool::RangeJob
+{
+	unsigned char	*m_data;
+	size_t			m_size, m_bpp;
+public:
+	SquareTransposeJob(unsigned char *data, size_t size, size_t bpp) : m_data(data), m_size(size), m_bpp(bpp) { }
+
+	virtual void processRange(size_t begin, size_t end)	// rows of tiles
+	{
+		for (size_t ty=begin; ty<end; ++ty)
+		{
+			size_t y0 = ty*TILE;
+			size_t y1 = (y0+TILE < m_size) ? y0+TILE : m_size;
+			for (size_t x0=y0; x0<m_size; x0+=TILE)
+			{
+				size_t x1 = (x0+TILE < m_size) ? x0+TILE : m_size;
+				for (size_t y=y0; y<y1; ++y)
+					for (size_t x=(x0 == y0) ? y+1 : x0; x<x1; ++x)
+						P::swap(m_data + (y*m_size + x)*m_bpp, m_data + (x*m_size + y)*m_bpp, m_bpp);
+			}
+		}
+	}
+};
+
+template <class P>
+void reorient_impl(unsigned char *src, unsigned char *dst, size_t width, size_t height, size_t bpp, Orientation o)
+{
+	size_t nTileRows = (height + TILE-1)/TILE;
+	if (src == dst) {
+		ASSERT(width == height && o == TRANSPOSE);
+		SquareTransposeJob<P> job(src, width, bpp);
+		ThreadPool::inst()->parallelFor(job, 0, nTileRows, 1);
+	}
+	else {
+		TransposeJob<P> job(src, dst, width, height, bpp, o);
+		ThreadPool::inst()->parallelFor(job, 0, nTileRows, 1);
+	}
+}
+
+// src == dst for square images transposed in place
+void reorient(unsigned char *src, unsigned char *dst, size_t width, size_t height, size_t bpp, Orientation o)
+{
+	switch (bpp) {
+		case 1:		reorient_impl<FixedPixel<1> >(src, dst, width, height, bpp, o); break;
+		case 2:		reorient_impl<FixedPixel<2> >(src, dst, width, height, bpp, o); break;
+		case 3:		reorient_impl<FixedPixel<3> >(src, dst, width, height, bpp, o); break;
+		case 4:		reorient_impl<FixedPixel<4> >(src, dst, width, height, bpp, o); break;
+		case 6:		reorient_impl<FixedPixel<6> >(src, dst, width, height, bpp, o); break;
+		case 8:		reorient_impl<FixedPixel<8> >(src, dst, width, height, bpp, o); break;
+		case 12:	reorient_impl<FixedPixel<12> >(src, dst, width, height, bpp, o); break;
+		case 16:	reorient_impl<FixedPixel<16> >(src, dst, width, height, bpp, o); break;
+		case 24:	reorient_impl<FixedPixel<24> >(src, dst, width, height, bpp, o); break;
+		case 32:	reorient_impl<FixedPixel<32> >(src, dst, width, height, bpp, o); break;
+		default:	reorient_impl<AnyPixel>(src, dst, width, height, bpp, o);
+	}
+}
+
+};
+
+void Image::flip()
+{
+	if (isEmpty())
+		return;
+	RowJob job(&m_data[0], m_width, m_height, m_bytesPerPixel, true, false);
+	ThreadPool::inst()->parallelFor(job, 0, m_height/2, 64);
+	markAllDirty();
+}
+
+void Image::mirror()
+{
+	if (isEmpty())
+		return;
+	RowJob job(&m_data[0], m_width, m_height, m_bytesPerPixel, false, true);
+	ThreadPool::inst()->parallelFor(job, 0, m_height, 64);
+	markAllDirty();
+}
+
+void Image::rotate180()
+{
+	if (isEmpty())
+		return;
+	RowJob job(&m_data[0], m_width, m_height, m_bytesPerPixel, true, true);
+	ThreadPool::inst()->parallelFor(job, 0, (m_height+1)/2, 64);
+	markAllDirty();
+}
+
+void Image::transpose()
+{
+	if (isEmpty())
+		return;
+	if (m_width == m_height)
+		reorient(&m_data[0], &m_data[0], m_width, m_height, m_bytesPerPixel, TRANSPOSE);
+	else {
+		std::vector<unsigned char> data(m_data.size());
+		reorient(&m_data[0], &data[0], m_width, m_height, m_bytesPerPixel, TRANSPOSE);
+		m_data.swap(data);
+		std::swap(m_width, m_height);
+	}
+	markAllDirty();
+}
+
+void Image::rotate90()
+{
+	if (isEmpty())
+		return;
+	if (m_width == m_height) {
+		// in place: the transpose, mirrored
+		transpose();
+		mirror();
+		return;
+	}
+	std::vector<unsigned char> data(m_data.size());
+	reorient(&m_data[0], &data[0], m_width, m_height, m_bytesPerPixel, ROTATE90);
+	m_data.swap(data);
+	std::swap(m_width, m_height);
+	markAllDirty();
+}
+
+void Image::rotate270()
+{
+	if (isEmpty())
+		return;
+	if (m_width == m_height) {
+		// in place: the transpose, flipped
+		transpose();
+		flip();
+		return;
+	}
+	std::vector<unsigned char> data(m_data.size());
+	reorient(&m_data[0], &data[0], m_width, m_height, m_bytesPerPixel, ROTATE270);
+	m_data.swap(data);
+	std::swap(m_width, m_height);
+	markAllDirty();
+}
+
+void Image::crop(size_t minX, size_t minY, size_t maxX, size_t maxY)
+{
+	ASSERT(minX <= maxX && minY <= maxY);
+	ASSERT(maxX < m_width && maxY < m_height);
+
+	size_t w = maxX - minX+1;
+	size_t h = maxY - minY+1;
+	size_t rowBytes = w*m_bytesPerPixel;
+	std::vector<unsigned char> data(h*rowBytes);
+	for (size_t j=0; j<h; ++j)
+		memcpy(&data[j*rowBytes], (*this)(minX, minY+j), rowBytes);
+
+	m_data.swap(data);
+	m_width = w;
+	m_height = h;
+	markAllDirty();
+}
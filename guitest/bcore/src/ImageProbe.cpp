@@ -0,0 +1,161 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Image.h"
+#include "HDRCodec.h"
+#include <ctype.h>
+
+namespace {
+
+// enough for the headers of all formats, except unusually long hdr headers
+const size_t PROBE_BYTES = 4096;
+const size_t PROBE_BYTES_MAX = 65536;
+
+inline unsigned int readLE16(const unsigned char *p)	{ return p[0] | (p[1] << 8); }
+inline unsigned int readLE32(const unsigned char *p)	{ return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24); }
+inline unsigned int readBE32(const unsigned char *p)	{ return ((unsigned int)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+
+// a number in a ppm header, after any whitespace and comments
+bool readPPMNumber(const unsigned char *&p, const unsigned char *end, size_t &val)
+{
+	while (p < end) {
+		if (*p == '#')
+			while (p < end && *p != '\n') ++p;
+		else if (isspace(*p))
+			++p;
+		else
+			break;
+	}
+	if (p == end || !isdigit(*p))
+		return false;
+	val = 0;
+	while (p < end && isdigit(*p))
+		val = val*10 + (*p++ - '0');
+	return true;
+}
+
+bool probePPM(const unsigned char *data, size_t size, Image::Info &info)
+{
+	// P5 (grey) or P6 (rgb), width, height, max value, a single whitespace character
+	const unsigned char *p = data + 2, *end = data + size;
+	size_t maxVal;
+	if (!readPPMNumber(p, end, info.width) || !readPPMNumber(p, end, info.height) || !readPPMNumber(p, end, maxVal))
+		return false;
+	if (p == end || !isspace(*p) || maxVal == 0 || maxVal > 65535 || info.width == 0 || info.height == 0)
+		return false;
+
+	info.fileType = Image::FILE_PPM;
+	info.nChannels = (data[1] == '5') ? 1 : 3;
+	info.format = (maxVal < 256) ? Image::I8BITS : Image::I16BITS;
+	info.dataOffset = (p + 1) - data;
+	return true;
+}
+
+bool probeBMP(const unsigned char *data, size_t size, Image::Info &info)
+{
+	// file header (14 bytes) and the start of the info header
+	if (size < 54)
+		return false;
+	int width = (int)readLE32(data + 18);
+	int height = (int)readLE32(data + 22);
+	unsigned int bitCount = readLE16(data + 28);
+	unsigned int compression = readLE32(data + 30);
+	if (width <= 0 || height == 0 || bitCount != 24 || compression != 0)
+		return false;	// only uncompressed 24 bit bitmaps are supported
+
+	info.fileType = Image::FILE_BMP;
+	info.width = width;
+	info.height = abs(height);
+	info.nChannels = 3;
+	info.format = Image::I8BITS;
+	info.dataOffset = readLE32(data + 10);
+	return true;
+}
+
+bool probePNG(const unsigned char *data, size_t size, Image::Info &info)
+{
+	// signature, then the IHDR chunk: length, type, width, height
+	if (size < 24 || memcmp(data + 12, "IHDR", 4) != 0)
+		return false;
+
+	info.fileType = Image::FILE_PNG;
+	info.width = readBE32(data + 16);
+	info.height = readBE32(data + 20);
+	info.nChannels = 4;		// always decoded to RGBA
+	info.format = Image::I8BITS;
+	return info.width > 0 && info.height > 0;
+}
+
+bool probeHDR(const unsigned char *data, size_t size, Image::Info &info)
+{
+	HDRCodec::Header header;
+	if (!HDRCodec::decodeHeader(data, size, header))
+		return false;
+
+	info.fileType = Image::FILE_HDR;
+	info.width = header.width;
+	info.height = header.height;
+	info.nChannels = 3;
+	info.format = Image::F32BITS;
+	return true;
+}
+
+};
+
+bool Image::probe(const unsigned char *data, size_t size, Info &info)
+{
+	info = Info();
+	if (size < 2)
+		return false;
+
+	// the type of the file is found from its first bytes
+	static const unsigned char pngSignature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	if (size >= 8 && memcmp(data, pngSignature, 8) == 0)
+		return probePNG(data, size, info);
+	if (data[0] == 'B' && data[1] == 'M')
+		return probeBMP(data, size, info);
+	if (data[0] == 'P' && (data[1] == '5' || data[1] == '6'))
+		return probePPM(data, size, info);
+	if (data[0] == '#' && data[1] == '?')
+		return probeHDR(data, size, info);
+	return false;
+}
+
+bool Image::probe(const std::string &fname, Info &info)
+{
+	info = Info();
+	FILE *fp = fopen(fname.c_str(), "rb");
+	if (!fp)
+		return false;
+
+	// a single read for the header
+	std::vector<unsigned char> header(PROBE_BYTES);
+	size_t size = fread(&header[0], 1, header.size(), fp);
+
+	// hdr headers are lines of text of any length
+	if (size == PROBE_BYTES && header[0] == '#' && header[1] == '?') {
+		header.resize(PROBE_BYTES_MAX);
+		size += fread(&header[size], 1, PROBE_BYTES_MAX - size, fp);
+	}
+	fclose(fp);
+
+	return probe(&header[0], size, info);
+}
@@ -0,0 +1,90 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ImagePyramid.h"
+
+ImagePyramid::ImagePyramid() : m_pBase(0), m_tileSize(256)
+{
+}
+
+ImagePyramid::~ImagePyramid()
+{
+	free();
+}
+
+void ImagePyramid::create(const Image &image, size_t tileSize, bool bSRGB)
+{
+	ASSERT(tileSize > 0);
+
+	free();
+	if (image.isEmpty())
+		return;
+
+	m_pBase = &image;
+	m_tileSize = tileSize;
+
+	// halve the previous level until everything fits in one tile
+	const Image *pPrev = m_pBase;
+	while (pPrev->getWidth() > m_tileSize || pPrev->getHeight() > m_tileSize)
+	{
+		Image *pLevel = new Image();
+		pPrev->downsample2x(*pLevel, bSRGB);
+		if (pLevel->isEmpty()) {
+			delete pLevel;
+			break;		// unsupported format, the pyramid is truncated
+		}
+		m_levels.push_back(pLevel);
+		pPrev = pLevel;
+	}
+}
+
+void ImagePyramid::free()
+{
+	for (size_t i=0; i<m_levels.size(); ++i)
+		SAFE_DELETE(m_levels[i]);
+	m_levels.clear();
+	m_pBase = 0;
+}
+
+void ImagePyramid::getTileRect(size_t level, size_t tx, size_t ty, size_t &x, size_t &y, size_t &w, size_t &h) const
+{
+	ASSERT(tx < getTilesX(level) && ty < getTilesY(level));
+
+	x = tx*m_tileSize;
+	y = ty*m_tileSize;
+	w = getLevelWidth(level) - x;
+	h = getLevelHeight(level) - y;
+	if (w > m_tileSize) w = m_tileSize;
+	if (h > m_tileSize) h = m_tileSize;
+}
+
+void ImagePyramid::getTile(size_t level, size_t tx, size_t ty, Image &tile) const
+{
+	const Image &img = getLevel(level);
+
+	size_t x, y, w, h;
+	getTileRect(level, tx, ty, x, y, w, h);
+
+	tile.create(w, h, (unsigned char)img.getChannelsNum(), img.getFormat());
+	size_t rowBytes = w*img.getBytesPerPixel();
+	for (size_t j=0; j<h; ++j)
+		memcpy(tile(0,j), img(x, y+j), rowBytes);
+}
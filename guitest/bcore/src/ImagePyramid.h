@@ -0,0 +1,70 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _IMAGEPYRAMID_H45631_INCLUDED_
+#define _IMAGEPYRAMID_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+
+/**
+ * ImagePyramid: a chain of successively half-sized copies of an image, cut in
+ *		square tiles of a fixed size. Level 0 is the original image, level i is
+ *		(about) 1/2^i of its size. The last level fits in a single tile.
+ *
+ *		Level 0 is not copied: the pyramid refers to the image passed to create(..),
+ *		which must outlive it (or until free() is called).
+ */
+class ImagePyramid
+{
+private:
+	const Image			*m_pBase;
+	std::vector<Image*>	m_levels;	// levels 1..n; level 0 is m_pBase
+	size_t				m_tileSize;
+
+public:
+	ImagePyramid();
+	virtual ~ImagePyramid();
+
+	// 8-bit images are averaged in linear light, as sRGB, unless bSRGB is false
+	void	create(const Image &image, size_t tileSize = 256, bool bSRGB = true);
+	void	free();
+
+	bool	isEmpty() const				{ return m_pBase == 0; }
+	size_t	getLevelsNum() const		{ return (m_pBase) ? m_levels.size()+1 : 0; }
+	size_t	getTileSize() const			{ return m_tileSize; }
+	const Image&	getLevel(size_t level) const	{ ASSERT(level < getLevelsNum()); return (level==0) ? *m_pBase : *m_levels[level-1]; }
+
+	size_t	getLevelWidth(size_t level) const	{ return getLevel(level).getWidth(); }
+	size_t	getLevelHeight(size_t level) const	{ return getLevel(level).getHeight(); }
+	size_t	getTilesX(size_t level) const		{ return (getLevelWidth(level) + m_tileSize-1) / m_tileSize; }
+	size_t	getTilesY(size_t level) const		{ return (getLevelHeight(level) + m_tileSize-1) / m_tileSize; }
+
+	// get the rectangle of a tile, in pixels of its level. Edge tiles may be smaller than the tile size.
+	void	getTileRect(size_t level, size_t tx, size_t ty, size_t &x, size_t &y, size_t &w, size_t &h) const;
+
+	// copy the pixels of a tile to an image of its size
+	void	getTile(size_t level, size_t tx, size_t ty, Image &tile) const;
+};
+
+#endif
@@ -0,0 +1,246 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ImageStatistics.h"
+#include "ThreadPool.h"
+
+namespace {
+
+// partial results for a band of rows, in unit values
+struct Partial
+{
+	std::vector<int>	bins;		// nBins per channel
+	std::vector<double>	min, max;
+	std::vector<double>	mean, m2;	// m2: sum of squared differences from the mean
+	size_t				n;
+
+	void init(size_t nChannels, size_t nBins) {
+		bins.assign(nChannels*nBins, 0);
+		min.assign(nChannels, 0);
+		max.assign(nChannels, 0);
+		mean.assign(nChannels, 0);
+		m2.assign(nChannels, 0);
+		n = 0;
+	}
+};
+
+// 8/16 bit channels: the bin of each value comes from a table, sums are exact
+template <class S>
+void accumulateInt(const Image &image, size_t y0, size_t y1, const std::vector<int> &binLUT, size_t nBins, Partial &p)
+{
+	size_t nChannels = image.getChannelsNum();
+	size_t w = image.getWidth();
+	std::vector<uint64_t> sum(nChannels, 0), sumSq(nChannels, 0);
+	std::vector<typename S::Type> vmin(nChannels), vmax(nChannels);
+	const typename S::Type *first = (const typename S::Type*)image(0, y0);
+	for (size_t c=0; c<nChannels; ++c)
+		vmin[c] = vmax[c] = first[c];
+
+	for (size_t y=y0; y<y1; ++y)
+	{
+		const typename S::Type *row = (const typename S::Type*)image(0, y);
+		for (size_t x=0; x<w; ++x, row+=nChannels)
+			for (size_t c=0; c<nChannels; ++c)
+			{
+				typename S::Type v = row[c];
+				p.bins[c*nBins + binLUT[v]]++;
+				sum[c] += v;
+				sumSq[c] += (uint64_t)v*v;
+				if (v < vmin[c]) vmin[c] = v;
+				if (v > vmax[c]) vmax[c] = v;
+			}
+	}
+
+	p.n = w*(y1-y0);
+	for (size_t c=0; c<nChannels; ++c)
+	{
+		double s = (double)sum[c];
+		p.min[c] = S::toUnit(vmin[c]);
+		p.max[c] = S::toUnit(vmax[c]);
+		p.mean[c] = s/p.n / 255.0;
+		p.m2[c] = ((double)sumSq[c] - s*s/p.n) / (255.0*255.0);
+	}
+}
+
+// other formats: sums of the differences from the first value of the band, which
+// keeps the variance accurate when it is small relative to the mean
+template <class S>
+void accumulateFloat(const Image &image, size_t y0, size_t y1, size_t nBins, Partial &p)
+{
+	size_t nChannels = image.getChannelsNum();
+	size_t w = image.getWidth();
+	double binScale = (double)(nBins-1);
+	std::vector<double> shift(nChannels), sum(nChannels, 0), sumSq(nChannels, 0);
+	const typename S::Type *first = (const typename S::Type*)image(0, y0);
+	for (size_t c=0; c<nChannels; ++c)
+		shift[c] = p.min[c] = p.max[c] = S::toUnit(first[c]);
+
+	for (size_t y=y0; y<y1; ++y)
+	{
+		const typename S::Type *row = (const typename S::Type*)image(0, y);
+		for (size_t x=0; x<w; ++x, row+=nChannels)
+			for (size_t c=0; c<nChannels; ++c)
+			{
+				double v = S::toUnit(row[c]);
+				double d = v - shift[c];
+				sum[c] += d;
+				sumSq[c] += d*d;
+				if (v < p.min[c]) p.min[c] = v;
+				if (v > p.max[c]) p.max[c] = v;
+
+				// clamped to [0,1], nans go to the first bin
+				double t = (v >= 0) ? ((v < 1) ? v : 1) : 0;
+				p.bins[c*nBins + (int)(binScale*t)]++;
+			}
+	}
+
+	p.n = w*(y1-y0);
+	for (size_t c=0; c<nChannels; ++c)
+	{
+		p.mean[c] = shift[c] + sum[c]/p.n;
+		p.m2[c] = sumSq[c] - sum[c]*sum[c]/p.n;
+	}
+}
+
+class StatisticsJob : public ThreadPool::RangeJob
+{
+	const Image				&m_image;
+	std::vector<Partial>	&m_partials;
+	const std::vector<int>	&m_binLUT;
+	size_t					m_nBins;
+	size_t					m_rowsPerBand;
+public:
+	StatisticsJob(const Image &image, std::vector<Partial> &partials, const std::vector<int> &binLUT, size_t nBins, size_t rowsPerBand) :
+		m_image(image), m_partials(partials), m_binLUT(binLUT), m_nBins(nBins), m_rowsPerBand(rowsPerBand) { }
+
+	virtual void processRange(size_t begin, size_t end)
+	{
+		for (size_t band=begin; band<end; ++band)
+		{
+			Partial &p = m_partials[band];
+			p.init(m_image.getChannelsNum(), m_nBins);
+			size_t y0 = band*m_rowsPerBand;
+			size_t y1 = y0 + m_rowsPerBand;
+			if (y1 > m_image.getHeight())
+				y1 = m_image.getHeight();
+			if (y0 >= y1)
+				continue;
+
+			switch (m_image.getFormat()) {
+				case Image::I8BITS:		accumulateInt<PixelI8>(m_image, y0, y1, m_binLUT, m_nBins, p); break;
+				case Image::I16BITS:	accumulateInt<PixelI16>(m_image, y0, y1, m_binLUT, m_nBins, p); break;
+				case Image::I32BITS:	accumulateFloat<PixelI32>(m_image, y0, y1, m_nBins, p); break;
+				case Image::F16BITS:	accumulateFloat<PixelF16>(m_image, y0, y1, m_nBins, p); break;
+				case Image::F32BITS:	accumulateFloat<PixelF32>(m_image, y0, y1, m_nBins, p); break;
+				case Image::F64BITS:	accumulateFloat<PixelF64>(m_image, y0, y1, m_nBins, p); break;
+			}
+		}
+	}
+};
+
+template <class S>
+void buildBinLUT(size_t nBins, std::vector<int> &lut)
+{
+	size_t nValues = (size_t)1 << (8*sizeof(typename S::Type));
+	lut.resize(nValues);
+	for (size_t v=0; v<nValues; ++v)
+		lut[v] = (int)((nBins-1) * clamp((double)S::toUnit((typename S::Type)v), 0.0, 1.0));
+}
+
+};
+
+void ImageStatistics::compute(const Image &image, size_t nBins)
+{
+	ASSERT(nBins > 1);
+
+	clear();
+	if (image.isEmpty())
+		return;
+	switch (image.getFormat()) {
+		case Image::I8BITS: case Image::I16BITS: case Image::I32BITS:
+		case Image::F16BITS: case Image::F32BITS: case Image::F64BITS:
+			break;
+		default:
+			throw std::runtime_error("image format not supported");
+	}
+
+	std::vector<int> binLUT;
+	if (image.getFormat() == Image::I8BITS)
+		buildBinLUT<PixelI8>(nBins, binLUT);
+	else if (image.getFormat() == Image::I16BITS)
+		buildBinLUT<PixelI16>(nBins, binLUT);
+
+	// one band of rows per thread (and one for the calling thread)
+	size_t h = image.getHeight();
+	size_t nBands = ThreadPool::inst()->getThreadsNum() + 1;
+	if (nBands > (h+15)/16)
+		nBands = (h+15)/16;
+	size_t rowsPerBand = (h + nBands-1) / nBands;
+
+	std::vector<Partial> partials(nBands);
+	StatisticsJob job(image, partials, binLUT, nBins, rowsPerBand);
+	ThreadPool::inst()->parallelFor(job, 0, nBands, 1);
+
+	// merge the bands (Chan et al. for the mean and variance)
+	size_t nChannels = image.getChannelsNum();
+	Partial total = partials[0];
+	for (size_t b=1; b<nBands; ++b)
+	{
+		const Partial &p = partials[b];
+		if (p.n == 0)
+			continue;
+		double n = (double)(total.n + p.n);
+		for (size_t c=0; c<nChannels; ++c)
+		{
+			double delta = p.mean[c] - total.mean[c];
+			total.mean[c] += delta*p.n/n;
+			total.m2[c] += p.m2[c] + delta*delta*total.n*p.n/n;
+			if (p.min[c] < total.min[c]) total.min[c] = p.min[c];
+			if (p.max[c] > total.max[c]) total.max[c] = p.max[c];
+		}
+		for (size_t i=0; i<total.bins.size(); ++i)
+			total.bins[i] += p.bins[i];
+		total.n += p.n;
+	}
+
+	m_nSamples = total.n;
+	m_channels.resize(nChannels);
+	for (size_t c=0; c<nChannels; ++c)
+	{
+		Channel &ch = m_channels[c];
+		ch.min = total.min[c];
+		ch.max = total.max[c];
+		ch.mean = total.mean[c];
+		ch.variance = total.m2[c]/total.n;
+		ch.histogram.create((int)nBins, 0, 1);
+		ch.entropy = 0;
+		for (size_t i=0; i<nBins; ++i)
+		{
+			int count = total.bins[c*nBins + i];
+			ch.histogram.getBin(i) = count;
+			if (count > 0) {
+				double p = (double)count/total.n;
+				ch.entropy -= p*log(p);
+			}
+		}
+		ch.entropy /= log(2.0);
+	}
+}
@@ -0,0 +1,79 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _IMAGESTATISTICS_H45631_INCLUDED_
+#define _IMAGESTATISTICS_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+#include "histogram.h"
+
+/**
+ * ImageStatistics: histograms, min, max, mean, variance and entropy of all the
+ *		channels of an image, computed in a single parallel pass.
+ *
+ *		Values are in the units of Image::changeFormat (integer formats: value/255,
+ *		float formats: the value itself). The histograms cover [0,1] and are binned
+ *		like Image::getHistogram, and the entropy (in bits) is that of Image::calcEntropy.
+ *		The variance is the population variance.
+ *
+ *		The rows are split in one band per thread. Each band has its own partial
+ *		histograms and sums, which are merged at the end. 8 and 16 bit images are
+ *		binned through a table indexed by the integer values, and their sums are
+ *		kept in integers.
+ */
+class ImageStatistics
+{
+public:
+	struct Channel {
+		double				min, max;
+		double				mean, variance;
+		double				entropy;
+		Histogram<double>	histogram;
+	};
+
+private:
+	std::vector<Channel>	m_channels;
+	size_t					m_nSamples;		// per channel
+
+public:
+	ImageStatistics() : m_nSamples(0) { }
+
+	void	compute(const Image &image, size_t nBins = 256);
+	void	clear()		{ m_channels.clear(); m_nSamples = 0; }
+
+	bool	isEmpty() const				{ return m_channels.empty(); }
+	size_t	getChannelsNum() const		{ return m_channels.size(); }
+	size_t	getSamplesNum() const		{ return m_nSamples; }
+	const Channel&	getChannel(size_t c) const	{ ASSERT(c < m_channels.size()); return m_channels[c]; }
+
+	double	getMin(size_t c) const		{ return getChannel(c).min; }
+	double	getMax(size_t c) const		{ return getChannel(c).max; }
+	double	getMean(size_t c) const		{ return getChannel(c).mean; }
+	double	getVariance(size_t c) const	{ return getChannel(c).variance; }
+	double	getStdDev(size_t c) const	{ return sqrt(getChannel(c).variance); }
+	double	getEntropy(size_t c) const	{ return getChannel(c).entropy; }
+	const Histogram<double>&	getHistogram(size_t c) const	{ return getChannel(c).histogram; }
+};
+
+#endif
@@ -0,0 +1,178 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MappedFile.h"
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : m_hFile(INVALID_HANDLE_VALUE), m_hMapping(0), m_pData(0), m_size(0), m_bOpen(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+	close();
+
+	m_hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER sz;
+	if (!GetFileSizeEx(m_hFile, &sz) || (unsigned __int64)sz.QuadPart > (size_t)-1) {
+		Console::error("MappedFile::open(): cannot get the size of %s\n", filename.c_str());
+		close();
+		return false;
+	}
+	m_size = (size_t)sz.QuadPart;
+	m_bOpen = true;
+	if (m_size == 0)
+		return true;	// empty files cannot be mapped, but they are valid
+
+	// map the whole file
+	m_hMapping = CreateFileMapping(m_hFile, 0, PAGE_READONLY, 0, 0, 0);
+	if (m_hMapping)
+		m_pData = (const unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_pData)
+		return true;
+
+	// mapping failed, read it to memory instead
+	if (m_hMapping) {
+		CloseHandle(m_hMapping);
+		m_hMapping = 0;
+	}
+	m_buffer.resize(m_size);
+	size_t nRead = 0;
+	while (nRead < m_size) {
+		DWORD chunk = (m_size - nRead > 0x40000000) ? 0x40000000 : (DWORD)(m_size - nRead);
+		DWORD got = 0;
+		if (!ReadFile(m_hFile, &m_buffer[nRead], chunk, &got, 0) || got == 0)
+			break;
+		nRead += got;
+	}
+	if (nRead < m_size) {
+		Console::error("MappedFile::open(): failed to read %s\n", filename.c_str());
+		close();
+		return false;
+	}
+	m_pData = &m_buffer[0];
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_pData && m_hMapping)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = 0;
+	m_pData = 0;
+	m_size = 0;
+	m_bOpen = false;
+	std::vector<unsigned char>().swap(m_buffer);
+}
+
+#else	// posix
+
+MappedFile::MappedFile() : m_fd(-1), m_bMapped(false), m_pData(0), m_size(0), m_bOpen(false)
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string &filename)
+{
+	close();
+
+	m_fd = ::open(filename.c_str(), O_RDONLY);
+	if (m_fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(m_fd, &st) != 0 || (uint64_t)st.st_size > (size_t)-1) {
+		Console::error("MappedFile::open(): cannot get the size of %s\n", filename.c_str());
+		close();
+		return false;
+	}
+	m_size = (size_t)st.st_size;
+	m_bOpen = true;
+	if (m_size == 0)
+		return true;	// empty files cannot be mapped, but they are valid
+
+	// map the whole file
+	void *p = mmap(0, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+	if (p != MAP_FAILED) {
+		madvise(p, m_size, MADV_SEQUENTIAL);
+		m_pData = (const unsigned char*)p;
+		m_bMapped = true;
+		return true;
+	}
+
+	// mapping failed, read it to memory instead
+	m_buffer.resize(m_size);
+	size_t nRead = 0;
+	while (nRead < m_size) {
+		ssize_t got = ::read(m_fd, &m_buffer[nRead], m_size - nRead);
+		if (got <= 0)
+			break;
+		nRead += got;
+	}
+	if (nRead < m_size) {
+		Console::error("MappedFile::open(): failed to read %s\n", filename.c_str());
+		close();
+		return false;
+	}
+	m_pData = &m_buffer[0];
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_bMapped)
+		munmap((void*)m_pData, m_size);
+	if (m_fd >= 0)
+		::close(m_fd);
+
+	m_fd = -1;
+	m_bMapped = false;
+	m_pData = 0;
+	m_size = 0;
+	m_bOpen = false;
+	std::vector<unsigned char>().swap(m_buffer);
+}
+
+#endif
@@ -0,0 +1,69 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _MAPPEDFILE_H45631_INCLUDED_
+#define _MAPPEDFILE_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * MappedFile: read-only access to the whole contents of a file as one block of
+ *		memory. The file is memory mapped, so the OS pages it in on demand and
+ *		nothing is copied. If mapping fails (fe. on some network shares), the
+ *		file is read in a single call to a buffer instead.
+ *
+ *		Parsers should scan the returned memory with pointers instead of doing
+ *		many small freads/getcs.
+ */
+class MappedFile
+{
+private:
+#ifdef _WIN32
+	HANDLE	m_hFile;
+	HANDLE	m_hMapping;
+#else
+	int		m_fd;
+	bool	m_bMapped;
+#endif
+	const unsigned char			*m_pData;
+	size_t						m_size;
+	bool						m_bOpen;
+	std::vector<unsigned char>	m_buffer;	// used when the file could not be mapped
+
+public:
+	MappedFile();
+	virtual ~MappedFile();
+
+	bool	open(const std::string &filename);
+	void	close();
+
+	bool	isOpen() const						{ return m_bOpen; }
+	const unsigned char*	getData() const		{ return m_pData; }
+	size_t	getSize() const						{ return m_size; }
+
+private:
+	MappedFile(const MappedFile&);				// not copyable
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif
@@ -25,34 +25,125 @@
 #pragma once
 
 #include "common.h"
+#include "AlignedAlloc.h"
+#include "Gemm.h"
+#include "CovarianceAccumulator.h"
 #include <fstream>
+#include <new>
+
+template <class T> class Matrix;
+
+/**
+ * Matrix expressions: element-wise sums and differences of matrices, and products
+ *		and quotients with scalars, are not evaluated when they are written but
+ *		build a small expression object instead. The expression is evaluated in a
+ *		single loop, without temporary matrices, when it is assigned to a matrix
+ *		(or used to construct one), so f.e. "c = a*2 + b" makes one pass over the
+ *		elements and allocates nothing if c already has the right size.
+ *
+ *		MatrixExpr is the (CRTP) base of Matrix and of all the expression types.
+ *		Every expression has numCols(), numRows() and elem(i), the element at
+ *		index i of the row-major storage.
+ */
+template <class T, class E>
+class MatrixExpr
+{
+public:
+	const E&	self() const	{ return static_cast<const E&>(*this); }
+};
+
+// matrices are kept by reference in expressions, other expressions by value
+template <class E>
+struct MatrixExprStore				{ typedef const E Type; };
+template <class T>
+struct MatrixExprStore< Matrix<T> >	{ typedef const Matrix<T>& Type; };
+
+// keeps the type of scalar operands from being deduced (so that m*2 works for a Matrix<double>)
+template <class T>
+struct MatrixScalar					{ typedef T Type; };
+
+struct MatrixAddOp	{ template <class T> static T apply(const T &a, const T &b) { return a + b; } };
+struct MatrixSubOp	{ template <class T> static T apply(const T &a, const T &b) { return a - b; } };
+struct MatrixMulOp	{ template <class T> static T apply(const T &a, const T &b) { return a * b; } };
+struct MatrixDivOp	{ template <class T> static T apply(const T &a, const T &b) { return a / b; } };
+
+template <class T, class L, class R, class Op>
+class MatrixBinaryExpr : public MatrixExpr<T, MatrixBinaryExpr<T,L,R,Op> >
+{
+	typename MatrixExprStore<L>::Type	m_l;
+	typename MatrixExprStore<R>::Type	m_r;
+public:
+	MatrixBinaryExpr(const L &l, const R &r) : m_l(l), m_r(r) {
+		ASSERT(l.numCols() == r.numCols() && l.numRows() == r.numRows());
+	}
+	size_t	numCols() const			{ return m_l.numCols(); }
+	size_t	numRows() const			{ return m_l.numRows(); }
+	T		elem(size_t i) const	{ return Op::apply(m_l.elem(i), m_r.elem(i)); }
+};
+
+template <class T, class E, class Op>
+class MatrixScalarExpr : public MatrixExpr<T, MatrixScalarExpr<T,E,Op> >
+{
+	typename MatrixExprStore<E>::Type	m_e;
+	T									m_f;
+public:
+	MatrixScalarExpr(const E &e, const T &f) : m_e(e), m_f(f) { }
+	size_t	numCols() const			{ return m_e.numCols(); }
+	size_t	numRows() const			{ return m_e.numRows(); }
+	T		elem(size_t i) const	{ return Op::apply(m_e.elem(i), m_f); }
+};
 
 /**
  * Matrix: a class to store general NxM matrices.
  *
+ *		The elements are stored row by row, in a block aligned to 64 bytes (see
+ *		AlignedAlloc, which can also pool the blocks of matrices that are created
+ *		and destroyed often). swap(..) exchanges the contents of two matrices
+ *		without copying, and compilers with rvalue references also get a move
+ *		constructor and move assignment.
  */
 template <class T>
-class Matrix
+class Matrix : public MatrixExpr<T, Matrix<T> >
 {
 private:
 	T *m_elems;
 	size_t m_nRows, m_nCols;
 
+	static T*	allocElems(size_t n);
+	static void	freeElems(T *elems, size_t n);
+
 public:
 	Matrix() : m_elems(0), m_nRows(0), m_nCols(0) { };
-	Matrix(size_t cols, size_t rows) : m_nRows(rows), m_nCols(cols) { m_elems = new T[rows*cols]; }
+	Matrix(size_t cols, size_t rows) : m_nRows(rows), m_nCols(cols) { m_elems = allocElems(rows*cols); }
 	Matrix(size_t cols, size_t rows, const T& val) : m_nRows(rows), m_nCols(cols) {
-		m_elems = new T[rows*cols]; for (size_t i=0; i<rows*cols; ++i) m_elems[i]=val;
+		m_elems = allocElems(rows*cols); fill(val);
 	}
 	Matrix(const Matrix<T>& mat) : m_nRows(mat.m_nRows), m_nCols(mat.m_nCols) {
-		m_elems=new T[mat.m_nRows*mat.m_nCols];
+		m_elems = allocElems(mat.m_nRows*mat.m_nCols);
 		for (size_t i=0; i<mat.m_nRows*mat.m_nCols; ++i) m_elems[i] = mat.m_elems[i];
 	}
-	~Matrix() { SAFE_DELETE_VEC(m_elems); };
+	template <class E>
+	Matrix(const MatrixExpr<T,E>& expr) : m_elems(0), m_nRows(0), m_nCols(0) { *this = expr; }
+#ifdef BCORE_HAS_RVALUE_REFS
+	Matrix(Matrix<T>&& mat) : m_elems(mat.m_elems), m_nRows(mat.m_nRows), m_nCols(mat.m_nCols) {
+		mat.m_elems = 0; mat.m_nRows = 0; mat.m_nCols = 0;
+	}
+#endif
+	~Matrix() { clear(); };
 
 	// methods to create a matrix
-	inline void create(size_t cols, size_t rows) { ASSERT(rows>0 && cols>0); clear(); m_elems = new T[rows*cols]; m_nRows=rows; m_nCols=cols; }
-	inline void clear() { SAFE_DELETE_VEC(m_elems); m_nRows=0; m_nCols=0; }
+	inline void create(size_t cols, size_t rows) {
+		ASSERT(rows>0 && cols>0);
+		if (rows*cols != m_nRows*m_nCols) { clear(); m_elems = allocElems(rows*cols); }	// keep the storage if it fits
+		m_nRows=rows; m_nCols=cols;
+	}
+	inline void clear() { freeElems(m_elems, m_nRows*m_nCols); m_elems=0; m_nRows=0; m_nCols=0; }
+	inline void fill(const T& val) { for (size_t i=0; i<m_nRows*m_nCols; ++i) m_elems[i] = val; }
+	inline void swap(Matrix<T>& mat) {
+		T *elems = m_elems; m_elems = mat.m_elems; mat.m_elems = elems;
+		size_t n = m_nRows; m_nRows = mat.m_nRows; mat.m_nRows = n;
+		n = m_nCols; m_nCols = mat.m_nCols; mat.m_nCols = n;
+	}
 		   void createGaussian(int size);
 	// NOTE: if size is odd, sum of elements will not be 0 in the following (dont use for e.g. derivatives):
 		   void createStep(int size, double orientation);	// create a step, with negative at the negative oriented x-axis
@@ -60,6 +151,7 @@ public:
 
 	inline size_t	numRows() const	{ return m_nRows; }
 	inline size_t	numCols() const	{ return m_nCols; }
+	inline size_t	numElems() const	{ return m_nRows*m_nCols; }
 
 	// mean and variance for the *whole* matrix
 	inline double mean() const;
@@ -74,44 +166,45 @@ public:
 	inline Matrix<double> correlation() const;	// each column is an observation, each row a variable
 	inline void calcCorrCovar(Matrix<double> &corr, Matrix<double> &covar) const;	// do both in one pass, 
 										// since they are interconnected, to avoid duplicate computations
+	// streams the columns to a covariance accumulator, in chunks
+	inline void accumulateCovariance(CovarianceAccumulator &acc) const;
 
 	// unary operations:
 	Matrix<T> transpose() const;
 
 	// convolution
-	template <class T>
-	friend inline Matrix<T> convolution(const Matrix<T> &m1, const Matrix<T> &m2);
-	template <class T>
-	friend inline Matrix<Color> convolution(const Matrix<Color> &m1, const Matrix<T> &m2);
-	template <class T>
-	friend inline double local_convolution(const Matrix<T> &m, const Matrix<T> &filter, size_t x, size_t y);
-	template <class T>
-	friend inline Color local_convolution(const Matrix<Color> &m, const Matrix<T> &filter, size_t x, size_t y);
-
-	template <class T>
-	friend Matrix<T> operator * (const Matrix<T>& m1, const Matrix<T> &m2);
-
-	// multiplication and division with scalars
-	template <class T, class M>
-	friend Matrix<T> operator * (const Matrix<T>& m, const M f);
-	template <class T, class M>
-	friend Matrix<T> operator * (const M f, const Matrix<T>& m);
-	template <class T, class M>
-	friend Matrix<T> operator / (const Matrix<T>& m, const M f);
+	template <class S>
+	friend inline Matrix<S> convolution(const Matrix<S> &m1, const Matrix<S> &m2);
+	template <class S>
+	friend inline Matrix<Color> convolution(const Matrix<Color> &m1, const Matrix<S> &m2);
+	template <class S>
+	friend inline double local_convolution(const Matrix<S> &m, const Matrix<S> &filter, size_t x, size_t y);
+	template <class S>
+	friend inline Color local_convolution(const Matrix<Color> &m, const Matrix<S> &filter, size_t x, size_t y);
+
+	template <class S>
+	friend Matrix<S> operator * (const Matrix<S>& m1, const Matrix<S> &m2);
 
 	// unary multiplication and division by scalar
 	Matrix<T>& operator *= (T f);
 	Matrix<T>& operator /= (T f);
 
-	// unary operations with matrices
-	Matrix<T>& operator += (const Matrix<T>& m);
-	Matrix<T>& operator -= (const Matrix<T>& m);
+	// unary operations with matrices (or matrix expressions)
+	template <class E> Matrix<T>& operator += (const MatrixExpr<T,E>& expr);
+	template <class E> Matrix<T>& operator -= (const MatrixExpr<T,E>& expr);
 
 	// access elements
 	__forceinline		T& operator () (size_t i, size_t j)			{ ASSERT(i>=0&&i<numCols()&&j>=0&&j<numRows()); return m_elems[j*m_nCols + i]; }
 	__forceinline const T& operator () (size_t i, size_t j) const	{ ASSERT(i>=0&&i<numCols()&&j>=0&&j<numRows()); return m_elems[j*m_nCols + i]; }
+	__forceinline		T& elem(size_t i)							{ ASSERT(i<numElems()); return m_elems[i]; }	// row-major index
+	__forceinline const T& elem(size_t i) const						{ ASSERT(i<numElems()); return m_elems[i]; }
 
 	inline Matrix<T>& operator = (const Matrix<T>& mat);
+	template <class E>
+	inline Matrix<T>& operator = (const MatrixExpr<T,E>& expr);
+#ifdef BCORE_HAS_RVALUE_REFS
+	Matrix<T>& operator = (Matrix<T>&& mat)	{ swap(mat); return *this; }	// our old storage goes with mat
+#endif
 	
 	// serialization operators
 	template <class S>
@@ -120,51 +213,96 @@ public:
 	friend std::istream& operator >> (std::istream& stream, Matrix<S>& mat);
 };
 
+template <class T>
+void swap(Matrix<T>& m1, Matrix<T>& m2)	{ m1.swap(m2); }
+
 //-----------------------------
 
+template <class T>
+T* Matrix<T>::allocElems(size_t n)
+{
+	T *elems = (T*)AlignedAlloc::alloc(n*sizeof(T));
+	for (size_t i=0; i<n; ++i)
+		new (elems+i) T;
+	return elems;
+}
+
+template <class T>
+void Matrix<T>::freeElems(T *elems, size_t n)
+{
+	if (!elems)
+		return;
+	for (size_t i=0; i<n; ++i)
+		elems[i].~T();
+	AlignedAlloc::free(elems, n*sizeof(T));
+}
+
 template <class T>
 Matrix<T>& Matrix<T>::operator = (const Matrix<T>& mat) {
-	clear();
-	m_nRows = mat.m_nRows; m_nCols = mat.m_nCols;
-	m_elems=new T[m_nRows*m_nCols];
+	if (&mat == this)
+		return *this;
+	if (mat.numElems() == 0)
+		clear();
+	else
+		create(mat.m_nCols, mat.m_nRows);
 //	memcpy(m_elems, mat.m_elems, sizeof(T)*m_nRows*m_nCols); // Dont use memcpy in case we have complex classes that need deep copy as T
 	for (size_t i=0; i<m_nRows*m_nCols; ++i) m_elems[i] = mat.m_elems[i];
 	return *this;
 }
 
+template <class T>
+template <class E>
+Matrix<T>& Matrix<T>::operator = (const MatrixExpr<T,E>& expr) {
+	// the expression is element-wise, so it may refer to this matrix too
+	const E &e = expr.self();
+	if (e.numCols()*e.numRows() == 0) {
+		clear();
+		return *this;
+	}
+	create(e.numCols(), e.numRows());
+	size_t nElems = m_nRows*m_nCols;
+	for (size_t i=0; i<nElems; ++i)
+		m_elems[i] = e.elem(i);
+	return *this;
+}
+
 template <class T>
 Matrix<T>& Matrix<T>::operator *= (T f) {
-	int nElems = m_nRows*m_nCols;
-	for (int i=0; i<nElems; ++i)
+	size_t nElems = m_nRows*m_nCols;
+	for (size_t i=0; i<nElems; ++i)
 		m_elems[i] *= f;
 	return *this;
 }
 
 template <class T>
 Matrix<T>& Matrix<T>::operator /= (T f) {
-	int nElems = m_nRows*m_nCols;
-	for (int i=0; i<nElems; ++i)
+	size_t nElems = m_nRows*m_nCols;
+	for (size_t i=0; i<nElems; ++i)
 		m_elems[i] /= f;
 	return *this;
 }
 
 template <class T>
-Matrix<T>& Matrix<T>::operator += (const Matrix<T> &m) {
-	ASSERT(m.numRows() == numRows());
-	ASSERT(m.numCols() == numCols());
-	int nElems = m_nRows*m_nCols;
-	for (int i=0; i<nElems; ++i)
-		m_elems[i] += m.m_elems[i];
+template <class E>
+Matrix<T>& Matrix<T>::operator += (const MatrixExpr<T,E> &expr) {
+	const E &e = expr.self();
+	ASSERT(e.numRows() == numRows());
+	ASSERT(e.numCols() == numCols());
+	size_t nElems = m_nRows*m_nCols;
+	for (size_t i=0; i<nElems; ++i)
+		m_elems[i] += e.elem(i);
 	return *this;
 }
 
 template <class T>
-Matrix<T>& Matrix<T>::operator -= (const Matrix<T> &m) {
-	ASSERT(m.numRows() == numRows());
-	ASSERT(m.numCols() == numCols());
-	int nElems = m_nRows*m_nCols;
-	for (int i=0; i<nElems; ++i)
-		m_elems[i] -= m.m_elems[i];
+template <class E>
+Matrix<T>& Matrix<T>::operator -= (const MatrixExpr<T,E> &expr) {
+	const E &e = expr.self();
+	ASSERT(e.numRows() == numRows());
+	ASSERT(e.numCols() == numCols());
+	size_t nElems = m_nRows*m_nCols;
+	for (size_t i=0; i<nElems; ++i)
+		m_elems[i] -= e.elem(i);
 	return *this;
 }
 
@@ -184,7 +322,7 @@ std::istream& operator >> (std::istream& stream, Matrix<T>& mat)
 	mat.clear();
 	stream.read((char*)&mat.m_nRows, sizeof(mat.m_nRows));
 	stream.read((char*)&mat.m_nCols, sizeof(mat.m_nCols));
-	mat.m_elems = new T[mat.m_nRows*mat.m_nCols];
+	mat.m_elems = Matrix<T>::allocElems(mat.m_nRows*mat.m_nCols);
 	stream.read((char*)mat.m_elems, sizeof(T)*mat.m_nRows*mat.m_nCols);
 	return stream;
 }
@@ -415,116 +553,93 @@ T Matrix<T>::abssum() const {
 }
 
 template <class T>
-Matrix<double> Matrix<T>::covariance() const
+void Matrix<T>::accumulateCovariance(CovarianceAccumulator &acc) const
 {
 	size_t nVars = numRows();
 	size_t nSamples = numCols();
+	acc.create(nVars);
 
-	// calculate mean and std for each variable
-	std::vector<double> mean(nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
+	// feed the columns in chunks, one observation after the other
+	const size_t CHUNK = 4096;
+	std::vector<double> obs(CHUNK*nVars);
+	for (size_t s0=0; s0<nSamples; s0+=CHUNK)
 	{
-		for (size_t s=0; s<nSamples; ++s)
-			mean[i] += (*this)(s, i);
-		mean[i] /= nSamples;
+		size_t n = (nSamples-s0 < CHUNK) ? nSamples-s0 : CHUNK;
+		for (size_t i=0; i<nVars; ++i) {
+			const T *row = &m_elems[i*m_nCols + s0];
+			for (size_t s=0; s<n; ++s)
+				obs[s*nVars + i] = (double)row[s];
+		}
+		acc.add(&obs[0], n);
 	}
+}
 
-	// calculate the covariance
-	Matrix<double> cov(nVars, nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
-		for (size_t j=i; j<nVars; ++j)
-		{
-			cov(i,j) = 0;
-			for (size_t s=0; s<nSamples; ++s)
-				cov(i,j) += ((*this)(s,i) - mean[i]) * ((*this)(s,j) - mean[j]);
-			cov(i,j) /= nSamples;
-			cov(j,i) = cov(i,j);
-		}
+template <class T>
+Matrix<double> Matrix<T>::covariance() const
+{
+	CovarianceAccumulator acc;
+	accumulateCovariance(acc);
 
+	Matrix<double> cov(numRows(), numRows());
+	if (numRows() > 0)
+		acc.getCovariance(&cov(0,0));
 	return cov;
 }
 
 template <class T>
 Matrix<double> Matrix<T>::correlation() const
 {
-	size_t nVars = numRows();
-	size_t nSamples = numCols();
-
-	// calculate mean and std for each variable
-	std::vector<double> mean(nVars, 0), var(nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
-	{
-		for (size_t s=0; s<nSamples; ++s) {
-			T elem = (*this)(s, i);
-			mean[i] += elem;
-			var[i] += elem*elem;
-		}
-		mean[i] /= nSamples;
-		var[i] = var[i]/nSamples - mean[i]*mean[i];
-
-		Console::print("%f - %f\n", mean[i], var[i]);
-	}
-
-	// calculate the covariance and correlation
-	Matrix<double> corr(nVars, nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
-		for (size_t j=i; j<nVars; ++j)
-		{
-			corr(i,j) = 0;
-			for (size_t s=0; s<nSamples; ++s)
-				corr(i,j) += ((*this)(s,i) - mean[i]) * ((*this)(s,j) - mean[j]);
-			corr(i,j) /= nSamples;
-
-			// now, corr(i,j) holds the value of the covariance of i and j
-			corr(i,j) /= sqrt(var[i]) * sqrt(var[j]);
-
-			corr(j,i) = corr(i,j);
-		}
+	CovarianceAccumulator acc;
+	accumulateCovariance(acc);
 
+	Matrix<double> corr(numRows(), numRows());
+	if (numRows() > 0)
+		acc.getCorrelation(&corr(0,0));
 	return corr;
 }
 
 template <class T>
 void Matrix<T>::calcCorrCovar(Matrix<double> &corr, Matrix<double> &covar) const
 {
-	size_t nVars = numRows();
-	size_t nSamples = numCols();
-
-	// calculate mean and std for each variable
-	std::vector<double> mean(nVars, 0), var(nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
-	{
-		for (size_t s=0; s<nSamples; ++s) {
-			T elem = (*this)(s, i);
-			mean[i] += elem;
-			var[i] += elem*elem;
-		}
-		mean[i] /= nSamples;
-		var[i] = var[i]/nSamples - mean[i]*mean[i];
-
-		Console::print("%f - %f\n", mean[i], var[i]);
+	CovarianceAccumulator acc;
+	accumulateCovariance(acc);
+
+	corr.create(numRows(), numRows());
+	covar.create(numRows(), numRows());
+	if (numRows() > 0) {
+		acc.getCorrelation(&corr(0,0));
+		acc.getCovariance(&covar(0,0));
 	}
+}
 
-	// calculate the covariance and correlation
-	corr = Matrix<double>(nVars, nVars, 0);
-	covar = Matrix<double>(nVars, nVars, 0);
-	for (size_t i=0; i<nVars; ++i)
-		for (size_t j=i; j<nVars; ++j)
-		{
-			// compute covariance
-			covar(i,j) = 0;
-			for (size_t s=0; s<nSamples; ++s)
-				covar(i,j) += ((*this)(s,i) - mean[i]) * ((*this)(s,j) - mean[j]);
-			covar(i,j) /= nSamples;
-
-			// compute correlation
-			corr(i,j) = covar(i,j) / (sqrt(var[i]) * sqrt(var[j]));
-
-			corr(j,i) = corr(i,j);
-			covar(j,i) = covar(i,j);
+// C += A*B, for row-major m x k A and k x n B
+template <class T>
+inline void matrixMultiplyAdd(size_t m, size_t n, size_t k, const T *A, const T *B, T *C)
+{
+	for (size_t j=0; j<m; ++j)
+		for (size_t p=0; p<k; ++p) {
+			const T a = A[j*k + p];
+			const T *b = B + p*n;
+			T *c = C + j*n;
+			for (size_t i=0; i<n; ++i)
+				c[i] += a * b[i];
 		}
+}
 
-	return corr;
+inline void matrixMultiplyAdd(size_t m, size_t n, size_t k, const double *A, const double *B, double *C)
+{
+	if (m*n*k < Gemm::MIN_FLOPS)
+		matrixMultiplyAdd<double>(m, n, k, A, B, C);
+	else
+		Gemm::multiplyAdd(m, n, k, A, k, B, n, C, n);
+}
+
+inline void matrixMultiplyAdd(size_t m, size_t n, size_t k, const float *A, const float *B, float *C)
+{
+	if (m*n*k < Gemm::MIN_FLOPS)
+		matrixMultiplyAdd<float>(m, n, k, A, B, C);
+	else
+		Gemm::multiplyAdd(m, n, k, A, k, B, n, C, n);
 }
 
 template <class T>
@@ -532,13 +647,8 @@ Matrix<T> operator * (const Matrix<T> &m1, const Matrix<T> &m2)
 {
 	ASSERT(m1.numCols() == m2.numRows());
 	Matrix<T> result(m2.numCols(), m1.numRows(), 0);
-
-	for (size_t i=0; i<m2.numCols(); ++i)
-		for (size_t j=0; j<m1.numRows(); ++j)
-		{
-			for (size_t k=0; k<m1.numCols(); ++k)
-				result(i,j) += m1(k,j) * m2(i,k);
-		}
+	if (result.numElems() > 0 && m1.numCols() > 0)
+		matrixMultiplyAdd(m1.numRows(), m2.numCols(), m1.numCols(), m1.m_elems, m2.m_elems, result.m_elems);
 	return result;
 }
 
@@ -552,35 +662,36 @@ Matrix<T> Matrix<T>::transpose() const
 	return result;
 }
 
-// multiplication and division with scalars
-template <class T, class M>
-Matrix<T> operator * (const Matrix<T>& m, const M f)
+// element-wise sums and differences (evaluated lazily, see MatrixExpr)
+template <class T, class L, class R>
+MatrixBinaryExpr<T,L,R,MatrixAddOp> operator + (const MatrixExpr<T,L>& m1, const MatrixExpr<T,R>& m2)
 {
-	Matrix<T> result(m.numCols(), m.numRows());
-	for (size_t i=0; i<m.numCols(); ++i)
-		for (size_t j=0; j<m.numRows(); ++j)
-			result(i,j) = m(i,j) * f;
-	return result;
+	return MatrixBinaryExpr<T,L,R,MatrixAddOp>(m1.self(), m2.self());
 }
 
-template <class T, class M>
-Matrix<T> operator * (const M f, const Matrix<T>& m)
+template <class T, class L, class R>
+MatrixBinaryExpr<T,L,R,MatrixSubOp> operator - (const MatrixExpr<T,L>& m1, const MatrixExpr<T,R>& m2)
 {
-	Matrix<T> result(m.numCols(), m.numRows());
-	for (size_t i=0; i<m.numCols(); ++i)
-		for (size_t j=0; j<m.numRows(); ++j)
-			result(i,j) = m(i,j) * f;
-	return result;
+	return MatrixBinaryExpr<T,L,R,MatrixSubOp>(m1.self(), m2.self());
 }
 
-template <class T, class M>
-Matrix<T> operator / (const Matrix<T>& m, const M f)
+// multiplication and division with scalars (evaluated lazily, see MatrixExpr)
+template <class T, class E>
+MatrixScalarExpr<T,E,MatrixMulOp> operator * (const MatrixExpr<T,E>& m, typename MatrixScalar<T>::Type f)
 {
-	Matrix<T> result(m.numCols(), m.numRows());
-	for (size_t i=0; i<m.numCols(); ++i)
-		for (size_t j=0; j<m.numRows(); ++j)
-			result(i,j) = m(i,j) / f;
-	return result;
+	return MatrixScalarExpr<T,E,MatrixMulOp>(m.self(), f);
+}
+
+template <class T, class E>
+MatrixScalarExpr<T,E,MatrixMulOp> operator * (typename MatrixScalar<T>::Type f, const MatrixExpr<T,E>& m)
+{
+	return MatrixScalarExpr<T,E,MatrixMulOp>(m.self(), f);
+}
+
+template <class T, class E>
+MatrixScalarExpr<T,E,MatrixDivOp> operator / (const MatrixExpr<T,E>& m, typename MatrixScalar<T>::Type f)
+{
+	return MatrixScalarExpr<T,E,MatrixDivOp>(m.self(), f);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,350 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "MipChain.h"
+#include "ThreadPool.h"
+#include <emmintrin.h>
+
+namespace {
+
+const size_t TILE_SIZE = 64;	// in pixels of level 0, a power of 2
+const size_t TILE_LEVELS = 6;	// levels computed inside a tile, log2(TILE_SIZE)
+
+// sRGB conversion tables, built during static initialization: mip chains are built on
+// any thread
+struct SRGBTables {
+	float			toLinear[256];
+	unsigned char	fromLinear[4096];
+	SRGBTables() {
+		for (int i=0; i<256; ++i) {
+			double c = i/255.0;
+			toLinear[i] = (float)((c <= 0.04045) ? c/12.92 : pow((c+0.055)/1.055, 2.4));
+		}
+		for (int i=0; i<4096; ++i) {
+			double l = i/4095.0;
+			double c = (l <= 0.0031308) ? l*12.92 : 1.055*pow(l, 1/2.4) - 0.055;
+			fromLinear[i] = (unsigned char)(c*255 + 0.5);
+		}
+	}
+};
+const SRGBTables g_srgb;
+
+// per format: the type that holds the sum of 4 values, and the average of such a sum
+template <class T> struct Box;
+template <> struct Box<uint8_t> {
+	typedef uint16_t Acc;
+	static uint8_t avg(unsigned int s)		{ return (uint8_t)((s+2) >> 2); }
+};
+template <> struct Box<uint16_t> {
+	typedef uint32_t Acc;
+	static uint16_t avg(unsigned int s)		{ return (uint16_t)((s+2) >> 2); }
+};
+template <> struct Box<uint32_t> {
+	typedef float64_t Acc;
+	static uint32_t avg(float64_t s)		{ return (uint32_t)(s*0.25 + 0.5); }
+};
+template <> struct Box<float32_t> {
+	typedef float32_t Acc;
+	static float32_t avg(float32_t s)		{ return s*0.25f; }
+};
+template <> struct Box<float64_t> {
+	typedef float64_t Acc;
+	static float64_t avg(float64_t s)		{ return s*0.25; }
+};
+
+// vertical pass: the sums of two rows, in the wider type
+inline void addRows(const uint8_t *a, const uint8_t *b, uint16_t *out, size_t n)
+{
+	size_t i = 0;
+	__m128i zero = _mm_setzero_si128();
+	for (; i+16 <= n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+		_mm_storeu_si128((__m128i*)(out+i), _mm_add_epi16(_mm_unpacklo_epi8(va, zero), _mm_unpacklo_epi8(vb, zero)));
+		_mm_storeu_si128((__m128i*)(out+i+8), _mm_add_epi16(_mm_unpackhi_epi8(va, zero), _mm_unpackhi_epi8(vb, zero)));
+	}
+	for (; i<n; ++i)
+		out[i] = (uint16_t)(a[i] + b[i]);
+}
+
+inline void addRows(const uint16_t *a, const uint16_t *b, uint32_t *out, size_t n)
+{
+	size_t i = 0;
+	__m128i zero = _mm_setzero_si128();
+	for (; i+8 <= n; i += 8) {
+		__m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b+i));
+		_mm_storeu_si128((__m128i*)(out+i), _mm_add_epi32(_mm_unpacklo_epi16(va, zero), _mm_unpacklo_epi16(vb, zero)));
+		_mm_storeu_si128((__m128i*)(out+i+4), _mm_add_epi32(_mm_unpackhi_epi16(va, zero), _mm_unpackhi_epi16(vb, zero)));
+	}
+	for (; i<n; ++i)
+		out[i] = (uint32_t)a[i] + b[i];
+}
+
+inline void addRows(const uint32_t *a, const uint32_t *b, float64_t *out, size_t n)
+{
+	for (size_t i=0; i<n; ++i)
+		out[i] = (float64_t)a[i] + b[i];
+}
+
+inline void addRows(const float32_t *a, const float32_t *b, float32_t *out, size_t n)
+{
+	size_t i = 0;
+	for (; i+4 <= n; i += 4)
+		_mm_storeu_ps(out+i, _mm_add_ps(_mm_loadu_ps(a+i), _mm_loadu_ps(b+i)));
+	for (; i<n; ++i)
+		out[i] = a[i] + b[i];
+}
+
+inline void addRows(const float64_t *a, const float64_t *b, float64_t *out, size_t n)
+{
+	size_t i = 0;
+	for (; i+2 <= n; i += 2)
+		_mm_storeu_pd(out+i, _mm_add_pd(_mm_loadu_pd(a+i), _mm_loadu_pd(b+i)));
+	for (; i<n; ++i)
+		out[i] = a[i] + b[i];
+}
+
+// the area of the source that a rectangle of the destination is computed from
+struct SrcSpan {
+	size_t	x0, x1;		// source columns [x0, x1)
+	size_t	srcW, srcH;
+	size_t	nChannels;
+
+	SrcSpan(const Image &src, size_t dx0, size_t dx1) : srcW(src.getWidth()), srcH(src.getHeight()), nChannels(src.getChannelsNum()) {
+		x0 = 2*dx0;
+		x1 = (2*dx1 < srcW) ? 2*dx1 : srcW;
+	}
+	size_t	getValuesNum() const			{ return (x1-x0)*nChannels; }
+	size_t	row1(size_t y) const			{ return (2*y+1 < srcH) ? 2*y+1 : 2*y; }
+	// offsets in the summed row of the two pixels that make destination pixel x
+	size_t	first(size_t x) const			{ return (2*x - x0)*nChannels; }
+	size_t	second(size_t x) const			{ return (2*x+1 < srcW) ? first(x)+nChannels : first(x); }
+};
+
+template <class T>
+void downsampleRect(const Image &src, Image &dst, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+	typedef typename Box<T>::Acc Acc;
+	SrcSpan span(src, x0, x1);
+	size_t nChannels = span.nChannels;
+	std::vector<Acc> sum(span.getValuesNum());
+
+	for (size_t y=y0; y<y1; ++y)
+	{
+		addRows((const T*)src(span.x0, 2*y), (const T*)src(span.x0, span.row1(y)), &sum[0], sum.size());
+		T *out = (T*)dst(x0, y);
+		for (size_t x=x0; x<x1; ++x) {
+			const Acc *p = &sum[span.first(x)], *q = &sum[span.second(x)];
+			for (size_t c=0; c<nChannels; ++c)
+				out[c] = Box<T>::avg(p[c] + q[c]);
+			out += nChannels;
+		}
+	}
+}
+
+// 8-bit sRGB: color is averaged in linear light, alpha as it is
+void downsampleRectSRGB(const Image &src, Image &dst, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+	SrcSpan span(src, x0, x1);
+	size_t nChannels = span.nChannels;
+	size_t alpha = (nChannels == 4) ? 3 : (nChannels == 2) ? 1 : nChannels;
+	std::vector<float> sum(span.getValuesNum());
+
+	for (size_t y=y0; y<y1; ++y)
+	{
+		const uint8_t *a = src(span.x0, 2*y), *b = src(span.x0, span.row1(y));
+		for (size_t i=0; i<sum.size(); i += nChannels)
+			for (size_t c=0; c<nChannels; ++c)
+				sum[i+c] = (c == alpha) ? (float)a[i+c] + b[i+c] : g_srgb.toLinear[a[i+c]] + g_srgb.toLinear[b[i+c]];
+
+		uint8_t *out = dst(x0, y);
+		for (size_t x=x0; x<x1; ++x) {
+			const float *p = &sum[span.first(x)], *q = &sum[span.second(x)];
+			for (size_t c=0; c<nChannels; ++c) {
+				float v = (p[c] + q[c])*0.25f;
+				out[c] = (c == alpha) ? (uint8_t)(v + 0.5f) : g_srgb.fromLinear[(int)(v*4095 + 0.5f)];
+			}
+			out += nChannels;
+		}
+	}
+}
+
+// half floats are averaged as floats
+void downsampleRectHalf(const Image &src, Image &dst, size_t x0, size_t y0, size_t x1, size_t y1)
+{
+	SrcSpan span(src, x0, x1);
+	size_t nChannels = span.nChannels;
+	std::vector<float> row0(span.getValuesNum()), row1(span.getValuesNum()), sum(span.getValuesNum());
+	std::vector<float> out((x1-x0)*nChannels);
+
+	for (size_t y=y0; y<y1; ++y)
+	{
+		Half::toFloat((const float16_t*)src(span.x0, 2*y), &row0[0], row0.size());
+		Half::toFloat((const float16_t*)src(span.x0, span.row1(y)), &row1[0], row1.size());
+		addRows(&row0[0], &row1[0], &sum[0], sum.size());
+		for (size_t x=x0; x<x1; ++x) {
+			const float *p = &sum[span.first(x)], *q = &sum[span.second(x)];
+			for (size_t c=0; c<nChannels; ++c)
+				out[(x-x0)*nChannels + c] = (p[c] + q[c])*0.25f;
+		}
+		Half::fromFloat(&out[0], (float16_t*)dst(x0, y), out.size());
+	}
+}
+
+// one level, in parallel over rows
+class LevelJob : public ThreadPool::RangeJob
+{
+	const Image	&m_src;
+	Image		&m_dst;
+	bool		m_bSRGB;
+public:
+	LevelJob(const Image &src, Image &dst, bool bSRGB) : m_src(src), m_dst(dst), m_bSRGB(bSRGB) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		MipChain::downsample(m_src, m_dst, 0, begin, m_dst.getWidth(), end, m_bSRGB);
+	}
+};
+
+// the first levels of a chain, in parallel over tiles of level 0. Each tile only
+// needs the pixels of the same tile in the previous level.
+class TileJob : public ThreadPool::RangeJob
+{
+	const MipChain	&m_chain;
+	size_t			m_tilesX;
+	size_t			m_levelsNum;
+public:
+	TileJob(const MipChain &chain, size_t tilesX, size_t levelsNum) : m_chain(chain), m_tilesX(tilesX), m_levelsNum(levelsNum) { }
+
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t t=begin; t<end; ++t)
+		{
+			size_t tx = t % m_tilesX, ty = t / m_tilesX;
+			for (size_t level=1; level<=m_levelsNum; ++level)
+			{
+				Image &dst = const_cast<Image&>(m_chain.getLevel(level));
+				size_t x0 = (tx*TILE_SIZE) >> level, x1 = ((tx+1)*TILE_SIZE) >> level;
+				size_t y0 = (ty*TILE_SIZE) >> level, y1 = ((ty+1)*TILE_SIZE) >> level;
+				if (x1 > dst.getWidth()) x1 = dst.getWidth();
+				if (y1 > dst.getHeight()) y1 = dst.getHeight();
+				if (x0 >= x1 || y0 >= y1)
+					break;
+				MipChain::downsample(m_chain.getLevel(level-1), dst, x0, y0, x1, y1, m_chain.isSRGB());
+			}
+		}
+	}
+};
+
+};
+
+MipChain::MipChain() : m_pBase(0), m_bSRGB(false)
+{
+}
+
+MipChain::~MipChain()
+{
+	free();
+}
+
+void MipChain::create(const Image &image, bool bSRGB, size_t maxLevels)
+{
+	free();
+	if (image.isEmpty())
+		return;
+
+	m_pBase = &image;
+	m_bSRGB = bSRGB && image.getFormat() == Image::I8BITS;
+
+	size_t levelsNum = getFullLevelsNum(image.getWidth(), image.getHeight());
+	if (maxLevels > 0 && maxLevels < levelsNum)
+		levelsNum = maxLevels;
+
+	size_t w = image.getWidth(), h = image.getHeight();
+	for (size_t i=1; i<levelsNum; ++i) {
+		w = (w > 1) ? w/2 : 1;
+		h = (h > 1) ? h/2 : 1;
+		Image *pLevel = new Image();
+		pLevel->create(w, h, (unsigned char)image.getChannelsNum(), image.getFormat());
+		m_levels.push_back(pLevel);
+	}
+
+	// the levels that are at least a pixel per tile, tile by tile
+	size_t tileLevels = (levelsNum-1 < TILE_LEVELS) ? levelsNum-1 : TILE_LEVELS;
+	if (tileLevels > 0) {
+		size_t tilesX = (image.getWidth() + TILE_SIZE-1) / TILE_SIZE;
+		size_t tilesY = (image.getHeight() + TILE_SIZE-1) / TILE_SIZE;
+		TileJob job(*this, tilesX, tileLevels);
+		ThreadPool::inst()->parallelFor(job, 0, tilesX*tilesY, 1);
+	}
+
+	// the rest, level by level
+	for (size_t i=tileLevels+1; i<levelsNum; ++i)
+		downsample(getLevel(i-1), *m_levels[i-1], m_bSRGB);
+}
+
+void MipChain::free()
+{
+	for (size_t i=0; i<m_levels.size(); ++i)
+		SAFE_DELETE(m_levels[i]);
+	m_levels.clear();
+	m_pBase = 0;
+	m_bSRGB = false;
+}
+
+size_t MipChain::getFullLevelsNum(size_t width, size_t height)
+{
+	size_t n = 1;
+	while (width > 1 || height > 1) {
+		width = (width > 1) ? width/2 : 1;
+		height = (height > 1) ? height/2 : 1;
+		n++;
+	}
+	return n;
+}
+
+bool MipChain::downsample(const Image &src, Image &dst, bool bSRGB)
+{
+	if (src.isEmpty() || dst.isEmpty() || src.getFormat() != dst.getFormat() || src.getChannelsNum() != dst.getChannelsNum())
+		return false;
+	if (dst.getWidth() > (src.getWidth()+1)/2 || dst.getHeight() > (src.getHeight()+1)/2)
+		return false;
+
+	LevelJob job(src, dst, bSRGB);
+	ThreadPool::inst()->parallelFor(job, 0, dst.getHeight(), 16);
+	return true;
+}
+
+void MipChain::downsample(const Image &src, Image &dst, size_t x0, size_t y0, size_t x1, size_t y1, bool bSRGB)
+{
+	switch (src.getFormat()) {
+		case Image::I8BITS:
+			if (bSRGB)
+				downsampleRectSRGB(src, dst, x0, y0, x1, y1);
+			else
+				downsampleRect<uint8_t>(src, dst, x0, y0, x1, y1);
+			break;
+		case Image::I16BITS:	downsampleRect<uint16_t>(src, dst, x0, y0, x1, y1); break;
+		case Image::I32BITS:	downsampleRect<uint32_t>(src, dst, x0, y0, x1, y1); break;
+		case Image::F16BITS:	downsampleRectHalf(src, dst, x0, y0, x1, y1); break;
+		case Image::F32BITS:	downsampleRect<float32_t>(src, dst, x0, y0, x1, y1); break;
+		case Image::F64BITS:	downsampleRect<float64_t>(src, dst, x0, y0, x1, y1); break;
+	}
+}
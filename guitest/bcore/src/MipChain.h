@@ -0,0 +1,78 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _MIPCHAIN_H45631_INCLUDED_
+#define _MIPCHAIN_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+
+/**
+ * MipChain: all the mip levels of an image, down to 1x1, built on the CPU. Each
+ *		level is half the size of the previous one, rounded down as in OpenGL, so
+ *		the chain can be uploaded as the complete mipmap set of a texture (see
+ *		Texture::create(const MipChain&)).
+ *
+ *		Levels are averaged with a 2x2 box filter, for all image formats. For 8-bit
+ *		sRGB images (bSRGB), color is averaged in linear light (alpha is linear
+ *		already), so that zoomed out images do not get darker.
+ *
+ *		Level 0 is cut in square tiles, and each tile computes all of its own levels
+ *		while it is still in the cache, in parallel with the other tiles. The few
+ *		smallest levels, which are smaller than a tile, are computed after that.
+ *
+ *		Like in ImagePyramid, level 0 is not copied: the chain refers to the image
+ *		passed to create(..), which must outlive it.
+ */
+class MipChain
+{
+private:
+	const Image			*m_pBase;
+	std::vector<Image*>	m_levels;	// levels 1..n
+	bool				m_bSRGB;
+
+public:
+	MipChain();
+	virtual ~MipChain();
+
+	// maxLevels limits the number of levels (including level 0); 0 builds all
+	void	create(const Image &image, bool bSRGB = false, size_t maxLevels = 0);
+	void	free();
+
+	bool	isEmpty() const				{ return m_pBase == 0; }
+	bool	isSRGB() const				{ return m_bSRGB; }
+	size_t	getLevelsNum() const		{ return (m_pBase) ? m_levels.size()+1 : 0; }
+	const Image&	getLevel(size_t level) const	{ ASSERT(level < getLevelsNum()); return (level==0) ? *m_pBase : *m_levels[level-1]; }
+
+	// the number of levels of a full chain for an image of that size
+	static size_t	getFullLevelsNum(size_t width, size_t height);
+
+	// averages 2x2 blocks of src into dst, which must already be created with the same
+	// format and about half the size (rounded up or down). Runs in parallel.
+	static bool		downsample(const Image &src, Image &dst, bool bSRGB = false);
+
+	// the same, only for the pixels [x0,x1)x[y0,y1) of dst
+	static void		downsample(const Image &src, Image &dst, size_t x0, size_t y0, size_t x1, size_t y1, bool bSRGB = false);
+};
+
+#endif
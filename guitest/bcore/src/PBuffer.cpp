@@ -1,5 +1,7 @@
 #include "PBuffer.h"
 
+#ifdef _WIN32
+
 //TEMP!
 extern void wglGetLastError();
 
@@ -231,4 +233,6 @@ void PBuffer::makeCurrent()
 {
 	if (wglMakeCurrent( m_hdc, m_hglrc) == FALSE)
 		wglGetLastError();
-}
\ No newline at end of file
+}
+
+#endif
@@ -26,6 +26,8 @@
 
 #include "common.h"
 
+#ifdef _WIN32	// wgl pbuffers; RenderPass uses FBOs everywhere else
+
 class PBuffer
 {
 private:
@@ -53,4 +55,6 @@ public:
 	void makeCurrent();
 };
 
+#endif
+
 #endif
\ No newline at end of file
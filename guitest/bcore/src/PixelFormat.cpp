@@ -0,0 +1,132 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PixelFormat.h"
+#include <emmintrin.h>
+
+// 8 bits <-> float
+
+template <>
+void PixelConvert<PixelI8, PixelF32>::row(const uint8_t *src, float32_t *dst, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f/255.0f);
+	size_t i = 0;
+	for (; i+16<=n; i+=16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		_mm_storeu_ps(dst+i,    _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+		_mm_storeu_ps(dst+i+4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+		_mm_storeu_ps(dst+i+8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+		_mm_storeu_ps(dst+i+12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+	}
+	for (; i<n; ++i)
+		dst[i] = PixelI8::toUnit(src[i]);
+}
+
+template <>
+void PixelConvert<PixelF32, PixelI8>::row(const float32_t *src, uint8_t *dst, size_t n)
+{
+	// max(x,0) also maps NaNs to 0, like PixelI8::fromUnit
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 zero = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i+16<=n; i+=16)
+	{
+		__m128i a = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i),    scale), zero), scale));
+		__m128i b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4),  scale), zero), scale));
+		__m128i c = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+8),  scale), zero), scale));
+		__m128i d = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src+i+12), scale), zero), scale));
+		__m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+		_mm_storeu_si128((__m128i*)(dst+i), v);
+	}
+	for (; i<n; ++i)
+		dst[i] = PixelI8::fromUnit(src[i]);
+}
+
+// 16 bits <-> float
+
+template <>
+void PixelConvert<PixelI16, PixelF32>::row(const uint16_t *src, float32_t *dst, size_t n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f/255.0f);
+	size_t i = 0;
+	for (; i+8<=n; i+=8)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(src+i));
+		_mm_storeu_ps(dst+i,   _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), scale));
+		_mm_storeu_ps(dst+i+4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), scale));
+	}
+	for (; i<n; ++i)
+		dst[i] = PixelI16::toUnit(src[i]);
+}
+
+template <>
+void PixelConvert<PixelF32, PixelI16>::row(const float32_t *src, uint16_t *dst, size_t n)
+{
+	// rounded like PixelI16::fromUnit. SSE2 has no unsigned 32->16 pack: bias the values
+	// to the signed range, pack with signed saturation and flip the sign bit back
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 maxv = _mm_set1_ps(65535.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128i bias32 = _mm_set1_epi32(32768);
+	const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+	size_t i = 0;
+	for (; i+8<=n; i+=8)
+	{
+		__m128i a = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src+i),   scale), half), zero), maxv));
+		__m128i b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src+i+4), scale), half), zero), maxv));
+		__m128i v = _mm_packs_epi32(_mm_sub_epi32(a, bias32), _mm_sub_epi32(b, bias32));
+		_mm_storeu_si128((__m128i*)(dst+i), _mm_xor_si128(v, bias16));
+	}
+	for (; i<n; ++i)
+		dst[i] = PixelI16::fromUnit(src[i]);
+}
+
+// half floats
+
+template <>
+void PixelConvert<PixelF16, PixelF32>::row(const float16_t *src, float32_t *dst, size_t n)
+{
+	Half::toFloat(src, dst, n);
+}
+
+template <>
+void PixelConvert<PixelF32, PixelF16>::row(const float32_t *src, float16_t *dst, size_t n)
+{
+	Half::fromFloat(src, dst, n);
+}
+
+template <>
+void PixelConvert<PixelI8, PixelF16>::row(const uint8_t *src, float16_t *dst, size_t n)
+{
+	Half::fromUint8(src, dst, n);
+}
+
+template <>
+void PixelConvert<PixelF16, PixelI8>::row(const float16_t *src, uint8_t *dst, size_t n)
+{
+	Half::toUint8(src, dst, n);
+}
@@ -0,0 +1,139 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _PIXELFORMAT_H45631_INCLUDED_
+#define _PIXELFORMAT_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Half.h"
+
+/**
+ * Pixel format traits, used by Image::transform(..) to specialise pixel kernels
+ *		on the pixel format at compile time. Each class gives the channel type and
+ *		the mapping between channel values and "unit" values: value/255 for the
+ *		integer formats (as Image::changeFormat always did), the value itself for
+ *		the float formats. fromUnit clamps to the range of integer formats.
+ *		maxUnit is the unit value of the largest channel value (1 for floats).
+ */
+struct PixelI8
+{
+	typedef uint8_t	Type;
+	static float	toUnit(Type v)		{ return v*(1.0f/255.0f); }
+	static Type		fromUnit(float v)	{ v *= 255.0f; return (v > 0) ? ((v < 255.0f) ? (Type)v : 255) : 0; }
+	static double	maxUnit()			{ return 1.0; }
+};
+
+struct PixelI16
+{
+	typedef uint16_t Type;
+	static float	toUnit(Type v)		{ return v*(1.0f/255.0f); }
+	static Type		fromUnit(float v)	{ v = v*255.0f + 0.5f; return (v > 0) ? ((v < 65535.0f) ? (Type)v : 65535) : 0; }	// rounded, so that I32 round-trips
+	static double	maxUnit()			{ return 65535.0/255.0; }
+};
+
+struct PixelI32
+{
+	typedef uint32_t Type;
+	static double	toUnit(Type v)		{ return v/255.0; }
+	static Type		fromUnit(double v)	{ v *= 255.0; return (v > 0) ? ((v < 4294967295.0) ? (Type)v : 4294967295u) : 0; }
+	static double	maxUnit()			{ return 4294967295.0/255.0; }
+};
+
+struct PixelF16
+{
+	typedef float16_t Type;
+	static float	toUnit(Type v)		{ return Half::toFloat(v); }
+	static Type		fromUnit(float v)	{ return Half::fromFloat(v); }
+	static double	maxUnit()			{ return 1.0; }
+};
+
+struct PixelF32
+{
+	typedef float32_t Type;
+	static float	toUnit(Type v)		{ return v; }
+	static Type		fromUnit(float v)	{ return v; }
+	static double	maxUnit()			{ return 1.0; }
+};
+
+struct PixelF64
+{
+	typedef float64_t Type;
+	static double	toUnit(Type v)		{ return v; }
+	static Type		fromUnit(double v)	{ return v; }
+	static double	maxUnit()			{ return 1.0; }
+};
+
+/**
+ * PixelChannels: the number of channels of a pixel, known at compile time for
+ *		N > 0. PixelChannels<0> carries the count at runtime.
+ */
+template <int N>
+struct PixelChannels
+{
+	size_t	num() const		{ return N; }
+};
+
+template <>
+struct PixelChannels<0>
+{
+	size_t	m_n;
+	PixelChannels(size_t n) : m_n(n) { }
+	size_t	num() const		{ return m_n; }
+};
+
+/**
+ * PixelConvert: converts n channel values of format S to format D. The generic
+ *		version goes through unit values one at a time; same-format copies, the
+ *		8/16 bit <-> float paths and the half float paths are specialised (SSE2,
+ *		or the bulk Half conversions).
+ */
+template <class S, class D>
+struct PixelConvert
+{
+	static void row(const typename S::Type *src, typename D::Type *dst, size_t n)
+	{
+		for (size_t i=0; i<n; ++i)
+			dst[i] = D::fromUnit(S::toUnit(src[i]));
+	}
+};
+
+template <class S>
+struct PixelConvert<S, S>
+{
+	static void row(const typename S::Type *src, typename S::Type *dst, size_t n)
+	{
+		if (src != dst)
+			memcpy(dst, src, n*sizeof(typename S::Type));
+	}
+};
+
+template <> void PixelConvert<PixelI8, PixelF32>::row(const uint8_t *src, float32_t *dst, size_t n);
+template <> void PixelConvert<PixelF32, PixelI8>::row(const float32_t *src, uint8_t *dst, size_t n);
+template <> void PixelConvert<PixelI16, PixelF32>::row(const uint16_t *src, float32_t *dst, size_t n);
+template <> void PixelConvert<PixelF32, PixelI16>::row(const float32_t *src, uint16_t *dst, size_t n);
+template <> void PixelConvert<PixelF16, PixelF32>::row(const float16_t *src, float32_t *dst, size_t n);
+template <> void PixelConvert<PixelF32, PixelF16>::row(const float32_t *src, float16_t *dst, size_t n);
+template <> void PixelConvert<PixelI8, PixelF16>::row(const uint8_t *src, float16_t *dst, size_t n);
+template <> void PixelConvert<PixelF16, PixelI8>::row(const float16_t *src, uint8_t *dst, size_t n);
+
+#endif
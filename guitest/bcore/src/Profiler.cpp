@@ -0,0 +1,213 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Profiler.h"
+#include "Timer.h"
+#include "Thread.h"
+#include <fstream>
+
+Profiler *Profiler::m_pInst = 0;
+
+Profiler::Profiler() : m_historyHead(0), m_historyNum(0), m_depth(0),
+	m_bEnabled(true), m_bInFrame(false), m_threadId(0), m_timeOrigin(Timer::now())
+{
+	m_history.resize(120);
+	m_cur.id = 0;
+	m_cur.start = m_cur.end = 0;
+	for (int i=0; i<COUNTERS_NUM; ++i)
+		m_cur.counters[i] = 0;
+}
+
+Profiler::~Profiler()
+{
+}
+
+bool Profiler::isCompiledIn()
+{
+#ifdef BCORE_PROFILER
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Profiler::isProfiledThread() const
+{
+	return m_bInFrame && Thread::currentId() == m_threadId;
+}
+
+void Profiler::nextFrame()
+{
+	double t = Timer::now();
+
+	// store the finished frame. Swapping keeps the zone vectors allocated,
+	// so that steady state frames do not allocate memory.
+	if (m_bInFrame && m_bEnabled && !m_history.empty())
+	{
+		m_cur.end = t;
+		Frame &slot = m_history[m_historyHead];
+		slot.id = m_cur.id;
+		slot.start = m_cur.start;
+		slot.end = m_cur.end;
+		slot.zones.swap(m_cur.zones);
+		for (int i=0; i<COUNTERS_NUM; ++i)
+			slot.counters[i] = m_cur.counters[i];
+
+		m_historyHead = (m_historyHead+1) % m_history.size();
+		if (m_historyNum < m_history.size())
+			++m_historyNum;
+	}
+
+	// start the new one
+	m_bInFrame = true;
+	m_threadId = Thread::currentId();
+	m_cur.id++;
+	m_cur.start = t;
+	m_cur.end = t;
+	m_cur.zones.clear();
+	for (int i=0; i<COUNTERS_NUM; ++i)
+		m_cur.counters[i] = 0;
+	m_depth = 0;
+}
+
+size_t Profiler::beginZone(const char *name)
+{
+	if (!m_bEnabled || !isProfiledThread())
+		return (size_t)-1;
+
+	ZoneEvent ev;
+	ev.name = name;
+	ev.start = Timer::now();
+	ev.end = ev.start;
+	ev.depth = m_depth++;
+	m_cur.zones.push_back(ev);
+	return m_cur.zones.size()-1;
+}
+
+void Profiler::endZone(size_t id, size_t frameId)
+{
+	// zones opened in a previous frame (or while disabled) are dropped
+	if (frameId != m_cur.id || id >= m_cur.zones.size() || !isProfiledThread())
+		return;
+	m_cur.zones[id].end = Timer::now();
+	if (m_depth > 0)
+		--m_depth;
+}
+
+void Profiler::count(Counter counter, int n)
+{
+	ASSERT(counter >= 0 && counter < COUNTERS_NUM);
+	if (m_bEnabled && isProfiledThread())
+		m_cur.counters[counter] += n;
+}
+
+void Profiler::setHistorySize(size_t nFrames)
+{
+	if (nFrames < 1)
+		nFrames = 1;
+	m_history.clear();
+	m_history.resize(nFrames);
+	m_historyHead = 0;
+	m_historyNum = 0;
+}
+
+const Profiler::Frame& Profiler::getFrame(size_t i) const
+{
+	ASSERT(i < m_historyNum);
+	size_t oldest = (m_historyHead + m_history.size() - m_historyNum) % m_history.size();
+	return m_history[(oldest + i) % m_history.size()];
+}
+
+void Profiler::clear()
+{
+	m_historyHead = 0;
+	m_historyNum = 0;
+}
+
+const char* Profiler::getCounterName(Counter counter)
+{
+	switch (counter) {
+		case VERTICES:			return "vertices";
+		case TEXTURE_BINDS:		return "texture binds";
+		case SCISSOR_CHANGES:	return "scissor changes";
+		case TEXTURE_UPLOADS:	return "texture uploads";
+		case UPLOAD_BYTES:		return "upload bytes";
+		default:				return "?";
+	}
+}
+
+namespace {
+
+void writeJSONString(std::ofstream &file, const char *str)
+{
+	file << '"';
+	for (const char *c = str; *c; ++c) {
+		if (*c == '"' || *c == '\\')
+			file << '\\';
+		file << *c;
+	}
+	file << '"';
+}
+
+};
+
+bool Profiler::exportChromeTrace(const std::string &filename) const
+{
+	std::ofstream file(filename.c_str());
+	if (!file) {
+		Console::error("Profiler::exportChromeTrace(): failed to open %s\n", filename.c_str());
+		return false;
+	}
+
+	// timestamps are in microseconds
+	file.setf(std::ios::fixed);
+	file.precision(3);
+	file << "{\"traceEvents\":[\n";
+	bool bFirst = true;
+	for (size_t i=0; i<m_historyNum; ++i)
+	{
+		const Frame &frame = getFrame(i);
+
+		if (!bFirst) file << ",\n";
+		bFirst = false;
+		file << "{\"name\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << (frame.start - m_timeOrigin)*1e6
+			<< ",\"dur\":" << frame.getDuration()*1e6 << ",\"args\":{\"id\":" << frame.id << "}}";
+
+		for (size_t j=0; j<frame.zones.size(); ++j) {
+			const ZoneEvent &ev = frame.zones[j];
+			file << ",\n{\"name\":";
+			writeJSONString(file, ev.name);
+			file << ",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":" << (ev.start - m_timeOrigin)*1e6
+				<< ",\"dur\":" << (ev.end - ev.start)*1e6 << "}";
+		}
+
+		file << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":" << (frame.start - m_timeOrigin)*1e6 << ",\"args\":{";
+		for (int c=0; c<COUNTERS_NUM; ++c) {
+			if (c > 0) file << ",";
+			writeJSONString(file, getCounterName((Counter)c));
+			file << ":" << frame.counters[c];
+		}
+		file << "}}";
+	}
+	file << "\n]}\n";
+
+	return true;
+}
@@ -0,0 +1,133 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _PROFILER_H45631_INCLUDED_
+#define _PROFILER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * Profiler: records timed zones and per-frame counters, and keeps the last
+ *		frames in a ring buffer, to be displayed in an overlay or exported as a
+ *		Chrome trace (chrome://tracing, or https://ui.perfetto.dev).
+ *
+ *		Code is instrumented with the PROFILE_* macros below. They compile to
+ *		nothing unless BCORE_PROFILER is defined, so instrumentation costs nothing
+ *		in normal builds. Only the thread that calls PROFILE_FRAME() is recorded;
+ *		zones and counters on other threads are ignored.
+ */
+#ifdef BCORE_PROFILER
+	#define PROFILE_CAT_I(a, b)			a##b
+	#define PROFILE_CAT(a, b)			PROFILE_CAT_I(a, b)
+	#define PROFILE_ZONE(name)			Profiler::Zone PROFILE_CAT(_profZone, __LINE__)(name)
+	#define PROFILE_COUNT(counter, n)	Profiler::inst()->count(Profiler::counter, (n))
+	#define PROFILE_FRAME()				Profiler::inst()->nextFrame()
+#else
+	#define PROFILE_ZONE(name)
+	#define PROFILE_COUNT(counter, n)
+	#define PROFILE_FRAME()
+#endif
+
+class Profiler
+{
+public:
+	enum Counter {
+		VERTICES,			// immediate mode vertices
+		TEXTURE_BINDS,
+		SCISSOR_CHANGES,
+		TEXTURE_UPLOADS,
+		UPLOAD_BYTES,
+		COUNTERS_NUM
+	};
+
+	struct ZoneEvent {
+		const char	*name;		// must be a string literal (or otherwise outlive the profiler)
+		double		start, end;	// in seconds
+		int			depth;
+	};
+
+	struct Frame {
+		size_t					id;
+		double					start, end;
+		std::vector<ZoneEvent>	zones;		// in order of entry
+		int						counters[COUNTERS_NUM];
+
+		double	getDuration() const		{ return end - start; }
+	};
+
+	// times the scope it is declared in
+	class Zone {
+		size_t	m_id, m_frameId;
+	public:
+		Zone(const char *name)	{ Profiler *p = Profiler::inst(); m_frameId = p->getCurFrameId(); m_id = p->beginZone(name); }
+		~Zone()					{ Profiler::inst()->endZone(m_id, m_frameId); }
+	};
+
+private:
+	std::vector<Frame>	m_history;		// ring buffer of finished frames
+	size_t				m_historyHead;	// next slot to write
+	size_t				m_historyNum;
+	Frame				m_cur;
+	int					m_depth;
+	bool				m_bEnabled;
+	bool				m_bInFrame;
+	unsigned long		m_threadId;		// the thread being profiled
+	double				m_timeOrigin;
+
+	static Profiler	*m_pInst;
+
+public:
+	Profiler();
+	virtual ~Profiler();
+
+	static Profiler* inst()		{ if (!m_pInst) m_pInst = new Profiler(); return m_pInst; }
+
+	// enable/pause recording at runtime
+	void	setEnabled(bool bEnabled)	{ m_bEnabled = bEnabled; }
+	bool	isEnabled() const			{ return m_bEnabled; }
+	static bool	isCompiledIn();
+
+	void	nextFrame();				// ends the current frame and starts a new one
+	size_t	getCurFrameId() const		{ return m_cur.id; }
+	size_t	beginZone(const char *name);
+	void	endZone(size_t id, size_t frameId);
+	void	count(Counter counter, int n = 1);
+
+	// recent frames: 0 is the oldest, getFramesNum()-1 the most recent
+	void	setHistorySize(size_t nFrames);
+	size_t	getHistorySize() const		{ return m_history.size(); }
+	size_t	getFramesNum() const		{ return m_historyNum; }
+	const Frame&	getFrame(size_t i) const;
+	const Frame*	getLastFrame() const	{ return (m_historyNum > 0) ? &getFrame(m_historyNum-1) : 0; }
+	void	clear();
+
+	static const char*	getCounterName(Counter counter);
+
+	// write the recorded frames in the Chrome trace event format (JSON)
+	bool	exportChromeTrace(const std::string &filename) const;
+
+private:
+	bool	isProfiledThread() const;
+};
+
+#endif
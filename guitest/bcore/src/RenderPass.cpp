@@ -1,19 +1,27 @@
 #include "RenderPass.h"
+#include "TextureBudget.h"
+#include "SharedContextLoader.h"
 #include <stdlib.h>
 
+#ifdef _WIN32
 //TEMP!
 void wglGetLastError() { };
+#endif
 
-RenderPass::RenderPass() : m_pFrameTexture(0), m_bOwnsTexture(false),
+std::vector<RenderPass*> RenderPass::m_passStack;
+
+RenderPass::RenderPass() : m_pFrameTexture(0), m_pDepthTex(0), m_bOwnsTexture(false),
 	m_width(-1), m_height(-1),
 	m_format(PIXEL_RGBA8),
-	m_last_hdc(0),
-	m_last_hglrc(0),
-	m_pDepthTex(0),
+	m_bGenMipmaps(false),
 	m_bUsePBuffer(false),
 	m_FBO(0),
 	m_FBODepthBuffer(0),
-	m_bGenMipmaps(false)
+	m_pSetupTask(0)
+#ifdef _WIN32
+	, m_last_hdc(0),
+	m_last_hglrc(0)
+#endif
 {
 }
 
@@ -22,6 +30,88 @@ RenderPass::~RenderPass()
 	free();
 }
 
+/**
+ * RenderPass::SetupTask: creates the targets of a pass on the loader thread. The FBO
+ * that holds them is not shared between contexts, so it is made on the GL thread.
+ */
+class RenderPass::SetupTask : public SharedContextLoader::Task
+{
+public:
+	RenderPass	*m_pPass;	// 0 if the pass was freed (or set up again) in the meantime
+	GLenum		m_texFormat;
+	int			m_width, m_height;
+	bool		m_bDepthBuffer;
+	Texture		*m_pTexture;
+	GLuint		m_depthBuffer;
+
+	SetupTask(RenderPass *pPass, GLenum texFormat, int w, int h, bool bDepthBuffer) : m_pPass(pPass),
+		m_texFormat(texFormat), m_width(w), m_height(h), m_bDepthBuffer(bDepthBuffer),
+		m_pTexture(0), m_depthBuffer(0) { }
+
+	virtual ~SetupTask() {
+		// whatever was not handed over to the pass
+		SAFE_DELETE(m_pTexture);
+		if (m_depthBuffer) {
+			TextureBudget::inst()->removeRenderbuffer(m_depthBuffer);
+			glDeleteRenderbuffersEXT(1, &m_depthBuffer);
+		}
+	}
+
+	virtual bool load() {
+		m_pTexture = new Texture();
+		m_pTexture->create(m_width, m_height, m_texFormat);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		if (m_bDepthBuffer)
+			m_depthBuffer = createDepthBuffer(m_width, m_height);
+		return m_pTexture->isLoaded() && (!m_bDepthBuffer || m_depthBuffer);
+	}
+
+	virtual void onLoaded(bool bOk) {
+		if (!m_pPass)
+			return;
+		RenderPass *pPass = m_pPass;
+		pPass->m_pSetupTask = 0;
+		if (!bOk) {
+			Console::error("RenderPass::setupAsync(): failed to create the render targets (%d x %d)\n", m_width, m_height);
+			return;
+		}
+
+		pPass->m_pFrameTexture = m_pTexture;
+		pPass->m_bOwnsTexture = true;
+		pPass->m_FBODepthBuffer = m_depthBuffer;
+		m_pTexture = 0;
+		m_depthBuffer = 0;
+		TextureBudget::inst()->setRenderTarget(pPass->m_pFrameTexture->getGLTex());
+		if (!pPass->attachTargets())
+			pPass->free();
+	}
+};
+
+GLenum RenderPass::textureFormat(PixelFormat pixelFormat)
+{
+	switch (pixelFormat)
+	{
+	case PIXEL_RGBA8: return GL_RGBA8;
+	case PIXEL_RGBA16F: return GL_RGBA16F_ARB;
+	case PIXEL_RGBA32F: return GL_RGBA32F_ARB;
+	default: ASSERT(0);
+	}
+	return GL_RGBA8;
+}
+
+GLuint RenderPass::createDepthBuffer(int frameW, int frameH)
+{
+	GLuint depthBuffer = 0;
+	glGenRenderbuffersEXT(1, &depthBuffer);
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, depthBuffer);
+
+	// assign some storage for the depth buffer
+	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, frameW, frameH);
+	TextureBudget::inst()->addRenderbuffer(depthBuffer, (size_t)frameW*frameH*4);
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, 0);
+	return depthBuffer;
+}
+
 bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture *pTarget, bool bDepthBuffer)
 {
 	ASSERT(!m_bGenMipmaps);	// Not implemented completely. Need to check if the mipmap filters have to
@@ -34,14 +124,7 @@ bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture
 	ASSERT(frameH > 0);
 	
 	// setup a texture format
-	int texFormat = GL_RGBA8;
-	switch (pixelFormat)
-	{
-	case PIXEL_RGBA8: texFormat = GL_RGBA8; break;
-	case PIXEL_RGBA16F: texFormat = GL_RGBA16F_ARB; break;
-	case PIXEL_RGBA32F: texFormat = GL_RGBA32F_ARB; break;
-	default: ASSERT(0);
-	}
+	int texFormat = textureFormat(pixelFormat);
 
 	if (pTarget)
 	{
@@ -60,18 +143,22 @@ bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture
 		m_bOwnsTexture = true;
 	}
 
+	// render targets are accounted separately, and never evicted
+	TextureBudget::inst()->setRenderTarget(m_pFrameTexture->getGLTex());
+
 	m_format = pixelFormat;
 	m_width = frameW;
 	m_height = frameH;
 
 	m_bUsePBuffer = false;
+#ifdef _WIN32
 	if (m_bUsePBuffer)
 	{
 		// Create the pbuffer
 		if (!m_pbuffer.create(frameW, frameH, texFormat))
 		{
-			MessageBox(0, TEXT("Failed to create pbuffer"), TEXT("Error"), MB_OK);
-			exit(-1);
+			Console::error("RenderPass::setup(): failed to create pbuffer\n");
+			return false;
 		}
 
 		// create a texture for the depth buffer
@@ -82,6 +169,7 @@ bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture
 		}
 	}
 	else
+#endif
 	{
 		// Use Frame Buffer Objects
 
@@ -90,36 +178,62 @@ bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture
 //			glGenerateMipmapEXT(GL_TEXTURE_2D);
 //		}
 
-		// create an FBO for rendering
-		//glGenFramebuffersEXT = (PFNGLGENFRAMEBUFFERSEXTPROC)wglGetProcAddress("glGenFramebuffersEXT");
-		glGenFramebuffersEXT(1, &m_FBO);
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_FBO);
+		if (bDepthBuffer)
+			m_FBODepthBuffer = createDepthBuffer(frameW, frameH);
+		return attachTargets();
+	}
 
-		if (bDepthBuffer) {
-			glGenRenderbuffersEXT(1, &m_FBODepthBuffer);
-			glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, m_FBODepthBuffer);
+	return true;
+}
 
-			// assign some storage for the depth buffer
-			glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, frameW, frameH);
+bool RenderPass::setupAsync(PixelFormat pixelFormat, int frameW, int frameH, bool bDepthBuffer)
+{
+	ASSERT(!m_bGenMipmaps);
 
-			// attach the depth buffer to the FBO
-			glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, m_FBODepthBuffer);
-		}
+	free();
 
-		// attach a texture to the FBO for rendering
-		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_pFrameTexture->getGLTex(), 0);
+	ASSERT(frameW > 0);
+	ASSERT(frameH > 0);
 
-		// check if the frame buffer is complete
-		GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
-		if (status != GL_FRAMEBUFFER_COMPLETE_EXT) {
-			// some error occured
-			// TODO: report the error and try to recover
+	m_format = pixelFormat;
+	m_width = frameW;
+	m_height = frameH;
+	m_bUsePBuffer = false;
 
-			// TODO: fallback to a p-buffer
+	// the loader deletes the task, after handing it over (synchronously, without a shared context)
+	m_pSetupTask = new SetupTask(this, textureFormat(pixelFormat), frameW, frameH, bDepthBuffer);
+	SharedContextLoader::inst()->submit(m_pSetupTask);
+	return m_pFrameTexture != 0 || m_pSetupTask != 0;
+}
 
-			// TEMP: report error
-			return false;
-		}
+bool RenderPass::attachTargets()
+{
+	// create an FBO for rendering
+	//glGenFramebuffersEXT = (PFNGLGENFRAMEBUFFERSEXTPROC)wglGetProcAddress("glGenFramebuffersEXT");
+	glGenFramebuffersEXT(1, &m_FBO);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_FBO);
+
+	// attach the depth buffer to the FBO
+	if (m_FBODepthBuffer)
+		glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, m_FBODepthBuffer);
+
+	// attach a texture to the FBO for rendering
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_pFrameTexture->getGLTex(), 0);
+
+	// check if the frame buffer is complete. The pass may be set up in the middle of
+	// a frame, or inside another pass, so the frame buffer that was bound is restored:
+	// beginPass() binds this one.
+	GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+	RenderPass *pCurrent = getCurrentPass();
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, (pCurrent) ? pCurrent->m_FBO : 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE_EXT) {
+		// some error occured
+		// TODO: report the error and try to recover
+
+		// TODO: fallback to a p-buffer
+
+		// TEMP: report error
+		return false;
 	}
 
 	return true;
@@ -127,24 +241,40 @@ bool RenderPass::setup(PixelFormat pixelFormat, int frameW, int frameH, Texture
 
 void RenderPass::free()
 {
+	// a pending setup is dropped when it arrives
+	if (m_pSetupTask) {
+		m_pSetupTask->m_pPass = 0;
+		m_pSetupTask = 0;
+	}
+
+#ifdef _WIN32
 	if (m_bUsePBuffer)
 		m_pbuffer.free();
 	else
+#endif
 	{
 		if (m_FBO)
 			glDeleteFramebuffersEXT(1, &m_FBO);
-		if (m_FBODepthBuffer)
+		if (m_FBODepthBuffer) {
+			TextureBudget::inst()->removeRenderbuffer(m_FBODepthBuffer);
 			glDeleteRenderbuffersEXT(1, &m_FBODepthBuffer);
+		}
+		m_FBO = 0;
+		m_FBODepthBuffer = 0;
 	}
 	if (m_bOwnsTexture && m_pFrameTexture)
 	{
 		SAFE_DELETE(m_pFrameTexture);
 		SAFE_DELETE(m_pDepthTex);
 	}
+	m_pFrameTexture = 0;
+	m_bOwnsTexture = false;
+	m_width = m_height = -1;
 }
 
 void RenderPass::beginPass()
 {
+#ifdef _WIN32
 	if (m_bUsePBuffer)
 	{
 		m_last_hdc = wglGetCurrentDC();
@@ -172,9 +302,11 @@ void RenderPass::beginPass()
 			wglGetLastError();
 	}
 	else
+#endif
 	{
 		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, m_FBO);
 	}
+	m_passStack.push_back(this);
 
 	// setup the viewport
 	glPushAttrib(GL_VIEWPORT_BIT);
@@ -186,6 +318,12 @@ void RenderPass::endPass()
 	// pop the viewport bit from beginPass()
 	glPopAttrib();
 
+	// passes end in the reverse order they began
+	ASSERT(!m_passStack.empty() && m_passStack.back() == this);
+	m_passStack.pop_back();
+	RenderPass *pParent = getCurrentPass();
+
+#ifdef _WIN32
 	if (m_bUsePBuffer)
 	{
 		// make the glut window's rendering context current and draw to the glut window.
@@ -200,13 +338,17 @@ void RenderPass::endPass()
 			wglGetLastError();
 	}
 	else
+#endif
 	{
-		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+		// back to the enclosing pass, or to the window
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, (pParent) ? pParent->m_FBO : 0);
 	}
 }
 
+#ifdef _WIN32
 void RenderPass::makePBufferCurrent()
 {
 	ASSERT(m_bUsePBuffer);
 	m_pbuffer.makeCurrent();
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
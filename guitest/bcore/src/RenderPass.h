@@ -25,9 +25,17 @@
 #pragma once
 
 #include "common.h"
-#include "PBuffer.h"
+#ifdef _WIN32
+	#include "PBuffer.h"
+#endif
 #include "Texture.h"
 
+/**
+ * RenderPass: renders to a texture, through a frame buffer object. Passes nest: a
+ *		pass can begin while another one is active, and when it ends, rendering goes
+ *		back to the enclosing pass (or to the window). Transient passes should come
+ *		from the RenderTargetPool rather than be created for each use.
+ */
 class RenderPass
 {
 public:
@@ -39,6 +47,9 @@ public:
 	};
 
 private:
+	class SetupTask;
+	friend class SetupTask;
+
 	Texture		*m_pFrameTexture;
 	Texture		*m_pDepthTex;
 	bool		m_bOwnsTexture;
@@ -51,10 +62,15 @@ private:
 	
 	GLuint		m_FBO;			// frame buffer object for rendering
 	GLuint		m_FBODepthBuffer;
+	SetupTask	*m_pSetupTask;	// of setupAsync(..), until the targets are attached
+
+	static std::vector<RenderPass*>	m_passStack;	// the active passes, innermost last
 
+#ifdef _WIN32
 	PBuffer		m_pbuffer;	// pbuffer for rendering
 	HDC			m_last_hdc;
 	HGLRC		m_last_hglrc;
+#endif
 
 public:
 	RenderPass();
@@ -62,10 +78,21 @@ public:
 
 	void setMipmapAutoGen(bool bGenMipmaps)		{ m_bGenMipmaps; }	// should be called BEFORE creating the renderpass!!!
 	bool setup(PixelFormat pixelFormat, int frameW, int frameH, Texture *pTarget = 0, bool bDepthBuffer=false);
+
+	// set up the pass without waiting for its targets: the texture and the depth buffer are
+	// created by the SharedContextLoader, and attached on a later update() of the loader.
+	// The size and format are set right away, but the pass can only be used when isReady().
+	bool setupAsync(PixelFormat pixelFormat, int frameW, int frameH, bool bDepthBuffer=false);
+	bool isReady() const	{ return m_pFrameTexture != 0 && m_pSetupTask == 0; }
+
 	void free();
 	void beginPass();
 	void endPass();
 	
+	// the innermost active pass, 0 when rendering to the window
+	static RenderPass*	getCurrentPass()	{ return (m_passStack.empty()) ? 0 : m_passStack.back(); }
+	static size_t		getPassDepth()		{ return m_passStack.size(); }
+
 	Texture*	getFrameData()			{ return m_pFrameTexture; }
 	Texture*	getDepthData()			{ return m_pDepthTex; }
 	PixelFormat	getPixelFormat() const	{ return m_format; }
@@ -75,7 +102,13 @@ public:
 	bool		isUsingPBuffer() const		{ return m_bUsePBuffer; }
 
 private:
+	static GLenum	textureFormat(PixelFormat pixelFormat);
+	static GLuint	createDepthBuffer(int frameW, int frameH);
+	bool			attachTargets();	// creates the FBO for the frame texture and depth buffer
+
+#ifdef _WIN32
 	void makePBufferCurrent();
+#endif
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "RenderTargetPool.h"
+#include "TextureBudget.h"
+
+RenderTargetPool *RenderTargetPool::m_pInst = 0;
+
+RenderTargetPool::RenderTargetPool() : m_frame(0),
+	m_maxIdleFrames(60)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+RenderTargetPool::~RenderTargetPool()
+{
+	for (size_t i=0; i<m_targets.size(); ++i)
+		SAFE_DELETE(m_targets[i].pPass);
+}
+
+int RenderTargetPool::bucketSize(int size)
+{
+	int step = 64;
+	while (step*8 < size)
+		step *= 2;
+	return (size + step-1) / step * step;
+}
+
+bool RenderTargetPool::fits(const RenderPass *pPass, int w, int h)
+{
+	if (!pPass || pPass->getWidth() < w || pPass->getHeight() < h)
+		return false;
+	return (size_t)pPass->getWidth()*pPass->getHeight() <= 2*(size_t)bucketSize(w)*bucketSize(h);
+}
+
+size_t RenderTargetPool::bytesOf(const Target &target)
+{
+	GLenum format = GL_RGBA8;
+	switch (target.format) {
+		case RenderPass::PIXEL_RGBA16F:	format = GL_RGBA16F_ARB; break;
+		case RenderPass::PIXEL_RGBA32F:	format = GL_RGBA32F_ARB; break;
+		default: break;
+	}
+	size_t texels = (size_t)target.width*target.height;
+	return texels*TextureBudget::texelSize(format) + ((target.bDepthBuffer) ? texels*4 : 0);
+}
+
+RenderPass* RenderTargetPool::acquire(int w, int h, RenderPass::PixelFormat format, bool bDepthBuffer, bool bAsync)
+{
+	ASSERT(w > 0 && h > 0);
+	int bw = bucketSize(w);
+	int bh = bucketSize(h);
+
+	// the smallest idle target that fits, unless it is more than twice the size needed
+	int best = -1;
+	size_t bestArea = 2*(size_t)bw*bh + 1;
+	for (size_t i=0; i<m_targets.size(); ++i)
+	{
+		const Target &t = m_targets[i];
+		if (t.bInUse || t.format != format || t.bDepthBuffer != bDepthBuffer)
+			continue;
+		if (t.width < bw || t.height < bh)
+			continue;
+		size_t area = (size_t)t.width*t.height;
+		if (area < bestArea) {
+			best = (int)i;
+			bestArea = area;
+		}
+	}
+	if (best >= 0) {
+		Target &t = m_targets[best];
+		t.bInUse = true;
+		t.lastUse = m_frame;
+		m_stats.inUseNum++;
+		m_stats.reused++;
+		return t.pPass;
+	}
+
+	// set up a new one
+	Target t;
+	t.pPass = new RenderPass();
+	t.width = bw;
+	t.height = bh;
+	t.format = format;
+	t.bDepthBuffer = bDepthBuffer;
+	t.bInUse = true;
+	t.lastUse = m_frame;
+	bool bOk = (bAsync) ? t.pPass->setupAsync(format, bw, bh, bDepthBuffer) :
+						  t.pPass->setup(format, bw, bh, 0, bDepthBuffer);
+	if (!bOk) {
+		Console::error("RenderTargetPool: failed to create a render target (%d x %d)\n", bw, bh);
+		delete t.pPass;
+		return 0;
+	}
+	m_targets.push_back(t);
+	m_stats.targetsNum++;
+	m_stats.inUseNum++;
+	m_stats.created++;
+	m_stats.bytes += bytesOf(t);
+	return t.pPass;
+}
+
+void RenderTargetPool::release(RenderPass *pPass)
+{
+	if (!pPass)
+		return;
+	for (size_t i=0; i<m_targets.size(); ++i)
+	{
+		Target &t = m_targets[i];
+		if (t.pPass != pPass)
+			continue;
+		ASSERT(t.bInUse);
+		t.bInUse = false;
+		t.lastUse = m_frame;
+		m_stats.inUseNum--;
+		return;
+	}
+	ASSERT(0);	// not from this pool
+}
+
+void RenderTargetPool::free(size_t i)
+{
+	ASSERT(!m_targets[i].bInUse);
+	m_stats.bytes -= bytesOf(m_targets[i]);
+	m_stats.targetsNum--;
+	delete m_targets[i].pPass;
+	m_targets[i] = m_targets.back();
+	m_targets.pop_back();
+}
+
+void RenderTargetPool::nextFrame()
+{
+	m_frame++;
+	for (size_t i=0; i<m_targets.size(); )
+	{
+		const Target &t = m_targets[i];
+		if (!t.bInUse && m_frame - t.lastUse > m_maxIdleFrames)
+			free(i);
+		else
+			++i;
+	}
+}
+
+void RenderTargetPool::clear()
+{
+	for (size_t i=0; i<m_targets.size(); )
+	{
+		if (!m_targets[i].bInUse)
+			free(i);
+		else
+			++i;
+	}
+}
+
+void RenderTargetPool::printStats() const
+{
+	Console::print("render targets: %d (%d in use), %d KB; %d created, %d reused\n",
+		(int)m_stats.targetsNum, (int)m_stats.inUseNum, (int)(m_stats.bytes/1024),
+		(int)m_stats.created, (int)m_stats.reused);
+}
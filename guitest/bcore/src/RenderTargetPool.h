@@ -0,0 +1,107 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RENDERTARGETPOOL_H45631_INCLUDED_
+#define _RENDERTARGETPOOL_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "RenderPass.h"
+
+/**
+ * RenderTargetPool: hands out render passes for offscreen rendering, and reuses them
+ *		across frames instead of creating a target for every use.
+ *
+ *		Sizes are rounded up to buckets (see bucketSize), so the pass that acquire(..)
+ *		returns is at least as large as requested; only the requested area should be
+ *		rendered to and sampled. A released pass goes back to the pool and can be
+ *		acquired again in the same frame, by anyone who asks for the same bucket (or a
+ *		slightly smaller one). Targets that nobody acquired for getMaxIdleFrames() frames
+ *		are freed in nextFrame().
+ *
+ *		So transient users (fe. windows that render their contents to a texture and
+ *		draw it right away) share a few targets, sized to what they render rather than
+ *		to the display.
+ */
+class RenderTargetPool
+{
+public:
+	struct Stats {
+		size_t	targetsNum;
+		size_t	inUseNum;
+		size_t	bytes;			// of all pooled targets, in use or idle
+		size_t	created;		// since the start
+		size_t	reused;
+	};
+
+private:
+	struct Target {
+		RenderPass	*pPass;
+		int			width, height;	// the bucket
+		RenderPass::PixelFormat	format;
+		bool		bDepthBuffer;
+		bool		bInUse;
+		size_t		lastUse;	// frame
+	};
+
+	std::vector<Target>	m_targets;
+	size_t				m_frame;
+	size_t				m_maxIdleFrames;
+	Stats				m_stats;
+
+	static RenderTargetPool	*m_pInst;
+
+public:
+	RenderTargetPool();
+	virtual ~RenderTargetPool();
+
+	static RenderTargetPool* inst()	{ if (!m_pInst) m_pInst = new RenderTargetPool(); return m_pInst; }
+
+	// a pass of at least w x h. A new pass is set up with RenderPass::setupAsync if
+	// bAsync is set, so it may not be ready yet (see RenderPass::isReady).
+	RenderPass*	acquire(int w, int h, RenderPass::PixelFormat format = RenderPass::PIXEL_RGBA8,
+						bool bDepthBuffer = false, bool bAsync = false);
+	void		release(RenderPass *pPass);
+
+	// called once per frame. Frees the targets that have been idle for too long.
+	void	nextFrame();
+	void	clear();	// free all idle targets
+
+	void	setMaxIdleFrames(size_t n)	{ m_maxIdleFrames = n; }
+	size_t	getMaxIdleFrames() const	{ return m_maxIdleFrames; }
+	const Stats&	getStats() const	{ return m_stats; }
+	void	printStats() const;
+
+	// the size that a dimension is rounded up to: a multiple of 64 for small sizes, and
+	// of 1/8 of the enclosing power of 2 for larger ones (so at most 1/8 is wasted)
+	static int	bucketSize(int size);
+
+	// whether a pass from the pool can be used for w x h: it is large enough, and at most
+	// twice the size of the bucket (which is what acquire(..) reuses)
+	static bool	fits(const RenderPass *pPass, int w, int h);
+
+private:
+	void	free(size_t i);
+	static size_t	bytesOf(const Target &target);	// of the texture and the depth buffer
+};
+
+#endif
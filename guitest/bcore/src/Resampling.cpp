@@ -20,6 +20,7 @@
 */
 
 #include "Image.h"
+#include "MipChain.h"
 
 double Image::m_filterLUT[FILTERS_NUM][LUT_SAMPLES];
 bool g_bImageLUTInited = false;
@@ -131,6 +132,7 @@ void Image::resize(double scale, Filter filter, double filter_stretch)
 	m_data = data;
 	m_width = w;
 	m_height = h;
+	markAllDirty();
 }
 
 void Image::resize(size_t w, size_t h, Filter filter, double filter_stretch)
@@ -170,4 +172,19 @@ void Image::resize(size_t w, size_t h, Filter filter, double filter_stretch)
 	m_data = data;
 	m_width = w;
 	m_height = h;
-}
\ No newline at end of file
+	markAllDirty();
+}
+void Image::downsample2x(Image &out, bool bSRGB) const
+{
+	ASSERT(&out != this);
+	if (m_width==0 || m_height==0) {
+		out.clear();
+		return;
+	}
+
+	out.create((m_width+1)/2, (m_height+1)/2, (unsigned char)m_nChannels, m_format);
+	if (!MipChain::downsample(*this, out, bSRGB)) {
+		Console::error("Image::downsample2x(): image format not supported (%d)\n", m_format);
+		out.clear();
+	}
+}
@@ -0,0 +1,194 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SharedContextLoader.h"
+#include "TextureBudget.h"
+#include "Profiler.h"
+
+SharedContextLoader *SharedContextLoader::m_pInst = 0;
+
+SharedContextLoader::SharedContextLoader() : m_pContext(0),
+	m_bStop(false),
+	m_bRunning(false),
+	m_nInFlight(0)
+{
+}
+
+SharedContextLoader::~SharedContextLoader()
+{
+	shutdown();
+}
+
+SharedContextLoader* SharedContextLoader::inst()
+{
+	if (!m_pInst)
+		m_pInst = new SharedContextLoader();
+	return m_pInst;
+}
+
+bool SharedContextLoader::initialize(Context *pContext)
+{
+	shutdown();
+	if (!pContext)
+		return false;
+
+	// the texture budget belongs to the thread that creates it: make sure it is this one
+	TextureBudget::inst();
+
+	// start the thread, and wait until it knows whether it can use the context
+	m_pContext = pContext;
+	m_bStop = false;
+	start();
+	m_doneEvent.wait();
+	if (!m_bRunning) {
+		join();
+		SAFE_DELETE(m_pContext);
+		Console::print("SharedContextLoader: the shared context cannot be made current, loading synchronously\n");
+		return false;
+	}
+	return true;
+}
+
+void SharedContextLoader::shutdown()
+{
+	if (!m_bRunning)
+		return;
+
+	finish();
+	m_bStop = true;
+	m_queueSem.post();
+	join();
+	m_bRunning = false;
+	SAFE_DELETE(m_pContext);
+}
+
+void SharedContextLoader::submit(Task *pTask)
+{
+	ASSERT(pTask);
+	if (!m_bRunning) {
+		bool bOk = pTask->load();
+		pTask->onLoaded(bOk);
+		delete pTask;
+		return;
+	}
+
+	m_nInFlight++;
+	{
+		ScopedLock lock(m_queueLock);
+		m_queue.push_back(pTask);
+	}
+	m_queueSem.post();
+}
+
+void SharedContextLoader::run()
+{
+	m_bRunning = m_pContext->makeCurrent();
+	m_doneEvent.set();
+	if (!m_bRunning)
+		return;
+
+	while (true)
+	{
+		m_queueSem.wait();
+		Task *pTask = 0;
+		{
+			ScopedLock lock(m_queueLock);
+			if (!m_queue.empty()) {
+				pTask = m_queue.front();
+				m_queue.pop_front();
+			}
+		}
+		if (!pTask) {
+			if (m_bStop)
+				break;
+			continue;
+		}
+
+		Done done;
+		done.pTask = pTask;
+		done.fence = 0;
+		done.bOk = pTask->load();
+
+		// the GL thread may use the objects once the commands that created them have
+		// completed. The flush makes sure that the fence gets to the gpu at all.
+		if (GLEW_ARB_sync) {
+			done.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+		}
+		else
+			glFinish();
+
+		{
+			ScopedLock lock(m_doneLock);
+			m_done.push_back(done);
+		}
+		m_doneEvent.set();
+	}
+
+	m_pContext->doneCurrent();
+}
+
+bool SharedContextLoader::deliver(bool bWait)
+{
+	Done done;
+	{
+		ScopedLock lock(m_doneLock);
+		if (m_done.empty())
+			return false;
+		done = m_done.front();
+	}
+
+	if (done.fence) {
+		GLenum res = glClientWaitSync(done.fence, 0, (bWait) ? (GLuint64)1000000000 : 0);	// nsec
+		if (res == GL_TIMEOUT_EXPIRED)
+			return false;
+		glDeleteSync(done.fence);
+	}
+	{
+		ScopedLock lock(m_doneLock);
+		m_done.pop_front();
+	}
+
+	// account for the objects of the task before handing them over
+	TextureBudget::inst()->flushPending();
+	done.pTask->onLoaded(done.bOk);
+	delete done.pTask;
+	ASSERT(m_nInFlight > 0);
+	m_nInFlight--;
+	return true;
+}
+
+void SharedContextLoader::update()
+{
+	if (m_nInFlight == 0)
+		return;
+	PROFILE_ZONE("SharedContextLoader::update");
+	while (deliver(false))
+		;
+}
+
+void SharedContextLoader::finish()
+{
+	while (m_nInFlight > 0) {
+		if (!deliver(true))
+			m_doneEvent.wait(10);
+	}
+}
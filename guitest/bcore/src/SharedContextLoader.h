@@ -0,0 +1,119 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SHAREDCONTEXTLOADER_H45631_INCLUDED_
+#define _SHAREDCONTEXTLOADER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Thread.h"
+
+/**
+ * SharedContextLoader: creates GL objects (textures, render buffers) on a thread of
+ *		its own, with a GL context that shares its objects with the rendering context,
+ *		so that the GL thread does not block on their creation and upload.
+ *
+ *		Work is submitted as Tasks. load() runs on the loader thread, with the shared
+ *		context current. The loader then puts a fence after the commands of the task
+ *		(a glFinish where ARB_sync is not supported), and update(), which should be
+ *		called once per frame from the GL thread, hands over the tasks whose fences
+ *		have signaled to onLoaded(), in the order they were submitted.
+ *
+ *		Only objects that hold data are shared between contexts: framebuffer objects
+ *		are not, so tasks create the textures and render buffers, and onLoaded()
+ *		attaches them to FBOs on the GL thread (see RenderPass::setupAsync).
+ *
+ *		The shared context is created by the frame window (FrameWindow::createSharedContext).
+ *		Without one, the loader is synchronous: submit(..) runs both steps of the task
+ *		right away, on the calling thread.
+ */
+class SharedContextLoader : private Thread
+{
+public:
+	/**
+	 * Context: a GL context that shares its objects with the rendering context, and
+	 *		can be made current on the loader thread.
+	 */
+	class Context {
+	public:
+		virtual ~Context() { }
+		virtual bool makeCurrent() = 0;
+		virtual void doneCurrent() = 0;
+	};
+
+	/**
+	 * Task: a piece of loading work. The loader owns the task once it is submitted,
+	 *		and deletes it after onLoaded(), from the GL thread.
+	 */
+	class Task {
+	public:
+		virtual ~Task() { }
+		virtual bool load() = 0;			// on the loader thread: create and upload the objects
+		virtual void onLoaded(bool bOk) { }	// on the GL thread: the objects can be used now
+	};
+
+private:
+	struct Done {
+		Task	*pTask;
+		GLsync	fence;
+		bool	bOk;
+	};
+
+	Context			*m_pContext;
+	std::list<Task*>	m_queue;		// submitted, not loaded yet
+	Mutex			m_queueLock;
+	Semaphore		m_queueSem;
+	std::list<Done>	m_done;			// loaded, waiting for the GL thread
+	Mutex			m_doneLock;
+	Event			m_doneEvent;	// set when a task is done (and when the thread has started)
+	volatile bool	m_bStop;
+	volatile bool	m_bRunning;		// the loader thread has its context current
+	size_t			m_nInFlight;	// submitted and not handed over yet (GL thread only)
+
+	static SharedContextLoader	*m_pInst;
+
+public:
+	SharedContextLoader();
+	virtual ~SharedContextLoader();
+
+	static SharedContextLoader* inst();
+
+	// start the loader thread with a shared context (owned by the loader from now on).
+	// Call from the GL thread. Returns false, and stays synchronous, if pContext is 0 or
+	// cannot be made current on the loader thread.
+	bool	initialize(Context *pContext);
+	void	shutdown();		// finish all submitted tasks and stop the thread
+	bool	isAsync() const		{ return m_bRunning; }
+
+	void	submit(Task *pTask);
+
+	// hand the loaded tasks over to onLoaded(). Call once per frame, from the GL thread.
+	void	update();
+	void	finish();		// block until all submitted tasks are handed over
+	size_t	getQueuedNum() const	{ return m_nInFlight; }
+
+private:
+	virtual void run();
+	bool	deliver(bool bWait);	// hand over the front task, if it is done. Returns false if none was.
+};
+
+#endif
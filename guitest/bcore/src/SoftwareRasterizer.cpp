@@ -0,0 +1,394 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+#include <emmintrin.h>
+
+namespace {
+
+const float INV_255 = 1.0f/255.0f;
+
+__forceinline __m128 loadRGBA8(const unsigned char *p)
+{
+	__m128i zero = _mm_setzero_si128();
+	__m128i px = _mm_cvtsi32_si128(*(const int*)p);
+	px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(px, zero), zero);
+	return _mm_mul_ps(_mm_cvtepi32_ps(px), _mm_set1_ps(INV_255));
+}
+
+__forceinline void storeRGBA8(unsigned char *p, __m128 c)
+{
+	__m128i px = _mm_cvtps_epi32(_mm_mul_ps(c, _mm_set1_ps(255.0f)));
+	px = _mm_packs_epi32(px, px);
+	px = _mm_packus_epi16(px, px);		// saturates to [0,255]
+	*(int*)p = _mm_cvtsi128_si32(px);
+}
+
+__forceinline __m128 fetchTexel(const Image &tex, int x, int y)
+{
+	const unsigned char *p = tex(x, y);
+	switch (tex.getChannelsNum()) {
+		case 4:		return loadRGBA8(p);
+		case 3:		return _mm_setr_ps(p[0]*INV_255, p[1]*INV_255, p[2]*INV_255, 1.0f);
+		default:	return _mm_setr_ps(p[0]*INV_255, p[0]*INV_255, p[0]*INV_255, 1.0f);
+	}
+}
+
+// bilinear sample, clamped to the edges
+__m128 sampleBilinear(const Image &tex, float u, float v)
+{
+	int w = (int)tex.getWidth();
+	int h = (int)tex.getHeight();
+	float x = u*w - 0.5f;
+	float y = v*h - 0.5f;
+	int x0 = (int)floor(x);
+	int y0 = (int)floor(y);
+	__m128 fx = _mm_set1_ps(x - x0);
+	__m128 fy = _mm_set1_ps(y - y0);
+	int x1 = x0+1, y1 = y0+1;
+	if (x0 < 0) x0 = 0; else if (x0 >= w) x0 = w-1;
+	if (x1 < 0) x1 = 0; else if (x1 >= w) x1 = w-1;
+	if (y0 < 0) y0 = 0; else if (y0 >= h) y0 = h-1;
+	if (y1 < 0) y1 = 0; else if (y1 >= h) y1 = h-1;
+
+	__m128 t00 = fetchTexel(tex, x0, y0), t10 = fetchTexel(tex, x1, y0);
+	__m128 t01 = fetchTexel(tex, x0, y1), t11 = fetchTexel(tex, x1, y1);
+	__m128 top = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), fx));
+	__m128 bot = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), fx));
+	return _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bot, top), fy));
+}
+
+// tie-breaking rule for pixels exactly on an edge: of two triangles sharing
+// an edge (traversed in opposite directions), only one includes the pixel
+__forceinline float edgeBias(float dx, float dy)
+{
+	return (dy > 0 || (dy == 0 && dx < 0)) ? 0.0f : -1e-7f;
+}
+
+};
+
+class SoftwareRasterizer::TileJob : public ThreadPool::RangeJob
+{
+	SoftwareRasterizer	*m_pRast;
+public:
+	TileJob(SoftwareRasterizer *pRast) : m_pRast(pRast) { }
+	virtual void processRange(size_t begin, size_t end) {
+		for (size_t i=begin; i<end; ++i)
+			m_pRast->rasterizeTile((int)i);
+	}
+};
+
+SoftwareRasterizer::SoftwareRasterizer() : m_pTarget(0), m_tileSize(64), m_tilesX(0), m_tilesY(0),
+	m_bStateChanged(true), m_bScissor(false), m_scissor(0,0,0,0)
+{
+	m_curState.pTexture = 0;
+	m_curState.bBlend = false;
+	m_curState.scissor = Rect<int>(0,0,0,0);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+void SoftwareRasterizer::setTarget(Image *pTarget)
+{
+	if (pTarget && (pTarget->getFormat() != Image::I8BITS || pTarget->getChannelsNum() != 4)) {
+		Console::error("SoftwareRasterizer::setTarget(): target must be an 8 bit RGBA image\n");
+		pTarget = 0;
+	}
+
+	flush();
+	m_pTarget = pTarget;
+	setTileSize(m_tileSize);
+	m_bStateChanged = true;
+}
+
+void SoftwareRasterizer::setTileSize(int size)
+{
+	ASSERT(size > 0);
+	flush();
+	m_tileSize = size;
+	m_tilesX = m_tilesY = 0;
+	if (m_pTarget) {
+		m_tilesX = ((int)m_pTarget->getWidth() + m_tileSize-1) / m_tileSize;
+		m_tilesY = ((int)m_pTarget->getHeight() + m_tileSize-1) / m_tileSize;
+	}
+	m_bins.resize(m_tilesX*m_tilesY);
+}
+
+void SoftwareRasterizer::setTexture(const Image *pTexture)
+{
+	if (pTexture && (pTexture->getFormat() != Image::I8BITS || pTexture->isEmpty() ||
+		(pTexture->getChannelsNum() != 1 && pTexture->getChannelsNum() != 3 && pTexture->getChannelsNum() != 4)))
+	{
+		Console::error("SoftwareRasterizer::setTexture(): texture format not supported\n");
+		pTexture = 0;
+	}
+	if (pTexture != m_curState.pTexture) {
+		m_curState.pTexture = pTexture;
+		m_bStateChanged = true;
+	}
+}
+
+void SoftwareRasterizer::setBlending(bool bBlend)
+{
+	if (bBlend != m_curState.bBlend) {
+		m_curState.bBlend = bBlend;
+		m_bStateChanged = true;
+	}
+}
+
+void SoftwareRasterizer::setScissor(int left, int top, int right, int bottom)
+{
+	m_bScissor = true;
+	m_scissor = Rect<int>(left, top, right, bottom);
+	m_bStateChanged = true;
+}
+
+void SoftwareRasterizer::disableScissor()
+{
+	if (m_bScissor) {
+		m_bScissor = false;
+		m_bStateChanged = true;
+	}
+}
+
+void SoftwareRasterizer::updateState()
+{
+	if (!m_bStateChanged)
+		return;
+
+	// clip the scissor rect to the target once, here
+	Rect<int> r(0, 0, (int)m_pTarget->getWidth(), (int)m_pTarget->getHeight());
+	if (m_bScissor) {
+		if (m_scissor.left > r.left) r.left = m_scissor.left;
+		if (m_scissor.top > r.top) r.top = m_scissor.top;
+		if (m_scissor.right < r.right) r.right = m_scissor.right;
+		if (m_scissor.bottom < r.bottom) r.bottom = m_scissor.bottom;
+	}
+	m_curState.scissor = r;
+	m_states.push_back(m_curState);
+	m_bStateChanged = false;
+}
+
+void SoftwareRasterizer::clear(float r, float g, float b, float a)
+{
+	if (!m_pTarget)
+		return;
+	flush();
+
+	// like glClear, clearing is limited by the scissor rectangle
+	m_bStateChanged = true;
+	updateState();
+	Rect<int> rc = m_states.back().scissor;
+	m_states.clear();
+	m_bStateChanged = true;
+
+	unsigned char px[4];
+	storeRGBA8(px, _mm_setr_ps(r, g, b, a));
+	for (int y=rc.top; y<rc.bottom; ++y) {
+		unsigned char *dst = (*m_pTarget)(rc.left, y);
+		for (int x=rc.left; x<rc.right; ++x, dst+=4)
+			*(unsigned int*)dst = *(unsigned int*)px;
+	}
+}
+
+void SoftwareRasterizer::drawTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2)
+{
+	if (!m_pTarget)
+		return;
+	updateState();
+	const Rect<int> &clip = m_states.back().scissor;
+
+	// bounding box, clipped
+	float minX = v0.x, maxX = v0.x, minY = v0.y, maxY = v0.y;
+	if (v1.x < minX) minX = v1.x;
+	if (v1.x > maxX) maxX = v1.x;
+	if (v2.x < minX) minX = v2.x;
+	if (v2.x > maxX) maxX = v2.x;
+	if (v1.y < minY) minY = v1.y;
+	if (v1.y > maxY) maxY = v1.y;
+	if (v2.y < minY) minY = v2.y;
+	if (v2.y > maxY) maxY = v2.y;
+	int x0 = (int)floor(minX), x1 = (int)ceil(maxX);
+	int y0 = (int)floor(minY), y1 = (int)ceil(maxY);
+	if (x0 < clip.left) x0 = clip.left;
+	if (y0 < clip.top) y0 = clip.top;
+	if (x1 > clip.right) x1 = clip.right;
+	if (y1 > clip.bottom) y1 = clip.bottom;
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	Triangle tri;
+	tri.v[0] = v0;
+	tri.v[1] = v1;
+	tri.v[2] = v2;
+	tri.state = m_states.size()-1;
+	unsigned int id = (unsigned int)m_triangles.size();
+	m_triangles.push_back(tri);
+
+	// bin it to the tiles overlapped by its bounding box
+	for (int ty=y0/m_tileSize; ty<=(y1-1)/m_tileSize; ++ty)
+		for (int tx=x0/m_tileSize; tx<=(x1-1)/m_tileSize; ++tx)
+			m_bins[ty*m_tilesX + tx].push_back(id);
+}
+
+void SoftwareRasterizer::drawQuad(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3)
+{
+	drawTriangle(v0, v1, v2);
+	drawTriangle(v0, v2, v3);
+}
+
+void SoftwareRasterizer::drawLine(const Vertex &v0, const Vertex &v1, float width)
+{
+	// a line is a thin quad around the segment. The half pixel offset across
+	// the minor axis makes lines on integer coordinates cover the row/column
+	// they are on; along the major axis the last pixel is left out, as in GL.
+	float dx = v1.x - v0.x, dy = v1.y - v0.y;
+	float len = sqrt(dx*dx + dy*dy);
+	if (len == 0)
+		return;
+	float nx = -dy/len * width*0.5f, ny = dx/len * width*0.5f;
+	float ox = (fabs(dx) < fabs(dy)) ? 0.5f : 0;
+	float oy = (fabs(dx) < fabs(dy)) ? 0 : 0.5f;
+
+	Vertex a = v0, b = v1, c = v1, d = v0;
+	a.x += ox + nx; a.y += oy + ny;
+	b.x += ox + nx; b.y += oy + ny;
+	c.x += ox - nx; c.y += oy - ny;
+	d.x += ox - nx; d.y += oy - ny;
+	drawQuad(a, b, c, d);
+}
+
+void SoftwareRasterizer::flush()
+{
+	if (m_triangles.empty())
+		return;
+
+	TileJob job(this);
+	ThreadPool::inst()->parallelFor(job, 0, m_bins.size(), 1);
+
+	m_triangles.clear();
+	m_states.clear();
+	for (size_t i=0; i<m_bins.size(); ++i)
+		m_bins[i].clear();
+	m_bStateChanged = true;
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile)
+{
+	const std::vector<unsigned int> &bin = m_bins[tile];
+	if (bin.empty())
+		return;
+
+	int tx = tile % m_tilesX, ty = tile / m_tilesX;
+	Rect<int> tileRect(tx*m_tileSize, ty*m_tileSize, (tx+1)*m_tileSize, (ty+1)*m_tileSize);
+
+	for (size_t i=0; i<bin.size(); ++i)
+	{
+		const Triangle &tri = m_triangles[bin[i]];
+		const Rect<int> &sc = m_states[tri.state].scissor;
+		Rect<int> clip(	(tileRect.left > sc.left) ? tileRect.left : sc.left,
+						(tileRect.top > sc.top) ? tileRect.top : sc.top,
+						(tileRect.right < sc.right) ? tileRect.right : sc.right,
+						(tileRect.bottom < sc.bottom) ? tileRect.bottom : sc.bottom);
+		if (clip.left < clip.right && clip.top < clip.bottom)
+			rasterizeTriangle(tri, clip);
+	}
+}
+
+void SoftwareRasterizer::rasterizeTriangle(const Triangle &tri, const Rect<int> &clip)
+{
+	const State &state = m_states[tri.state];
+
+	// make the winding consistent, so that inside means all edge functions positive
+	const Vertex *p0 = &tri.v[0], *p1 = &tri.v[1], *p2 = &tri.v[2];
+	float area = (p1->x - p0->x)*(p2->y - p0->y) - (p1->y - p0->y)*(p2->x - p0->x);
+	if (area == 0)
+		return;
+	if (area < 0) {
+		const Vertex *t = p1; p1 = p2; p2 = t;
+		area = -area;
+	}
+	float invArea = 1.0f/area;
+
+	// edge functions E_ij(x,y) = (pj-pi) x (p-pi); the weight of a vertex is
+	// the edge function of the opposite edge
+	float dx01 = p1->x - p0->x, dy01 = p1->y - p0->y;
+	float dx12 = p2->x - p1->x, dy12 = p2->y - p1->y;
+	float dx20 = p0->x - p2->x, dy20 = p0->y - p2->y;
+	float bias01 = edgeBias(dx01, dy01), bias12 = edgeBias(dx12, dy12), bias20 = edgeBias(dx20, dy20);
+
+	// bounding box within the clip rect
+	float fminX = p0->x, fmaxX = p0->x, fminY = p0->y, fmaxY = p0->y;
+	if (p1->x < fminX) fminX = p1->x;
+	if (p1->x > fmaxX) fmaxX = p1->x;
+	if (p2->x < fminX) fminX = p2->x;
+	if (p2->x > fmaxX) fmaxX = p2->x;
+	if (p1->y < fminY) fminY = p1->y;
+	if (p1->y > fmaxY) fmaxY = p1->y;
+	if (p2->y < fminY) fminY = p2->y;
+	if (p2->y > fmaxY) fmaxY = p2->y;
+	int minX = (int)floor(fminX), maxX = (int)ceil(fmaxX);
+	int minY = (int)floor(fminY), maxY = (int)ceil(fmaxY);
+	if (minX < clip.left) minX = clip.left;
+	if (minY < clip.top) minY = clip.top;
+	if (maxX > clip.right) maxX = clip.right;
+	if (maxY > clip.bottom) maxY = clip.bottom;
+
+	__m128 c0 = _mm_setr_ps(p0->r, p0->g, p0->b, p0->a);
+	__m128 c1 = _mm_setr_ps(p1->r, p1->g, p1->b, p1->a);
+	__m128 c2 = _mm_setr_ps(p2->r, p2->g, p2->b, p2->a);
+	__m128 one = _mm_set1_ps(1.0f);
+	const Image *pTex = state.pTexture;
+
+	for (int y=minY; y<maxY; ++y)
+	{
+		float py = y + 0.5f;
+		float px = minX + 0.5f;
+		float e01 = dx01*(py - p0->y) - dy01*(px - p0->x);
+		float e12 = dx12*(py - p1->y) - dy12*(px - p1->x);
+		float e20 = dx20*(py - p2->y) - dy20*(px - p2->x);
+		unsigned char *dst = (*m_pTarget)(minX, y);
+
+		for (int x=minX; x<maxX; ++x, dst+=4, e01-=dy01, e12-=dy12, e20-=dy20)
+		{
+			if (e01 + bias01 < 0 || e12 + bias12 < 0 || e20 + bias20 < 0)
+				continue;
+
+			float w0 = e12*invArea, w1 = e20*invArea, w2 = e01*invArea;
+			__m128 col = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(w0)),
+									_mm_mul_ps(c1, _mm_set1_ps(w1))), _mm_mul_ps(c2, _mm_set1_ps(w2)));
+			if (pTex) {
+				float u = p0->u*w0 + p1->u*w1 + p2->u*w2;
+				float v = p0->v*w0 + p1->v*w1 + p2->v*w2;
+				col = _mm_mul_ps(col, sampleBilinear(*pTex, u, v));
+			}
+			if (state.bBlend) {
+				__m128 alpha = _mm_shuffle_ps(col, col, _MM_SHUFFLE(3,3,3,3));
+				__m128 d = loadRGBA8(dst);
+				col = _mm_add_ps(_mm_mul_ps(col, alpha), _mm_mul_ps(d, _mm_sub_ps(one, alpha)));
+			}
+			storeRGBA8(dst, col);
+		}
+	}
+}
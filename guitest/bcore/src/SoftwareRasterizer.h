@@ -0,0 +1,116 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SOFTWARERASTERIZER_H45631_INCLUDED_
+#define _SOFTWARERASTERIZER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Image.h"
+#include "Rect.h"
+
+/**
+ * SoftwareRasterizer: renders 2D textured, colored and alpha blended triangles
+ *		into an RGBA 8-bit Image, without any GPU. Meant for headless rendering,
+ *		golden-image tests and benchmarks.
+ *
+ *		Triangles are queued with the current state (texture, blending, scissor)
+ *		and rendered by flush(): the target is split in square tiles, each
+ *		triangle is binned to the tiles its bounding box overlaps, and the tiles
+ *		are rasterized in parallel on the ThreadPool. Each tile draws its
+ *		triangles in submission order, so the result does not depend on the
+ *		number of threads. Shading and blending use SSE2.
+ *
+ *		Coordinates are in pixels, with the origin at the top-left corner of the
+ *		target and pixel centers at +0.5. Texture coordinates follow OpenGL:
+ *		(0,0) is the first pixel of the texture image, sampled with bilinear
+ *		filtering and clamped to the edges. Blending is
+ *		(SRC_ALPHA, ONE_MINUS_SRC_ALPHA), applied to all four channels.
+ */
+class SoftwareRasterizer
+{
+public:
+	struct Vertex {
+		float x, y;
+		float u, v;
+		float r, g, b, a;
+
+		Vertex() : x(0), y(0), u(0), v(0), r(1), g(1), b(1), a(1) { }
+		Vertex(float _x, float _y, float _u, float _v, const Color &cl, float alpha) :
+			x(_x), y(_y), u(_u), v(_v), r(cl.r), g(cl.g), b(cl.b), a(alpha) { }
+	};
+
+private:
+	struct State {
+		const Image	*pTexture;
+		bool		bBlend;
+		Rect<int>	scissor;		// already clipped to the target
+	};
+	struct Triangle {
+		Vertex	v[3];
+		size_t	state;
+	};
+	class TileJob;
+
+	Image					*m_pTarget;
+	int						m_tileSize;
+	int						m_tilesX, m_tilesY;
+
+	State					m_curState;
+	bool					m_bStateChanged;
+	bool					m_bScissor;
+	Rect<int>				m_scissor;
+
+	std::vector<State>		m_states;
+	std::vector<Triangle>	m_triangles;
+	std::vector< std::vector<unsigned int> >	m_bins;	// triangle ids per tile
+
+public:
+	SoftwareRasterizer();
+	virtual ~SoftwareRasterizer();
+
+	// the target must be an I8BITS image with 4 channels
+	void	setTarget(Image *pTarget);
+	Image*	getTarget() const				{ return m_pTarget; }
+	void	setTileSize(int size);
+
+	// state for the triangles submitted after each call
+	void	setTexture(const Image *pTexture);	// 0: untextured. Only I8BITS images with 1, 3 or 4 channels
+	void	setBlending(bool bBlend);
+	void	setScissor(int left, int top, int right, int bottom);	// [left,right) x [top,bottom)
+	void	disableScissor();
+
+	void	clear(float r, float g, float b, float a);	// flushes queued triangles first
+	void	drawTriangle(const Vertex &v0, const Vertex &v1, const Vertex &v2);
+	void	drawQuad(const Vertex &v0, const Vertex &v1, const Vertex &v2, const Vertex &v3);
+	void	drawLine(const Vertex &v0, const Vertex &v1, float width = 1.0f);
+
+	void	flush();	// render everything queued so far
+	size_t	getQueuedNum() const			{ return m_triangles.size(); }
+
+private:
+	void	updateState();
+	void	rasterizeTile(int tile);
+	void	rasterizeTriangle(const Triangle &tri, const Rect<int> &clip);
+};
+
+#endif
@@ -22,18 +22,40 @@
 #include "Texture.h"
 #include "BaseTextFile.h"
 #include "Image.h"
+#include "Profiler.h"
+#include "TextureBudget.h"
+#include "MipChain.h"
+#include <algorithm>
 
-Texture::Texture()
+bool Texture::m_bKeepShadowCopies = false;
+
+Texture::Texture() : m_pShadow(0)
 {
 }
 
 Texture::~Texture()
 {
 	free();
+	SAFE_DELETE(m_pShadow);
+}
+
+void Texture::swap(Texture &t)
+{
+	ASSERT(!m_bIsManaged && !t.m_bIsManaged);
+	std::swap(m_texture, t.m_texture);
+	std::swap(m_width, t.m_width);
+	std::swap(m_height, t.m_height);
+	std::swap(m_depth, t.m_depth);
+	std::swap(m_pShadow, t.m_pShadow);
+	m_data.swap(t.m_data);
+	m_fData.swap(t.m_fData);
 }
 
 void Texture::create(int width, int height, GLenum format, unsigned char* data)
 {
+	PROFILE_ZONE("Texture::create");
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+
 	// create the texture object
 	if (!m_texture) {
 		glGenTextures(1, &m_texture);
@@ -70,6 +92,9 @@ void Texture::create(int width, int height, GLenum format, unsigned char* data)
 	case GL_RGBA8:
 		texformat = GL_RGBA;
 		break;
+	case GL_LUMINANCE8:
+		texformat = GL_LUMINANCE;
+		break;
 
 	case GL_RGBA32F_ARB:
 	case GL_RGBA16F_ARB:
@@ -79,13 +104,15 @@ void Texture::create(int width, int height, GLenum format, unsigned char* data)
 	case GL_RGB16F_ARB:
 		texformat = GL_RGB;
 		break;
+	case GL_LUMINANCE32F_ARB:
+	case GL_LUMINANCE16F_ARB:
+		texformat = GL_LUMINANCE;
+		break;
 	case GL_ALPHA32F_ARB:
 	case GL_INTENSITY32F_ARB:
-	case GL_LUMINANCE32F_ARB:
 	case GL_LUMINANCE_ALPHA32F_ARB:
 	case GL_ALPHA16F_ARB:
 	case GL_INTENSITY16F_ARB:
-	case GL_LUMINANCE16F_ARB:
 	case GL_LUMINANCE_ALPHA16F_ARB:
 		Console::print("Texture::create: ERROR - unable to handle format\n");
 		break;
@@ -97,6 +124,7 @@ void Texture::create(int width, int height, GLenum format, unsigned char* data)
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glPixelStorei(GL_PACK_ALIGNMENT, 1);
 	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, texformat, dataformat, data);
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
 	
 	//GLboolean res;
 	//bool bres = glAreTexturesResident(1, &m_texture, &res) != 0;
@@ -104,10 +132,32 @@ void Texture::create(int width, int height, GLenum format, unsigned char* data)
 
 	m_width = width;
 	m_height = height;
+
+	// keep a copy of 8-bit data for software rendering
+	SAFE_DELETE(m_pShadow);
+	if (m_bKeepShadowCopies && dataformat == GL_UNSIGNED_BYTE)
+	{
+		int nChannels = 0;
+		switch (texformat) {
+			case GL_LUMINANCE:	nChannels = 1; break;
+			case GL_RGB:		nChannels = 3; break;
+			case GL_RGBA:		nChannels = 4; break;
+		}
+		if (nChannels > 0) {
+			m_pShadow = new Image();
+			m_pShadow->create(width, height, (unsigned char)nChannels);
+			if (data)
+				memcpy((*m_pShadow)(0,0), data, width*height*nChannels);
+		}
+	}
 }
 
 void Texture::create(const Image &image, bool bResize)
 {
+	PROFILE_ZONE("Texture::create");
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+	PROFILE_COUNT(UPLOAD_BYTES, (int)(image.getWidth()*image.getHeight()*image.getBytesPerPixel()));
+
 	// create the texture object
 	if (!m_texture) {
 		glGenTextures(1, &m_texture);
@@ -117,6 +167,271 @@ void Texture::create(const Image &image, bool bResize)
 
 	// find the best texture format to represent the image
 	GLenum format, dataformat, imgformat;
+	if (!getImageFormat(image, format, imgformat, dataformat))
+	{
+		Console::error("Texture::create(): image format is not supported (%d)\n", image.getFormat());
+		return;
+	}
+
+	// get a ptr to the data to use
+	Image tmp_img;
+	const Image &fitted = fitImage(image, bResize, tmp_img);
+	void *data = (void*)fitted(0,0);
+	size_t w = fitted.getWidth();
+	size_t h = fitted.getHeight();
+
+	// now create the texture
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, imgformat, dataformat, data);
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
+	
+	m_width = w;
+	m_height = h;
+
+	SAFE_DELETE(m_pShadow);
+	if (m_bKeepShadowCopies && image.getFormat() == Image::I8BITS) {
+		m_pShadow = new Image();
+		m_pShadow->copy(tmp_img.isEmpty() ? image : tmp_img);
+	}
+}
+
+void Texture::create(const MipChain &chain)
+{
+	PROFILE_ZONE("Texture::create");
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+
+	if (chain.isEmpty())
+		return;
+	const Image &base = chain.getLevel(0);
+
+	// create the texture object
+	if (!m_texture) {
+		glGenTextures(1, &m_texture);
+	}
+	if (m_texture == 0)
+		Console::print("ERROR: failed to create OpenGL texture\n");
+
+	GLenum format, dataformat, imgformat;
+	if (!getImageFormat(base, format, imgformat, dataformat))
+	{
+		Console::error("Texture::create(): image format is not supported (%d)\n", base.getFormat());
+		return;
+	}
+
+	// all levels, in one go
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	uploadLevels(chain, 0, format, imgformat, dataformat);
+
+	m_width = (int)base.getWidth();
+	m_height = (int)base.getHeight();
+
+	SAFE_DELETE(m_pShadow);
+	if (m_bKeepShadowCopies && base.getFormat() == Image::I8BITS) {
+		m_pShadow = new Image();
+		m_pShadow->copy(base);
+	}
+}
+
+void Texture::createMipMapped(const Image &image, bool bSRGB, bool bResize)
+{
+	Image tmp_img;
+	MipChain chain;
+	chain.create(fitImage(image, bResize, tmp_img), bSRGB);
+	create(chain);
+}
+
+void Texture::create(const CompressedImage &image)
+{
+	PROFILE_ZONE("Texture::create");
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+
+	if (image.isEmpty())
+		return;
+	if (!BlockCompression::isSupported(image.getFormat()))
+	{
+		Image decoded;
+		image.decode(decoded);
+		if (image.getLevelsNum() > 1)
+			createMipMapped(decoded, image.isSRGB(), false);
+		else
+			create(decoded, false);
+		return;
+	}
+
+	// create the texture object
+	if (!m_texture) {
+		glGenTextures(1, &m_texture);
+	}
+	if (m_texture == 0)
+		Console::print("ERROR: failed to create OpenGL texture\n");
+
+	GLenum format = BlockCompression::getGLFormat(image.getFormat());
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (image.getLevelsNum() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.getLevelsNum()-1);
+	for (size_t i=0; i<image.getLevelsNum(); ++i)
+	{
+		PROFILE_COUNT(UPLOAD_BYTES, (int)image.getLevelBytes(i));
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, format, (GLsizei)image.getLevelWidth(i), (GLsizei)image.getLevelHeight(i), 0,
+								(GLsizei)image.getLevelBytes(i), image.getLevelData(i));
+	}
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
+
+	m_width = (int)image.getWidth();
+	m_height = (int)image.getHeight();
+
+	// software renderers sample the decoded image
+	SAFE_DELETE(m_pShadow);
+	if (m_bKeepShadowCopies && BlockCompression::getChannelsNum(image.getFormat()) != 2) {
+		m_pShadow = new Image();
+		image.decode(*m_pShadow);
+	}
+}
+
+void Texture::create(const Image &image, BlockCompression::Format format, bool bMipMaps, bool bSRGB, bool bResize)
+{
+	Image tmp_img;
+	CompressedImage compressed;
+	if (!compressed.create(fitImage(image, bResize, tmp_img), format, bMipMaps, bSRGB))
+	{
+		Console::error("Texture::create(): image cannot be compressed (format %d, %d channels)\n", image.getFormat(), (int)image.getChannelsNum());
+		return;
+	}
+	create(compressed);
+}
+
+void Texture::createCompressed(const Image &image, bool bMipMaps, bool bSRGB, bool bResize)
+{
+	BlockCompression::Format format;
+	if (BlockCompression::chooseFormat(image, format))
+		create(image, format, bMipMaps, bSRGB, bResize);
+	else if (bMipMaps)
+		createMipMapped(image, bSRGB, bResize);
+	else
+		create(image, bResize);
+}
+
+void Texture::uploadLevels(const MipChain &chain, size_t firstLevel, GLenum format, GLenum imgformat, GLenum dataformat)
+{
+	// the texture is bound
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (chain.getLevelsNum() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)chain.getLevelsNum()-1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t i=firstLevel; i<chain.getLevelsNum(); ++i)
+	{
+		const Image &level = chain.getLevel(i);
+		PROFILE_COUNT(UPLOAD_BYTES, (int)(level.getWidth()*level.getHeight()*level.getBytesPerPixel()));
+		glTexImage2D(GL_TEXTURE_2D, (GLint)i, format, (GLsizei)level.getWidth(), (GLsizei)level.getHeight(), 0, imgformat, dataformat, level(0,0));
+	}
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
+}
+
+const Image& Texture::fitImage(const Image &image, bool bResize, Image &tmp)
+{
+	static GLint maxSize = 0;
+	if (!maxSize)
+		glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+
+	// with non power of 2 textures, the image is used as it is
+	if (!bResize || (GLEW_ARB_texture_non_power_of_two && image.getWidth() <= (size_t)maxSize && image.getHeight() <= (size_t)maxSize))
+		return image;
+
+	size_t w=1;
+	size_t h=1;
+	while (w<image.getWidth())
+		w *= 2;
+	while (h<image.getHeight())
+		h *= 2;
+	if (w>2048)
+		w=2048;
+	if (h>2048)
+		h=2048;
+	if (w == image.getWidth() && h == image.getHeight())
+		return image;
+
+	tmp.copy(image);
+	tmp.resize(w, h);
+	return tmp;
+}
+
+void Texture::update(const Image &image, int x, int y, int w, int h)
+{
+	TextureBudget::inst()->touch(m_texture);	// the rest of the texture has to be resident
+	if (!m_texture || m_width != (int)image.getWidth() || m_height != (int)image.getHeight()) {
+		create(image, false);
+		return;
+	}
+
+	// clip to the image
+	if (x < 0) { w += x; x = 0; }
+	if (y < 0) { h += y; y = 0; }
+	if (x+w > m_width) w = m_width - x;
+	if (y+h > m_height) h = m_height - y;
+	if (w <= 0 || h <= 0)
+		return;
+
+	GLenum format, dataformat, imgformat;
+	if (!getImageFormat(image, format, imgformat, dataformat))
+	{
+		Console::error("Texture::update(): image format is not supported (%d)\n", image.getFormat());
+		return;
+	}
+
+	PROFILE_ZONE("Texture::update");
+	PROFILE_COUNT(TEXTURE_UPLOADS, 1);
+	PROFILE_COUNT(UPLOAD_BYTES, (int)(w*h*image.getBytesPerPixel()));
+
+	// the sub-rectangle is read in place, using the image width as row length
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)image.getWidth());
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, imgformat, dataformat, image(x,y));
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	updateShadow(image, x, y, w, h);
+}
+
+void Texture::updateShadow(const Image &image, int x, int y, int w, int h)
+{
+	if (!m_bKeepShadowCopies || image.getFormat() != Image::I8BITS)
+		return;
+
+	// (re)create the copy if it doesnt match the image
+	if (!m_pShadow || m_pShadow->getWidth() != image.getWidth() || m_pShadow->getHeight() != image.getHeight() ||
+		m_pShadow->getChannelsNum() != image.getChannelsNum())
+	{
+		SAFE_DELETE(m_pShadow);
+		m_pShadow = new Image();
+		m_pShadow->copy(image);
+		return;
+	}
+
+	size_t rowBytes = w*image.getBytesPerPixel();
+	for (int j=y; j<y+h; ++j)
+		memcpy((*m_pShadow)(x,j), image(x,j), rowBytes);
+}
+
+void Texture::update(const Image &image, const DirtyRegion &region)
+{
+	if (!m_texture || m_width != (int)image.getWidth() || m_height != (int)image.getHeight()) {
+		create(image, false);
+		return;
+	}
+
+	for (size_t i=0; i<region.getRectsNum(); ++i) {
+		const Rect<int> &r = region.getRect(i);
+		update(image, r.left, r.top, r.getWidth(), r.getHeight());
+	}
+}
+
+bool Texture::getImageFormat(const Image &image, GLenum &format, GLenum &imgformat, GLenum &dataformat)
+{
 	bool bNotSupported = false;
 	switch (image.getFormat())
 	{
@@ -142,8 +457,8 @@ void Texture::create(const Image &image, bool bResize)
 		else
 			bNotSupported = true;
 		break;*/
-	/*case Image::F16BITS:
-		dataformat = GL_FLOAT;
+	case Image::F16BITS:
+		dataformat = GL_HALF_FLOAT_ARB;		// uploaded as is, without converting to float
 		if (image.getChannelsNum() == 1)
 			format = GL_LUMINANCE16F_ARB;
 		else if (image.getChannelsNum() == 3)
@@ -152,7 +467,7 @@ void Texture::create(const Image &image, bool bResize)
 			format = GL_RGBA16F_ARB;
 		else
 			bNotSupported = true;
-		break;*/
+		break;
 	case Image::F32BITS:
 		dataformat = GL_FLOAT;
 		if (image.getChannelsNum() == 1)
@@ -175,69 +490,40 @@ void Texture::create(const Image &image, bool bResize)
 		imgformat = GL_RGBA;
 	else
 		bNotSupported = true;
-	if (bNotSupported)
-	{
-		Console::error("Texture::create(): image format is not supported (%d)\n", image.getFormat());
-		return;
-	}
-
-	// get a ptr to the data to use
-	void *data = (void*)image(0,0);
-
-	// if the image doesnt have power-of-2 dimensions, then
-	// either resize the image or use OpenGL extensions
-	size_t w=1;
-	size_t h=1;
-	while (w<image.getWidth())
-		w *= 2;
-	while (h<image.getHeight())
-		h *= 2;
-	if (w>2048)
-		w=2048;
-	if (h>2048)
-		h=2048;
-	Image tmp_img;
-	if (w != image.getWidth() || h != image.getHeight())
-	{
-		//bResize = true;
-		if (bResize) {
-			tmp_img.copy(image);
-			tmp_img.resize(w, h);
-			data = (void*)tmp_img(0,0);
-		}
-		else {
-			//TODO: check if non-power-of-2 textures are supported
-			// if not, create a padded power-of-2 image
-			w = image.getWidth();
-			h = image.getHeight();
-		}
-	}
 
-	// now create the texture
-	glBindTexture(GL_TEXTURE_2D, m_texture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-	glPixelStorei(GL_PACK_ALIGNMENT, 1);
-	glTexImage2D(GL_TEXTURE_2D, 0, format, w, h, 0, imgformat, dataformat, data);
-	
-	m_width = w;
-	m_height = h;
+	return !bNotSupported;
 }
 
 void Texture::set()
 {
 	if (m_texture) {
+		TextureBudget::inst()->touch(m_texture);	// restores the texture if it was evicted
 		ASSERT(glIsTexture(m_texture));
 		glEnable(GL_TEXTURE_2D);
 		glBindTexture(GL_TEXTURE_2D, m_texture);
+		PROFILE_COUNT(TEXTURE_BINDS, 1);
 	}
 }
 
-void Texture::createMipMaps()
+void Texture::createMipMaps(bool bSRGB)
 {
+	if (!m_texture)
+		return;
+	TextureBudget::inst()->touch(m_texture);
+
+	// read level 0 back, as 8-bit or float depending on the texture format
 	glBindTexture(GL_TEXTURE_2D, m_texture);
-	gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGB, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, &m_data[0]);
+	GLint format = GL_RGBA8;
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+	bool bFloat = (format >= GL_RGBA32F_ARB && format <= GL_LUMINANCE_ALPHA16F_ARB);
+	Image base;
+	base.create(m_width, m_height, 4, bFloat ? Image::F32BITS : Image::I8BITS);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, bFloat ? GL_FLOAT : GL_UNSIGNED_BYTE, base.getData());
+
+	MipChain chain;
+	chain.create(base, bSRGB);
+	uploadLevels(chain, 1, format, GL_RGBA, bFloat ? GL_FLOAT : GL_UNSIGNED_BYTE);
 	Console::print("\tGenerated texture mipmaps\n");
 }
 
@@ -283,6 +569,7 @@ bool Texture::loadMatrixFile(const std::string& filename, int sz)
 	// create the opengl texture object
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, sz, sz, 0, GL_LUMINANCE, GL_FLOAT, data);
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR)
 		Console::print("ERROR: %s\n", gluErrorString(error));
@@ -334,30 +621,22 @@ bool Texture::loadMatrixFileCSV(const std::string& filename)
 	Console::print("\t\txResolution = %d, yResolution = %d\n\t\txBegin = %d, xEnd = %d\n\t\tyBegin = %d, yEnd = %d\n",
 					xResolution, yResolution, xBegin, xEnd, yBegin, yEnd);
 
-	// Manual control from this point on
-	FILE *fp = file.getFP();
+	// values are separated by commas or line breaks
+	file.addWordBreakChar(',');
 
 	// Create the texture
 	m_fData.resize(xResolution*yResolution);
 
-
+	Tokenizer::Token token;
 	for (int i=0; i<xResolution; ++i)
 		for (int j=0; j<yResolution; ++j)
 		{
-			// read until next comma or new line
-			std::string str;
-			char ch;
 			do {
-				ch = getc(fp);
-				if (isspace(ch))
-					continue;
-				str += ch;
-			} while (ch != ',' && ch != '\n' && !feof(fp));
-
-			double val = atof(str.c_str());
+				file >> token;
+			} while (token == "," && !file.eof());
 
 			// Write this value to the texture.
-			m_fData[j*xResolution+i] = (float)val;
+			m_fData[j*xResolution+i] = (float)Tokenizer::toDouble(token);
 		}
 
 //	fclose(fp);
@@ -370,6 +649,7 @@ bool Texture::loadMatrixFileCSV(const std::string& filename)
 	// create the opengl texture object
 	glBindTexture(GL_TEXTURE_2D, m_texture);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, xResolution, yResolution, 0, GL_LUMINANCE, GL_FLOAT, &m_fData[0]);
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_2D);
 	GLenum error = glGetError();
 	if (error != GL_NO_ERROR)
 		Console::print("ERROR: %s\n", gluErrorString(error));
@@ -436,4 +716,4 @@ void Texture::toImage(Image *image)
 			(*image)(i,j)[1] = buf[3*(j*m_width + i)+1];
 			(*image)(i,j)[2] = buf[3*(j*m_width + i)+2];
 		}
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -26,7 +26,12 @@
 
 #include "common.h"
 #include "BaseTexture.h"
+#include "BlockCompression.h"
 class Image;
+class DirtyRegion;
+class MipChain;
+class BrickedVolume;
+class EnvironmentMap;
 
 #define TEXTURE_RECTANGLE_ARB            0x84F5
 
@@ -56,24 +61,67 @@ class Image;
 
 #define FLOAT_RGBA16_NV                                 0x888A
 
+#ifndef GL_HALF_FLOAT_ARB
+	#define GL_HALF_FLOAT_ARB                   0x140B
+#endif
+
 class Texture : public BaseTexture
 {
 	friend class TextureManager;
+	friend class AsyncTextureLoader;
 private:
 	std::vector<unsigned char> m_data;
 
 	std::vector<float>	m_fData;
 
+	// CPU side copy of the texture contents, used by software rendering
+	Image	*m_pShadow;
+	static bool	m_bKeepShadowCopies;
+
 public:
 	Texture();
 	virtual ~Texture();
 
 	void create(int width, int height, GLenum format, unsigned char* data = 0);
 	void create(const Image &image, bool bResize = true);
+
+	// create a mipmapped texture: create(chain) uploads all levels of the chain at once, and
+	// createMipMapped(..) builds the chain of an image first (see MipChain for bSRGB)
+	void create(const MipChain &chain);
+	void createMipMapped(const Image &image, bool bSRGB = false, bool bResize = true);
+
+	// create a texture with a block compressed internal format, with all the levels of the
+	// compressed image. If the driver does not support the format, it is decoded and
+	// uploaded uncompressed. create(image, format, ..) compresses the image first, and
+	// createCompressed(..) also picks the format (see BlockCompression::chooseFormat) -
+	// images that cannot be compressed are uploaded as they are.
+	void create(const CompressedImage &image);
+	void create(const Image &image, BlockCompression::Format format, bool bMipMaps = false, bool bSRGB = false, bool bResize = true);
+	void createCompressed(const Image &image, bool bMipMaps = false, bool bSRGB = false, bool bResize = true);
+
+	// upload only part of an image that was used to create this texture (with bResize=false).
+	// If the texture does not match the size of the image, it is created again.
+	void update(const Image &image, int x, int y, int w, int h);
+	void update(const Image &image, const DirtyRegion &region);
 	void toImage(Image *image);
 
+	// find the GL internal format, pixel format and data type that match the format of an image.
+	// Returns false if the image format cannot be uploaded to a texture.
+	static bool getImageFormat(const Image &image, GLenum &internalFormat, GLenum &pixelFormat, GLenum &dataType);
+
+	// when enabled, textures created from 8-bit data keep a copy of it in system memory,
+	// so that renderers that do not use OpenGL can sample them. Off by default.
+	static void	setKeepShadowCopies(bool bKeep)		{ m_bKeepShadowCopies = bKeep; }
+	static bool	getKeepShadowCopies()				{ return m_bKeepShadowCopies; }
+	const Image* getShadowImage() const				{ return m_pShadow; }
+
 	void set();
-	void createMipMaps();
+	void createMipMaps(bool bSRGB = false);	// builds the levels from the contents of level 0
+
+	// exchange the GL textures (and everything that goes with them) of two texture
+	// objects. Used to hand a texture that was created on another thread to an object
+	// that is already in use, fe. by SharedContextLoader tasks.
+	void swap(Texture &t);
 
 	inline int	getWidth() const	{ return m_width; }
 	inline int	getHeight() const	{ return m_height; }
@@ -91,6 +139,12 @@ public:
 
 private:
 	double evalF(Texture *F, double x, double y, double xScale, double yScale);
+	void updateShadow(const Image &image, int x, int y, int w, int h);
+	void uploadLevels(const MipChain &chain, size_t firstLevel, GLenum format, GLenum imgformat, GLenum dataformat);
+
+	// the image to upload for create(image, bResize): the image itself, or a power of 2
+	// copy in tmp if bResize is set and the driver needs one
+	static const Image& fitImage(const Image &image, bool bResize, Image &tmp);
 };
 
 class Texture3D : public BaseTexture
@@ -101,7 +155,8 @@ public:
 	virtual ~Texture3D();
 
 	void create(int format, int width, int height, int depth, unsigned char* voxels);
-	bool load(const std::string &filename);
+	bool create(const BrickedVolume &volume, size_t level);	// one level of detail of a bricked volume
+	bool load(const std::string &filename);	// fails for volumes larger than the 3D texture size (see BrickedVolume)
 	void set();
 	void createMipMaps();
 	
@@ -121,6 +176,11 @@ public:
 	void set();
 	bool loadCubePPM(const std::string (&fnames)[6]);
 	bool loadCubeHDR(const std::string (&fnames)[6]);
+
+	// the specular chain of a prefiltered environment, as the mip levels of the cube map.
+	// The small levels look right only with GL_TEXTURE_CUBE_MAP_SEAMLESS, which the
+	// frame window enables when it sets up GL
+	bool create(const EnvironmentMap &env);
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -20,7 +20,19 @@
 */
 
 #include "Texture.h"
+#include "TextureBudget.h"
+#include "BrickedVolume.h"
 
+namespace {
+
+bool fitsTexture3D(int width, int height, int depth)
+{
+	GLint maxSize = 0;
+	glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize);
+	return width <= maxSize && height <= maxSize && depth <= maxSize;
+}
+
+};
 
 Texture3D::Texture3D()
 {
@@ -58,13 +70,18 @@ bool Texture3D::load(const std::string &fname)
 	// read image dimensions 
 	int w, h, d;
 	sscanf(str,"%d %d %d", &w, &h, &d);
+	if (!fitsTexture3D(w, h, d)) {
+		Console::error("Texture3D::load(): %s (%d x %d x %d) is larger than the maximum 3D texture size\n", fname.c_str(), w, h, d);
+		fclose(fp);
+		return false;
+	}
 
 	// read the next line into dummy variable
 	fgets(str,100,fp);
 		
 	// read the image data 
-	std::vector<unsigned char> data(w*h*d);
-	fread(&data[0], sizeof(unsigned char), w*h*d, fp);
+	std::vector<unsigned char> data((size_t)w*h*d);
+	fread(&data[0], sizeof(unsigned char), data.size(), fp);
 
 	fclose(fp);
 
@@ -79,8 +96,10 @@ void Texture3D::create(int format, int width, int height, int depth, unsigned ch
 {
 	ASSERT(voxels);
 
-	if (m_texture)
+	if (m_texture) {
+		TextureBudget::inst()->remove(m_texture);
 		glDeleteTextures(1, &m_texture);
+	}
 	
 	// Create the texture
 	glEnable(GL_TEXTURE_3D);
@@ -93,6 +112,7 @@ void Texture3D::create(int format, int width, int height, int depth, unsigned ch
 	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP);
 	glTexImage3D(GL_TEXTURE_3D, 0, format, width, height, depth, 0, format, 
 				GL_UNSIGNED_BYTE, voxels);
+	TextureBudget::inst()->add(m_texture, GL_TEXTURE_3D);
 	m_width = width;
 	m_height = height;
 	m_depth = depth;
@@ -100,8 +120,41 @@ void Texture3D::create(int format, int width, int height, int depth, unsigned ch
 	Console::print("\tLoaded 3D texture (%d x %d x %d)\n", m_width, m_height, m_depth);
 }
 
+bool Texture3D::create(const BrickedVolume &volume, size_t level)
+{
+	if (level >= volume.getLevelsNum())
+		return false;
+	const BrickedVolume::Level &lv = volume.getLevel(level);
+	if (!fitsTexture3D(lv.width, lv.height, lv.depth)) {
+		Console::error("Texture3D::create(): level %d of the volume (%d x %d x %d) is larger than the maximum 3D texture size\n",
+			(int)level, lv.width, lv.height, lv.depth);
+		return false;
+	}
+
+	// copy the inside of each brick to its place
+	std::vector<unsigned char> voxels((size_t)lv.width*lv.height*lv.depth);
+	std::vector<unsigned char> brick(volume.getBrickBytes());
+	int b = volume.getBrickSize(), s = volume.getStoredBrickSize(), border = volume.getBorder();
+	for (int bz=0; bz<lv.bricksZ; ++bz)
+		for (int by=0; by<lv.bricksY; ++by)
+			for (int bx=0; bx<lv.bricksX; ++bx)
+			{
+				if (!volume.readBrick(BrickedVolume::makeKey((int)level, bx, by, bz), &brick[0]))
+					return false;
+				int nx = std::min(b, lv.width - bx*b), ny = std::min(b, lv.height - by*b), nz = std::min(b, lv.depth - bz*b);
+				for (int k=0; k<nz; ++k)
+					for (int j=0; j<ny; ++j)
+						memcpy(&voxels[((size_t)(bz*b + k)*lv.height + by*b + j)*lv.width + bx*b],
+							   &brick[((size_t)(k + border)*s + j + border)*s + border], nx);
+			}
+
+	create(GL_LUMINANCE, lv.width, lv.height, lv.depth, &voxels[0]);
+	return true;
+}
+
 void Texture3D::set()
 {
+	TextureBudget::inst()->touch(m_texture);
 	glEnable(GL_TEXTURE_3D);
 	glBindTexture(GL_TEXTURE_3D, m_texture);
 }
\ No newline at end of file
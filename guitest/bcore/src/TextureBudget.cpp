@@ -0,0 +1,521 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TextureBudget.h"
+#include "Texture.h"
+#include "Image.h"
+#include "BlockCompression.h"
+#include <algorithm>
+
+TextureBudget *TextureBudget::m_pInst = 0;
+
+namespace {
+
+const int MAX_LEVELS = 16;
+
+// eviction order: lower priority first, then least recently used
+struct Candidate {
+	double	priority;
+	size_t	lastUse;
+	GLuint	texId;
+	bool operator < (const Candidate &c) const {
+		if (priority != c.priority)
+			return priority < c.priority;
+		return lastUse < c.lastUse;
+	}
+};
+
+GLenum bindingOf(GLenum target)
+{
+	switch (target) {
+		case GL_TEXTURE_3D:				return GL_TEXTURE_BINDING_3D;
+		case GL_TEXTURE_CUBE_MAP_ARB:	return GL_TEXTURE_BINDING_CUBE_MAP_ARB;
+	}
+	return GL_TEXTURE_BINDING_2D;
+}
+
+int facesNum(GLenum target)
+{
+	return (target == GL_TEXTURE_CUBE_MAP_ARB) ? 6 : 1;
+}
+
+GLenum faceTarget(GLenum target, int face)
+{
+	return (target == GL_TEXTURE_CUBE_MAP_ARB) ? GL_TEXTURE_CUBE_MAP_POSITIVE_X_ARB + face : target;
+}
+
+// the bytes used by all levels (and faces) of the bound texture
+size_t measure(GLenum target)
+{
+	size_t bytes = 0;
+	for (int face=0; face<facesNum(target); ++face)
+	{
+		GLenum ft = faceTarget(target, face);
+		for (int level=0; level<MAX_LEVELS; ++level)
+		{
+			GLint w = 0, h = 1, d = 1, fmt = 0, compressed = 0;
+			glGetTexLevelParameteriv(ft, level, GL_TEXTURE_WIDTH, &w);
+			if (w <= 0)
+				break;
+			glGetTexLevelParameteriv(ft, level, GL_TEXTURE_HEIGHT, &h);
+			if (target == GL_TEXTURE_3D)
+				glGetTexLevelParameteriv(ft, level, GL_TEXTURE_DEPTH, &d);
+			glGetTexLevelParameteriv(ft, level, GL_TEXTURE_COMPRESSED_ARB, &compressed);
+			if (compressed) {
+				GLint sz = 0;
+				glGetTexLevelParameteriv(ft, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE_ARB, &sz);
+				bytes += sz;
+			}
+			else {
+				glGetTexLevelParameteriv(ft, level, GL_TEXTURE_INTERNAL_FORMAT, &fmt);
+				bytes += (size_t)w*h*d*TextureBudget::texelSize(fmt);
+			}
+		}
+	}
+	return bytes;
+}
+
+// drops the storage of all levels of the bound texture, but keeps the texture name
+void release(GLenum target)
+{
+	for (int face=0; face<facesNum(target); ++face)
+	{
+		GLenum ft = faceTarget(target, face);
+		for (int level=MAX_LEVELS-1; level>=0; --level)
+		{
+			GLint w = 0, fmt = GL_RGBA8;
+			glGetTexLevelParameteriv(ft, level, GL_TEXTURE_WIDTH, &w);
+			if (w <= 0)
+				continue;
+			glGetTexLevelParameteriv(ft, level, GL_TEXTURE_INTERNAL_FORMAT, &fmt);
+			if (target == GL_TEXTURE_3D)
+				glTexImage3D(ft, level, fmt, 0, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+			else
+				glTexImage2D(ft, level, fmt, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+		}
+	}
+}
+
+TextureBudget::Kind kindOf(GLenum target)
+{
+	switch (target) {
+		case GL_TEXTURE_3D:				return TextureBudget::KIND_3D;
+		case GL_TEXTURE_CUBE_MAP_ARB:	return TextureBudget::KIND_CUBE;
+	}
+	return TextureBudget::KIND_2D;
+}
+
+};
+
+bool TextureBudget::uploadImage(GLuint texId, const Image &image, bool bResize)
+{
+	Texture tex;
+	tex.m_texture = texId;
+	tex.create(image, bResize);
+	tex.m_texture = 0;		// the name is still used by the evicted texture objects
+	return true;
+}
+
+bool TextureBudget::uploadImage(GLuint texId, const CompressedImage &image)
+{
+	Texture tex;
+	tex.m_texture = texId;
+	tex.create(image);
+	tex.m_texture = 0;
+	return true;
+}
+
+TextureBudget::ImageReloader::ImageReloader(const Image &image, bool bCopy, bool bResize) :
+	m_pCopy(0),
+	m_pImage(&image),
+	m_bResize(bResize)
+{
+	if (bCopy) {
+		m_pCopy = new Image();
+		m_pCopy->copy(image);
+		m_pImage = m_pCopy;
+	}
+}
+
+TextureBudget::ImageReloader::~ImageReloader()
+{
+	SAFE_DELETE(m_pCopy);
+}
+
+bool TextureBudget::ImageReloader::reload(GLuint texId, GLenum target)
+{
+	if (target != GL_TEXTURE_2D || m_pImage->isEmpty())
+		return false;
+	return uploadImage(texId, *m_pImage, m_bResize);
+}
+
+bool TextureBudget::FileReloader::reload(GLuint texId, GLenum target)
+{
+	if (target != GL_TEXTURE_2D)
+		return false;
+	if (m_bCompressed) {
+		CompressedImage compressed;
+		if (compressed.loadCached(m_filename))
+			return uploadImage(texId, compressed);
+	}
+
+	Image image;
+	if (!image.load(m_filename))
+		return false;
+	return uploadImage(texId, image, m_bResize);
+}
+
+TextureBudget::TextureBudget() : m_glThread(Thread::currentId())
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+TextureBudget::~TextureBudget()
+{
+	for (EntryMap::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+		SAFE_DELETE(it->second.pReloader);
+}
+
+void TextureBudget::setBudget(size_t bytes)
+{
+	m_stats.budget = bytes;
+	if (m_stats.budget > 0 && m_stats.usedBytes > m_stats.budget)
+		evict(m_stats.budget);
+}
+
+void TextureBudget::printStats() const
+{
+	Console::print("textures: %d (%d evicted), %d KB used of %d KB (peak %d KB)\n",
+		(int)m_stats.texturesNum, (int)m_stats.evictedNum, (int)(m_stats.usedBytes/1024),
+		(int)(m_stats.budget/1024), (int)(m_stats.peakBytes/1024));
+	Console::print("\t2D: %d KB, 3D: %d KB, cube: %d KB, render targets: %d KB, evicted: %d KB\n",
+		(int)(m_stats.kindBytes[KIND_2D]/1024), (int)(m_stats.kindBytes[KIND_3D]/1024),
+		(int)(m_stats.kindBytes[KIND_CUBE]/1024), (int)(m_stats.kindBytes[KIND_RENDER_TARGET]/1024),
+		(int)(m_stats.evictedBytes/1024));
+	Console::print("\t%d evictions, %d restores\n", (int)m_stats.evictions, (int)m_stats.restores);
+}
+
+void TextureBudget::nextFrame()
+{
+	flushPending();
+	m_stats.frame++;
+	if (m_stats.budget > 0 && m_stats.usedBytes > m_stats.budget)
+		evict(m_stats.budget);
+}
+
+void TextureBudget::account(const Entry &entry, bool bResident, int sign)
+{
+	if (sign > 0) {
+		m_stats.texturesNum++;
+		if (bResident) {
+			m_stats.usedBytes += entry.bytes;
+			m_stats.kindBytes[entry.kind] += entry.bytes;
+		}
+		else {
+			m_stats.evictedBytes += entry.bytes;
+			m_stats.evictedNum++;
+		}
+		if (m_stats.usedBytes > m_stats.peakBytes)
+			m_stats.peakBytes = m_stats.usedBytes;
+	}
+	else {
+		m_stats.texturesNum--;
+		if (bResident) {
+			m_stats.usedBytes -= entry.bytes;
+			m_stats.kindBytes[entry.kind] -= entry.bytes;
+		}
+		else {
+			m_stats.evictedBytes -= entry.bytes;
+			m_stats.evictedNum--;
+		}
+	}
+}
+
+bool TextureBudget::defer(PendingOp::Op op, GLuint id, GLenum target, size_t bytes)
+{
+	if (Thread::currentId() == m_glThread)
+		return false;
+	PendingOp pending;
+	pending.op = op;
+	pending.id = id;
+	pending.target = target;
+	pending.bytes = bytes;
+	ScopedLock lock(m_pendingLock);
+	m_pending.push_back(pending);
+	return true;
+}
+
+void TextureBudget::flushPending()
+{
+	std::vector<PendingOp> pending;
+	{
+		ScopedLock lock(m_pendingLock);
+		if (m_pending.empty())
+			return;
+		pending.swap(m_pending);
+	}
+	for (size_t i=0; i<pending.size(); ++i)
+	{
+		const PendingOp &p = pending[i];
+		switch (p.op) {
+			case PendingOp::ADD:					add(p.id, p.target, p.bytes); break;
+			case PendingOp::REMOVE:					remove(p.id); break;
+			case PendingOp::ADD_RENDERBUFFER:		addRenderbuffer(p.id, p.bytes); break;
+			case PendingOp::REMOVE_RENDERBUFFER:	removeRenderbuffer(p.id); break;
+		}
+	}
+}
+
+void TextureBudget::add(GLuint texId, GLenum target)
+{
+	if (!texId)
+		return;
+
+	// the texture is bound on the calling thread, so it is measured right away
+	size_t bytes = measure(target);
+	if (!defer(PendingOp::ADD, texId, target, bytes))
+		add(texId, target, bytes);
+}
+
+void TextureBudget::add(GLuint texId, GLenum target, size_t bytes)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it != m_entries.end())
+	{
+		// uploaded again (fe. resized)
+		Entry &entry = it->second;
+		account(entry, !entry.bEvicted, -1);
+		entry.target = target;
+		if (entry.kind != KIND_RENDER_TARGET)
+			entry.kind = kindOf(target);
+		entry.bytes = bytes;
+		entry.bEvicted = false;
+		entry.lastUse = m_stats.frame;
+		account(entry, true, 1);
+	}
+	else
+	{
+		Entry entry;
+		entry.target = target;
+		entry.kind = kindOf(target);
+		entry.bytes = bytes;
+		entry.lastUse = m_stats.frame;
+		entry.priority = 0.5;
+		entry.bEvicted = false;
+		entry.pReloader = 0;
+		m_entries.insert(EntryMap::value_type(texId, entry));
+		account(entry, true, 1);
+	}
+
+	if (m_stats.budget > 0 && m_stats.usedBytes > m_stats.budget)
+		evict(m_stats.budget);
+}
+
+void TextureBudget::remove(GLuint texId)
+{
+	if (defer(PendingOp::REMOVE, texId, 0, 0))
+		return;
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end())
+		return;
+	account(it->second, !it->second.bEvicted, -1);
+	SAFE_DELETE(it->second.pReloader);
+	m_entries.erase(it);
+}
+
+void TextureBudget::setReloader(GLuint texId, Reloader *pReloader)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end()) {
+		delete pReloader;
+		return;
+	}
+	SAFE_DELETE(it->second.pReloader);
+	it->second.pReloader = pReloader;
+}
+
+void TextureBudget::setPriority(GLuint texId, double priority)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end())
+		return;
+	it->second.priority = priority;
+	if (priority >= 1.0 && it->second.bEvicted)
+		restore(texId);
+}
+
+void TextureBudget::setRenderTarget(GLuint texId)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end())
+		return;
+	if (it->second.bEvicted)
+		restore(texId);
+	account(it->second, !it->second.bEvicted, -1);
+	it->second.kind = KIND_RENDER_TARGET;
+	it->second.priority = 1.0;
+	account(it->second, !it->second.bEvicted, 1);
+}
+
+bool TextureBudget::isEvicted(GLuint texId) const
+{
+	EntryMap::const_iterator it = m_entries.find(texId);
+	return (it != m_entries.end() && it->second.bEvicted);
+}
+
+void TextureBudget::addRenderbuffer(GLuint rbId, size_t bytes)
+{
+	if (defer(PendingOp::ADD_RENDERBUFFER, rbId, 0, bytes))
+		return;
+	removeRenderbuffer(rbId);
+	m_renderbuffers[rbId] = bytes;
+	m_stats.usedBytes += bytes;
+	m_stats.kindBytes[KIND_RENDER_TARGET] += bytes;
+	if (m_stats.usedBytes > m_stats.peakBytes)
+		m_stats.peakBytes = m_stats.usedBytes;
+	if (m_stats.budget > 0 && m_stats.usedBytes > m_stats.budget)
+		evict(m_stats.budget);
+}
+
+void TextureBudget::removeRenderbuffer(GLuint rbId)
+{
+	if (defer(PendingOp::REMOVE_RENDERBUFFER, rbId, 0, 0))
+		return;
+	stdext::hash_map<GLuint, size_t>::iterator it = m_renderbuffers.find(rbId);
+	if (it == m_renderbuffers.end())
+		return;
+	m_stats.usedBytes -= it->second;
+	m_stats.kindBytes[KIND_RENDER_TARGET] -= it->second;
+	m_renderbuffers.erase(it);
+}
+
+size_t TextureBudget::texelSize(GLenum internalFormat)
+{
+	switch (internalFormat) {
+		case 1:
+		case GL_ALPHA:
+		case GL_ALPHA8:
+		case GL_LUMINANCE:
+		case GL_LUMINANCE8:
+		case GL_INTENSITY:
+		case GL_INTENSITY8:
+			return 1;
+		case 2:
+		case GL_LUMINANCE_ALPHA:
+		case GL_LUMINANCE8_ALPHA8:
+		case GL_ALPHA16F_ARB:
+		case GL_LUMINANCE16F_ARB:
+		case GL_INTENSITY16F_ARB:
+		case GL_DEPTH_COMPONENT16:
+			return 2;
+		case GL_LUMINANCE_ALPHA16F_ARB:
+		case GL_ALPHA32F_ARB:
+		case GL_LUMINANCE32F_ARB:
+		case GL_INTENSITY32F_ARB:
+			return 4;
+		case GL_RGB16F_ARB:
+		case GL_RGBA16F_ARB:
+		case GL_LUMINANCE_ALPHA32F_ARB:
+			return 8;
+		case GL_RGB32F_ARB:
+		case GL_RGBA32F_ARB:
+			return 16;
+	}
+	return 4;	// RGB(A)8, depth 24/32 and anything unknown
+}
+
+void TextureBudget::evict(size_t targetBytes)
+{
+	// textures that can be restored, and are not in use in this frame
+	std::vector<Candidate> candidates;
+	for (EntryMap::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		const Entry &entry = it->second;
+		if (entry.bEvicted || !entry.pReloader || entry.priority >= 1.0 ||
+			entry.kind == KIND_RENDER_TARGET || entry.lastUse >= m_stats.frame)
+			continue;
+		Candidate c = { entry.priority, entry.lastUse, it->first };
+		candidates.push_back(c);
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (size_t i=0; i<candidates.size() && m_stats.usedBytes > targetBytes; ++i)
+		evict(m_entries[candidates[i].texId], candidates[i].texId);
+}
+
+bool TextureBudget::evict(GLuint texId)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end() || it->second.bEvicted || !it->second.pReloader || it->second.kind == KIND_RENDER_TARGET)
+		return false;
+	evict(it->second, texId);
+	return true;
+}
+
+void TextureBudget::evict(Entry &entry, GLuint texId)
+{
+	// this runs from add(..) too, while the caller is still setting up its own texture:
+	// leave its binding as it was
+	GLint prevTex = 0;
+	glGetIntegerv(bindingOf(entry.target), &prevTex);
+	glBindTexture(entry.target, texId);
+	release(entry.target);
+	glBindTexture(entry.target, prevTex);
+
+	account(entry, true, -1);
+	entry.bEvicted = true;
+	account(entry, false, 1);
+	m_stats.evictions++;
+}
+
+bool TextureBudget::restore(GLuint texId)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end() || !it->second.bEvicted)
+		return false;
+
+	// the reloader usually uploads through the texture classes, which call add(..)
+	// themselves; measure again in case it did not
+	GLenum target = it->second.target;
+	GLint prevTex = 0;
+	glGetIntegerv(bindingOf(target), &prevTex);
+	glBindTexture(target, texId);
+	bool bOk = it->second.pReloader->reload(texId, target);
+	glBindTexture(target, texId);
+	if (bOk)
+		add(texId, target);
+	else
+	{
+		// keep it evicted, dropping anything the reloader managed to upload
+		Console::error("TextureBudget: failed to restore evicted texture %d\n", texId);
+		release(target);
+		Entry &entry = m_entries[texId];
+		if (!entry.bEvicted) {
+			account(entry, true, -1);
+			entry.bEvicted = true;
+			account(entry, false, 1);
+		}
+	}
+	glBindTexture(target, prevTex);
+
+	m_stats.restores++;
+	return bOk;
+}
@@ -0,0 +1,209 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TEXTUREBUDGET_H45631_INCLUDED_
+#define _TEXTUREBUDGET_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Thread.h"
+#include <hash_map>
+class Image;
+class CompressedImage;
+
+/**
+ * TextureBudget: accounts the video memory used by all OpenGL textures and render
+ *		targets, and keeps it under a budget by evicting the textures that were
+ *		used least recently.
+ *
+ *		Textures are tracked by their GL name, so all texture objects that share one
+ *		(fe. through the TextureManager) share the accounting. The texture classes
+ *		report every upload with add(..), and every bind with touch(..).
+ *
+ *		An evicted texture keeps its GL name and its size in the texture objects, but
+ *		its storage is released. It is uploaded again the next time it is bound, by
+ *		the Reloader that was given for it. Textures without a reloader, textures
+ *		used in the current frame, and pinned textures (priority 1, see
+ *		BaseTexture::setPriority) are never evicted. Among the rest, textures with
+ *		a lower priority go first, then the least recently used ones.
+ *
+ *		The budget is 0 (unlimited) by default.
+ *
+ *		The budget belongs to the GL thread (the thread that first used it). Textures
+ *		and render buffers that are created or deleted on another thread with a shared
+ *		context (see SharedContextLoader) are measured there, but accounted for only
+ *		when the GL thread calls flushPending() (nextFrame() does).
+ */
+class TextureBudget
+{
+public:
+	enum Kind {
+		KIND_2D,
+		KIND_3D,
+		KIND_CUBE,
+		KIND_RENDER_TARGET,
+		KINDS_NUM
+	};
+
+	/**
+	 * Reloader: restores the contents of an evicted texture. reload(..) is called
+	 * with the texture bound, and should upload all of its levels again.
+	 */
+	class Reloader {
+	public:
+		virtual ~Reloader() { }
+		virtual bool reload(GLuint texId, GLenum target) = 0;
+	};
+
+	/**
+	 * ImageReloader: restores a 2D texture from an image in system memory. The
+	 * image is either copied, or referenced (in which case it must stay valid for
+	 * as long as the texture exists).
+	 */
+	class ImageReloader : public Reloader {
+		Image		*m_pCopy;
+		const Image	*m_pImage;
+		bool		m_bResize;
+	public:
+		ImageReloader(const Image &image, bool bCopy, bool bResize = true);
+		virtual ~ImageReloader();
+		virtual bool reload(GLuint texId, GLenum target);
+	};
+
+	/**
+	 * FileReloader: restores a 2D texture by loading its image file again. Compressed
+	 * textures are restored from the compressed image cache of the file.
+	 */
+	class FileReloader : public Reloader {
+		std::string	m_filename;
+		bool		m_bResize;
+		bool		m_bCompressed;
+	public:
+		FileReloader(const std::string &filename, bool bResize = true, bool bCompressed = false) :
+			m_filename(filename), m_bResize(bResize), m_bCompressed(bCompressed) { }
+		virtual bool reload(GLuint texId, GLenum target);
+	};
+
+	struct Stats {
+		size_t	budget;					// bytes, 0 for no limit
+		size_t	usedBytes;				// resident textures and render buffers
+		size_t	peakBytes;
+		size_t	kindBytes[KINDS_NUM];	// resident bytes of each kind
+		size_t	evictedBytes;			// bytes of the textures currently evicted
+		size_t	texturesNum, evictedNum;
+		size_t	evictions, restores;	// since the start
+		size_t	frame;
+	};
+
+private:
+	struct Entry {
+		GLenum		target;
+		Kind		kind;
+		size_t		bytes;
+		size_t		lastUse;	// frame
+		double		priority;
+		bool		bEvicted;
+		Reloader	*pReloader;
+	};
+
+	// add/remove calls made on other threads, in the order they were made
+	struct PendingOp {
+		enum Op { ADD, REMOVE, ADD_RENDERBUFFER, REMOVE_RENDERBUFFER };
+		Op		op;
+		GLuint	id;
+		GLenum	target;
+		size_t	bytes;
+	};
+
+	typedef stdext::hash_map<GLuint, Entry>	EntryMap;
+	EntryMap							m_entries;
+	stdext::hash_map<GLuint, size_t>	m_renderbuffers;
+	Stats								m_stats;
+	unsigned long						m_glThread;
+	std::vector<PendingOp>				m_pending;
+	Mutex								m_pendingLock;
+
+	static TextureBudget	*m_pInst;
+
+public:
+	TextureBudget();
+	virtual ~TextureBudget();
+
+	static TextureBudget* inst()	{ if (!m_pInst) m_pInst = new TextureBudget(); return m_pInst; }
+
+	void	setBudget(size_t bytes);
+	size_t	getBudget() const				{ return m_stats.budget; }
+	const Stats&	getStats() const		{ return m_stats; }
+	void	printStats() const;
+
+	// called once per frame, before rendering. Evicts textures if over budget.
+	void	nextFrame();
+	void	flushPending();		// account for the textures added/removed by other threads
+	size_t	getCurFrame() const				{ return m_stats.frame; }
+
+	// called by the texture classes. add(..) measures the levels of a texture that
+	// was just uploaded (and is bound), remove(..) when it is deleted. These four
+	// may be called from any thread with a context; the rest only from the GL thread.
+	void	add(GLuint texId, GLenum target);
+	void	remove(GLuint texId);
+	inline void	touch(GLuint texId);		// the texture is about to be used
+
+	// the reloader is owned by the budget from now on, and replaces any previous one.
+	// It must restore the latest contents of the texture, so a texture that is later
+	// filled with something else should get a new reloader (or 0).
+	void	setReloader(GLuint texId, Reloader *pReloader);
+	void	setPriority(GLuint texId, double priority);	// 1 pins the texture
+	void	setRenderTarget(GLuint texId);				// accounted as a render target, never evicted
+	bool	isEvicted(GLuint texId) const;
+
+	void	addRenderbuffer(GLuint rbId, size_t bytes);
+	void	removeRenderbuffer(GLuint rbId);
+
+	// bytes per texel of an internal format, as most drivers store it (RGB padded to RGBA)
+	static size_t	texelSize(GLenum internalFormat);
+
+	// uploads an image to an existing texture name, the same way Texture::create does
+	static bool		uploadImage(GLuint texId, const Image &image, bool bResize = true);
+	static bool		uploadImage(GLuint texId, const CompressedImage &image);
+
+	void	evict(size_t targetBytes);
+	bool	evict(GLuint texId);
+	bool	restore(GLuint texId);
+
+private:
+	void	evict(Entry &entry, GLuint texId);
+	void	account(const Entry &entry, bool bResident, int sign);
+	void	add(GLuint texId, GLenum target, size_t bytes);
+	bool	defer(PendingOp::Op op, GLuint id, GLenum target, size_t bytes);	// false on the GL thread
+};
+
+inline void TextureBudget::touch(GLuint texId)
+{
+	EntryMap::iterator it = m_entries.find(texId);
+	if (it == m_entries.end())
+		return;
+	it->second.lastUse = m_stats.frame;
+	if (it->second.bEvicted)
+		restore(texId);
+}
+
+#endif
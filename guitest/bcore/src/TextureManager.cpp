@@ -22,8 +22,11 @@
 #include "TextureManager.h"
 #include "Texture.h"
 #include "Image.h"
+#include "TextureBudget.h"
+#include "BlockCompression.h"
+#include "AsyncTextureLoader.h"
 
-#if (_MSC_VER >= 1310)
+#if !defined(_MSC_VER) || (_MSC_VER >= 1310)
 	stdext::hash_map<std::string, GLuint> TextureManager::m_loadedFilenames;
 	stdext::hash_map<GLuint, TextureManager::texRef> TextureManager::m_textures;
 #else
@@ -31,6 +34,17 @@
 	std::hash_map<GLuint, TextureManager::texRef> TextureManager::m_textures;
 #endif
 
+namespace {
+
+// background loads started by loadTextureAsync
+struct AsyncLoad {
+	AsyncTextureLoader::Handle	handle;
+	bool						bCompress;
+};
+stdext::hash_map<std::string, AsyncLoad>	g_asyncLoads;
+
+};
+
 TextureManager::TextureManager()
 {
 }
@@ -40,16 +54,21 @@ TextureManager::~TextureManager()
 	// free all managed textures
 	for (tTexRefIter it=m_textures.begin(); it!=m_textures.end(); ++it)
 	{
+		TextureBudget::inst()->remove((*it).second.texId);
 		glDeleteTextures(1, &(*it).second.texId);
 	}
 	m_textures.clear();
 	m_loadedFilenames.clear();
 }
 
-Texture* TextureManager::loadTexture(const std::string& filename, bool bUnique)
+Texture* TextureManager::loadTexture(const std::string& filename, bool bUnique, bool bCompress)
 {
 	Texture *pTex = 0;
 
+	// take over a background load of the file, if it is done
+	if (!bUnique)
+		finishAsync(filename);
+
 	// check the hash table to see if this texture file has already been loaded
 	tFileRefIter it = m_loadedFilenames.find(filename);
 	if (it != m_loadedFilenames.end() && !bUnique)
@@ -65,6 +84,7 @@ Texture* TextureManager::loadTexture(const std::string& filename, bool bUnique)
 			return 0;
 		}
 		texRef &tref = (*rit).second;
+		tref.nRefs++;
 
 		// the texture has already been loaded. Just wrap it in a new
 		// texture object
@@ -79,33 +99,103 @@ Texture* TextureManager::loadTexture(const std::string& filename, bool bUnique)
 	}
 	else
 	{
-		// load the image
+		// load the image, from the compressed image cache if possible
 		Image image;
-		if (!image.load(filename))
+		CompressedImage compressed;
+		if (bCompress) {
+			if (!compressed.loadCached(filename))
+				bCompress = false;
+		}
+		if (!bCompress && !image.load(filename))
 			return 0;
 
 		// create a texture object
 		pTex = new Texture();
 
 		// load the data to the texture object
-		pTex->create(image);
+		if (bCompress)
+			pTex->create(compressed);
+		else
+			pTex->create(image);
 		pTex->m_bIsManaged = true;
 
-		// create a new texture reference
-		texRef ref;
-		ref.nRefs = 1;
-		ref.texId = pTex->getGLTex();
-		
-		// add the new texture to the hashmap of managed textures
-		m_textures.insert(tTexRefVal(ref.texId, ref));
-
-		// store the texture id to the hash table
-		m_loadedFilenames.insert(tFileRefVal(filename, ref.texId));
+		addTexture(filename, pTex->getGLTex(), pTex->getWidth(), pTex->getHeight(), 1, true, bCompress);
 	}
 
 	return pTex;
 }
 
+void TextureManager::addTexture(const std::string& filename, GLuint texId, int w, int h, int nRefs, bool bResized, bool bCompress)
+{
+	// create a new texture reference
+	texRef ref;
+	ref.nRefs = nRefs;
+	ref.texId = texId;
+	ref.w = w;
+	ref.h = h;
+	ref.d = 0;
+
+	// the texture can be evicted from video memory, and loaded again from its file
+	TextureBudget::inst()->setReloader(ref.texId, new TextureBudget::FileReloader(filename, bResized, bCompress));
+	
+	// add the new texture to the hashmap of managed textures
+	m_textures.insert(tTexRefVal(ref.texId, ref));
+
+	// store the texture id to the hash table
+	m_loadedFilenames.insert(tFileRefVal(filename, ref.texId));
+}
+
+void TextureManager::loadTextureAsync(const std::string& filename, bool bCompress)
+{
+	if (m_loadedFilenames.find(filename) != m_loadedFilenames.end() || isLoading(filename))
+		return;
+	AsyncLoad load;
+	load.handle = AsyncTextureLoader::inst()->load(filename, false, bCompress);
+	load.bCompress = bCompress;
+	g_asyncLoads[filename] = load;
+}
+
+bool TextureManager::isLoading(const std::string& filename)
+{
+	return g_asyncLoads.find(filename) != g_asyncLoads.end();
+}
+
+bool TextureManager::finishAsync(const std::string& filename)
+{
+	stdext::hash_map<std::string, AsyncLoad>::iterator it = g_asyncLoads.find(filename);
+	if (it == g_asyncLoads.end())
+		return false;
+
+	AsyncLoad &load = it->second;
+	bool bAdded = false;
+	Texture *pTex = load.handle.releaseTexture();
+	if (pTex)
+	{
+		// keep the GL texture, as a managed one that no texture object uses yet. The
+		// first loadTexture(..) of the file will wrap it.
+		if (m_loadedFilenames.find(filename) == m_loadedFilenames.end()) {
+			addTexture(filename, pTex->m_texture, pTex->m_width, pTex->m_height, 0, false, load.bCompress);	// not resized to a power of 2
+			pTex->m_texture = 0;
+			bAdded = true;
+		}
+		delete pTex;
+	}
+	else
+		load.handle.cancel();	// not done: the caller loads the file itself
+	g_asyncLoads.erase(it);
+	return bAdded;
+}
+
+void TextureManager::update()
+{
+	std::vector<std::string> done;
+	for (stdext::hash_map<std::string, AsyncLoad>::const_iterator it = g_asyncLoads.begin(); it != g_asyncLoads.end(); ++it)
+		if (it->second.handle.isDone())
+			done.push_back(it->first);
+	for (size_t i=0; i<done.size(); ++i)
+		finishAsync(done[i]);
+}
+
 Texture3D* TextureManager::loadTexture3D(const std::string& filename)
 {
 	return 0;
@@ -132,6 +222,7 @@ void TextureManager::freeTexture(BaseTexture *pTex)
 		// if the ref counter is zero, the texture is no longer used. Delete it.
 		if (ref.nRefs <= 0)
 		{
+			TextureBudget::inst()->remove(texid);
 			glDeleteTextures(1, &texid);
 
 			// remove the texture from the m_loadedFilenames hash, by searching with the tex id
@@ -154,6 +245,7 @@ void TextureManager::freeTexture(BaseTexture *pTex)
 	else
 	{
 		// if there is no entry, then the texture is unmanaged, so just delete it
+		TextureBudget::inst()->remove(texid);
 		glDeleteTextures(1, &texid);
 	}
 }
@@ -39,7 +39,7 @@ private:
 		GLuint texId;
 		int w, h, d;
 	};
-#if (_MSC_VER >= 1310)	// if using visual studio .NET 2003 or later (yeah, thanks MS...)
+#if !defined(_MSC_VER) || (_MSC_VER >= 1310)	// if using visual studio .NET 2003 or later (yeah, thanks MS...)
 	static stdext::hash_map<std::string, GLuint> m_loadedFilenames;
 	typedef stdext::hash_map<std::string, GLuint>::iterator tFileRefIter;
 	typedef stdext::hash_map<std::string, GLuint>::value_type tFileRefVal;
@@ -65,11 +65,26 @@ public:
 	// object. However, the underlying OpenGL texture is loaded only once for the same texture
 	// file. A hash map is used to find already loaded files and avoid reloading them. Reference
 	// counting is used to free the textures when they are no longer used.
-	static Texture* loadTexture(const std::string& filename, bool bUnique=false);
+	// With bCompress, the texture is block compressed (see CompressedImage::loadCached).
+	static Texture* loadTexture(const std::string& filename, bool bUnique=false, bool bCompress=false);
 	static Texture3D* loadTexture3D(const std::string& filename);
 	static CubeTexture* loadTextureCube(const std::string& filename);
 
+	// loadTextureAsync starts loading a texture file in the background, through the
+	// AsyncTextureLoader, and returns at once. update() adds the textures that have finished
+	// loading to the managed ones, so that loadTexture(..) of the same file then only wraps
+	// the loaded texture. Until then, loadTexture(..) cancels the background load and loads
+	// the file itself. update() should be called once per frame, after
+	// AsyncTextureLoader::update().
+	static void loadTextureAsync(const std::string& filename, bool bCompress=false);
+	static bool isLoading(const std::string& filename);
+	static void update();
+
 	static void freeTexture(BaseTexture*);
+
+private:
+	static bool finishAsync(const std::string& filename);	// true if it was added to the managed textures
+	static void addTexture(const std::string& filename, GLuint texId, int w, int h, int nRefs, bool bResized, bool bCompress);
 };
 
 #endif
\ No newline at end of file
@@ -20,33 +20,294 @@
 */
 
 #include "Thread.h"
+#ifndef _WIN32
+	#include <errno.h>
+	#include <sched.h>
+	#include <sys/time.h>
+	#include <time.h>
+#endif
+
+#ifdef _WIN32
 
-Thread::Thread()
+Thread::Thread() : m_hThread(0)
 {
 }
 
 Thread::~Thread()
 {
+	if (m_hThread)
+		::CloseHandle(m_hThread);
 }
 
 void Thread::start()
 {
-#ifdef _POSIX_THREADS
-	// write some posix code (for REAL OSes)
-#endif
-
 	// create and start the thread (blasted win32 api).
 	m_hThread = ::CreateThread(NULL, 0, (unsigned long (__stdcall *)(void *))this->runProc, 
 								(void *)this, 0, NULL);
 }
 
-void Thread::run()
+void Thread::join()
 {
-	// override
+	if (m_hThread)
+		::WaitForSingleObject(m_hThread, INFINITE);
+}
+
+size_t Thread::getProcessorsNum()
+{
+	SYSTEM_INFO info;
+	::GetSystemInfo(&info);
+	if (info.dwNumberOfProcessors < 1)
+		return 1;
+	return info.dwNumberOfProcessors;
+}
+
+void Thread::sleep(unsigned long msec)
+{
+	::Sleep(msec);
+}
+
+unsigned long Thread::currentId()
+{
+	return ::GetCurrentThreadId();
 }
 
 unsigned long Thread::runProc(void *pThis)
 {
 	((Thread*)pThis)->run();
 	return 0;
-}
\ No newline at end of file
+}
+
+#else	// posix
+
+Thread::Thread() : m_bStarted(false)
+{
+}
+
+Thread::~Thread()
+{
+	if (m_bStarted)
+		pthread_detach(m_thread);
+}
+
+void Thread::start()
+{
+	m_bStarted = (pthread_create(&m_thread, NULL, runProc, (void*)this) == 0);
+}
+
+void Thread::join()
+{
+	if (m_bStarted) {
+		pthread_join(m_thread, NULL);
+		m_bStarted = false;
+	}
+}
+
+size_t Thread::getProcessorsNum()
+{
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 1)
+		return 1;
+	return (size_t)n;
+}
+
+void Thread::sleep(unsigned long msec)
+{
+	if (msec == 0) {
+		sched_yield();
+		return;
+	}
+	timespec ts;
+	ts.tv_sec = msec / 1000;
+	ts.tv_nsec = (msec % 1000) * 1000000;
+	while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+		;
+}
+
+unsigned long Thread::currentId()
+{
+	return (unsigned long)pthread_self();
+}
+
+void* Thread::runProc(void *pThis)
+{
+	((Thread*)pThis)->run();
+	return 0;
+}
+
+#endif
+
+void Thread::run()
+{
+	// override
+}
+
+//--------------------------------
+
+#ifndef _WIN32
+namespace {
+	// the absolute time msec from now, for the timed waits of pthreads
+	timespec deadline(unsigned long msec)
+	{
+		timeval now;
+		gettimeofday(&now, 0);
+		timespec ts;
+		ts.tv_sec = now.tv_sec + msec / 1000;
+		ts.tv_nsec = now.tv_usec*1000 + (msec % 1000)*1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		return ts;
+	}
+
+	// one wait on the condition (with the mutex locked). Returns false on timeout.
+	bool waitOnce(pthread_cond_t &cond, pthread_mutex_t &mutex, unsigned long msec, const timespec &ts)
+	{
+		if (msec == INFINITE)
+			return pthread_cond_wait(&cond, &mutex) == 0;
+		return pthread_cond_timedwait(&cond, &mutex, &ts) != ETIMEDOUT;
+	}
+};
+#endif
+
+#ifdef _WIN32
+
+Event::Event(bool bManualReset, bool bSignaled)
+{
+	m_hEvent = ::CreateEvent(NULL, bManualReset ? TRUE : FALSE, bSignaled ? TRUE : FALSE, NULL);
+	ASSERT(m_hEvent);
+}
+
+Event::~Event()
+{
+	::CloseHandle(m_hEvent);
+}
+
+void Event::set()
+{
+	::SetEvent(m_hEvent);
+}
+
+void Event::reset()
+{
+	::ResetEvent(m_hEvent);
+}
+
+bool Event::wait(unsigned long msec)
+{
+	return ::WaitForSingleObject(m_hEvent, msec) == WAIT_OBJECT_0;
+}
+
+#else
+
+Event::Event(bool bManualReset, bool bSignaled) : m_bManualReset(bManualReset), m_bSignaled(bSignaled)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+}
+
+Event::~Event()
+{
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void Event::set()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_bSignaled = true;
+	if (m_bManualReset)
+		pthread_cond_broadcast(&m_cond);
+	else
+		pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+void Event::reset()
+{
+	pthread_mutex_lock(&m_mutex);
+	m_bSignaled = false;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool Event::wait(unsigned long msec)
+{
+	timespec ts = deadline((msec == INFINITE) ? 0 : msec);
+	pthread_mutex_lock(&m_mutex);
+	while (!m_bSignaled && waitOnce(m_cond, m_mutex, msec, ts))
+		;
+	bool bOk = m_bSignaled;
+	if (bOk && !m_bManualReset)
+		m_bSignaled = false;
+	pthread_mutex_unlock(&m_mutex);
+	return bOk;
+}
+
+#endif
+
+//--------------------------------
+
+#ifdef _WIN32
+
+Semaphore::Semaphore(long initialCount, long maxCount)
+{
+	m_hSemaphore = ::CreateSemaphore(NULL, initialCount, maxCount, NULL);
+	ASSERT(m_hSemaphore);
+}
+
+Semaphore::~Semaphore()
+{
+	::CloseHandle(m_hSemaphore);
+}
+
+void Semaphore::post(long count)
+{
+	::ReleaseSemaphore(m_hSemaphore, count, NULL);
+}
+
+bool Semaphore::wait(unsigned long msec)
+{
+	return ::WaitForSingleObject(m_hSemaphore, msec) == WAIT_OBJECT_0;
+}
+
+#else
+
+Semaphore::Semaphore(long initialCount, long maxCount) : m_count(initialCount), m_maxCount(maxCount)
+{
+	pthread_mutex_init(&m_mutex, NULL);
+	pthread_cond_init(&m_cond, NULL);
+}
+
+Semaphore::~Semaphore()
+{
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+void Semaphore::post(long count)
+{
+	pthread_mutex_lock(&m_mutex);
+	m_count += count;
+	if (m_count > m_maxCount)
+		m_count = m_maxCount;
+	if (count == 1)
+		pthread_cond_signal(&m_cond);
+	else
+		pthread_cond_broadcast(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+bool Semaphore::wait(unsigned long msec)
+{
+	timespec ts = deadline((msec == INFINITE) ? 0 : msec);
+	pthread_mutex_lock(&m_mutex);
+	while (m_count <= 0 && waitOnce(m_cond, m_mutex, msec, ts))
+		;
+	bool bOk = (m_count > 0);
+	if (bOk)
+		m_count--;
+	pthread_mutex_unlock(&m_mutex);
+	return bOk;
+}
+
+#endif
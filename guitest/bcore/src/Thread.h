@@ -25,24 +25,163 @@
 #pragma once
 
 #include "common.h"
+#ifndef _WIN32
+	#include <pthread.h>
+#endif
 
+/**
+ * Thread: a thread of the OS (win32 threads, or pthreads elsewhere). Derive from
+ *		it and override run().
+ */
 class Thread
 {
 private:
-#ifdef _POSIX_THREADS
-	// TODO: posix thread support (for REAL OSes)
-#endif
+#ifdef _WIN32
 	HANDLE	m_hThread;
+#else
+	pthread_t	m_thread;
+	bool		m_bStarted;
+#endif
 
 public:
 	Thread();
 	virtual ~Thread();
 
 	void start();
+	void join();	// wait until run() returns
 	virtual void run();
 
+	static size_t getProcessorsNum();
+	static void	sleep(unsigned long msec);	// 0 yields the rest of the time slice
+	static unsigned long	currentId();	// id of the calling thread
+
 private:
+#ifdef _WIN32
 	static unsigned long runProc(void* pThis);
+#else
+	static void* runProc(void* pThis);
+#endif
+};
+
+/**
+ * Atomic increment/decrement of a counter shared between threads. Both return
+ * the new value.
+ */
+#ifdef _WIN32
+inline long atomicIncrement(volatile long *p)	{ return InterlockedIncrement(p); }
+inline long atomicDecrement(volatile long *p)	{ return InterlockedDecrement(p); }
+#else
+inline long atomicIncrement(volatile long *p)	{ return __sync_add_and_fetch(p, 1); }
+inline long atomicDecrement(volatile long *p)	{ return __sync_sub_and_fetch(p, 1); }
+#endif
+
+/**
+ * Mutex: a lightweight lock (a critical section on win32). Use it through
+ *		ScopedLock wherever possible, so that the lock is released when leaving
+ *		the scope, even if an exception is thrown.
+ */
+class Mutex
+{
+private:
+#ifdef _WIN32
+	CRITICAL_SECTION	m_cs;
+#else
+	pthread_mutex_t		m_mutex;
+#endif
+
+	Mutex(const Mutex&);				// not copyable
+	Mutex& operator = (const Mutex&);
+
+public:
+#ifdef _WIN32
+	Mutex()		{ InitializeCriticalSection(&m_cs); }
+	~Mutex()	{ DeleteCriticalSection(&m_cs); }
+
+	void lock()		{ EnterCriticalSection(&m_cs); }
+	void unlock()	{ LeaveCriticalSection(&m_cs); }
+#else
+	Mutex() {
+		// recursive, like critical sections
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&m_mutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+	}
+	~Mutex()	{ pthread_mutex_destroy(&m_mutex); }
+
+	void lock()		{ pthread_mutex_lock(&m_mutex); }
+	void unlock()	{ pthread_mutex_unlock(&m_mutex); }
+#endif
+};
+
+class ScopedLock
+{
+private:
+	Mutex	&m_mutex;
+
+	ScopedLock(const ScopedLock&);
+	ScopedLock& operator = (const ScopedLock&);
+
+public:
+	ScopedLock(Mutex &mutex) : m_mutex(mutex)	{ m_mutex.lock(); }
+	~ScopedLock()								{ m_mutex.unlock(); }
+};
+
+/**
+ * Event: a signal that one or more threads can wait on. An auto-reset event
+ *		releases a single waiting thread and resets itself, a manual-reset event
+ *		stays signaled until reset() is called.
+ */
+class Event
+{
+private:
+#ifdef _WIN32
+	HANDLE	m_hEvent;
+#else
+	pthread_mutex_t	m_mutex;
+	pthread_cond_t	m_cond;
+	bool			m_bManualReset;
+	bool			m_bSignaled;
+#endif
+
+	Event(const Event&);
+	Event& operator = (const Event&);
+
+public:
+	Event(bool bManualReset = false, bool bSignaled = false);
+	~Event();
+
+	void set();
+	void reset();
+	bool wait(unsigned long msec = INFINITE);	// returns false on timeout
+};
+
+/**
+ * Semaphore: counts available resources (f.e. jobs in a queue). wait() blocks
+ *		until the count is positive and then decrements it.
+ */
+class Semaphore
+{
+private:
+#ifdef _WIN32
+	HANDLE	m_hSemaphore;
+#else
+	pthread_mutex_t	m_mutex;
+	pthread_cond_t	m_cond;
+	long			m_count;
+	long			m_maxCount;
+#endif
+
+	Semaphore(const Semaphore&);
+	Semaphore& operator = (const Semaphore&);
+
+public:
+	Semaphore(long initialCount = 0, long maxCount = 0x7fffffff);
+	~Semaphore();
+
+	void post(long count = 1);
+	bool wait(unsigned long msec = INFINITE);
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
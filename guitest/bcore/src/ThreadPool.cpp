@@ -0,0 +1,227 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ThreadPool.h"
+
+ThreadPool *ThreadPool::m_pInst = 0;
+
+/**
+ * ForTask: the state shared by all threads working on one parallelFor call.
+ *		Chunks are handed out through an atomic counter, so the chunks are
+ *		balanced between threads regardless of how early each one started.
+ */
+class ThreadPool::ForTask {
+public:
+	RangeJob		*m_pJob;
+	size_t			m_begin, m_end, m_chunkSize;
+	long			m_nChunks;
+	volatile long	m_nextChunk;
+	volatile long	m_nPendingHelpers;
+	Event			m_helpersDone;
+
+	ForTask() : m_helpersDone(true, false) { }
+
+	void processChunks() {
+		while (true) {
+			long chunk = atomicIncrement(&m_nextChunk) - 1;
+			if (chunk >= m_nChunks)
+				break;
+			size_t b = m_begin + chunk*m_chunkSize;
+			size_t e = b + m_chunkSize;
+			if (e > m_end)
+				e = m_end;
+			m_pJob->processRange(b, e);
+		}
+	}
+	void helperDone() {
+		if (atomicDecrement(&m_nPendingHelpers) == 0)
+			m_helpersDone.set();
+	}
+};
+
+class ThreadPool::ForHelper : public ThreadPool::Job {
+public:
+	ForTask	*m_pTask;
+
+	virtual void run() {
+		m_pTask->processChunks();
+		m_pTask->helperDone();
+	}
+};
+
+//--------------------------------
+
+ThreadPool::ThreadPool() : m_bShutdown(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+	free();
+}
+
+ThreadPool* ThreadPool::inst()
+{
+	if (!m_pInst) {
+		m_pInst = new ThreadPool();
+		m_pInst->create();
+	}
+	return m_pInst;
+}
+
+void ThreadPool::create(size_t nThreads)
+{
+	free();
+
+	if (nThreads == 0)
+		nThreads = Thread::getProcessorsNum();
+
+	m_bShutdown = false;
+	for (size_t i=0; i<nThreads; ++i) {
+		Worker *pWorker = new Worker(this);
+		m_workers.push_back(pWorker);
+		pWorker->start();
+	}
+}
+
+void ThreadPool::free()
+{
+	if (m_workers.empty())
+		return;
+
+	// wake up all workers and let them exit
+	m_bShutdown = true;
+	m_jobsAvailable.post((long)m_workers.size());
+	for (size_t i=0; i<m_workers.size(); ++i) {
+		m_workers[i]->join();
+		SAFE_DELETE(m_workers[i]);
+	}
+	m_workers.clear();
+
+	// the jobs still queued belong to their submitters, who are waiting for them to
+	// run: run them here rather than drop them
+	while (Job *pJob = popJob())
+		pJob->run();
+}
+
+void ThreadPool::submit(Job *pJob)
+{
+	ASSERT(pJob);
+
+	// without workers, run the job right away
+	if (m_workers.empty()) {
+		pJob->run();
+		return;
+	}
+
+	{
+		ScopedLock lock(m_queueLock);
+		m_queue.push_back(pJob);
+	}
+	m_jobsAvailable.post();
+}
+
+bool ThreadPool::cancel(Job *pJob)
+{
+	ScopedLock lock(m_queueLock);
+	for (std::list<Job*>::iterator it = m_queue.begin(); it != m_queue.end(); ++it) {
+		if (*it == pJob) {
+			m_queue.erase(it);
+			// the semaphore count is now one higher than the queue size. A worker
+			// will wake up for nothing, find the queue empty and go back to sleep.
+			return true;
+		}
+	}
+	return false;
+}
+
+ThreadPool::Job* ThreadPool::popJob()
+{
+	ScopedLock lock(m_queueLock);
+	if (m_queue.empty())
+		return 0;
+	Job *pJob = m_queue.front();
+	m_queue.pop_front();
+	return pJob;
+}
+
+void ThreadPool::Worker::run()
+{
+	while (true) {
+		m_pPool->m_jobsAvailable.wait();
+		if (m_pPool->m_bShutdown)
+			break;
+		Job *pJob = m_pPool->popJob();
+		if (pJob)
+			pJob->run();
+	}
+}
+
+void ThreadPool::parallelFor(RangeJob &job, size_t begin, size_t end, size_t grain)
+{
+	if (end <= begin)
+		return;
+	if (grain < 1)
+		grain = 1;
+
+	// split the range in a few chunks per thread, so that uneven chunks
+	// are balanced out, but never in chunks smaller than the grain size
+	size_t nThreads = m_workers.size() + 1;
+	size_t chunkSize = (end - begin + 4*nThreads - 1) / (4*nThreads);
+	if (chunkSize < grain)
+		chunkSize = grain;
+	long nChunks = (long)((end - begin + chunkSize - 1) / chunkSize);
+	if (nChunks <= 1 || m_workers.empty()) {
+		job.processRange(begin, end);
+		return;
+	}
+
+	ForTask task;
+	task.m_pJob = &job;
+	task.m_begin = begin;
+	task.m_end = end;
+	task.m_chunkSize = chunkSize;
+	task.m_nChunks = nChunks;
+	task.m_nextChunk = 0;
+
+	long nHelpers = nChunks-1;
+	if (nHelpers > (long)m_workers.size())
+		nHelpers = (long)m_workers.size();
+	task.m_nPendingHelpers = nHelpers;
+
+	std::vector<ForHelper> helpers(nHelpers);
+	for (long i=0; i<nHelpers; ++i) {
+		helpers[i].m_pTask = &task;
+		submit(&helpers[i]);
+	}
+
+	// work on the range from this thread too
+	task.processChunks();
+
+	// all chunks have been handed out. Helpers that did not start yet have nothing
+	// to do, so take them out of the queue instead of waiting for a free worker
+	// (this also makes nested parallelFor calls from inside jobs safe)
+	for (long i=0; i<nHelpers; ++i) {
+		if (cancel(&helpers[i]))
+			task.helperDone();
+	}
+	task.m_helpersDone.wait();
+}
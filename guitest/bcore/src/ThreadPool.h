@@ -0,0 +1,95 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _THREADPOOL_H45631_INCLUDED_
+#define _THREADPOOL_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Thread.h"
+
+/**
+ * ThreadPool: a fixed set of worker threads that execute jobs from a shared
+ *		queue. There is one global pool (inst()), created lazily with one worker
+ *		per processor the first time it is used.
+ *
+ *		submit(..) queues a job and returns immediately. The pool never takes
+ *		ownership of a job: the caller must keep it alive until it has run (or
+ *		until cancel(..) has removed it from the queue).
+ *
+ *		parallelFor(..) splits a range in chunks and processes them on the workers
+ *		*and* on the calling thread, returning when all of the range is done. It
+ *		can safely be called from inside a job.
+ */
+class ThreadPool
+{
+public:
+	class Job {
+	public:
+		virtual ~Job() { }
+		virtual void run() = 0;
+	};
+
+	class RangeJob {
+	public:
+		virtual ~RangeJob() { }
+		virtual void processRange(size_t begin, size_t end) = 0;	// process [begin, end)
+	};
+
+private:
+	class Worker : public Thread {
+		ThreadPool	*m_pPool;
+	public:
+		Worker(ThreadPool *pPool) : m_pPool(pPool) { }
+		virtual void run();
+	};
+	class ForTask;
+	class ForHelper;
+
+	std::vector<Worker*>	m_workers;
+	std::list<Job*>			m_queue;
+	Mutex					m_queueLock;
+	Semaphore				m_jobsAvailable;
+	volatile bool			m_bShutdown;
+
+	static ThreadPool	*m_pInst;
+
+public:
+	ThreadPool();
+	virtual ~ThreadPool();
+
+	static ThreadPool* inst();
+
+	void	create(size_t nThreads = 0);	// 0: one thread per processor
+	void	free();							// waits for the running jobs to return, and runs the queued ones
+	size_t	getThreadsNum() const	{ return m_workers.size(); }
+
+	void	submit(Job *pJob);
+	bool	cancel(Job *pJob);		// true if the job was still queued and has been removed
+
+	void	parallelFor(RangeJob &job, size_t begin, size_t end, size_t grain = 1);
+
+private:
+	Job*	popJob();
+};
+
+#endif
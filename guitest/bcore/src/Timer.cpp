@@ -0,0 +1,46 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Timer.h"
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+double Timer::now()
+{
+#ifndef _WIN32
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+#else
+	static double secPerTick = 0;
+	if (secPerTick == 0) {
+		LARGE_INTEGER freq;
+		::QueryPerformanceFrequency(&freq);
+		secPerTick = 1.0 / (double)freq.QuadPart;
+	}
+
+	LARGE_INTEGER ticks;
+	::QueryPerformanceCounter(&ticks);
+	return ticks.QuadPart * secPerTick;
+#endif
+}
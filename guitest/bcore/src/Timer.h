@@ -0,0 +1,50 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TIMER_H45631_INCLUDED_
+#define _TIMER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+
+/**
+ * Timer: a monotonic, high resolution wall-clock timer (based on the
+ *		performance counter). Unlike clock(), it measures real elapsed time,
+ *		not cpu time consumed by the process.
+ */
+class Timer
+{
+private:
+	double	m_startTime;
+
+public:
+	Timer() : m_startTime(now()) { }
+
+	void	reset()				{ m_startTime = now(); }
+	double	elapsed() const		{ return now() - m_startTime; }		// in seconds
+	double	elapsedMsec() const	{ return 1000.0*(now() - m_startTime); }
+
+	// seconds since an arbitrary (but fixed) point in time
+	static double now();
+};
+
+#endif
@@ -0,0 +1,270 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Tokenizer.h"
+#include <stdlib.h>
+
+namespace {
+
+// powers of 10 that are exact in a double
+const double g_pow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool isDigit(char c)	{ return c >= '0' && c <= '9'; }
+inline bool isSpace(char c)	{ return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// strtod on a zero-terminated copy, for everything the fast path cannot handle
+double slowToDouble(const char *str, size_t len)
+{
+	char buf[128];
+	if (len < sizeof(buf)) {
+		memcpy(buf, str, len);
+		buf[len] = 0;
+		return strtod(buf, 0);
+	}
+	return strtod(std::string(str, len).c_str(), 0);
+}
+
+};
+
+Tokenizer::Tokenizer(size_t bufferSize) : m_fp(0),
+	m_pData(0),
+	m_buffer(bufferSize > 16 ? bufferSize : 16),
+	m_pos(0),
+	m_end(0),
+	m_keep(0),
+	m_fileEnd(0),
+	m_bEOF(false),
+	m_nLines(0),
+	m_bReadWholeLines(false),
+	m_bSkipComments(true)
+{
+	for (int c=0; c<256; ++c)
+		m_class[c] = isSpace((char)c) ? SPACE_CHAR : WORD_CHAR;
+}
+
+void Tokenizer::setInput(FILE *fp)
+{
+	m_fp = fp;
+	m_nLines = 0;
+	reset();
+}
+
+void Tokenizer::setInput(const char *data, size_t size)
+{
+	m_fp = 0;
+	m_pData = data;
+	m_pos = m_keep = 0;
+	m_end = size;
+	m_fileEnd = (long)size;
+	m_bEOF = false;
+	m_nLines = 0;
+}
+
+void Tokenizer::reset()
+{
+	if (!m_fp)
+		return;
+	m_pData = &m_buffer[0];
+	m_pos = m_end = m_keep = 0;
+	m_fileEnd = ftell(m_fp);
+	m_bEOF = false;
+}
+
+bool Tokenizer::refill()
+{
+	if (!m_fp)
+		return false;
+
+	// move the word being read to the start of the buffer
+	if (m_keep > 0) {
+		memmove(&m_buffer[0], &m_buffer[m_keep], m_end - m_keep);
+		m_end -= m_keep;
+		m_pos -= m_keep;
+		m_keep = 0;
+	}
+	if (m_end == m_buffer.size())
+		m_buffer.resize(2*m_buffer.size());		// a word longer than the buffer
+	m_pData = &m_buffer[0];
+
+	size_t n = fread(&m_buffer[m_end], 1, m_buffer.size() - m_end, m_fp);
+	m_end += n;
+	m_fileEnd = ftell(m_fp);
+	return n > 0;
+}
+
+bool Tokenizer::isComment(const char *str, size_t len) const
+{
+	for (size_t i=0; i<m_lineCommentPrefixes.size(); ++i) {
+		const std::string &prefix = m_lineCommentPrefixes[i];
+		if (len >= prefix.length() && memcmp(str, prefix.c_str(), prefix.length()) == 0)
+			return true;
+	}
+	return false;
+}
+
+bool Tokenizer::next(Token &token)
+{
+	token = Token();
+	int ch;
+	size_t start;
+	while (true)
+	{
+		// whitespace before the word
+		do {
+			m_keep = m_pos;
+			ch = get();
+			if (ch == '\n')
+				m_nLines++;
+		} while (ch >= 0 && m_class[ch] == SPACE_CHAR);
+		if (ch < 0)
+			return false;
+
+		// the word: a single word break character, or word characters up to the next one
+		start = m_pos-1;
+		m_keep = start;
+		if (m_class[ch] != BREAK_CHAR) {
+			while ((ch = get()) >= 0 && m_class[ch] == WORD_CHAR)
+				;
+			if (ch >= 0)
+				unget();
+		}
+		start = m_keep;		// the buffer may have moved
+
+		if (!m_bSkipComments || !isComment(m_pData + start, m_pos - start))
+			break;
+
+		// skip the rest of the line
+		do {
+			m_keep = m_pos;
+			ch = get();
+		} while (ch >= 0 && ch != '\n');
+		if (ch == '\n')
+			m_nLines++;
+	}
+	token.len = m_pos - start;
+
+	// whitespace after the word, up to the end of the line
+	while ((ch = get()) >= 0)
+	{
+		if (ch == '\n') {
+			m_nLines++;
+			break;
+		}
+		if (m_class[ch] != SPACE_CHAR && !m_bReadWholeLines) {
+			unget();
+			break;
+		}
+	}
+	// the word is still in the buffer: refills keep everything from m_keep
+	token.str = m_pData + m_keep;
+	return true;
+}
+
+bool Tokenizer::nextLine(Token &line)
+{
+	m_keep = m_pos;
+	int ch;
+	while ((ch = get()) >= 0 && ch != '\n')
+		;
+	size_t end = (ch == '\n') ? m_pos-1 : m_pos;
+	if (ch == '\n')
+		m_nLines++;
+	if (end > m_keep && m_pData[end-1] == '\r')
+		--end;
+
+	line.str = m_pData + m_keep;
+	line.len = end - m_keep;
+	return ch >= 0 || line.len > 0;
+}
+
+double Tokenizer::toDouble(const char *str, size_t len)
+{
+	const char *p = str, *end = str + len;
+	while (p < end && isSpace(*p))
+		++p;
+	bool bNeg = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		bNeg = (*p++ == '-');
+
+	// up to 19 significant digits fit in the mantissa
+	uint64_t mant = 0;
+	int nDigits = 0, exp10 = 0;
+	bool bDigits = false;
+	for (; p < end && isDigit(*p); ++p) {
+		bDigits = true;
+		mant = mant*10 + (*p - '0');
+		if (mant > 0 && ++nDigits > 19)
+			return slowToDouble(str, len);
+	}
+	if (p < end && (*p == 'x' || *p == 'X'))
+		return slowToDouble(str, len);		// hexadecimal
+	if (p < end && *p == '.') {
+		for (++p; p < end && isDigit(*p); ++p) {
+			bDigits = true;
+			mant = mant*10 + (*p - '0');
+			exp10--;
+			if (mant > 0 && ++nDigits > 19)
+				return slowToDouble(str, len);
+		}
+	}
+	if (!bDigits)
+		return slowToDouble(str, len);		// inf, nan, or no number at all
+
+	if (p < end && (*p == 'e' || *p == 'E')) {
+		const char *q = p+1;
+		bool bNegExp = false;
+		if (q < end && (*q == '-' || *q == '+'))
+			bNegExp = (*q++ == '-');
+		if (q < end && isDigit(*q)) {
+			int e = 0;
+			for (; q < end && isDigit(*q); ++q)
+				if (e < 100000)
+					e = e*10 + (*q - '0');
+			exp10 += (bNegExp) ? -e : e;
+		}
+	}
+
+	// exact when the mantissa and the power of 10 are both exact doubles
+	if (mant == 0)
+		return (bNeg) ? -0.0 : 0.0;
+	if (mant > ((uint64_t)1 << 53) || exp10 < -22 || exp10 > 22)
+		return slowToDouble(str, len);
+	double val = (double)(int64_t)mant;
+	val = (exp10 >= 0) ? val*g_pow10[exp10] : val/g_pow10[-exp10];
+	return (bNeg) ? -val : val;
+}
+
+int Tokenizer::toInt(const char *str, size_t len)
+{
+	const char *p = str, *end = str + len;
+	while (p < end && isSpace(*p))
+		++p;
+	bool bNeg = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		bNeg = (*p++ == '-');
+	int val = 0;
+	for (; p < end && isDigit(*p); ++p)
+		val = val*10 + (*p - '0');
+	return (bNeg) ? -val : val;
+}
@@ -0,0 +1,108 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of Be3D library.
+//
+//    Be3D is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    Be3D is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with Be3D.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TOKENIZER_H45631_INCLUDED_
+#define _TOKENIZER_H45631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include <stdio.h>
+
+/**
+ * Tokenizer: splits text into words, separated by whitespace and word break
+ *		characters (which are words on their own). Words that start with a line
+ *		comment prefix are skipped, along with the rest of their line.
+ *
+ *		The text is read from a file in large blocks or taken directly from memory
+ *		(fe. a MappedFile). Characters are classified with a lookup table, and the
+ *		returned tokens point into the buffer, so reading a word does not allocate.
+ *		A Tokenizer has no shared state: different instances can be used on
+ *		different threads.
+ */
+class Tokenizer
+{
+public:
+	// a word in the buffer of the tokenizer, valid until the next call to it
+	struct Token {
+		const char	*str;
+		size_t		len;
+
+		Token() : str(0), len(0) { }
+		bool		empty() const						{ return len == 0; }
+		bool		operator == (const char *s) const	{ return strncmp(str ? str : "", s, len) == 0 && s[len] == 0; }
+		bool		operator != (const char *s) const	{ return !(*this == s); }
+		std::string	toString() const					{ return std::string(str ? str : "", len); }
+	};
+
+private:
+	enum CharClass {
+		WORD_CHAR,
+		SPACE_CHAR,
+		BREAK_CHAR
+	};
+
+	FILE				*m_fp;			// not owned
+	const char			*m_pData;		// the buffer, or the text passed to setInput
+	std::vector<char>	m_buffer;
+	size_t				m_pos;			// next character in m_pData
+	size_t				m_end;			// end of the valid data in m_pData
+	size_t				m_keep;			// start of the word being read, kept when the buffer is refilled
+	long				m_fileEnd;		// file offset of m_pData[m_end]
+	bool				m_bEOF;
+	int					m_nLines;
+	bool				m_bReadWholeLines;
+	bool				m_bSkipComments;
+	unsigned char		m_class[256];
+	std::vector<std::string>	m_lineCommentPrefixes;
+
+	bool	refill();
+	int		get()		{ if (m_pos == m_end && !refill()) { m_bEOF = true; return -1; } return (unsigned char)m_pData[m_pos++]; }
+	void	unget()		{ ASSERT(m_pos > 0); --m_pos; }
+	bool	isComment(const char *str, size_t len) const;
+
+public:
+	Tokenizer(size_t bufferSize = 64*1024);
+
+	void	setInput(FILE *fp);							// reads from the current position of fp
+	void	setInput(const char *data, size_t size);	// text in memory, which is not copied
+	void	reset();		// drop the buffered text: reading continues from the current position of the file
+
+	bool	next(Token &token);		// false at the end of the input
+	bool	nextLine(Token &line);	// the rest of the current line, without the line break
+	bool	eof() const				{ return m_bEOF; }
+	int		getLinesNum() const		{ return m_nLines; }
+	long	getFilePos() const		{ return m_fileEnd - (long)(m_end - m_pos); }	// of the next character
+
+	void	setReadWholeLines(bool bEnable)	{ m_bReadWholeLines = bEnable; }	// skip the rest of the line after each word
+	void	setSkipComments(bool bSkip)		{ m_bSkipComments = bSkip; }
+	void	addLineCommentDef(const std::string& commentStart)	{ m_lineCommentPrefixes.push_back(commentStart); }
+	void	addWordBreakChar(char c)		{ m_class[(unsigned char)c] = BREAK_CHAR; }
+
+	// number parsing with atof/atoi semantics (leading whitespace, parse up to the
+	// first invalid character), that needs no terminating zero
+	static double	toDouble(const char *str, size_t len);
+	static int		toInt(const char *str, size_t len);
+	static double	toDouble(const Token &token)	{ return toDouble(token.str, token.len); }
+	static int		toInt(const Token &token)		{ return toInt(token.str, token.len); }
+};
+
+#endif
@@ -28,12 +28,15 @@
 
 /* includes */
 #include <math.h>
-#include "trackball.h"
-#include <ctime>
+#include "Trackball.h"
+#include "Timer.h"
 
 
 /* globals */
 static GLuint    tb_lasttime;
+
+/* wall-clock msec (clock() is the cpu time of the process), wrapped to an int */
+static int tb_msec() { return (int)fmod(1000.0*Timer::now(), 2147483648.0); }
 static GLfloat   tb_lastposition[3];
 
 static GLfloat   tb_angle = 0.0;
@@ -128,13 +131,13 @@ void Trackball::reshape(int width, int height)
 void Trackball::mouseDown(int x, int y)
 {
 	int button = 1;//TEMP
-	_tbStartMotion(x, y, button, (int)(1000*clock()/CLOCKS_PER_SEC));
+	_tbStartMotion(x, y, button, tb_msec());
 }
 
 void Trackball::mouseUp(int x, int y)
 {
 	int button = 1;//TEMP
-	_tbStopMotion(button, (int)(1000*clock()/CLOCKS_PER_SEC));
+	_tbStopMotion(button, tb_msec());
 }
 
 void Trackball::motion(int x, int y)
@@ -162,7 +165,7 @@ void Trackball::motion(int x, int y)
 				tb_lastposition[1] * current_position[0];
 
 	/* reset for next time */
-	tb_lasttime = (int)(1000*clock()/CLOCKS_PER_SEC);
+	tb_lasttime = tb_msec();
 	tb_lastposition[0] = current_position[0];
 	tb_lastposition[1] = current_position[1];
 	tb_lastposition[2] = current_position[2];
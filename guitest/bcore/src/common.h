@@ -41,14 +41,19 @@
 #endif
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 
 /**
  * OpenGL-relevant includes (opengl, glu32, glaux, glut, glui)
  */
 #include <GL/glew.h>
-#include <GL/wglew.h>
+#ifdef _WIN32
+	#include <GL/wglew.h>
+#endif
 
 //#include <gl\gl.h>	// opengl
 //#include <gl\glu.h>	// glu32
@@ -63,6 +68,8 @@
 #include <vector>
 #include <list>
 #include <string>
+#include <typeinfo>
+#include <stdexcept>	// throw std::runtime_error: std::exception(const char*) is an MSVC extension
 
 /**
  * Some basic 3d structs
@@ -85,17 +92,58 @@
 #define PI 3.14159f
 
 // define integer types with size guarantee
+#ifdef _MSC_VER
 typedef unsigned __int8 uint8_t;
 typedef unsigned __int16 uint16_t;
 typedef unsigned __int32 uint32_t;
+typedef unsigned __int64 uint64_t;
 typedef __int8 int8_t;
 typedef __int16 int16_t;
 typedef __int32 int32_t;
+typedef __int64 int64_t;
+#else
+#include <stdint.h>
+#endif
 
 // define float types with size guarantee (?)
+typedef uint16_t float16_t;		// IEEE half, stored as bits. Convert with Half:: (Half.h)
 typedef float float32_t;
 typedef double float64_t;
 
+// rvalue references (move constructors/assignment) are available from VC10 on
+#if (defined(_MSC_VER) && _MSC_VER >= 1600) || __cplusplus >= 201103L
+	#define BCORE_HAS_RVALUE_REFS
+#endif
+
+/**
+ * The MSVC/win32 names used throughout the code, on other platforms (gcc, posix).
+ * The OS specific parts (threads, file mapping, windows) have their own posix
+ * implementations, in the same files.
+ */
+#ifndef _WIN32
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <hash_map>
+
+	#define __forceinline	inline __attribute__((always_inline))
+	#define _stat			stat
+	#define _getcwd			getcwd
+	#define _fseeki64		fseeko
+	#define _ftelli64		ftello
+	#ifndef INFINITE
+		#define INFINITE	0xFFFFFFFF
+	#endif
+
+	namespace __gnu_cxx {
+		template <> struct hash<std::string> {
+			size_t operator() (const std::string &s) const	{ return __stl_hash_string(s.c_str()); }
+		};
+	};
+	namespace stdext {
+		using __gnu_cxx::hash_map;
+	};
+#endif
+
 /**
  * Some useful enums
  */
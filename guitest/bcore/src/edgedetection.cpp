@@ -25,8 +25,10 @@ void EdgeDetector::sobel(const Image &image, std::vector< Matrix<double> > &grad
 	gradient.resize(nChannels);
 	angle.resize(nChannels);
 	for (size_t c=0; c<nChannels; ++c) {
-		gradient[c] = Matrix<double>(w,h,0);
-		angle[c] = Matrix<double>(w,h,0);
+		gradient[c].create(w,h);
+		gradient[c].fill(0);
+		angle[c].create(w,h);
+		angle[c].fill(0);
 	}
 
 	// run the sobel filter - x and y axis
@@ -54,9 +56,10 @@ void EdgeDetector::sobel(const Image &image, std::vector< Matrix<double> > &grad
 						case Image::I8BITS : img_sample = image.at<uint8_t >(x+i-border, y+j-border, k) / 255.0; break;
 						case Image::I16BITS: img_sample = image.at<uint16_t>(x+i-border, y+j-border, k) / 255.0; break;
 						case Image::I32BITS: img_sample = image.at<uint32_t>(x+i-border, y+j-border, k) / 255.0; break;
+						case Image::F16BITS: img_sample = Half::toFloat(image.at<float16_t>(x+i-border, y+j-border, k)); break;
 						case Image::F32BITS: img_sample = image.at<float32_t>(x+i-border, y+j-border, k); break;
 						case Image::F64BITS: img_sample = image.at<float64_t>(x+i-border, y+j-border, k); break;
-						default: throw std::exception("image format not supported");
+						default: throw std::runtime_error("image format not supported");
 						}
 
 						respX += img_sample * sobX[i][j];
@@ -140,7 +143,7 @@ void EdgeDetector::canny(const Image &image, std::vector< Matrix<double> > &grad
 			}
 
 		// store the gradients after non-max suppression
-		gradient[c] = grad_supr;
+		gradient[c].swap(grad_supr);
 
 		// perform hysterisis thresholding
 	}
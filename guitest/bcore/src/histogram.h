@@ -102,24 +102,24 @@ protected:
 public:
 	ProbHistogram() : m_nTotalValues(0) { }
 	ProbHistogram(const Histogram<T>& h) : m_nTotalValues(0) {
-		m_min=h.getRangeMin(); m_max=h.getRangeMax();
-		m_bins.resize(h.getBinsNum());
-		for (size_t i=0; i<m_bins.size(); ++i) {
-			m_bins[i] = h.getBin(i);
-			m_nTotalValues += m_bins[i];
+		this->m_min=h.getRangeMin(); this->m_max=h.getRangeMax();
+		this->m_bins.resize(h.getBinsNum());
+		for (size_t i=0; i<this->m_bins.size(); ++i) {
+			this->m_bins[i] = h.getBin(i);
+			m_nTotalValues += this->m_bins[i];
 		}
 	}
 
-	void create(int nBins, const T& min, const T& max)		{ Histogram::create(nBins, min, max); m_nTotalValues = 0; }
-	void add(const T& val)		{ Histogram::add(val); m_nTotalValues++; }
+	void create(int nBins, const T& min, const T& max)		{ Histogram<T>::create(nBins, min, max); m_nTotalValues = 0; }
+	void add(const T& val)		{ Histogram<T>::add(val); m_nTotalValues++; }
 
 	double probOfValue(const T& val) const	{
-		ASSERT(m_min!=m_max);
-		int bin = (int)((m_bins.size()-1) * (val - m_min)/(m_max - m_min));
-		return (double)m_bins[bin]/m_nTotalValues;
+		ASSERT(this->m_min!=this->m_max);
+		int bin = (int)((this->m_bins.size()-1) * (val - this->m_min)/(this->m_max - this->m_min));
+		return (double)this->m_bins[bin]/m_nTotalValues;
 	}
 	double probOfBin(size_t bin) const {
-		return (double)m_bins[bin]/m_nTotalValues;
+		return (double)this->m_bins[bin]/m_nTotalValues;
 	}
 };
 
@@ -44,7 +44,7 @@ private:
 		S		value;
 		float	time;
 
-		Item(S& s, float t) : value(s), time(t) { }
+		Item(const S& s, float t) : value(s), time(t) { }
 	};
 	typedef Item<T> tItem;
 
@@ -63,7 +63,7 @@ public:
 	// update to move to the current time.
 	void update(float time)
 	{
-		m_currentValue = valueAt(time);
+		m_curValue = valueAt(time);
 	}
 
 	// get the current value
@@ -71,19 +71,19 @@ public:
 
 	// get the value for an arbitrary time
 	// calculates a value using linear interpolation
-	const T& valueAt(float time) const
+	T valueAt(float time) const
 	{
 		if (time < m_values.front().time)
 			return m_values.front().value;
 		
 		T prevValue = m_values.front().value;
 		float prevTime = m_values.front().time;
-		for (int i=0; i<m_values.size(); ++i)
+		for (size_t i=0; i<m_values.size(); ++i)
 		{
 			if (time < m_values[i].time)
 			{
 				// CHANGEME: interpolate using an arbitrary interpolator as a template arg!!
-				float f = (time - m_values[i].time)/(prevTime - m_values[i].time);
+				float f = (time - prevTime)/(m_values[i].time - prevTime);
 				return (1-f)*prevValue + f*m_values[i].value;
 			}
 			prevValue = m_values[i].value;
@@ -118,7 +118,7 @@ private:
 		S		value;
 		float	time;
 
-		Item(S& s, float t) : value(s), time(t) { }
+		Item(const S& s, float t) : value(s), time(t) { }
 	};
 	typedef Item<T> tItem;
 
@@ -129,9 +129,9 @@ private:
 #endif
 
 public:
-	OblivSequence() :
+	OblivSequence()
 #ifdef _DEBUG
-	  m_lastTime(0)
+	  : m_lastTime(0)
 #endif
 	{
 		m_values.push_back(tItem(T(), 0));
@@ -146,41 +146,24 @@ public:
 	// update to move to the current time.
 	void update(float time)
 	{
+#ifdef _DEBUG
 		ASSERT(time >= m_lastTime);
-		
-		if (time < m_values.front().time)
-			return m_values.front().value;
-		
-		T prevValue = m_values.front().value;
-		float prevTime = m_values.front().time;
-		for (std::list<T>::iterator it=m_values.begin(); it!=m_values.end(); )
-		{
-			tItem &t = (*it);
-			if (time < t.time)
-			{
-				// CHANGEME: interpolate using an arbitrary interpolator as a template arg!!
-				float f = (time - t.time)/(prevTime - t.time);
-				return (1-f)*prevValue + f*t.value;
-			}
-			prevValue = t.value;
-			prevTime = t.time;
-
-			// check if this item should be removed.
-			++it;
-			if (it == m_values.end())
-			{
-				// if this (it-1) is the last element, do not remove
-				// it. Just return the last value.
-				return m_values.back().value;
-			}
-			if ((*it).time < time)
-			{
-				// remove this element
-				--it;
-				it = m_values.erase(it);
-			}
+		m_lastTime = time;
+#endif
+		// discard the items in the past, but keep the last one before 'time' to interpolate from
+		while (m_values.size() > 1 && (++m_values.begin())->time <= time)
+			m_values.pop_front();
+
+		const tItem &prev = m_values.front();
+		if (m_values.size() == 1 || time <= prev.time) {
+			m_curValue = prev.value;
+			return;
 		}
-		return m_values.back().value;
+
+		// CHANGEME: interpolate using an arbitrary interpolator as a template arg!!
+		const tItem &next = *(++m_values.begin());
+		float f = (time - prev.time)/(next.time - prev.time);
+		m_curValue = (1-f)*prev.value + f*next.value;
 	}
 
 	// get the current value
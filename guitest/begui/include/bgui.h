@@ -49,5 +49,9 @@
 #include "../src/ComboBox.h"
 #include "../src/TabContainer.h"
 #include "../src/WindowBuffered.h"
+#include "../src/TiledImageBox.h"
+#include "../src/ProfilerOverlay.h"
+#include "../src/Renderer.h"
+#include "../src/SoftwareRenderer.h"
 
 #endif
\ No newline at end of file
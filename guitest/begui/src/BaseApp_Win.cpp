@@ -24,6 +24,12 @@
 #include "FrameWindow.h"
 #include "Font.h"
 #include "ResourceManager.h"
+#include "../../bcore/src/AsyncTextureLoader.h"
+#include "../../bcore/src/TextureManager.h"
+#include "../../bcore/src/SharedContextLoader.h"
+#include "../../bcore/src/Profiler.h"
+#include "../../bcore/src/TextureBudget.h"
+#include "../../bcore/src/RenderTargetPool.h"
 
 using namespace begui;
 
@@ -45,16 +51,9 @@ bool BaseApp_Win::initialize(const std::string &title, size_t width, size_t heig
 	FrameWindow::Options opt;
 	if (pOpt)
 		opt = *pOpt;
-	else {
-		opt.bOwnDraw = true;
-		opt.bFullScreen = false;
-		opt.nColorBits = 16;
-		opt.nDepthBits = 16;
-		opt.nStencilBits = 0;
-	}
 
 	// Create Our OpenGL Window
-	FrameWindow::createInstance();
+	FrameWindow::createInstance(opt.bHeadless);
 	std::string wnd_style = "std_framewnd";
 	if (opt.windowStyleName.length() > 0)
 		wnd_style = opt.windowStyleName;
@@ -73,6 +72,10 @@ bool BaseApp_Win::initialize(const std::string &title, size_t width, size_t heig
 	if (!onCreate())
 		return false;
 
+	// the fonts and the resources were loading while the application created its
+	// windows. The first frame waits only for what is left of them.
+	SharedContextLoader::inst()->finish();
+
 	// update and render the frame once after creating the window
 	updateFrame();
 	renderFrame();
@@ -82,8 +85,30 @@ bool BaseApp_Win::initialize(const std::string &title, size_t width, size_t heig
 
 void BaseApp_Win::updateFrame()
 {
-	// update all timeseries objects with the current time
-	Updater::inst()->update_all_current_time();
+	PROFILE_FRAME();
+
+	// update all timeseries objects with the current time. Keep rendering frames
+	// while they are animating.
+	bool bAnimating;
+	{
+		PROFILE_ZONE("Updater::update_all");
+		bAnimating = Updater::inst()->update_all_current_time();
+	}
+
+	// upload textures that finished loading in the background, and take over the
+	// objects that the loader thread has created
+	AsyncTextureLoader::inst()->update();
+	TextureManager::update();
+	ResourceManager::inst()->update();
+	SharedContextLoader::inst()->update();
+	if (AsyncTextureLoader::inst()->getQueuedNum() > 0 || SharedContextLoader::inst()->getQueuedNum() > 0)
+		bAnimating = true;	// poll until they are all in
+	FrameScheduler::inst()->setAnimating(bAnimating);
+
+	// keep the textures within the video memory budget, and drop the render
+	// targets that have not been used for a while
+	TextureBudget::inst()->nextFrame();
+	RenderTargetPool::inst()->nextFrame();
 
 	// update the main window
 	FrameWindow::inst()->frameUpdate();
@@ -96,58 +121,46 @@ void BaseApp_Win::renderFrame()
 
 int BaseApp_Win::run()
 {
-	MSG		msg;									// Windows Message Structure
-	BOOL	done=FALSE;								// Bool Variable To Exit Loop
+	FrameWindow *pFrame = FrameWindow::inst();
+	FrameScheduler *pScheduler = FrameScheduler::inst();
 
-	while(!done)									// Loop That Runs While done=FALSE
+	while (true)
 	{
-		// if we are not using synchronous rendering, wait for messages
-		if (!FrameWindow::inst()->useSyncRendering())
-			WaitMessage();
-
-		if (PeekMessage(&msg,NULL,0,0,PM_REMOVE))	// Is There A Message Waiting?
+		// handle all waiting events first. Any of them may change what is displayed.
+		if (!pFrame->processEvents(0))
+			break;
+
+		// without synchronous rendering, or when in the background, frames are only
+		// rendered when needed. Sleep until the next frame is due, or an event arrives.
+		pScheduler->setIdleMode(!pFrame->useSyncRendering() || !pFrame->isActive());
+		double wait = pScheduler->getWaitTime();
+		if (wait != 0)
 		{
-			if (msg.message == 0)
-			{
-				// Draw The Scene.  Watch for Quit Messages From DrawGLScene()
-				if (FrameWindow::inst()->isActive())				// Program Active?
-				{
-					updateFrame();
-					if (FrameWindow::inst()->useSyncRendering())
-						renderFrame();
-				}
+			if (wait < 0) {
+				if (!pFrame->processEvents(-1))
+					break;
 			}
-			if (msg.message==WM_QUIT)				// Have We Received A Quit Message?
-			{
-				done=TRUE;							// If So done=TRUE
-			}
-			else									// If Not, Deal With Window Messages
-			{
-				TranslateMessage(&msg);				// Translate The Message
-				DispatchMessage(&msg);				// Dispatch The Message
-			}
-
-			// update and render the frame after a message is processed
-			updateFrame();
-			renderFrame();
-		}
-		else										// If There Are No Messages
-		{
-			// idle-time rendering. This will be reached only if 
-			// synchronous rendering is used
-			onIdle();
-
-			if (FrameWindow::inst()->isActive())
-			{
-				updateFrame();
-				if (FrameWindow::inst()->useSyncRendering())
-					renderFrame();
+			else if (wait > 0.002) {
+				if (!pFrame->processEvents(wait - 0.001))
+					break;
 			}
+			else
+				FrameScheduler::sleep(wait);
+			continue;
 		}
+
+		onIdle();
+
+		pScheduler->beginFrame();
+		for (size_t i=0; i<pScheduler->getStepsNum(); ++i)
+			onFixedUpdate(pScheduler->getFixedStep());
+		updateFrame();
+		renderFrame();
+		pScheduler->endFrame();
 	}
 
 	// Shutdown
-	FrameWindow::inst()->free();
+	pFrame->free();
 
-	return (msg.wParam);
+	return pFrame->getExitCode();
 }
\ No newline at end of file
@@ -26,10 +26,19 @@
 
 #include "common.h"
 #include "../../bcore/src/RenderPass.h"
+#include "../../bcore/src/FrameScheduler.h"
 #include "FrameWindow.h"
 
 namespace begui {
 
+/**
+ * BaseApp_Win: the main loop of an application. Frames are scheduled by the
+ *		FrameScheduler: with synchronous rendering, they are rendered continuously
+ *		at the target frame rate while the window is active; otherwise only after
+ *		events, or while something is animating. Between frames, the loop sleeps until the next frame is due or
+ *		a message arrives. The events come from FrameWindow::processEvents, so the
+ *		loop is the same on all platforms (the name is historical).
+ */
 class BaseApp_Win
 {
 private:
@@ -42,12 +51,16 @@ public:
 	virtual int run();
 	
 	void setSyncRendering(bool bSyncRendering)	{ FrameWindow::inst()->setSyncRendering(bSyncRendering); }
+	void setTargetFPS(double fps)				{ FrameScheduler::inst()->setTargetFPS(fps); }	// 0: as fast as possible
+	bool setVSync(bool bVSync)					{ return FrameWindow::inst()->setVSync(bVSync); }
+	const FrameScheduler::Stats& getFrameStats() const	{ return FrameScheduler::inst()->getStats(); }
 
 	static BaseApp_Win* inst()	{ if (!m_pInst) m_pInst = new BaseApp_Win(); return m_pInst; }
 
 	// overridables
 	virtual bool onCreate() { return true; }
 	virtual void onIdle()	{ }
+	virtual void onFixedUpdate(double dt)	{ }	// called at a constant rate (FrameScheduler::setFixedStep), before updateFrame
 
 protected:
 	BaseApp_Win();
@@ -25,6 +25,43 @@
 
 using namespace begui;
 
+namespace {
+
+// the properties of a button style, resolved once for all buttons of that style
+struct ButtonStyle : public ResourceManager::StyleBinding {
+	ResourceManager::ImageRef	faceUp, faceHover, faceDown;
+	bool		bHover, bDown, bActiveArea;
+	Rect<int>	resizableArea, activeArea;
+	int			defaultWidth, defaultHeight;	// -1 if not given
+
+	void bind(const ResourceManager::Style &style) {
+		static const ResourceManager::PropId FACE_UP = ResourceManager::propId("face_up");
+		static const ResourceManager::PropId FACE_HOVER = ResourceManager::propId("face_hover");
+		static const ResourceManager::PropId FACE_DOWN = ResourceManager::propId("face_down");
+		static const ResourceManager::PropId RESIZABLE_AREA = ResourceManager::propId("resizable_area");
+		static const ResourceManager::PropId ACTIVE_AREA = ResourceManager::propId("active_area");
+		static const ResourceManager::PropId DEFAULT_WIDTH = ResourceManager::propId("default_width");
+		static const ResourceManager::PropId DEFAULT_HEIGHT = ResourceManager::propId("default_height");
+
+		faceUp = ResourceManager::inst()->loadImage(style.get_img(FACE_UP));
+		bHover = style.hasProp(FACE_HOVER);
+		if (bHover)
+			faceHover = ResourceManager::inst()->loadImage(style.get_img(FACE_HOVER));
+		bDown = style.hasProp(FACE_DOWN);
+		if (bDown)
+			faceDown = ResourceManager::inst()->loadImage(style.get_img(FACE_DOWN));
+		ASSERT(style.hasProp(RESIZABLE_AREA));
+		resizableArea = style.get_rect(RESIZABLE_AREA);
+		bActiveArea = style.hasProp(ACTIVE_AREA);
+		if (bActiveArea)
+			activeArea = style.get_rect(ACTIVE_AREA);
+		defaultWidth = style.hasProp(DEFAULT_WIDTH) ? style.get_i(DEFAULT_WIDTH) : -1;
+		defaultHeight = style.hasProp(DEFAULT_HEIGHT) ? style.get_i(DEFAULT_HEIGHT) : -1;
+	}
+};
+
+};
+
 Button::Button() : 
 	m_id(-1),
 	m_status(Button::UP),
@@ -45,13 +82,13 @@ Button::Button() :
 {
 }
 
-void Button::create(int x, int y, const std::string &title, int id, Functor1<int> &callback, 
+void Button::create(int x, int y, const std::string &title, int id, const Functor1<int> &callback, 
 				const std::string &style_name)
 {
 	create(x,y, 0,0, title, id, callback, style_name);
 }
 
-void Button::create(int x, int y, int w, int h, const std::string &title, int id, Functor1<int> &callback, 
+void Button::create(int x, int y, int w, int h, const std::string &title, int id, const Functor1<int> &callback, 
 				const std::string &style_name)
 {
 	m_title = title;
@@ -63,18 +100,18 @@ void Button::create(int x, int y, int w, int h, const std::string &title, int id
 	m_top = y;
 
 	// load the rest of the properties from the property manager
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("Button").style(style_name);
-	setFace(UP, ResourceManager::inst()->loadImage(style.get_img("face_up")));
-	if (style.hasProp("face_hover"))
-		setFace(MOUSE_OVER, ResourceManager::inst()->loadImage(style.get_img("face_hover")));
-	if (style.hasProp("face_down"))
-		setFace(DOWN, ResourceManager::inst()->loadImage(style.get_img("face_down")));
-	ASSERT(style.hasProp("resizable_area"));
-	m_resizableArea = style.get_rect("resizable_area");
+	static ResourceManager::BoundStyle<ButtonStyle> styles("Button");
+	const ButtonStyle &style = styles.get(style_name);
+	setFace(UP, style.faceUp);
+	if (style.bHover)
+		setFace(MOUSE_OVER, style.faceHover);
+	if (style.bDown)
+		setFace(DOWN, style.faceDown);
+	m_resizableArea = style.resizableArea;
 	
 	// get the button's active area
-	if (style.hasProp("active_area"))
-		m_activeArea = style.get_rect("active_area");
+	if (style.bActiveArea)
+		m_activeArea = style.activeArea;
 	else
 		m_activeArea = Rect<int>(0,0,m_faces[UP].m_width, m_faces[UP].m_height);
 
@@ -84,8 +121,8 @@ void Button::create(int x, int y, int w, int h, const std::string &title, int id
 		m_right = x + w;
 	}
 	else {
-		if (style.hasProp("default_width"))
-			m_right = x+style.get_i("default_width")-borders.left-borders.right;
+		if (style.defaultWidth >= 0)
+			m_right = x+style.defaultWidth-borders.left-borders.right;
 		else if (title.length() > 0)
 		{
 			m_bAutoSzX = true;
@@ -107,10 +144,10 @@ void Button::create(int x, int y, int w, int h, const std::string &title, int id
 		m_bottom = y+h;
 	}
 	else {
-		if (style.hasProp("default_height"))
+		if (style.defaultHeight >= 0)
 		{
 			m_bAutoSzY = true;
-			int default_height = style.get_i("default_height")-borders.top-borders.bottom;
+			int default_height = style.defaultHeight-borders.top-borders.bottom;
 			m_bottom = y+default_height;
 		}
 		else {
@@ -138,8 +175,7 @@ void Button::onUpdate()
 
 void Button::onRender()
 {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	display::enableBlending(true);
 	
 	int w = getWidth();
 	int h = getHeight();
@@ -155,17 +191,17 @@ void Button::onRender()
 	else
 		btn_face = m_faces[Button::UP];
 
-	btn_face.m_texture->set();
+	display::bindTexture(btn_face.m_texture);
 	//w = btn_face.m_width;
 	//h = btn_face.m_height;
 
 	float offs = 0.0f;
 	if (m_status == Button::INACTIVE)
-		glColor4f(m_btnColor.r, m_btnColor.g, m_btnColor.b, 0.5);
+		display::setColor(m_btnColor.r, m_btnColor.g, m_btnColor.b, 0.5);
 	else if (m_status == Button::MOUSE_OVER && !m_faces[m_status].m_texture)
-		glColor4f(m_btnColor.r, m_btnColor.g, m_btnColor.b, 0.8f);
+		display::setColor(m_btnColor.r, m_btnColor.g, m_btnColor.b, 0.8f);
 	else
-		glColor4f(m_btnColor.r, m_btnColor.g, m_btnColor.b, 1);
+		display::setColor(m_btnColor.r, m_btnColor.g, m_btnColor.b, 1);
 	if (m_status == Button::DOWN && !m_faces[m_status].m_texture)
 		offs = 1.0f;
 
@@ -198,14 +234,14 @@ void Button::onRender()
 		Component::drawImage(m_icon, ix, iy, iw, ih);
 	}
 	
-	glDisable(GL_BLEND);
-	glBindTexture(GL_TEXTURE_2D, 0);
+	display::enableBlending(false);
+	display::bindTexture(0);
 
 	// render the text
 	if (m_status == Button::INACTIVE)
-		glColor3f(m_inactiveTextColor.r, m_inactiveTextColor.g, m_inactiveTextColor.b);
+		display::setColor(m_inactiveTextColor.r, m_inactiveTextColor.g, m_inactiveTextColor.b);
 	else
-		glColor3f(m_textColor.r, m_textColor.g, m_textColor.b);
+		display::setColor(m_textColor.r, m_textColor.g, m_textColor.b);
 	Font::renderString(centerx - title_w/2 + iw/2, centery+4, m_title);
 }
 
@@ -73,22 +73,22 @@ private:
 public:
 	Button();
 
-	void create(int x, int y, const std::string &title, int id, Functor1<int> &callback = Functor1<int>(), 
+	void create(int x, int y, const std::string &title, int id, const Functor1<int> &callback = Functor1<int>(), 
 				const std::string &style = "std");
 	void create(int x, int y, int w, int h, const std::string &title, int id, 
-				Functor1<int> &callback = Functor1<int>(), 
+				const Functor1<int> &callback = Functor1<int>(), 
 				const std::string &style = "std");
 
 	virtual void onUpdate();
 	virtual void onRender();
 
 	// event hooks
-	void	handleClick(Functor1<int> &callback)						{ m_onClick = callback; }
-	void	handleDragStart(Functor1<int> &callback)					{ m_onDragStart = callback; }
-	void	handleDragEnd(Functor1<int> &callback)						{ m_onDragEnd = callback; }
-	void	handleButtonDown(Functor2<int, const Vector2i&> &callback)	{ m_onButtonDown = callback; }
-	void	handleButtonUp(Functor2<int, const Vector2i&> &callback)	{ m_onButtonUp = callback; }
-	void	handleDrag(Functor2<int, const Vector2i&> &callback)		{ m_onButtonDrag = callback; }
+	void	handleClick(const Functor1<int> &callback)						{ m_onClick = callback; }
+	void	handleDragStart(const Functor1<int> &callback)					{ m_onDragStart = callback; }
+	void	handleDragEnd(const Functor1<int> &callback)						{ m_onDragEnd = callback; }
+	void	handleButtonDown(const Functor2<int, const Vector2i&> &callback)	{ m_onButtonDown = callback; }
+	void	handleButtonUp(const Functor2<int, const Vector2i&> &callback)	{ m_onButtonUp = callback; }
+	void	handleDrag(const Functor2<int, const Vector2i&> &callback)		{ m_onButtonDrag = callback; }
 
 	virtual	void	setState(State state)										{ m_status = state; }
 	virtual	State	getState() const											{ return m_status; }
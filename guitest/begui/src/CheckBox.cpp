@@ -23,6 +23,7 @@
 #include "Font.h"
 #include "ResourceManager.h"
 #include "Container.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -45,7 +46,7 @@ void CheckBox::create(int x, int y, const std::string &title, int id, const Func
 	m_bHover = false;
 
 	// load the rest of the properties from the property manager
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("CheckBox").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("CheckBox").style(style_name);
 	ASSERT(style.hasProp("unchecked_face"));
 	m_faceUnchecked = ResourceManager::inst()->loadImage(style.get_img("unchecked_face"));
 	ASSERT(style.hasProp("checked_face"));
@@ -64,15 +65,15 @@ void CheckBox::onUpdate()
 
 void CheckBox::onRender()
 {
-	glEnable(GL_BLEND);
+	display::enableBlending(true);
 
 	// render the icon
 	if (!isEnabled())
-		glColor4f(1.0f,1.0f,1.0f,0.5f);
+		display::setColor(1.0f,1.0f,1.0f,0.5f);
 	else if (m_bHover)
-		glColor4f(1.0f,1.0f,1.0f,0.8f);
+		display::setColor(1.0f,1.0f,1.0f,0.8f);
 	else
-		glColor4f(1,1,1,1);
+		display::setColor(1,1,1,1);
 	if (m_state == true) {
 		Component::drawImage(m_faceChecked, 0, 0);
 	}
@@ -81,9 +82,9 @@ void CheckBox::onRender()
 	}
 
 	// render the text
-	glColor4f(0.3f,0.3f,0.3f,1);
+	display::setColor(0.3f,0.3f,0.3f,1);
 	if (!isEnabled())
-		glColor4f(0.6f, 0.6f, 0.6f, 0.5f);
+		display::setColor(0.6f, 0.6f, 0.6f, 0.5f);
 	Font::renderString(m_faceChecked.m_width+3, getHeight() - (m_faceChecked.m_height - m_activeArea.bottom)-1, m_title);
 }
 
@@ -22,6 +22,7 @@
 #include "ComboBox.h"
 #include "Font.h"
 #include "ResourceManager.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -37,7 +38,7 @@ ComboBox::~ComboBox()
 void ComboBox::create(int x, int y, int width, int list_height, const std::string &style_name)
 {
 	// load the combo box style sheet
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("ComboBox").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("ComboBox").style(style_name);
 	m_face = ResourceManager::inst()->loadImage(style.get_img("face"));
 	m_expandIcon = ResourceManager::inst()->loadImage(style.get_img("expand_icon"));
 	m_activeArea = style.get_rect("active_area");
@@ -81,8 +82,8 @@ void ComboBox::onRender()
 	ASSERT(pFont);
 	int lineHeight = pFont->getLineHeight()+2;
 	
-	glEnable(GL_BLEND);
-	glColor4f(1,1,1,1);
+	display::enableBlending(true);
+	display::setColor(1,1,1,1);
 
 	// draw the background
 	Component::drawImageWtBorders(m_face, -m_activeArea.left, -m_activeArea.top,
@@ -94,7 +95,7 @@ void ComboBox::onRender()
 	Component::drawImage(m_expandIcon, getWidth() - m_expandIcon.m_width - 5,
 		getHeight()/2 - m_expandIcon.m_height/2);
 
-	glColor4f(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 1.0f);
+	display::setColor(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 1.0f);
 	pFont->renderString(m_textPos.x, m_textPos.y, m_text);
 }
 
@@ -21,6 +21,8 @@
 
 #include "Component.h"
 #include "util.h"
+#include "../../bcore/src/Profiler.h"
+#include <typeinfo>
 
 using namespace begui;
 
@@ -76,61 +78,62 @@ void Component::drawBorderedQuad(int l, int t, int r, int b,		// position to app
 						float texL, float texLB, float texR, float texRB,	// left to right positions in tex
 						float texT, float texTB, float texB, float texBB)	// top to bottom
 {	
-	glBegin(GL_QUADS);
+	PROFILE_COUNT(VERTICES, 36);
+	display::startBatch(display::QUADS);
 		// top-left corner
-		glTexCoord2f(texL, texT);	glVertex3f((float)l, (float)t, 0);
-		glTexCoord2f(texLB, texT);	glVertex3f((float)lB, (float)t, 0);
-		glTexCoord2f(texLB, texTB);	glVertex3f((float)lB, (float)tB, 0);
-		glTexCoord2f(texL, texTB);	glVertex3f((float)l, (float)tB, 0);
+		display::texCoord(texL, texT);	display::vertex((float)l, (float)t);
+		display::texCoord(texLB, texT);	display::vertex((float)lB, (float)t);
+		display::texCoord(texLB, texTB);	display::vertex((float)lB, (float)tB);
+		display::texCoord(texL, texTB);	display::vertex((float)l, (float)tB);
 		
 		// top border
-		glTexCoord2f(texLB, texT);	glVertex3f((float)lB, (float)t, 0);
-		glTexCoord2f(texRB, texT);	glVertex3f((float)rB, (float)t, 0);
-		glTexCoord2f(texRB, texTB);	glVertex3f((float)rB, (float)tB, 0);
-		glTexCoord2f(texLB, texTB);	glVertex3f((float)lB, (float)tB, 0);
+		display::texCoord(texLB, texT);	display::vertex((float)lB, (float)t);
+		display::texCoord(texRB, texT);	display::vertex((float)rB, (float)t);
+		display::texCoord(texRB, texTB);	display::vertex((float)rB, (float)tB);
+		display::texCoord(texLB, texTB);	display::vertex((float)lB, (float)tB);
 
 		// top-right corner
-		glTexCoord2f(texRB, texT);	glVertex3f((float)rB, (float)t, 0);
-		glTexCoord2f(texR, texT);	glVertex3f((float)r, (float)t, 0);
-		glTexCoord2f(texR, texTB);	glVertex3f((float)r, (float)tB, 0);
-		glTexCoord2f(texRB, texTB);	glVertex3f((float)rB, (float)tB, 0);
+		display::texCoord(texRB, texT);	display::vertex((float)rB, (float)t);
+		display::texCoord(texR, texT);	display::vertex((float)r, (float)t);
+		display::texCoord(texR, texTB);	display::vertex((float)r, (float)tB);
+		display::texCoord(texRB, texTB);	display::vertex((float)rB, (float)tB);
 
 		// left border
-		glTexCoord2f(texL, texTB);	glVertex3f((float)l, (float)tB, 0);
-		glTexCoord2f(texLB, texTB);	glVertex3f((float)lB, (float)tB, 0);
-		glTexCoord2f(texLB, texBB);	glVertex3f((float)lB, (float)bB, 0);
-		glTexCoord2f(texL, texBB);	glVertex3f((float)l, (float)bB, 0);
+		display::texCoord(texL, texTB);	display::vertex((float)l, (float)tB);
+		display::texCoord(texLB, texTB);	display::vertex((float)lB, (float)tB);
+		display::texCoord(texLB, texBB);	display::vertex((float)lB, (float)bB);
+		display::texCoord(texL, texBB);	display::vertex((float)l, (float)bB);
 
 		// center area
-		glTexCoord2f(texLB, texTB);	glVertex3f((float)lB, (float)tB, 0);
-		glTexCoord2f(texRB, texTB);	glVertex3f((float)rB, (float)tB, 0);
-		glTexCoord2f(texRB, texBB);	glVertex3f((float)rB, (float)bB, 0);
-		glTexCoord2f(texLB, texBB);	glVertex3f((float)lB, (float)bB, 0);
+		display::texCoord(texLB, texTB);	display::vertex((float)lB, (float)tB);
+		display::texCoord(texRB, texTB);	display::vertex((float)rB, (float)tB);
+		display::texCoord(texRB, texBB);	display::vertex((float)rB, (float)bB);
+		display::texCoord(texLB, texBB);	display::vertex((float)lB, (float)bB);
 
 		// right border
-		glTexCoord2f(texRB, texTB);	glVertex3f((float)rB, (float)tB, 0);
-		glTexCoord2f(texR, texTB);	glVertex3f((float)r, (float)tB, 0);
-		glTexCoord2f(texR, texBB);	glVertex3f((float)r, (float)bB, 0);
-		glTexCoord2f(texRB, texBB);	glVertex3f((float)rB, (float)bB, 0);
+		display::texCoord(texRB, texTB);	display::vertex((float)rB, (float)tB);
+		display::texCoord(texR, texTB);	display::vertex((float)r, (float)tB);
+		display::texCoord(texR, texBB);	display::vertex((float)r, (float)bB);
+		display::texCoord(texRB, texBB);	display::vertex((float)rB, (float)bB);
 
 		// bottom-left corner
-		glTexCoord2f(texL, texBB);	glVertex3f((float)l, (float)bB, 0);
-		glTexCoord2f(texLB, texBB);	glVertex3f((float)lB, (float)bB, 0);
-		glTexCoord2f(texLB, texB);	glVertex3f((float)lB, (float)b, 0);
-		glTexCoord2f(texL, texB);	glVertex3f((float)l, (float)b, 0);
+		display::texCoord(texL, texBB);	display::vertex((float)l, (float)bB);
+		display::texCoord(texLB, texBB);	display::vertex((float)lB, (float)bB);
+		display::texCoord(texLB, texB);	display::vertex((float)lB, (float)b);
+		display::texCoord(texL, texB);	display::vertex((float)l, (float)b);
 
 		// bottom border
-		glTexCoord2f(texLB, texBB);	glVertex3f((float)lB, (float)bB, 0);
-		glTexCoord2f(texRB, texBB);	glVertex3f((float)rB, (float)bB, 0);
-		glTexCoord2f(texRB, texB);	glVertex3f((float)rB, (float)b, 0);
-		glTexCoord2f(texLB, texB);	glVertex3f((float)lB, (float)b, 0);
+		display::texCoord(texLB, texBB);	display::vertex((float)lB, (float)bB);
+		display::texCoord(texRB, texBB);	display::vertex((float)rB, (float)bB);
+		display::texCoord(texRB, texB);	display::vertex((float)rB, (float)b);
+		display::texCoord(texLB, texB);	display::vertex((float)lB, (float)b);
 
 		// bottom-right corner
-		glTexCoord2f(texRB, texBB);	glVertex3f((float)rB, (float)bB, 0);
-		glTexCoord2f(texR, texBB);	glVertex3f((float)r, (float)bB, 0);
-		glTexCoord2f(texR, texB);	glVertex3f((float)r, (float)b, 0);
-		glTexCoord2f(texRB, texB);	glVertex3f((float)rB, (float)b, 0);
-	glEnd();
+		display::texCoord(texRB, texBB);	display::vertex((float)rB, (float)bB);
+		display::texCoord(texR, texBB);	display::vertex((float)r, (float)bB);
+		display::texCoord(texR, texB);	display::vertex((float)r, (float)b);
+		display::texCoord(texRB, texB);	display::vertex((float)rB, (float)b);
+	display::endBatch();
 }
 
 void Component::getFocus()
@@ -198,51 +201,53 @@ bool Component::isPtInside(int x, int y)
 void Component::frameRender()
 {
 	// transform the parent coordinate system to the local one
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glTranslatef((float)m_left, (float)m_top, 0);
+	display::pushTranslation((float)m_left, (float)m_top);
 	
 	// Render the component
-	onRender();
+	{
+		PROFILE_ZONE(typeid(*this).name());
+		onRender();
+	}
 
 	// Reset the coordinate system
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
+	display::popTranslation();
 }
 
 void Component::frameUpdate()
 {
+	PROFILE_ZONE(typeid(*this).name());
 	onUpdate();
 }
 
 void Component::drawImage(ResourceManager::ImageRef &image, int x, int y, int w, int h)
 {
 	ASSERT(image.m_texture);
-	image.m_texture->set();
+	display::bindTexture(image.m_texture);
 
 	if (w <= 0)
 		w = image.m_width;
 	if (h <= 0)
 		h = image.m_height;
-	glBegin(GL_QUADS);
-		glTexCoord2f(image.m_topLeft.x, image.m_topLeft.y);
-		glVertex3f((float)x, (float)y, 0);
-		glTexCoord2f(image.m_bottomRight.x, image.m_topLeft.y);
-		glVertex3f((float)(x+w), (float)y, 0);
-		glTexCoord2f(image.m_bottomRight.x, image.m_bottomRight.y);
-		glVertex3f((float)(x+w), (float)(y+h), 0);
-		glTexCoord2f(image.m_topLeft.x, image.m_bottomRight.y);
-		glVertex3f((float)x, (float)(y+h), 0);
-	glEnd();
+	PROFILE_COUNT(VERTICES, 4);
+	display::startBatch(display::QUADS);
+		display::texCoord(image.m_topLeft.x, image.m_topLeft.y);
+		display::vertex((float)x, (float)y);
+		display::texCoord(image.m_bottomRight.x, image.m_topLeft.y);
+		display::vertex((float)(x+w), (float)y);
+		display::texCoord(image.m_bottomRight.x, image.m_bottomRight.y);
+		display::vertex((float)(x+w), (float)(y+h));
+		display::texCoord(image.m_topLeft.x, image.m_bottomRight.y);
+		display::vertex((float)x, (float)(y+h));
+	display::endBatch();
 	
-	glDisable(GL_TEXTURE_2D);
+	display::enableTexture(0, false);
 }
 
 void Component::drawImageWtBorders(begui::ResourceManager::ImageRef &image, int x, int y, 
 								   int w, int h, const Rect<int> &resizable_area)
 {
 	ASSERT(image.m_texture);
-	image.m_texture->set();
+	display::bindTexture(image.m_texture);
 
 	if (w <= 0)
 		w = image.m_width;
@@ -261,7 +266,7 @@ void Component::drawImageWtBorders(begui::ResourceManager::ImageRef &image, int
 		image.m_topLeft.y, image.m_topLeft.y + (float)resizable_area.top/image.m_texture->getHeight(),
 		image.m_bottomRight.y, image.m_topLeft.y + (float)resizable_area.bottom/image.m_texture->getHeight());
 	
-	glDisable(GL_TEXTURE_2D);
+	display::enableTexture(0, false);
 }
 
 float Component::getHierarchyAlpha() const
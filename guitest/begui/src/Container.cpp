@@ -20,6 +20,9 @@
 */
 
 #include "Container.h"
+#include "Display.h"
+#include "../../bcore/src/Profiler.h"
+#include <typeinfo>
 
 using namespace begui;
 
@@ -33,6 +36,7 @@ Container::~Container()
 
 void Container::frameUpdate()
 {
+	PROFILE_ZONE(typeid(*this).name());
 	onUpdate();
 
 	// update children too
@@ -46,10 +50,10 @@ void Container::frameUpdate()
 void Container::frameRender()
 {
 	// Change the coordinate system to the local one
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glTranslatef((float)m_left, (float)m_top, 0);
+	display::pushTranslation((float)m_left, (float)m_top);
 	
+	PROFILE_ZONE(typeid(*this).name());
+
 	// Render the container itself
 	onRender();
 	
@@ -66,21 +70,20 @@ void Container::frameRender()
 	// show the modal component, if any
 	if (m_pModalComponent && m_pModalComponent->isVisible())
 	{
-		glEnable(GL_BLEND);
-		glColor4f(0,0,0, 0.5f);
-		glBegin(GL_QUADS);
-			glVertex2f(0, 0);
-			glVertex2f((float)getWidth(), 0);
-			glVertex2f((float)getWidth(), (float)getHeight());
-			glVertex2f(0, (float)getHeight());
-		glEnd();
+		display::enableBlending(true);
+		display::setColor(0,0,0, 0.5f);
+		display::startBatch(display::QUADS);
+			display::vertex(0, 0);
+			display::vertex((float)getWidth(), 0);
+			display::vertex((float)getWidth(), (float)getHeight());
+			display::vertex(0, (float)getHeight());
+		display::endBatch();
 
 		m_pModalComponent->frameRender();
 	}
 
 	// Reset the coordinate system
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
+	display::popTranslation();
 }
 
 bool Container::onMouseDown(int x, int y, int button)
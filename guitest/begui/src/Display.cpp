@@ -21,9 +21,15 @@
 
 #include "util.h"
 #include "FrameWindow.h"
+#include "Renderer.h"
+#include "../../bcore/src/Profiler.h"
 
 using namespace begui;
 
+// the active renderer
+GLRenderer	g_glRenderer;
+Renderer	*g_pRenderer = &g_glRenderer;
+
 // display dimensions
 int	g_displayWidth = 0;
 int g_displayHeight = 0;
@@ -53,6 +59,16 @@ void display::setSize(int w, int h)
 	g_displayHeight = h;
 }
 
+void display::setRenderer(Renderer *pRenderer)
+{
+	g_pRenderer = (pRenderer) ? pRenderer : &g_glRenderer;
+}
+
+Renderer* display::getRenderer()
+{
+	return g_pRenderer;
+}
+
 // Mask the screen except this given rectangle. Any
 // rendering after this call will be restricted only within
 // this rectangle
@@ -91,8 +107,8 @@ void display::pushMask(int x, int y, int w, int h, bool ignoreParent)
 
 	// set the new mask
 	g_maskStack.push_back(rect);
-	glScissor(rect.left, rect.top, rect.getWidth(), rect.getHeight());
-	glEnable(GL_SCISSOR_TEST);
+	PROFILE_COUNT(SCISSOR_CHANGES, 1);
+	g_pRenderer->setScissor(&rect);
 }
 
 // Remove any previous masks. Rendering can be done anywhere
@@ -101,14 +117,13 @@ void display::popMask()
 {
 	if (g_maskStack.size() > 0)
 		g_maskStack.pop_back();
+	PROFILE_COUNT(SCISSOR_CHANGES, 1);
 
 	if (g_maskStack.size() == 0)
-		glDisable(GL_SCISSOR_TEST);
+		g_pRenderer->setScissor(0);
 	else {
 		// load the previous mask
-		Rect<int> &rect = g_maskStack.back();	
-		glScissor(rect.left, rect.top, rect.getWidth(), rect.getHeight());
-		glEnable(GL_SCISSOR_TEST);
+		g_pRenderer->setScissor(&g_maskStack.back());
 	}
 }
 
@@ -120,4 +135,84 @@ void display::pushRefFrame(int x, int y, int w, int h)
 void display::popRefFrame()
 {
 	g_refFrameStack.pop_back();
+}
+
+void display::clear()
+{
+	g_pRenderer->clear();
+}
+
+void display::startBatch(PrimitiveType prim)
+{
+	g_pRenderer->startBatch(prim);
+}
+
+void display::endBatch()
+{
+	g_pRenderer->endBatch();
+}
+
+void display::vertex(float x, float y)
+{
+	g_pRenderer->vertex(x, y);
+}
+
+void display::vertex(const Vector2& pos, const Vector2 *uv, const Color *color)
+{
+	if (uv)
+		g_pRenderer->texCoord((float)uv->x, (float)uv->y);
+	if (color)
+		g_pRenderer->setColor(color->r, color->g, color->b, 1.0f);
+	g_pRenderer->vertex((float)pos.x, (float)pos.y);
+}
+
+void display::texCoord(float u, float v)
+{
+	g_pRenderer->texCoord(u, v);
+}
+
+void display::setColor(float r, float g, float b, float a)
+{
+	g_pRenderer->setColor(r, g, b, a);
+}
+
+void display::setColor(const Color &cl, float a)
+{
+	g_pRenderer->setColor(cl.r, cl.g, cl.b, a);
+}
+
+void display::enableBlending(bool bEnable)
+{
+	g_pRenderer->enableBlending(bEnable);
+}
+
+void display::enableTexture(int texlevel, bool bEnable)
+{
+	ASSERT(texlevel == 0);	// only one texture unit is used by the gui
+	g_pRenderer->enableTexture(bEnable);
+}
+
+void display::bindTexture(Texture *pTex)
+{
+	g_pRenderer->bindTexture(pTex);
+}
+
+void display::pushState()
+{
+	g_pRenderer->pushState();
+}
+
+void display::popState()
+{
+	g_pRenderer->popState();
+}
+
+void display::pushTranslation(float x, float y)
+{
+	g_pRenderer->pushTranslation(x, y);
+}
+
+void display::popTranslation()
+{
+	g_pRenderer->popTranslation();
 }
\ No newline at end of file
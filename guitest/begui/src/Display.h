@@ -27,8 +27,15 @@
 
 namespace begui {
 
+class Renderer;
+
 namespace display
 {
+	// the backend that executes the rendering commands. By default
+	// this is a GLRenderer, drawing in the current OpenGL context.
+	void setRenderer(Renderer *pRenderer);	// 0 restores the default renderer
+	Renderer* getRenderer();
+
 	// Mask the screen except this given rectangle. Any
 	// rendering after this call will be restricted only within
 	// this rectangle
@@ -57,11 +64,23 @@ namespace display
 	void clear();	// clears the screen
 	void startBatch(PrimitiveType prim);
 	void endBatch();
+	void vertex(float x, float y);
 	void vertex(const Vector2& pos, const Vector2 *uv = 0, const Color *color = 0);
-	void setColor(float r, float g, float b, float a);
+	void texCoord(float u, float v);
+	void setColor(float r, float g, float b, float a = 1.0f);
 	void setColor(const Color &cl, float a);
 	void enableBlending(bool bEnable);
 	void enableTexture(int texlevel, bool bEnable);
+	void bindTexture(Texture *pTex);	// binds and enables the texture, 0 unbinds it
+
+	// save/restore texture and blending states
+	void pushState();
+	void popState();
+
+	// translation of the coordinate system, used to go to the
+	// local coordinates of a component
+	void pushTranslation(float x, float y);
+	void popTranslation();
 };
 
 };
@@ -22,7 +22,7 @@ EditableText::EditableText() : m_bMultiLine(true), m_cursorX(0), m_cursorY(0),
 	m_cursorAlpha.push_back(0.8f, 0.8);
 	m_cursorAlpha.push_back(0, 1);
 	m_cursorAlpha.set_loop(true);
-	m_cursorAlpha.set_interpolation(TimeSeries<float>::Interpolation::LINEAR);
+	m_cursorAlpha.set_interpolation(TimeSeries<float>::LINEAR);
 	m_cursorAlpha.start();
 }
 
@@ -73,8 +73,8 @@ void EditableText::renderString()
 	// render the background for each selected character
 	if (m_bTextSelectable)
 	{
-		glColor4f(m_selectionColor.r, m_selectionColor.g, m_selectionColor.b, m_selectionAlpha);
-		glBegin(GL_QUADS);
+		display::setColor(m_selectionColor.r, m_selectionColor.g, m_selectionColor.b, m_selectionAlpha);
+		display::startBatch(display::QUADS);
 		int selStart = m_selectStart, selEnd = m_selectEnd;
 		if (selStart > selEnd) {
 			selStart = m_selectEnd;
@@ -83,12 +83,12 @@ void EditableText::renderString()
 		for (int i = selStart; i<selEnd; ++i) {
 			// highlight this character
 			Rect<int> &pos = m_charPos[i];
-			glVertex2f((float)pos.left-1, (float)pos.top-1);
-			glVertex2f((float)pos.right, (float)pos.top-1);
-			glVertex2f((float)pos.right, (float)pos.bottom);
-			glVertex2f((float)pos.left-1, (float)pos.bottom);
+			display::vertex((float)pos.left-1, (float)pos.top-1);
+			display::vertex((float)pos.right, (float)pos.top-1);
+			display::vertex((float)pos.right, (float)pos.bottom);
+			display::vertex((float)pos.left-1, (float)pos.bottom);
 		}
-		glEnd();
+		display::endBatch();
 	}
 
 	// if text should be hidden (password field) replace text with *
@@ -101,7 +101,7 @@ void EditableText::renderString()
 	// TODO: render each character separately if text has been changed, otherwise
 	// use a display list to speed things up
 	m_charPos.clear();
-	glColor4f(m_textColor.r, m_textColor.g, m_textColor.b, m_textAlpha);
+	display::setColor(m_textColor.r, m_textColor.g, m_textColor.b, m_textAlpha);
 	if (m_bMultiLine)
 		FontManager::getCurFont()->renderStringMultiline(m_x, m_y+lineHeight, m_lineWidth, text, &m_charPos, true);
 	else
@@ -110,11 +110,11 @@ void EditableText::renderString()
 	// render the cursor
 	if (m_bEditable && m_bRenderCursor)
 	{
-		glColor4f(m_cursorColor.r, m_cursorColor.g, m_cursorColor.b, m_cursorAlpha);
-		glBegin(GL_LINES);
-			glVertex2f((float)m_cursorX, (float)m_cursorY);
-			glVertex2f((float)m_cursorX, (float)m_cursorY-10);
-		glEnd();
+		display::setColor(m_cursorColor.r, m_cursorColor.g, m_cursorColor.b, m_cursorAlpha);
+		display::startBatch(display::LINES);
+			display::vertex((float)m_cursorX, (float)m_cursorY);
+			display::vertex((float)m_cursorX, (float)m_cursorY-10);
+		display::endBatch();
 	}
 }
 
@@ -22,6 +22,7 @@
 #include "Font.h"
 #include "util.h"
 #include "../../bcore/src/Image.h"
+#include "../../bcore/src/Profiler.h"
 
 using namespace begui;
 
@@ -84,13 +85,13 @@ void Font::renderString_i(int x, int y, const std::string &str,
 						  std::vector< Rect<int> > *char_pos_out,
 						  bool bRender)
 {
+	PROFILE_ZONE("Font::renderString");
 	Texture *pCurTex = 0;
 
-	glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT);
-	glEnable(GL_BLEND);
-	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	display::pushState();
+	display::enableBlending(true);
 
-	glBegin(GL_QUADS);
+	display::startBatch(display::QUADS);
 	int xpos = x;
 	int ypos = y;
 	for (size_t i=0; i<str.length(); ++i)
@@ -113,10 +114,10 @@ void Font::renderString_i(int x, int y, const std::string &str,
 		if (charInfo.m_pTexture != pCurTex) {
 			// make sure that we dont change texture while inside
 			// the glBegin/glEnd block.
-			glEnd();
+			display::endBatch();
 			pCurTex = charInfo.m_pTexture;
-			pCurTex->set();
-			glBegin(GL_QUADS);
+			display::bindTexture(pCurTex);
+			display::startBatch(display::QUADS);
 		}
 
 		// get character metrics
@@ -133,10 +134,11 @@ void Font::renderString_i(int x, int y, const std::string &str,
 		int top = ypos - charInfo.m_horiBearingY;
 		int bottom = ypos+fh - charInfo.m_horiBearingY;
 		if (bRender) {
-			glTexCoord2f(tx,ty+th);		glVertex2f((float)left, (float)top);
-			glTexCoord2f(tx+tw,ty+th);	glVertex2f((float)right, (float)top);
-			glTexCoord2f(tx+tw,ty);		glVertex2f((float)right, (float)bottom);
-			glTexCoord2f(tx,ty);		glVertex2f((float)left, (float)bottom);
+			PROFILE_COUNT(VERTICES, 4);
+			display::texCoord(tx,ty+th);		display::vertex((float)left, (float)top);
+			display::texCoord(tx+tw,ty+th);	display::vertex((float)right, (float)top);
+			display::texCoord(tx+tw,ty);		display::vertex((float)right, (float)bottom);
+			display::texCoord(tx,ty);		display::vertex((float)left, (float)bottom);
 		}
 
 		// store the position of the rendered character
@@ -147,15 +149,16 @@ void Font::renderString_i(int x, int y, const std::string &str,
 		// advance horizontal position
 		xpos += charInfo.m_horiAdvance;
 	}
-	glEnd();
+	display::endBatch();
 
 	// restore texture/blending states
-	glPopAttrib();
+	display::popState();
 }
 
 void Font::renderStringMultiline(int x, int y, int lineWidth, const std::string &str,
 								 std::vector< Rect<int> > *char_pos_out, bool bRender)
 {
+	PROFILE_ZONE("Font::renderStringMultiline");
 	int curLinePos = 0;
 	int ypos = y;
 	size_t i = 0;
@@ -227,6 +230,7 @@ void Font::renderStringMultiline(int x, int y, int lineWidth, const std::string
 
 int Font::stringLength(const std::string &str)
 {
+	PROFILE_ZONE("Font::stringLength");
 	ASSERT(FontManager::m_curFont >= 0);
 
 	int len = 0;
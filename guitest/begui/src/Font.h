@@ -130,8 +130,9 @@ protected:
 	// starts font caching (drawing font faces into textures)
 	static void beginFontCaching();
 
-	// ends font caching. In this step, the textures are created
-	// from the temporary images in system memory (so this call can be costly)
+	// ends font caching. In this step, the textures are created from the temporary
+	// images in system memory (by the SharedContextLoader, so they may arrive a few
+	// frames later)
 	static void endFontCaching();
 
 	// Get the drawing area for a character. The drawing area includes a pointer to the
@@ -20,9 +20,36 @@
 */
 
 #include "Font.h"
+#include "../../bcore/src/SharedContextLoader.h"
 
 using namespace begui;
 
+namespace {
+	// uploads a copy of a font page on the loader thread, and hands the texture
+	// over to the page's texture object (which the characters point to)
+	class FontPageTask : public SharedContextLoader::Task {
+		Texture		*m_pTarget;
+		Texture		*m_pTexture;
+		int			m_width, m_height;
+		std::vector<unsigned char>	m_data;
+	public:
+		FontPageTask(Texture *pTarget, const unsigned char *data, int w, int h) :
+			m_pTarget(pTarget), m_pTexture(0), m_width(w), m_height(h), m_data(data, data + w*h*4) { }
+		virtual ~FontPageTask()	{ SAFE_DELETE(m_pTexture); }
+
+		virtual bool load() {
+			m_pTexture = new Texture();
+			m_pTexture->create(m_width, m_height, GL_RGBA, &m_data[0]);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return m_pTexture->isLoaded();
+		}
+		virtual void onLoaded(bool bOk) {
+			if (bOk)
+				m_pTarget->swap(*m_pTexture);
+		}
+	};
+};
+
 std::vector<Font*>		FontManager::m_fonts;
 FT_Library				FontManager::m_freetype;
 bool					FontManager::m_ftInitialized = false;
@@ -50,6 +77,9 @@ bool FontManager::initialize()
 
 void FontManager::clear()
 {
+	// the loader may still be uploading font pages
+	SharedContextLoader::inst()->finish();
+
 	// destroy all fonts
 	for (size_t i=0; i<m_fonts.size(); ++i)
 		SAFE_DELETE(m_fonts[i]);
@@ -109,8 +139,9 @@ Font::Character FontManager::allocCharacterDrawingArea(int width, int height)
 	{
 		Texture *pLastTex = m_textureList.back();
 
-		// check if we have enough space in the last texture used
-		if (m_lastCharRight + width + 3 < pLastTex->getWidth())
+		// check if we have enough space in the last texture used. (All pages have the same
+		// size, and the texture itself may still be on its way from the loader thread.)
+		if (m_lastCharRight + width + 3 < m_texWidth)
 		{
 			// fill in the returned image ref
 			ref.m_pTexture = pLastTex;
@@ -129,7 +160,7 @@ Font::Character FontManager::allocCharacterDrawingArea(int width, int height)
 
 			return ref;
 		}
-		if (m_lastCharBottom + height + 3 < pLastTex->getHeight())
+		if (m_lastCharBottom + height + 3 < m_texHeight)
 		{
 			// go to the next line
 
@@ -175,7 +206,9 @@ Font::Character FontManager::allocCharacterDrawingArea(int width, int height)
 
 void FontManager::endFontCaching()
 {
-	// create all textures, copying data from the corresponding drawing surfaces
+	// create all textures, copying data from the corresponding drawing surfaces. The
+	// textures are created by the loader thread, from a copy of the surfaces, since
+	// caching the next font may draw on them again.
 	for (size_t i=0; i<m_textureList.size(); ++i)
 	{
 		// only re-create textures where the font drawing memory contains data
@@ -183,6 +216,6 @@ void FontManager::endFontCaching()
 			continue;
 
 		// create the texture
-		m_textureList[i]->create(m_texWidth, m_texHeight, GL_RGBA, m_fontDrawingMem[i]);
+		SharedContextLoader::inst()->submit(new FontPageTask(m_textureList[i], m_fontDrawingMem[i], m_texWidth, m_texHeight));
 	}
 }
\ No newline at end of file
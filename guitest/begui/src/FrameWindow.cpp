@@ -23,8 +23,12 @@
 #include "ResourceManager.h"
 #include "Font.h"
 #include "util.h"
+#include "../../bcore/src/RenderTargetPool.h"
 #ifdef _WIN32
 	#include "FrameWindow_Win32.h"
+#else
+	#include "FrameWindow_X11.h"
+	#include "FrameWindow_Headless.h"
 #endif
 
 using namespace begui;
@@ -35,7 +39,7 @@ FrameWindow *FrameWindow::m_pInst = 0;
 int g_lastXPos = 0;
 int g_lastYPos = 0;
 
-FrameWindow::FrameWindow()
+FrameWindow::FrameWindow() : m_bSyncRendering(false), m_exitCode(0)
 {
 	// default style for a frame window
 	setStyle(Window::MULTIPLE);
@@ -46,12 +50,17 @@ FrameWindow::~FrameWindow()
 	free();
 }
 
-FrameWindow* FrameWindow::createInstance()
+FrameWindow* FrameWindow::createInstance(bool bHeadless)
 {
 	if (m_pInst)
 		return m_pInst;
 #ifdef _WIN32
 	m_pInst = new FrameWindow_Win32;
+#else
+	if (bHeadless || !getenv("DISPLAY"))
+		m_pInst = new FrameWindow_Headless;
+	else
+		m_pInst = new FrameWindow_X11;
 #endif
 	ASSERT(m_pInst);
 	return m_pInst;
@@ -61,22 +70,13 @@ void FrameWindow::create(int left, int top, int width, int height, const std::st
 						 const std::string &style_name)
 {
 	// set the various options for the created window
-	if (opt) {
-		m_options = *opt;
-	}
-	else {
-		m_options.bOwnDraw = true;
-		m_options.bFullScreen = false;
-		m_options.nColorBits = 16;
-		m_options.nDepthBits = 16;
-		m_options.nStencilBits = 0;
-	}
+	m_options = (opt) ? *opt : Options();
 
 	// create the OpenGL window
 	try {
 		createGLWindow(left, top, width, height, title, m_options);
 	}
-	catch (std::exception e) {
+	catch (std::exception &e) {
 		Console::error("Failed to create OpenGL window: " + (std::string)e.what() + "\n");
 		throw e;
 	}
@@ -93,10 +93,60 @@ void FrameWindow::create(int left, int top, int width, int height, const std::st
 
 void FrameWindow::free()
 {
+	// the pooled render targets that no window holds go with the context
+	RenderTargetPool::inst()->clear();
+
 	// release the OpenGL window
 	freeGLWindow();
 }
 
+void FrameWindow::initializeSubsystems(const std::string &fontFile)
+{
+	std::string font = fontFile;
+	if (font.empty()) {
+#ifdef _WIN32
+		char win_dir[MAX_PATH+1];
+		GetWindowsDirectory(win_dir, MAX_PATH);
+		font = std::string(win_dir) + "\\Fonts\\tahoma.ttf";
+#else
+		// the first one of some common fonts that is installed
+		const char *fonts[] = {
+			"/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+			"/usr/share/fonts/dejavu/DejaVuSans.ttf",
+			"/usr/share/fonts/TTF/DejaVuSans.ttf",
+			"/usr/share/fonts/truetype/liberation/LiberationSans-Regular.ttf",
+			"/usr/share/fonts/liberation/LiberationSans-Regular.ttf",
+		};
+		for (size_t i=0; i<sizeof(fonts)/sizeof(fonts[0]) && font.empty(); ++i) {
+			if (access(fonts[i], R_OK) == 0)
+				font = fonts[i];
+		}
+#endif
+	}
+
+	// start the loader thread first: the font pages and the stock textures below are
+	// created on it, while the application creates its windows
+	SharedContextLoader::inst()->initialize(createSharedContext());
+
+	// Initialize font subsystem
+	if (!FontManager::initialize())
+		throw std::runtime_error("failed to initialize font subsystem");
+	if (!FontManager::setFont(font, 11))
+		throw std::runtime_error("failed to set default font");
+	
+	// Initialize the window manager and load resources
+	ResourceManager::inst()->loadResources();
+	
+	// set some OpenGL states
+	glClearColor(0, 0, 0, 0);
+	glEnable(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	if (m_options.bOwnDraw)
+		glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+	if (GLEW_ARB_seamless_cube_map)
+		glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);	// cube maps filtered across the face edges
+}
+
 void FrameWindow::frameRender()
 {
 	resetViewport();
@@ -200,7 +250,7 @@ void FrameWindow::onCaptionBtn(int id)
 		case 101:
 			// close btn
 			//m_onClose(CLOSE);
-			exit(0);
+			postQuit(0);
 			break;
 		default:
 			Window::onCaptionBtn(id);
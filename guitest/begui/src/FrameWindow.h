@@ -30,6 +30,7 @@
 #include "Menu.h"
 #include "Dialog.h"
 #include "Button.h"
+#include "../../bcore/src/SharedContextLoader.h"
 
 namespace begui {
 
@@ -50,6 +51,9 @@ namespace begui {
  *				still desirable (example: having a full GUI inside the viewport of a 
  *				3D app)
  *
+ *			The OS specific part is implemented by FrameWindow_Win32 (win32/wgl),
+ *			FrameWindow_X11 (Xlib/glx) and FrameWindow_Headless (EGL, without any
+ *			window: for batch rendering and tests on machines without a display).
  */
 class FrameWindow : public Window
 {
@@ -60,14 +64,19 @@ public:
 		int	nColorBits;
 		int nDepthBits;
 		int nStencilBits;
+		bool bHeadless;		// render offscreen, without a window
 		std::string windowStyleName;
+
+		Options() : bOwnDraw(true), bFullScreen(false), nColorBits(16), nDepthBits(16), nStencilBits(0),
+			bHeadless(false) { }
 	};
 
 public:
 	virtual ~FrameWindow();
 
-	// An instance of a FrameWindow is created only by calling createInstance()
-	static FrameWindow* createInstance();
+	// An instance of a FrameWindow is created only by calling createInstance(). Without
+	// a display (fe. DISPLAY is not set on X11), the window is always headless.
+	static FrameWindow* createInstance(bool bHeadless = false);
 	static FrameWindow* inst()				{ return m_pInst; }
 
 	virtual void create(int left, int top, int width, int height, const std::string &title, const Options *opt = 0,
@@ -79,6 +88,15 @@ public:
 	bool	useSyncRendering() const		{ return m_bSyncRendering; }
 	void	setSyncRendering(bool bSync)	{ m_bSyncRendering = bSync; }
 
+	// synchronize buffer swaps to the vertical retrace. Returns false if not supported.
+	virtual bool setVSync(bool bVSync)		{ return false; }
+
+	// dispatch the pending events of the OS. If there are none, waits up to maxWait secs
+	// for one (< 0: until one arrives). Returns false when the application should quit.
+	virtual bool processEvents(double maxWait) = 0;
+	virtual void postQuit(int exitCode = 0) = 0;
+	int		getExitCode() const		{ return m_exitCode; }
+
 	Options	getOptions() const	{ return m_options; }
 
 	virtual void frameRender();
@@ -94,6 +112,16 @@ protected:
 	FrameWindow();
 	virtual void createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt) = 0;
 	virtual void freeGLWindow() = 0;
+
+	// after creating the OpenGL context: start the loader thread, load the fonts and the
+	// resources, and set the default GL states. An empty fontFile selects a default font
+	// of the system.
+	void initializeSubsystems(const std::string &fontFile = "");
+
+	// a context that shares its objects with the rendering context, for the loader thread
+	// (see SharedContextLoader). Called with the rendering context current. 0 if the
+	// platform cannot create one: the loader then works synchronously.
+	virtual SharedContextLoader::Context*	createSharedContext()	{ return 0; }
 	
 	// overridden methods
 	virtual void onCaptionBtn(int id);
@@ -102,6 +130,7 @@ protected:
 protected:
 	Options	m_options;
 	bool	m_bSyncRendering;
+	int		m_exitCode;
 
 	static FrameWindow *m_pInst;
 
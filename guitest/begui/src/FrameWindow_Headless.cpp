@@ -0,0 +1,270 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrameWindow_Headless.h"
+
+#ifndef _WIN32
+
+#include "util.h"
+#include "Font.h"
+#include "../../bcore/src/Thread.h"
+#include <EGL/eglext.h>
+
+using namespace begui;
+
+namespace {
+	// the context of the loader thread, sharing the objects of the main context
+	class SharedContext_EGL : public SharedContextLoader::Context {
+		EGLDisplay	m_eglDisplay;
+		EGLContext	m_eglContext;
+		EGLSurface	m_eglSurface;
+	public:
+		SharedContext_EGL(EGLDisplay display) : m_eglDisplay(display), m_eglContext(EGL_NO_CONTEXT),
+			m_eglSurface(EGL_NO_SURFACE) { }
+		virtual ~SharedContext_EGL() {
+			if (m_eglContext != EGL_NO_CONTEXT)
+				eglDestroyContext(m_eglDisplay, m_eglContext);
+			if (m_eglSurface != EGL_NO_SURFACE)
+				eglDestroySurface(m_eglDisplay, m_eglSurface);
+		}
+
+		bool create(EGLConfig config, EGLContext shareContext, bool bSurfaceless) {
+			m_eglContext = eglCreateContext(m_eglDisplay, config, shareContext, 0);
+			if (m_eglContext == EGL_NO_CONTEXT)
+				return false;
+			if (!bSurfaceless) {
+				const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+				m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, config, pbufferAttribs);
+				return m_eglSurface != EGL_NO_SURFACE;
+			}
+			return true;
+		}
+
+		virtual bool makeCurrent() {
+			// the API is bound per thread
+			return eglBindAPI(EGL_OPENGL_API) && eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext);
+		}
+		virtual void doneCurrent()	{ eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT); }
+	};
+};
+
+FrameWindow_Headless::FrameWindow_Headless() : m_eglDisplay(EGL_NO_DISPLAY), m_eglConfig(0), m_eglContext(EGL_NO_CONTEXT),
+	m_eglSurface(EGL_NO_SURFACE), m_bQuit(false)
+{
+}
+
+FrameWindow_Headless::~FrameWindow_Headless()
+{
+}
+
+void FrameWindow_Headless::createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt)
+{
+	m_options = opt;
+	m_options.bFullScreen = false;
+	m_options.bHeadless = true;
+	m_bQuit = false;
+
+	try {
+		// get a display without a window system, or the default one
+		PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (eglGetPlatformDisplayEXT)
+			m_eglDisplay = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+		if (m_eglDisplay == EGL_NO_DISPLAY)
+			m_eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		EGLint major = 0, minor = 0;
+		if (m_eglDisplay == EGL_NO_DISPLAY || !eglInitialize(m_eglDisplay, &major, &minor))
+			throw std::runtime_error("Can't Initialize EGL");
+		if (!eglBindAPI(EGL_OPENGL_API))
+			throw std::runtime_error("EGL does not support desktop OpenGL");
+
+		// the frames are rendered to a render pass, so the configuration hardly matters.
+		// Prefer one with pbuffers, for the case that a surface is needed.
+		EGLint attribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_NONE
+		};
+		EGLConfig &config = m_eglConfig;
+		EGLint nConfigs = 0;
+		if (!eglChooseConfig(m_eglDisplay, attribs, &config, 1, &nConfigs) || nConfigs < 1) {
+			attribs[1] = EGL_DONT_CARE;
+			if (!eglChooseConfig(m_eglDisplay, attribs, &config, 1, &nConfigs) || nConfigs < 1)
+				throw std::runtime_error("Can't Find A Suitable EGL Configuration");
+		}
+
+		// Create a rendering context and activate it
+		if ((m_eglContext = eglCreateContext(m_eglDisplay, config, EGL_NO_CONTEXT, 0)) == EGL_NO_CONTEXT)
+			throw std::runtime_error("Can't Create A GL Rendering Context");
+		if (!eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext))
+		{
+			// no EGL_KHR_surfaceless_context
+			const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			m_eglSurface = eglCreatePbufferSurface(m_eglDisplay, config, pbufferAttribs);
+			if (m_eglSurface == EGL_NO_SURFACE ||
+				!eglMakeCurrent(m_eglDisplay, m_eglSurface, m_eglSurface, m_eglContext))
+				throw std::runtime_error("Can't Activate The GL Rendering Context");
+		}
+		Console::print("Status: Using EGL %d.%d, %s\n", major, minor, glGetString(GL_RENDERER));
+
+		// Initialize GLEW for extensions. A GLEW built for glx finds no glx display
+		// here, but it has loaded the GL functions by then.
+		GLenum err = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+		if (err == GLEW_ERROR_NO_GLX_DISPLAY)
+			err = GLEW_OK;
+#endif
+		if (err != GLEW_OK)
+			throw std::runtime_error((const char*)glewGetErrorString(err));
+
+		// there is no window to fall back to
+		if (!glewIsSupported("GL_EXT_framebuffer_object"))
+			throw std::runtime_error("frame buffer objects not supported");
+
+		// after creating the OpenGL context, it's time to initialize all
+		// subsystems, before creating our main application window
+		initializeSubsystems();
+
+		// set the size of the display area. The render pass is created with the first frame.
+		display::setSize(width, height);
+	}
+	catch (std::exception &e) {
+		Console::error("Failed to create headless window, with error:\n%s\n", e.what());
+		freeGLWindow();
+		throw;
+	}
+}
+
+void FrameWindow_Headless::freeGLWindow()
+{
+	if (m_eglDisplay == EGL_NO_DISPLAY)
+		return;
+
+	if (m_eglContext != EGL_NO_CONTEXT) {
+		// stop the loader thread while the objects it made can still be handed over
+		SharedContextLoader::inst()->shutdown();
+		m_frameRenderPass.free();
+		eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(m_eglDisplay, m_eglContext);
+		m_eglContext = EGL_NO_CONTEXT;
+	}
+	if (m_eglSurface != EGL_NO_SURFACE) {
+		eglDestroySurface(m_eglDisplay, m_eglSurface);
+		m_eglSurface = EGL_NO_SURFACE;
+	}
+
+	eglTerminate(m_eglDisplay);
+	m_eglDisplay = EGL_NO_DISPLAY;
+}
+
+SharedContextLoader::Context* FrameWindow_Headless::createSharedContext()
+{
+	SharedContext_EGL *pContext = new SharedContext_EGL(m_eglDisplay);
+	if (!pContext->create(m_eglConfig, m_eglContext, m_eglSurface == EGL_NO_SURFACE)) {
+		Console::print("WARNING: could not create a shared context for the loader thread\n");
+		SAFE_DELETE(pContext);
+	}
+	return pContext;
+}
+
+bool FrameWindow_Headless::processEvents(double maxWait)
+{
+	// nothing can arrive to end the wait early; without a timeout, check back regularly
+	if (maxWait != 0 && !m_bQuit)
+		Thread::sleep((maxWait > 0) ? (unsigned long)(1000*maxWait) : 10);
+	return !m_bQuit;
+}
+
+void FrameWindow_Headless::postQuit(int exitCode)
+{
+	m_exitCode = exitCode;
+	m_bQuit = true;
+}
+
+void FrameWindow_Headless::getFrameSize(int &w, int &h)
+{
+	w = display::getWidth();
+	h = display::getHeight();
+	if (m_options.bOwnDraw) {
+		Rect<int> border = getInactiveBorders();
+		w += border.left + border.right;
+		h += border.top + border.bottom;
+	}
+}
+
+void FrameWindow_Headless::frameRender()
+{
+	// check if the render pass has the right size. If not, update
+	int w, h;
+	getFrameSize(w, h);
+	if (m_frameRenderPass.getWidth() != w || m_frameRenderPass.getHeight() != h) {
+		if (!m_frameRenderPass.setup(RenderPass::PIXEL_RGBA8, w, h, 0, false)) {
+			Console::error("FrameWindow_Headless: failed to create the render pass (%d x %d)\n", w, h);
+			return;
+		}
+	}
+
+	m_frameRenderPass.beginPass();
+
+	glClearDepth(1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// render the main window
+	FrameWindow::frameRender();
+
+	m_frameRenderPass.endPass();
+}
+
+bool FrameWindow_Headless::readFrame(Image &img)
+{
+	int w = m_frameRenderPass.getWidth();
+	int h = m_frameRenderPass.getHeight();
+	if (w <= 0 || h <= 0)
+		return false;	// nothing rendered yet
+
+	img.create(w, h, 4, Image::I8BITS);
+	m_frameRenderPass.beginPass();
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, img.getData());
+	m_frameRenderPass.endPass();
+	img.flip();		// GL has the bottom row first
+	return true;
+}
+
+bool FrameWindow_Headless::saveFrame(const std::string &filename)
+{
+	Image img;
+	if (!readFrame(img))
+		return false;
+	return img.savePNG(filename);
+}
+
+void FrameWindow_Headless::setSize(int w, int h)
+{
+	display::setSize(w,h);
+	FrameWindow::setSize(w, h);
+}
+
+#endif
@@ -0,0 +1,88 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _FRAMEWINDOW_HEADLESS_H42631_INCLUDED_
+#define _FRAMEWINDOW_HEADLESS_H42631_INCLUDED_
+
+#pragma once
+
+#ifndef _WIN32			// EGL, for the platforms that are not Windows
+
+#include "Window.h"
+#include "FrameWindow.h"
+#include "../../bcore/src/RenderPass.h"
+#include "../../bcore/src/Image.h"
+
+#include <EGL/egl.h>
+
+namespace begui {
+
+/**
+ * FrameWindow_Headless: a frame window without a window, for batch rendering and
+ *		tests on machines without a display. The OpenGL context comes from EGL: on
+ *		mesa's surfaceless platform when available (llvmpipe renders in software
+ *		if there is no gpu), otherwise from the default EGL display. The frames are
+ *		rendered to an offscreen render pass, from which they can be read back.
+ *
+ *		There are no events: applications drive the frames themselves (or use
+ *		synchronous rendering), and end the main loop with postQuit().
+ */
+class FrameWindow_Headless : public FrameWindow
+{
+	friend class FrameWindow;
+
+private:
+	EGLDisplay	m_eglDisplay;
+	EGLConfig	m_eglConfig;
+	EGLContext	m_eglContext;
+	EGLSurface	m_eglSurface;	// a dummy pbuffer, if contexts without surfaces are not supported
+	bool		m_bQuit;
+
+	RenderPass	m_frameRenderPass;
+
+public:
+	virtual ~FrameWindow_Headless();
+
+	virtual void frameRender();
+	virtual bool processEvents(double maxWait);
+	virtual void postQuit(int exitCode = 0);
+	virtual void setSize(int w, int h);
+
+	// the last rendered frame, as 8 bit RGBA with the top row first
+	bool	readFrame(Image &img);
+	bool	saveFrame(const std::string &filename);		// as png
+
+protected:
+	FrameWindow_Headless();
+
+	virtual void createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt);
+	virtual void freeGLWindow();
+	virtual SharedContextLoader::Context*	createSharedContext();
+
+private:
+	void getFrameSize(int &w, int &h);
+};
+
+};
+
+#endif
+
+#endif
@@ -1,6 +1,7 @@
 #include "FrameWindow_Win32.h"
 #include "util.h"
 #include "Font.h"
+#include "../../bcore/src/FrameScheduler.h"
 
 #ifdef _WIN32
 
@@ -8,6 +9,42 @@ using namespace begui;
 
 LRESULT	CALLBACK WndProc(HWND, UINT, WPARAM, LPARAM);
 
+namespace {
+	// the context of the loader thread: the context of a small pbuffer, sharing the
+	// objects of the window's context (see PBuffer::create). Without pbuffers, a second
+	// context on the window's DC.
+	class SharedContext_Win32 : public SharedContextLoader::Context {
+		PBuffer	m_pbuffer;
+		bool	m_bPBuffer;
+		HDC		m_hDC;
+		HGLRC	m_hRC;
+	public:
+		SharedContext_Win32() : m_bPBuffer(false), m_hDC(0), m_hRC(0) { }
+		virtual ~SharedContext_Win32() {
+			if (m_bPBuffer)
+				m_pbuffer.free();
+			else if (m_hRC)
+				wglDeleteContext(m_hRC);
+		}
+
+		bool create(HDC hWindowDC, HGLRC hWindowRC) {
+			if (WGLEW_ARB_pbuffer && m_pbuffer.create(1, 1, GL_RGBA8, false, true)) {
+				m_bPBuffer = true;
+				m_hDC = m_pbuffer.getDC();
+				m_hRC = m_pbuffer.getRenderingContext();
+				return true;
+			}
+			m_pbuffer.free();
+			m_hDC = hWindowDC;
+			m_hRC = wglCreateContext(hWindowDC);
+			return m_hRC && wglShareLists(hWindowRC, m_hRC);
+		}
+
+		virtual bool makeCurrent()	{ return wglMakeCurrent(m_hDC, m_hRC) != FALSE; }
+		virtual void doneCurrent()	{ wglMakeCurrent(NULL, NULL); }
+	};
+};
+
 
 FrameWindow_Win32::FrameWindow_Win32() :
 	m_hInstance(0),
@@ -255,31 +292,22 @@ void FrameWindow_Win32::createGLWindow(int left, int top, int width, int height,
 	}
 }
 
-void FrameWindow_Win32::initializeSubsystems()
+SharedContextLoader::Context* FrameWindow_Win32::createSharedContext()
 {
-	// Get windows directory
-	char win_dir[MAX_PATH+1];
-	GetWindowsDirectory(win_dir, MAX_PATH);
-
-	// Initialize font subsystem
-	if (!FontManager::initialize())
-		throw std::exception("failed to initialize font subsystem");
-	if (!FontManager::setFont(strcat(win_dir, "\\Fonts\\tahoma.ttf"), 11))
-		throw std::exception("failed to set default font");
-	
-	// Initialize the window manager and load resources
-	ResourceManager::inst()->loadResources();
-	
-	// set some OpenGL states
-	glClearColor(0, 0, 0, 0);
-	glEnable(GL_BLEND);
-	glDisable(GL_DEPTH_TEST);
-	if (m_options.bOwnDraw)
-		glBlendEquationSeparate(GL_FUNC_ADD, GL_MAX);
+	SharedContext_Win32 *pContext = new SharedContext_Win32();
+	if (!pContext->create(m_hDC, m_hRC)) {
+		Console::print("WARNING: could not create a shared context for the loader thread\n");
+		SAFE_DELETE(pContext);
+	}
+	return pContext;
 }
 
 void FrameWindow_Win32::freeGLWindow()
 {
+	// stop the loader thread while the objects it made can still be handed over
+	if (m_hRC)
+		SharedContextLoader::inst()->shutdown();
+
 	// if in full-screen mode, go back to windowed mode
 	if (m_options.bFullScreen)
 	{
@@ -360,7 +388,7 @@ LRESULT FrameWindow_Win32::wndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM l
 
 		case WM_CLOSE:
 		{
-			PostQuitMessage(0);
+			postQuit(0);
 			return 0;
 		}
 
@@ -556,6 +584,43 @@ void FrameWindow_Win32::frameRender()
 	}
 }
 
+bool FrameWindow_Win32::setVSync(bool bVSync)
+{
+	// own-drawn windows are not swapped, but copied to a layered window
+	if (m_options.bOwnDraw || !WGLEW_EXT_swap_control)
+		return false;
+	return wglSwapIntervalEXT(bVSync ? 1 : 0) == TRUE;
+}
+
+bool FrameWindow_Win32::processEvents(double maxWait)
+{
+	MSG msg;
+	if (maxWait != 0 && !PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE)) {
+		if (maxWait < 0)
+			WaitMessage();
+		else
+			MsgWaitForMultipleObjects(0, NULL, FALSE, (DWORD)(1000*maxWait), QS_ALLINPUT);
+	}
+
+	// any of the messages may change what is displayed
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+	{
+		if (msg.message == WM_QUIT) {
+			m_exitCode = (int)msg.wParam;
+			return false;
+		}
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+		FrameScheduler::inst()->requestFrame();
+	}
+	return true;
+}
+
+void FrameWindow_Win32::postQuit(int exitCode)
+{
+	PostQuitMessage(exitCode);
+}
+
 void FrameWindow_Win32::setPos(int x, int y)
 {
 	FrameWindow::setPos(x,y);
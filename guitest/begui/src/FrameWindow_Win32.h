@@ -59,6 +59,9 @@ public:
 	virtual ~FrameWindow_Win32();
 
 	virtual void frameRender();
+	virtual bool setVSync(bool bVSync);
+	virtual bool processEvents(double maxWait);
+	virtual void postQuit(int exitCode = 0);
 	virtual void setPos(int x, int y);
 	virtual void setSize(int w, int h);
 	virtual void minimize();
@@ -74,8 +77,8 @@ protected:
 	FrameWindow_Win32();
 
 	virtual void createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt);
-	virtual void initializeSubsystems();
 	virtual void freeGLWindow();
+	virtual SharedContextLoader::Context*	createSharedContext();
 };
 
 };
@@ -0,0 +1,518 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "FrameWindow_X11.h"
+
+#ifndef _WIN32
+
+#include "util.h"
+#include "Font.h"
+#include "../../bcore/src/FrameScheduler.h"
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <sys/select.h>
+
+using namespace begui;
+
+namespace {
+
+	// the hints of the Motif window manager, which most window managers still honor
+	struct MotifWMHints {
+		unsigned long	flags;
+		unsigned long	functions;
+		unsigned long	decorations;
+		long			inputMode;
+		unsigned long	status;
+	};
+	const unsigned long MWM_HINTS_DECORATIONS = 2;
+
+	int translateKey(KeySym sym)
+	{
+		switch (sym)
+		{
+			case XK_Left: return KEY_LEFT;
+			case XK_Right: return KEY_RIGHT;
+			case XK_Up: return KEY_UP;
+			case XK_Down: return KEY_DOWN;
+			case XK_Home: return KEY_HOME;
+			case XK_End: return KEY_END;
+			case XK_Insert: return KEY_INSERT;
+			case XK_Delete: return KEY_DELETE;
+			case XK_Page_Up: return KEY_PAGEUP;
+			case XK_Page_Down: return KEY_PAGEDOWN;
+			case XK_Shift_L: return KEY_LSHIFT;
+			case XK_Shift_R: return KEY_RSHIFT;
+			case XK_Control_L: return KEY_LCTRL;
+			case XK_Control_R: return KEY_RCTRL;
+			case XK_Alt_L: return KEY_LALT;
+			case XK_Alt_R: return KEY_RALT;
+		}
+		return -1;
+	}
+
+	int translateButton(unsigned int button)
+	{
+		switch (button)
+		{
+			case Button1: return MOUSE_BUTTON_LEFT;
+			case Button2: return MOUSE_BUTTON_MIDDLE;
+			case Button3: return MOUSE_BUTTON_RIGHT;
+		}
+		return -1;	// the wheel
+	}
+
+	bool hasGLXExtension(Display *pDisplay, const char *ext)
+	{
+		const char *exts = glXQueryExtensionsString(pDisplay, DefaultScreen(pDisplay));
+		if (!exts)
+			return false;
+		size_t len = strlen(ext);
+		for (const char *p = strstr(exts, ext); p; p = strstr(p+len, ext)) {
+			if ((p == exts || p[-1] == ' ') && (p[len] == ' ' || p[len] == 0))
+				return true;
+		}
+		return false;
+	}
+
+	// the context of the loader thread: a small pbuffer, and a context that shares the
+	// objects of the window's context
+	class SharedContext_X11 : public SharedContextLoader::Context {
+		Display		*m_pDisplay;
+		GLXContext	m_context;
+		GLXPbuffer	m_pbuffer;
+	public:
+		SharedContext_X11(Display *pDisplay) : m_pDisplay(pDisplay), m_context(0), m_pbuffer(0) { }
+		virtual ~SharedContext_X11() {
+			if (m_context)
+				glXDestroyContext(m_pDisplay, m_context);
+			if (m_pbuffer)
+				glXDestroyPbuffer(m_pDisplay, m_pbuffer);
+		}
+
+		bool create(GLXContext shareContext) {
+			int attribs[] = {
+				GLX_DRAWABLE_TYPE, GLX_PBUFFER_BIT,
+				GLX_RENDER_TYPE, GLX_RGBA_BIT,
+				None
+			};
+			int nConfigs = 0;
+			GLXFBConfig *pConfigs = glXChooseFBConfig(m_pDisplay, DefaultScreen(m_pDisplay), attribs, &nConfigs);
+			if (!pConfigs || nConfigs < 1)
+				return false;
+			GLXFBConfig config = pConfigs[0];
+			XFree(pConfigs);
+
+			const int pbufferAttribs[] = { GLX_PBUFFER_WIDTH, 1, GLX_PBUFFER_HEIGHT, 1, None };
+			m_pbuffer = glXCreatePbuffer(m_pDisplay, config, pbufferAttribs);
+			m_context = glXCreateNewContext(m_pDisplay, config, GLX_RGBA_TYPE, shareContext, True);
+			return m_pbuffer && m_context;
+		}
+
+		virtual bool makeCurrent()	{ return glXMakeContextCurrent(m_pDisplay, m_pbuffer, m_pbuffer, m_context) != False; }
+		virtual void doneCurrent()	{ glXMakeContextCurrent(m_pDisplay, None, None, 0); }
+	};
+};
+
+FrameWindow_X11::FrameWindow_X11() : m_pDisplay(0), m_window(0), m_colormap(0), m_context(0),
+	m_wmDeleteWindow(0), m_bQuit(false),
+	m_winX(0), m_winY(0), m_winW(0), m_winH(0)
+{
+}
+
+FrameWindow_X11::~FrameWindow_X11()
+{
+}
+
+void FrameWindow_X11::createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt)
+{
+	m_options = opt;
+	m_bQuit = false;
+
+	try {
+		// the loader thread makes its context current on the same display connection
+		XInitThreads();
+		if (!(m_pDisplay = XOpenDisplay(0)))
+			throw std::runtime_error("Cannot open the X display");
+		int screen = DefaultScreen(m_pDisplay);
+
+		// find a matching framebuffer configuration
+		int channelBits = (m_options.nColorBits >= 24) ? 8 : 5;
+		int attribs[] = {
+			GLX_X_RENDERABLE, True,
+			GLX_DRAWABLE_TYPE, GLX_WINDOW_BIT,
+			GLX_RENDER_TYPE, GLX_RGBA_BIT,
+			GLX_DOUBLEBUFFER, True,
+			GLX_RED_SIZE, channelBits,
+			GLX_GREEN_SIZE, channelBits,
+			GLX_BLUE_SIZE, channelBits,
+			GLX_DEPTH_SIZE, m_options.nDepthBits,
+			GLX_STENCIL_SIZE, m_options.nStencilBits,
+			None
+		};
+		int nConfigs = 0;
+		GLXFBConfig *pConfigs = glXChooseFBConfig(m_pDisplay, screen, attribs, &nConfigs);
+		if (!pConfigs || nConfigs < 1)
+			throw std::runtime_error("Can't Find A Suitable Framebuffer Configuration");
+		GLXFBConfig config = pConfigs[0];
+		XFree(pConfigs);
+		XVisualInfo *pVisual = glXGetVisualFromFBConfig(m_pDisplay, config);
+		if (!pVisual)
+			throw std::runtime_error("Can't Find A Suitable Visual");
+
+		// create the window
+		::Window root = RootWindow(m_pDisplay, screen);
+		m_colormap = XCreateColormap(m_pDisplay, root, pVisual->visual, AllocNone);
+		XSetWindowAttributes swa;
+		memset(&swa, 0, sizeof(swa));
+		swa.colormap = m_colormap;
+		swa.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+						 PointerMotionMask | StructureNotifyMask | FocusChangeMask;
+		m_window = XCreateWindow(m_pDisplay, root, left, top, width, height, 0, pVisual->depth, InputOutput,
+								 pVisual->visual, CWColormap | CWEventMask, &swa);
+		XFree(pVisual);
+		if (!m_window)
+			throw std::runtime_error("XCreateWindow failed. Cannot create window.");
+		m_winX = left;
+		m_winY = top;
+		m_winW = width;
+		m_winH = height;
+		XStoreName(m_pDisplay, m_window, title.c_str());
+
+		// closing the window from the window manager posts a quit
+		m_wmDeleteWindow = XInternAtom(m_pDisplay, "WM_DELETE_WINDOW", False);
+		XSetWMProtocols(m_pDisplay, m_window, &m_wmDeleteWindow, 1);
+
+		// make a window without caption and border if we are going to render everything ourselves
+		if (m_options.bOwnDraw || m_options.bFullScreen) {
+			MotifWMHints hints;
+			memset(&hints, 0, sizeof(hints));
+			hints.flags = MWM_HINTS_DECORATIONS;
+			Atom prop = XInternAtom(m_pDisplay, "_MOTIF_WM_HINTS", False);
+			XChangeProperty(m_pDisplay, m_window, prop, prop, 32, PropModeReplace, (unsigned char*)&hints, 5);
+		}
+		if (m_options.bFullScreen) {
+			Atom state = XInternAtom(m_pDisplay, "_NET_WM_STATE_FULLSCREEN", False);
+			XChangeProperty(m_pDisplay, m_window, XInternAtom(m_pDisplay, "_NET_WM_STATE", False), XA_ATOM, 32,
+							PropModeReplace, (unsigned char*)&state, 1);
+		}
+
+		// Create a rendering context and activate it
+		if (!(m_context = glXCreateNewContext(m_pDisplay, config, GLX_RGBA_TYPE, 0, True)))
+			throw std::runtime_error("Can't Create A GL Rendering Context");
+		if (!glXMakeContextCurrent(m_pDisplay, m_window, m_window, m_context))
+			throw std::runtime_error("Can't Activate The GL Rendering Context");
+
+		// Initialize GLEW for extensions
+		GLenum err = glewInit();
+		if (err != GLEW_OK)
+			throw std::runtime_error((const char*)glewGetErrorString(err));
+		Console::print("Status: Using GLEW %s\n", glewGetString(GLEW_VERSION));
+
+		// Check hardware support. Own-drawn windows are drawn directly here, so
+		// there is no fallback to make.
+		if (!GL_VERSION_2_0)
+			Console::print("WARNING: OpenGL 2.0 not supported. Try updating the graphics card drivers.\n");
+		if (!glewIsSupported("GL_EXT_framebuffer_object"))
+			Console::print("WARNING: frame buffer objects not supported\n");
+
+		// after creating the OpenGL window, it's time to initialize all
+		// subsystems, before creating our main application window
+		initializeSubsystems();
+
+		// set the size of the display area
+		display::setSize(width, height);
+
+		// Show the window
+		XMapRaised(m_pDisplay, m_window);
+		XFlush(m_pDisplay);
+	}
+	catch (std::exception &e) {
+		Console::error("Failed to create main window, with error:\n%s\n", e.what());
+		freeGLWindow();
+		throw;
+	}
+}
+
+SharedContextLoader::Context* FrameWindow_X11::createSharedContext()
+{
+	SharedContext_X11 *pContext = new SharedContext_X11(m_pDisplay);
+	if (!pContext->create(m_context)) {
+		Console::print("WARNING: could not create a shared context for the loader thread\n");
+		SAFE_DELETE(pContext);
+	}
+	return pContext;
+}
+
+void FrameWindow_X11::freeGLWindow()
+{
+	if (!m_pDisplay)
+		return;
+
+	// stop the loader thread while the objects it made can still be handed over
+	if (m_context)
+		SharedContextLoader::inst()->shutdown();
+
+	// release rendering context
+	if (m_context) {
+		glXMakeContextCurrent(m_pDisplay, None, None, 0);
+		glXDestroyContext(m_pDisplay, m_context);
+		m_context = 0;
+	}
+
+	// destroy window
+	if (m_window) {
+		XDestroyWindow(m_pDisplay, m_window);
+		m_window = 0;
+	}
+	if (m_colormap) {
+		XFreeColormap(m_pDisplay, m_colormap);
+		m_colormap = 0;
+	}
+
+	XCloseDisplay(m_pDisplay);
+	m_pDisplay = 0;
+}
+
+bool FrameWindow_X11::processEvents(double maxWait)
+{
+	if (maxWait != 0 && !m_bQuit && XPending(m_pDisplay) == 0)
+	{
+		// wait on the connection to the X server
+		int fd = ConnectionNumber(m_pDisplay);
+		fd_set fds;
+		FD_ZERO(&fds);
+		FD_SET(fd, &fds);
+		timeval tv;
+		if (maxWait > 0) {
+			tv.tv_sec = (long)maxWait;
+			tv.tv_usec = (long)(1000000*(maxWait - tv.tv_sec));
+		}
+		select(fd+1, &fds, 0, 0, (maxWait > 0) ? &tv : 0);
+	}
+
+	// any of the events may change what is displayed
+	while (!m_bQuit && XPending(m_pDisplay) > 0)
+	{
+		XEvent ev;
+		XNextEvent(m_pDisplay, &ev);
+		handleEvent(ev);
+		FrameScheduler::inst()->requestFrame();
+	}
+	return !m_bQuit;
+}
+
+void FrameWindow_X11::postQuit(int exitCode)
+{
+	m_exitCode = exitCode;
+	m_bQuit = true;
+}
+
+void FrameWindow_X11::handleEvent(XEvent &ev)
+{
+	switch (ev.type)
+	{
+		case ClientMessage:
+			if ((Atom)ev.xclient.data.l[0] == m_wmDeleteWindow)
+				postQuit(0);
+			break;
+
+		case FocusIn:
+			onActivate();
+			break;
+		case FocusOut:
+			onDeactivate();
+			break;
+
+		case Expose:
+			if (ev.xexpose.count == 0 && !m_bSyncRendering)
+				frameRender();
+			break;
+
+		case ConfigureNotify:
+			// own-drawn windows set the geometry of the X window themselves
+			if (!m_options.bOwnDraw && (ev.xconfigure.width != m_winW || ev.xconfigure.height != m_winH)) {
+				m_winW = ev.xconfigure.width;
+				m_winH = ev.xconfigure.height;
+				setSize(m_winW, m_winH);
+			}
+			break;
+
+		case KeyPress:
+		{
+			char ch = 0;
+			KeySym sym = 0;
+			int nChars = XLookupString(&ev.xkey, &ch, 1, &sym, 0);
+			int key = translateKey(sym);
+			if (key >= 0) {
+				input::keyDown(key);
+				onKeyDown(key);
+			}
+			else if (nChars == 1)
+				onKeyDown((unsigned char)ch);
+			break;
+		}
+		case KeyRelease:
+		{
+			char ch = 0;
+			KeySym sym = 0;
+			int nChars = XLookupString(&ev.xkey, &ch, 1, &sym, 0);
+			int key = translateKey(sym);
+			if (key < 0 && nChars == 1)
+				key = (unsigned char)ch;
+			if (key >= 0) {
+				onKeyUp(key);
+				input::keyUp(key);
+			}
+			break;
+		}
+
+		case ButtonPress:
+		{
+			int button = translateButton(ev.xbutton.button);
+			if (button >= 0) {
+				input::mouseButtonDown(ev.xbutton.x, ev.xbutton.y, button);
+				onMouseDown(ev.xbutton.x, ev.xbutton.y, button);
+			}
+			break;
+		}
+		case MotionNotify:
+		{
+			Vector2i lastMousePos = input::lastMousePos();
+			input::mousePos(ev.xmotion.x, ev.xmotion.y);
+			onMouseMove(ev.xmotion.x, ev.xmotion.y, lastMousePos.x, lastMousePos.y);
+			break;
+		}
+		case ButtonRelease:
+		{
+			int button = translateButton(ev.xbutton.button);
+			if (button >= 0) {
+				input::mouseButtonUp(ev.xbutton.x, ev.xbutton.y, button);
+				onMouseUp(ev.xbutton.x, ev.xbutton.y, button);
+			}
+			break;
+		}
+	}
+}
+
+void FrameWindow_X11::frameRender()
+{
+	if (m_options.bOwnDraw && !m_options.bFullScreen)
+	{
+		// keep the X window over the area that the frame window draws, with its borders
+		Rect<int> border = getInactiveBorders();
+		int x = getLeft() - border.left;
+		int y = getTop() - border.top;
+		if (m_state == MAXIMIZED) {
+			x = -border.left;
+			y = -border.top;
+		}
+		int w = display::getWidth() + border.left + border.right;
+		int h = display::getHeight() + border.top + border.bottom;
+		if (x != m_winX || y != m_winY || w != m_winW || h != m_winH) {
+			XMoveResizeWindow(m_pDisplay, m_window, x, y, w, h);
+			m_winX = x;
+			m_winY = y;
+			m_winW = w;
+			m_winH = h;
+		}
+	}
+
+	glClearDepth(1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// render the main window
+	FrameWindow::frameRender();
+
+	// display the new frame
+	glXSwapBuffers(m_pDisplay, m_window);
+}
+
+bool FrameWindow_X11::setVSync(bool bVSync)
+{
+	if (hasGLXExtension(m_pDisplay, "GLX_EXT_swap_control")) {
+		PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT =
+			(PFNGLXSWAPINTERVALEXTPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+		if (glXSwapIntervalEXT) {
+			glXSwapIntervalEXT(m_pDisplay, m_window, bVSync ? 1 : 0);
+			return true;
+		}
+	}
+	if (hasGLXExtension(m_pDisplay, "GLX_MESA_swap_control")) {
+		PFNGLXSWAPINTERVALMESAPROC glXSwapIntervalMESA =
+			(PFNGLXSWAPINTERVALMESAPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalMESA");
+		if (glXSwapIntervalMESA)
+			return glXSwapIntervalMESA(bVSync ? 1 : 0) == 0;
+	}
+	return false;
+}
+
+void FrameWindow_X11::setPos(int x, int y)
+{
+	FrameWindow::setPos(x,y);
+}
+
+void FrameWindow_X11::setSize(int w, int h)
+{
+	display::setSize(w,h);
+	FrameWindow::setSize(w, h);
+}
+
+void FrameWindow_X11::setWMState(bool bAdd, const char *state1, const char *state2)
+{
+	// ask the window manager, as described by the EWMH spec
+	XEvent ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.xclient.type = ClientMessage;
+	ev.xclient.window = m_window;
+	ev.xclient.message_type = XInternAtom(m_pDisplay, "_NET_WM_STATE", False);
+	ev.xclient.format = 32;
+	ev.xclient.data.l[0] = bAdd ? 1 : 0;	// _NET_WM_STATE_ADD : _NET_WM_STATE_REMOVE
+	ev.xclient.data.l[1] = XInternAtom(m_pDisplay, state1, False);
+	ev.xclient.data.l[2] = state2 ? XInternAtom(m_pDisplay, state2, False) : 0;
+	ev.xclient.data.l[3] = 1;	// from a normal application
+	XSendEvent(m_pDisplay, DefaultRootWindow(m_pDisplay), False,
+			   SubstructureRedirectMask | SubstructureNotifyMask, &ev);
+}
+
+void FrameWindow_X11::minimize()
+{
+	m_state = MINIMIZED;
+	XIconifyWindow(m_pDisplay, m_window, DefaultScreen(m_pDisplay));
+}
+
+void FrameWindow_X11::maximize()
+{
+	// own-drawn windows are placed by frameRender(), from their state
+	m_state = MAXIMIZED;
+	if (!m_options.bOwnDraw)
+		setWMState(true, "_NET_WM_STATE_MAXIMIZED_VERT", "_NET_WM_STATE_MAXIMIZED_HORZ");
+}
+
+void FrameWindow_X11::restore()
+{
+	m_state = VISIBLE;
+	if (!m_options.bOwnDraw)
+		setWMState(false, "_NET_WM_STATE_MAXIMIZED_VERT", "_NET_WM_STATE_MAXIMIZED_HORZ");
+	XMapRaised(m_pDisplay, m_window);
+}
+
+#endif
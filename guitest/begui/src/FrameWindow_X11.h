@@ -0,0 +1,89 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _FRAMEWINDOW_X11_H42631_INCLUDED_
+#define _FRAMEWINDOW_X11_H42631_INCLUDED_
+
+#pragma once
+
+#ifndef _WIN32			// Xlib/glx, for the platforms that are not Windows
+
+#include "Window.h"
+#include "FrameWindow.h"
+
+#include <X11/Xlib.h>
+#include <GL/glx.h>
+
+namespace begui {
+
+/**
+ * FrameWindow_X11: the frame window on X11, with a glx context. Own-drawn frame
+ *		windows get no decorations from the window manager, and the X window is moved
+ *		and resized to follow the frame window's own caption and borders. (There is
+ *		no alpha blending on the desktop: that would need an ARGB visual and a
+ *		compositing manager.)
+ */
+class FrameWindow_X11 : public FrameWindow
+{
+	friend class FrameWindow;
+
+private:
+	Display		*m_pDisplay;
+	::Window	m_window;
+	Colormap	m_colormap;
+	GLXContext	m_context;
+	Atom		m_wmDeleteWindow;
+	bool		m_bQuit;
+	int			m_winX, m_winY, m_winW, m_winH;	// the geometry of the X window
+
+public:
+	virtual ~FrameWindow_X11();
+
+	virtual void frameRender();
+	virtual bool setVSync(bool bVSync);
+	virtual bool processEvents(double maxWait);
+	virtual void postQuit(int exitCode = 0);
+	virtual void setPos(int x, int y);
+	virtual void setSize(int w, int h);
+	virtual void minimize();
+	virtual void maximize();
+	virtual void restore();
+
+	Display*	getDisplay() const		{ return m_pDisplay; }
+	::Window	getXWindow() const		{ return m_window; }
+
+protected:
+	FrameWindow_X11();
+
+	virtual void createGLWindow(int left, int top, int width, int height, const std::string &title, const Options &opt);
+	virtual void freeGLWindow();
+	virtual SharedContextLoader::Context*	createSharedContext();
+
+private:
+	void handleEvent(XEvent &ev);
+	void setWMState(bool bAdd, const char *state1, const char *state2 = 0);
+};
+
+};
+
+#endif
+
+#endif
@@ -22,6 +22,7 @@
 #include "Group.h"
 #include "Font.h"
 #include "ResourceManager.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -41,7 +42,7 @@ void Group::create(int left, int top, int width, int height, const std::string &
 	m_bottom = m_top + height;
 	m_title = title;
 
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("GroupBox").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("GroupBox").style(style_name);
 	ASSERT(style.hasProp("bg"));
 	m_bg = ResourceManager::inst()->loadImage(style.get_img("bg"));
 	if (style.hasProp("resizable_area"))
@@ -58,18 +59,17 @@ void Group::create(int left, int top, int width, int height, const std::string &
 
 void Group::onRender()
 {
-	glEnable(GL_BLEND);
-	glColor4f(m_frameColor.r, m_frameColor.g, m_frameColor.b, 1.0f);
+	display::enableBlending(true);
+	display::setColor(m_frameColor.r, m_frameColor.g, m_frameColor.b, 1.0f);
 	Component::drawImageWtBorders(m_bg, -m_activeArea.left, -m_activeArea.top, 
 		getWidth()+(m_bg.m_width - m_activeArea.right)+m_activeArea.left, 
 		getHeight()+(m_bg.m_height - m_activeArea.bottom)+m_activeArea.top, m_resizableArea);
 
 /*	// set the texture of a window
 	Texture *pTex = ResourceManager::inst()->getStockMap(ResourceManager::STD_CONTROLS);
-	pTex->set();
+	display::bindTexture(pTex);
 	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	display::enableBlending(true);
 
 	double ul=382;
 	double ut=34;
@@ -79,21 +79,21 @@ void Group::onRender()
 	double th=512;
 	int left = 0, top=0;	//NOTE: rendering is done in LOCAL coordinate system!!
 	int right = m_right-m_left, bottom=m_bottom-m_top;
-	glColor4f(0,0,0,0.17);
+	display::setColor(0,0,0,0.17);
 	Component::drawBorderedQuad(left, top, right, bottom,
 						left+4, top+4, right-4, bottom-4,
 						ul/tw, (ul+4)/tw, ur/tw, (ur-4)/tw,
 						ut/th, (ut+4)/th, ub/th, (ub-4)/th);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	display::bindTexture(0);
 
 	
-	glDisable(GL_BLEND);*/
+	display::enableBlending(false);*/
 	
 	// render the text
 	Font *pFont = FontManager::getCurFont();
 	int center = getWidth()/2;
-	glColor4f(m_textColor.r, m_textColor.g, m_textColor.b, 0.5f);
+	display::setColor(m_textColor.r, m_textColor.g, m_textColor.b, 0.5f);
 	Font::renderString(center - Font::stringLength(m_title)/2, pFont->getLineHeight()+1, m_title);
 }
 
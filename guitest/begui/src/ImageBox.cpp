@@ -21,13 +21,19 @@
 
 #include "ImageBox.h"
 #include "util.h"
+#include "../../bcore/src/TextureBudget.h"
 
 using namespace begui;
 
-ImageBox::ImageBox() : m_pImage(0), m_bResizeImg(false), m_bSelectable(false)
+ImageBox::ImageBox() : m_pImage(0), m_imageGeneration(0), m_bResizeImg(false), m_bSelectable(false)
 {
 }
 
+ImageBox::~ImageBox()
+{
+	setImage(0);
+}
+
 void ImageBox::create(int x, int y, int width, int height, Image *pImg, bool bResizeImg)
 {
 	setPos(x,y);
@@ -38,16 +44,67 @@ void ImageBox::create(int x, int y, int width, int height, Image *pImg, bool bRe
 
 void ImageBox::setImage(Image *pImg)
 {
+	m_asyncImage.cancel();
+	m_asyncImage.reset();
+
+	// the reloader refers to the previous image, which may not live much longer
+	if (m_texture.isLoaded())
+		TextureBudget::inst()->setReloader(m_texture.getGLTex(), 0);
+
 	m_pImage = pImg;
-	if (m_pImage)
+	if (m_pImage) {
 		m_texture.create(*m_pImage, false);
+		m_imageGeneration = m_pImage->getGeneration();
+
+		// if evicted, the texture is restored from the image (which is kept up to date)
+		TextureBudget::inst()->setReloader(m_texture.getGLTex(), new TextureBudget::ImageReloader(*m_pImage, false, false));
+	}
 	else
 		m_texture.free();
 	m_selLine.clear();
 }
 
+void ImageBox::setImageAsync(const std::string &filename)
+{
+	setImage(0);
+	m_asyncImage = AsyncTextureLoader::inst()->load(filename);
+}
+
+Texture* ImageBox::getDisplayTexture()
+{
+	if (m_asyncImage.isValid())
+		return m_asyncImage.getTexture();
+	return &m_texture;
+}
+
+bool ImageBox::getImageSize(int &w, int &h) const
+{
+	if (m_pImage) {
+		w = (int)m_pImage->getWidth();
+		h = (int)m_pImage->getHeight();
+		return true;
+	}
+	if (m_asyncImage.isReady()) {
+		Texture *pTex = m_asyncImage.getTexture();
+		w = pTex->getWidth();
+		h = pTex->getHeight();
+		return true;
+	}
+	return false;
+}
+
 void ImageBox::onUpdate()
 {
+	// upload the parts of the image that have changed since the last update. The image
+	// may be shown by other viewers too, so its changes are not cleared here.
+	if (m_pImage && m_pImage->getGeneration() != m_imageGeneration) {
+		DirtyRegion changed;
+		if (m_pImage->getChangesSince(m_imageGeneration, changed))
+			m_texture.update(*m_pImage, changed);
+		else
+			m_texture.create(*m_pImage, false);
+		m_imageGeneration = m_pImage->getGeneration();
+	}
 }
 
 void ImageBox::onRender()
@@ -55,16 +112,17 @@ void ImageBox::onRender()
 	int w = getWidth();
 	int h = getHeight();
 
-	glColor4f(0,0,0,0.5f);
-	glBegin(GL_QUADS);
-		glVertex2f(0, 0);
-		glVertex2f((float)w, 0);
-		glVertex2f((float)w, (float)h);
-		glVertex2f(0, (float)h);
-	glEnd();
+	display::setColor(0,0,0,0.5f);
+	display::startBatch(display::QUADS);
+		display::vertex(0, 0);
+		display::vertex((float)w, 0);
+		display::vertex((float)w, (float)h);
+		display::vertex(0, (float)h);
+	display::endBatch();
 
 	// Render the image
-	if (m_texture.isLoaded())
+	Texture *pTex = getDisplayTexture();
+	if (pTex->isLoaded())
 	{
 		float left = 0;	// change if centering the image..
 		float top = 0;
@@ -78,29 +136,29 @@ void ImageBox::onRender()
 			u = (float)iw/m_texture.getWidth();
 			v = (float)ih/m_texture.getHeight();
 		}*/
-		m_texture.set();
-		glColor4f(1,1,1,1);
-		glBegin(GL_QUADS);
-			glTexCoord2f(0,0); glVertex2f(left, top);
-			glTexCoord2f(u,0); glVertex2f(left+iw, top);
-			glTexCoord2f(u,v); glVertex2f(left+iw, top+ih);
-			glTexCoord2f(0,v); glVertex2f(left, top+ih);
-		glEnd();
-		glBindTexture(GL_TEXTURE_2D, 0);
+		display::bindTexture(pTex);
+		display::setColor(1,1,1,1);
+		display::startBatch(display::QUADS);
+			display::texCoord(0,0); display::vertex(left, top);
+			display::texCoord(u,0); display::vertex(left+iw, top);
+			display::texCoord(u,v); display::vertex(left+iw, top+ih);
+			display::texCoord(0,v); display::vertex(left, top+ih);
+		display::endBatch();
+		display::bindTexture(0);
 	}
 
 	// draw the selection here
 	if (m_selLine.size() > 2 && m_bSelectable)
 	{
-		glColor4f(1,0,0,1);
-		glBegin(GL_LINES);
-			glVertex2f(m_selLine[0].x, m_selLine[0].y);
+		display::setColor(1,0,0,1);
+		display::startBatch(display::LINES);
+			display::vertex(m_selLine[0].x, m_selLine[0].y);
 			for (size_t i=1; i<m_selLine.size(); ++i) {
-				glVertex2f(m_selLine[i].x, m_selLine[i].y);
-				glVertex2f(m_selLine[i].x, m_selLine[i].y);
+				display::vertex(m_selLine[i].x, m_selLine[i].y);
+				display::vertex(m_selLine[i].x, m_selLine[i].y);
 			}
-			glVertex2f(m_selLine[0].x, m_selLine[0].y);
-		glEnd();
+			display::vertex(m_selLine[0].x, m_selLine[0].y);
+		display::endBatch();
 	}
 
 	// additional rendering, controlled by the application
@@ -111,15 +169,16 @@ bool ImageBox::onMouseDown(int x, int y, int button)
 {
 	if (button == MOUSE_BUTTON_LEFT)
 	{
-		if (m_pImage && m_bSelectable)
+		int imgW, imgH;
+		if (m_bSelectable && getImageSize(imgW, imgH))
 		{
 			m_selLine.clear();
 			
 			Vector2 pt(float(x-m_left), float(y-m_top));
 			if (pt.x < 0) pt.x = 0;
 			if (pt.y < 0) pt.y = 0;
-			if (pt.x > m_pImage->getWidth()) pt.x = (float)m_pImage->getWidth();
-			if (pt.y > m_pImage->getHeight()) pt.y = (float)m_pImage->getHeight();
+			if (pt.x > imgW) pt.x = (float)imgW;
+			if (pt.y > imgH) pt.y = (float)imgH;
 			m_selLine.push_back(pt);
 		}
 
@@ -133,13 +192,14 @@ bool ImageBox::onMouseMove(int x, int y, int prevx, int prevy)
 {
 	if (input::isMouseButtonDown(MOUSE_BUTTON_LEFT))
 	{
-		if (m_pImage && m_bSelectable)
+		int imgW, imgH;
+		if (m_bSelectable && getImageSize(imgW, imgH))
 		{
 			Vector2 pt(float(x-m_left), float(y-m_top));
 			if (pt.x < 0) pt.x = 0;
 			if (pt.y < 0) pt.y = 0;
-			if (pt.x > m_pImage->getWidth()) pt.x = (float)m_pImage->getWidth();
-			if (pt.y > m_pImage->getHeight()) pt.y = (float)m_pImage->getHeight();
+			if (pt.x > imgW) pt.x = (float)imgW;
+			if (pt.y > imgH) pt.y = (float)imgH;
 			m_selLine.push_back(pt);
 		}
 	}
@@ -151,13 +211,14 @@ bool ImageBox::onMouseUp(int x, int y, int button)
 {
 	if (button == MOUSE_BUTTON_LEFT)
 	{
-		if (m_pImage && m_bSelectable)
+		int imgW, imgH;
+		if (m_bSelectable && getImageSize(imgW, imgH))
 		{
 			Vector2 pt(float(x-m_left), float(y-m_top));
 			if (pt.x < 0) pt.x = 0;
 			if (pt.y < 0) pt.y = 0;
-			if (pt.x > m_pImage->getWidth()) pt.x = (float)m_pImage->getWidth();
-			if (pt.y > m_pImage->getHeight()) pt.y = (float)m_pImage->getHeight();
+			if (pt.x > imgW) pt.x = (float)imgW;
+			if (pt.y > imgH) pt.y = (float)imgH;
 			m_selLine.push_back(pt);
 
 			if (m_selLine.size() <= 2)	// only endpoints, no mouse move in between
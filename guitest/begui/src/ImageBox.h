@@ -27,6 +27,7 @@
 #include "common.h"
 #include "Component.h"
 #include "../../bcore/src/Image.h"
+#include "../../bcore/src/AsyncTextureLoader.h"
 
 namespace begui {
 
@@ -35,6 +36,8 @@ class ImageBox : public Component
 protected:
 	Image	*m_pImage;
 	Texture	m_texture;
+	size_t	m_imageGeneration;	// of the image, when the texture was last updated
+	AsyncTextureLoader::Handle	m_asyncImage;	// image being loaded in the background, if any
 	bool	m_bResizeImg;	// stretch image to fill the ImageBox area
 
 	std::vector<Vector2> m_selLine;
@@ -46,10 +49,16 @@ protected:
 
 public:
 	ImageBox();
+	virtual ~ImageBox();
 
 	virtual void create(int x, int y, int width, int height, Image *pImg, bool bResizeImg = false);
 
+	// the image is not copied: later changes to it are shown, as Image marks them (see
+	// Image::getChangesSince), and an evicted texture is restored from it. The image must
+	// stay valid until the ImageBox is given another one (or 0), or is destroyed.
 	virtual void setImage(Image *pImg);
+	virtual void setImageAsync(const std::string &filename);	// shows a placeholder until the file is loaded
+	bool		 isImageLoading() const		{ return m_asyncImage.isValid() && !m_asyncImage.isDone(); }
 	virtual void handleMouseDown(const Functor1<Vector2i> fun)	{ m_onMouseDown = fun; }
 	virtual void handleMouseUp(const Functor1<Vector2i> fun)	{ m_onMouseUp = fun; }
 	virtual void handleKeyDown(const Functor1<int> fun)			{ m_onKeyDown = fun; }
@@ -65,8 +74,11 @@ public:
 	virtual void onKeyUp(int key);
 	virtual bool isPtInside(int x, int y);
 
+protected:
+	Texture*	getDisplayTexture();
+	bool		getImageSize(int &w, int &h) const;
 };
 
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include "Label.h"
 #include "Font.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -90,9 +91,9 @@ void Label::onRender()
 
 	// set the text color
 	if (isEnabled())
-		glColor4f(m_textColor.r, m_textColor.g, m_textColor.b, 0.8f);
+		display::setColor(m_textColor.r, m_textColor.g, m_textColor.b, 0.8f);
 	else
-		glColor4f(m_textColor.r, m_textColor.g, m_textColor.b, 0.5f);
+		display::setColor(m_textColor.r, m_textColor.g, m_textColor.b, 0.5f);
 
 	// render the string
 	if (m_bMultiLine)
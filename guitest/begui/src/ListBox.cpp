@@ -25,6 +25,37 @@
 
 using namespace begui;
 
+namespace {
+
+// the properties of a listbox style, resolved once for all listboxes of that style
+struct ListBoxStyle : public ResourceManager::StyleBinding {
+	ResourceManager::ImageRef	face;
+	Rect<int>	activeArea, resizableArea, padding, scrollBarPadding;
+	Color		textColor;
+	bool		bTextColor, bPadding, bScrollBarPadding;
+
+	void bind(const ResourceManager::Style &style) {
+		static const ResourceManager::PropId FACE = ResourceManager::propId("face");
+		static const ResourceManager::PropId ACTIVE_AREA = ResourceManager::propId("active_area");
+		static const ResourceManager::PropId RESIZABLE_AREA = ResourceManager::propId("resizable_area");
+		static const ResourceManager::PropId TEXT_COLOR = ResourceManager::propId("text_color");
+		static const ResourceManager::PropId PADDING = ResourceManager::propId("padding");
+		static const ResourceManager::PropId SCROLLBAR_PADDING = ResourceManager::propId("scrollbar_padding");
+
+		face = ResourceManager::inst()->loadImage(style.get_img(FACE));
+		activeArea = style.get_rect(ACTIVE_AREA);
+		resizableArea = style.get_rect(RESIZABLE_AREA);
+		if (bTextColor = style.hasProp(TEXT_COLOR))
+			textColor = style.get_c(TEXT_COLOR);
+		if (bPadding = style.hasProp(PADDING))
+			padding = style.get_rect(PADDING);
+		if (bScrollBarPadding = style.hasProp(SCROLLBAR_PADDING))
+			scrollBarPadding = style.get_rect(SCROLLBAR_PADDING);
+	}
+};
+
+};
+
 ListBox::ListBox() : 
 	m_curItem(0), m_prevItem(-1), m_selectMode(MULTI_SELECT), m_style(STYLE_FLAT),
 	m_bHighlightMouseOver(false), m_mouseOverItem(-1),
@@ -48,16 +79,17 @@ void ListBox::create(int x, int y, int width, int height, SelectionMode selMode,
 	m_maxHeight = height;
 
 	// load the stylesheet for the listbox
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("ListBox").style(style_name);
-	m_bg = ResourceManager::inst()->loadImage(style.get_img("face"));
-	m_activeArea = style.get_rect("active_area");
-	m_resizableArea = style.get_rect("resizable_area");
-	if (style.hasProp("text_color"))
-		m_textColor = style.get_c("text_color");
-	if (style.hasProp("padding"))
-		m_contentPadding = style.get_rect("padding");
-	if (style.hasProp("scrollbar_padding"))
-		m_scrollBarPadding = style.get_rect("scrollbar_padding");
+	static ResourceManager::BoundStyle<ListBoxStyle> styles("ListBox");
+	const ListBoxStyle &style = styles.get(style_name);
+	m_bg = style.face;
+	m_activeArea = style.activeArea;
+	m_resizableArea = style.resizableArea;
+	if (style.bTextColor)
+		m_textColor = style.textColor;
+	if (style.bPadding)
+		m_contentPadding = style.padding;
+	if (style.bScrollBarPadding)
+		m_scrollBarPadding = style.scrollBarPadding;
 
 	m_scroller.create(width, m_scrollBarPadding.top, 
 		height-m_scrollBarPadding.top-m_scrollBarPadding.bottom, 
@@ -115,10 +147,10 @@ void ListBox::onRender()
 		content_y_offs = -(int)(m_scroller.getScrollPos()*lineHeight);
 	}
 
-	glEnable(GL_BLEND);
+	display::enableBlending(true);
 
 	// draw the listbox background
-	glColor4f(1.0f,1.0f,1.0f,1.0f);
+	display::setColor(1.0f,1.0f,1.0f,1.0f);
 	Component::drawImageWtBorders(m_bg, -m_activeArea.left, -m_activeArea.top,
 		getWidth()+m_activeArea.left + (m_bg.m_width-m_activeArea.right), 
 		getHeight()+m_activeArea.top + (m_bg.m_height-m_activeArea.bottom), 
@@ -198,64 +230,64 @@ void ListBox::onRender()
 			continue;
 		
 		// draw a rectange as item background
-		glColor4f(bgCl.r, bgCl.g, bgCl.b, bgAlpha);
+		display::setColor(bgCl.r, bgCl.g, bgCl.b, bgAlpha);
 		if (m_style != STYLE_FLAT ||
 			(m_items[i].m_bEnabled && m_items[i].m_bSelected) ||
 			(i==m_mouseOverItem && m_bHighlightMouseOver)) {
-			glBegin(GL_QUADS);
-				glVertex2f(left, top);
-				glVertex2f(right, top);
-				glVertex2f(right, bottom);
-				glVertex2f(left, bottom);
-			glEnd();
+			display::startBatch(display::QUADS);
+				display::vertex(left, top);
+				display::vertex(right, top);
+				display::vertex(right, bottom);
+				display::vertex(left, bottom);
+			display::endBatch();
 		}
 		
 		// draw a line frame for the item
 		if (m_style == STYLE_BUTTONS) {
-			glColor4f(0,0,0,0.5f);
-			glBegin(GL_LINES);
-				glVertex2f(left, top);
-				glVertex2f(right, top);
-				glVertex2f(right, top);
-				glVertex2f(right, bottom);
-				glVertex2f(right, bottom);
-				glVertex2f(left, bottom);
-				glVertex2f(left, bottom);
-				glVertex2f(left, top);
-			glEnd();
+			display::setColor(0,0,0,0.5f);
+			display::startBatch(display::LINES);
+				display::vertex(left, top);
+				display::vertex(right, top);
+				display::vertex(right, top);
+				display::vertex(right, bottom);
+				display::vertex(right, bottom);
+				display::vertex(left, bottom);
+				display::vertex(left, bottom);
+				display::vertex(left, top);
+			display::endBatch();
 		}
 		else if (m_style == STYLE_FLAT && i!=m_items.size()-1) {
 			// draw lines separating the items
-			glColor4f(0.4f,0.4f,0.4f,0.3f);
-			glBegin(GL_LINES);
-				glVertex2f(right, bottom);
-				glVertex2f(left, bottom);
-			glEnd();
+			display::setColor(0.4f,0.4f,0.4f,0.3f);
+			display::startBatch(display::LINES);
+				display::vertex(right, bottom);
+				display::vertex(left, bottom);
+			display::endBatch();
 		}
 
 		// if this is the current item, draw a line frame to indicate that
 		if (i == m_curItem) {
-			glColor4f(0.1f, 0.1f, 0.1f, 0.3f);
-			glBegin(GL_LINES);
-				glVertex2f(left+2, top+2);
-				glVertex2f(right-2, top+2);
-				glVertex2f(right-2, top+2);
-				glVertex2f(right-2, bottom-2);
-				glVertex2f(right-2, bottom-2);
-				glVertex2f(left+2, bottom-2);
-				glVertex2f(left+2, bottom-2);
-				glVertex2f(left+2, top+2);
-			glEnd();
+			display::setColor(0.1f, 0.1f, 0.1f, 0.3f);
+			display::startBatch(display::LINES);
+				display::vertex(left+2, top+2);
+				display::vertex(right-2, top+2);
+				display::vertex(right-2, top+2);
+				display::vertex(right-2, bottom-2);
+				display::vertex(right-2, bottom-2);
+				display::vertex(left+2, bottom-2);
+				display::vertex(left+2, bottom-2);
+				display::vertex(left+2, top+2);
+			display::endBatch();
 		}
 
-		glColor4f(textCl.r, textCl.g, textCl.b, textAlpha);
+		display::setColor(textCl.r, textCl.g, textCl.b, textAlpha);
 		Font::renderString((int)left + 2, (int)bottom-3, m_items[i].m_text.getText());
 	}
 	
 	display::popMask();
 
 	if (bNeedsScrolling) {
-		glColor4f(1,1,1,1);
+		display::setColor(1,1,1,1);
 		m_scroller.frameRender();
 	}
 }
@@ -110,7 +110,7 @@ public:
 	void		selectItem(size_t i, bool bSel)		{ m_items[i].m_bSelected = bSel; }
 	void		setHighlightOnMouseOver(bool b)		{ m_bHighlightMouseOver = b; }
 
-	void	handleOnItemSelect(Functor1<int> &f)		{ m_onItemSelect = f; }
+	void	handleOnItemSelect(const Functor1<int> &f)		{ m_onItemSelect = f; }
 
 private:
 	void selectRange(size_t start, size_t end);
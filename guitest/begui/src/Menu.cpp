@@ -62,7 +62,7 @@ void Menu::createMainMenu(const std::string &style_name)
 	m_bottom = 25;
 
 	// get the style properties
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("Menu").style("std");
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("Menu").style("std");
 	ASSERT(style.hasProp("menubar_face"));
 	m_menuFace = ResourceManager::inst()->loadImage(style.get_img("menubar_face"));
 	m_menuFaceResizableArea = style.get_rect("resizable_area");
@@ -80,7 +80,7 @@ void Menu::close()
 	m_itemOpen = false;
 }
 
-Menu* Menu::addMenuItem(const std::string &title, int id, Functor1<int> &callback)
+Menu* Menu::addMenuItem(const std::string &title, int id, const Functor1<int> &callback)
 {
 	Menu *menu = new Menu();
 	menu->m_title = title;
@@ -168,9 +168,8 @@ void Menu::onRender()
 	int w = m_right-m_left;
 	int h = 25;
 	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glColor4f(1,1,1,1);
+	display::enableBlending(true);
+	display::setColor(1,1,1,1);
 
 	if (m_isMainMenu)
 	{
@@ -180,12 +179,12 @@ void Menu::onRender()
 	{
 		// set the texture of a window
 		Texture *pTex = ResourceManager::inst()->getStockMap(ResourceManager::STD_CONTROLS);
-		pTex->set();
+		display::bindTexture(pTex);
 
 		// This is a submenu or a menuitem
 		if (m_menuItems.size() > 0)
 		{
-			glColor4f(1,1,1,0.9f);
+			display::setColor(1,1,1,0.9f);
 			float tW = 512;	// texture width;
 			float tH = 512;	// texture width;
 			float wtL = 0;		// window left in pixels in texture
@@ -205,54 +204,54 @@ void Menu::onRender()
 		}
 	}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	display::bindTexture(0);
 
 	// highlight selected menu item
 	if (m_activeItem != -1 && !m_menuItems[m_activeItem]->m_bSeparator)
 	{
 		Menu *mi = m_menuItems[m_activeItem];
 		if (m_itemOpen || !m_isMainMenu)
-			glColor3f(0.9f, 0.5f, 0);
+			display::setColor(0.9f, 0.5f, 0);
 		else
-			glColor3f(0.6f, 0.6f, 0.6f);
+			display::setColor(0.6f, 0.6f, 0.6f);
 		int hl_right = mi->m_right;
 		if (!m_isMainMenu)
 			hl_right = mi->m_left + m_contentWidth - 40;
-		glBegin(GL_QUADS);
-			glVertex3f((float)mi->m_left, (float)mi->m_top, 0);
-			glVertex3f((float)mi->m_right, (float)mi->m_top, 0);
-			glVertex3f((float)mi->m_right, (float)mi->m_bottom, 0);
-			glVertex3f((float)mi->m_left, (float)mi->m_bottom, 0);
+		display::startBatch(display::QUADS);
+			display::vertex((float)mi->m_left, (float)mi->m_top);
+			display::vertex((float)mi->m_right, (float)mi->m_top);
+			display::vertex((float)mi->m_right, (float)mi->m_bottom);
+			display::vertex((float)mi->m_left, (float)mi->m_bottom);
 			
-			glColor4f(0.9f, 0.5f, 0, 1); glVertex3f((float)mi->m_right, (float)mi->m_top, 0);
-			glColor4f(0.7f, 0.4f, 0, 1); glVertex3f((float)hl_right, (float)mi->m_top, 0);
-			glColor4f(0.7f, 0.4f, 0, 1); glVertex3f((float)hl_right, (float)mi->m_bottom, 0);
-			glColor4f(0.9f, 0.5f, 0, 1); glVertex3f((float)mi->m_right, (float)mi->m_bottom, 0);
-		glEnd();
+			display::setColor(0.9f, 0.5f, 0, 1); display::vertex((float)mi->m_right, (float)mi->m_top);
+			display::setColor(0.7f, 0.4f, 0, 1); display::vertex((float)hl_right, (float)mi->m_top);
+			display::setColor(0.7f, 0.4f, 0, 1); display::vertex((float)hl_right, (float)mi->m_bottom);
+			display::setColor(0.9f, 0.5f, 0, 1); display::vertex((float)mi->m_right, (float)mi->m_bottom);
+		display::endBatch();
 	}
 	
-	glDisable(GL_BLEND);
+	display::enableBlending(false);
 
 	// render menu item text
 	for (size_t i=0; i<m_menuItems.size(); ++i)
 	{
 		// set the text color
-		glColor4f(m_textColor.r, m_textColor.g, m_textColor.b, 1.0f);
+		display::setColor(m_textColor.r, m_textColor.g, m_textColor.b, 1.0f);
 		if (m_menuItems[i]->m_bSeparator)
-			glColor3f(0.6f,0.6f,0.6f);
+			display::setColor(0.6f,0.6f,0.6f);
 		else if (!m_menuItems[i]->isEnabled())
-			glColor3f(0.5f, 0.5f, 0.5f);
+			display::setColor(0.5f, 0.5f, 0.5f);
 		else if (i == m_activeItem)
-			glColor3f(1,1,1);
+			display::setColor(1,1,1);
 
 		// render the menu item text
 		Font::renderString(m_menuItems[i]->m_left+5, m_menuItems[i]->m_top + 11, m_menuItems[i]->m_title);
 	}
-	glColor3f(1,1,1);
+	display::setColor(1,1,1);
 
 	Texture *pTex = ResourceManager::inst()->getStockMap(ResourceManager::STD_CONTROLS);
-	pTex->set();
-	glEnable(GL_BLEND);
+	display::bindTexture(pTex);
+	display::enableBlending(true);
 	
 	// render the check marks next to menu items
 	for (size_t i=0; i<m_menuItems.size(); ++i)
@@ -270,21 +269,21 @@ void Menu::onRender()
 			float chV = 4;
 
 			if (!m_menuItems[i]->isEnabled())
-				glColor4f(0, 0, 0, 0.25f);
+				display::setColor(0, 0, 0, 0.25f);
 			else
-				glColor4f(0,0,0, 0.8f);
-
-			glBegin(GL_QUADS);
-				glTexCoord2f(chU/512.0f, chV/512.0f);				glVertex3f((float)mi->m_right, (float)mi->m_bottom-11, 0);
-				glTexCoord2f((chU+chW)/512.0f, chV/512.0f);			glVertex3f((float)mi->m_right+8, (float)mi->m_bottom-11, 0);
-				glTexCoord2f((chU+chW)/512.0f, (chV+chH)/512.0f);	glVertex3f((float)mi->m_right+8, (float)mi->m_bottom-1, 0);
-				glTexCoord2f(chU/512.0f, (chV+chH)/512.0f);			glVertex3f((float)mi->m_right, (float)mi->m_bottom-1, 0);
-			glEnd();
+				display::setColor(0,0,0, 0.8f);
+
+			display::startBatch(display::QUADS);
+				display::texCoord(chU/512.0f, chV/512.0f);				display::vertex((float)mi->m_right, (float)mi->m_bottom-11);
+				display::texCoord((chU+chW)/512.0f, chV/512.0f);			display::vertex((float)mi->m_right+8, (float)mi->m_bottom-11);
+				display::texCoord((chU+chW)/512.0f, (chV+chH)/512.0f);	display::vertex((float)mi->m_right+8, (float)mi->m_bottom-1);
+				display::texCoord(chU/512.0f, (chV+chH)/512.0f);			display::vertex((float)mi->m_right, (float)mi->m_bottom-1);
+			display::endBatch();
 		}
 	}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glDisable(GL_BLEND);
+	display::bindTexture(0);
+	display::enableBlending(false);
 
 	// render the rolled-down submenu, if any
 	if (m_itemOpen)
@@ -72,7 +72,7 @@ public:
 			bool isPtInsideSubmenu(int x, int y);
 	virtual void onDeactivate();
 
-	Menu*	addMenuItem(const std::string &title, int id, Functor1<int>& callback);
+	Menu*	addMenuItem(const std::string &title, int id, const Functor1<int>& callback);
 	void	addSeparator();
 	Menu*	getMenuItem(const std::string &title);
 	Menu*	getMenuItem(int id);
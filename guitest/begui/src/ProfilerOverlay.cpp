@@ -0,0 +1,236 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ProfilerOverlay.h"
+#include "Font.h"
+#include "util.h"
+
+using namespace begui;
+
+#define HIST_BINS			25
+#define HIST_BIN_MSEC		2.0
+
+namespace {
+
+// a stable color for each zone name
+void zoneColor(const char *name)
+{
+	unsigned int h = 5381;
+	for (const char *c = name; *c; ++c)
+		h = h*33 + (unsigned char)*c;
+	display::setColor(0.45f + 0.4f*((h & 0xff)/255.0f),
+				0.35f + 0.4f*(((h >> 8) & 0xff)/255.0f),
+				0.25f + 0.3f*(((h >> 16) & 0xff)/255.0f), 0.9f);
+}
+
+// names of component zones come from typeid, as "class begui::Button"
+const char* displayName(const char *name)
+{
+	if (strncmp(name, "class ", 6) == 0)
+		return name+6;
+	return name;
+}
+
+void drawRect(float l, float t, float r, float b)
+{
+	display::startBatch(display::QUADS);
+		display::vertex(l, t);
+		display::vertex(r, t);
+		display::vertex(r, b);
+		display::vertex(l, b);
+	display::endBatch();
+}
+
+};
+
+ProfilerOverlay::ProfilerOverlay() : m_traceFilename("profile_trace.json"), m_lastStatsFrame(0)
+{
+}
+
+void ProfilerOverlay::onCreate()
+{
+	int w = getClientArea().getWidth();
+
+	m_flameGraph.setPos(8, 8);
+	m_flameGraph.setSize(w-16, 140);
+	addComponent(&m_flameGraph);
+
+	m_histogram.setPos(8, 156);
+	m_histogram.setSize(w-16, 90);
+	addComponent(&m_histogram);
+
+	m_stats.createMultiline(8, 254, w-130, "");
+	addComponent(&m_stats);
+
+	Functor1<int> onBtn = makeFunctor(*this, &ProfilerOverlay::onButton);
+	m_pauseBtn.create(w-110, 254, 100, 20, "Pause", 1, onBtn);
+	addComponent(&m_pauseBtn);
+	m_exportBtn.create(w-110, 280, 100, 20, "Export trace", 2, onBtn);
+	addComponent(&m_exportBtn);
+}
+
+void ProfilerOverlay::onUpdate()
+{
+	if (!isVisible())
+		return;
+
+	Profiler *pProf = Profiler::inst();
+	const Profiler::Frame *pLast = pProf->getLastFrame();
+	if (!Profiler::isCompiledIn()) {
+		if (m_lastStatsFrame == 0) {
+			m_stats.setText("Profiling is not compiled in (define BCORE_PROFILER)");
+			m_lastStatsFrame = 1;
+		}
+		return;
+	}
+	if (!pLast || pLast->id < m_lastStatsFrame + 15)	// refresh the text a few times per second only
+		return;
+	m_lastStatsFrame = pLast->id;
+
+	double avg = 0, maxDur = 0;
+	for (size_t i=0; i<pProf->getFramesNum(); ++i) {
+		double d = pProf->getFrame(i).getDuration();
+		avg += d;
+		if (d > maxDur) maxDur = d;
+	}
+	avg /= pProf->getFramesNum();
+
+	char buf[512];
+	sprintf(buf, "frame %.2f ms (avg %.2f, max %.2f over %d frames)\n"
+				"vertices: %d   texture binds: %d   scissor changes: %d\n"
+				"texture uploads: %d (%.1f KB)",
+				pLast->getDuration()*1000, avg*1000, maxDur*1000, (int)pProf->getFramesNum(),
+				pLast->counters[Profiler::VERTICES], pLast->counters[Profiler::TEXTURE_BINDS],
+				pLast->counters[Profiler::SCISSOR_CHANGES], pLast->counters[Profiler::TEXTURE_UPLOADS],
+				pLast->counters[Profiler::UPLOAD_BYTES]/1024.0);
+	m_stats.setText(buf);
+}
+
+void ProfilerOverlay::onButton(int id)
+{
+	switch (id) {
+		case 1:
+			Profiler::inst()->setEnabled(!Profiler::inst()->isEnabled());
+			m_pauseBtn.setTitle(Profiler::inst()->isEnabled() ? "Pause" : "Resume");
+			break;
+		case 2:
+			if (Profiler::inst()->exportChromeTrace(m_traceFilename))
+				Console::print("Profiler trace written to %s\n", m_traceFilename.c_str());
+			break;
+	}
+}
+
+void ProfilerOverlay::FlameGraph::onRender()
+{
+	int w = getWidth();
+	int h = getHeight();
+
+	display::enableTexture(0, false);
+	display::setColor(0,0,0,0.6f);
+	drawRect(0, 0, (float)w, (float)h);
+
+	const Profiler::Frame *pFrame = Profiler::inst()->getLastFrame();
+	if (!pFrame || pFrame->getDuration() <= 0)
+		return;
+
+	Vector2i wpos = localToWorld(Vector2i(0,0));
+	display::pushMask(wpos.x, wpos.y, w, h);
+
+	const int rowH = 16;
+	double scale = w / pFrame->getDuration();
+	for (size_t i=0; i<pFrame->zones.size(); ++i)
+	{
+		const Profiler::ZoneEvent &ev = pFrame->zones[i];
+		float l = (float)((ev.start - pFrame->start)*scale);
+		float r = (float)((ev.end - pFrame->start)*scale);
+		float t = (float)(ev.depth*rowH);
+		if (r - l < 1) r = l+1;
+		if (t >= h)
+			continue;
+
+		display::enableTexture(0, false);
+		zoneColor(ev.name);
+		drawRect(l, t, r, t+rowH-1);
+
+		// label the zones that are wide enough
+		const char *name = displayName(ev.name);
+		if (r - l > 40) {
+			display::pushMask(wpos.x+(int)l, wpos.y+(int)t, (int)(r-l), rowH);
+			display::setColor(0,0,0,1);
+			Font::renderString((int)l+2, (int)t+rowH-4, name);
+			display::popMask();
+		}
+	}
+
+	display::popMask();
+	display::enableTexture(0, false);
+}
+
+void ProfilerOverlay::FrameHistogram::onRender()
+{
+	int w = getWidth();
+	int h = getHeight();
+
+	display::enableTexture(0, false);
+	display::setColor(0,0,0,0.6f);
+	drawRect(0, 0, (float)w, (float)h);
+
+	Profiler *pProf = Profiler::inst();
+	if (pProf->getFramesNum() == 0)
+		return;
+
+	// bin the frame times, the last bin takes everything slower
+	int bins[HIST_BINS] = {0};
+	int maxCount = 1;
+	for (size_t i=0; i<pProf->getFramesNum(); ++i) {
+		int b = (int)(pProf->getFrame(i).getDuration()*1000 / HIST_BIN_MSEC);
+		if (b >= HIST_BINS) b = HIST_BINS-1;
+		if (++bins[b] > maxCount) maxCount = bins[b];
+	}
+	int lastBin = (int)(pProf->getLastFrame()->getDuration()*1000 / HIST_BIN_MSEC);
+	if (lastBin >= HIST_BINS) lastBin = HIST_BINS-1;
+
+	float binW = (float)w / HIST_BINS;
+	for (int b=0; b<HIST_BINS; ++b) {
+		if (bins[b] == 0)
+			continue;
+		if (b == lastBin)
+			display::setColor(1.0f, 0.8f, 0.3f, 0.9f);
+		else
+			display::setColor(0.4f, 0.7f, 1.0f, 0.8f);
+		float bh = (float)(h-2) * bins[b] / maxCount;
+		drawRect(b*binW+1, h-bh, (b+1)*binW-1, (float)h);
+	}
+
+	// 60 and 30 fps markers
+	display::setColor(1,0.3f,0.3f,0.8f);
+	float x60 = (float)(1000.0/60/HIST_BIN_MSEC*binW);
+	float x30 = (float)(1000.0/30/HIST_BIN_MSEC*binW);
+	display::startBatch(display::LINES);
+		display::vertex(x60, 0); display::vertex(x60, (float)h);
+		display::vertex(x30, 0); display::vertex(x30, (float)h);
+	display::endBatch();
+
+	display::setColor(1,1,1,0.8f);
+	Font::renderString((int)x60+2, 12, "16.7 ms");
+	Font::renderString((int)x30+2, 12, "33.3 ms");
+	display::enableTexture(0, false);
+}
@@ -0,0 +1,82 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _PROFILEROVERLAY_H42631_INCLUDED_
+#define _PROFILEROVERLAY_H42631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Window.h"
+#include "Label.h"
+#include "Button.h"
+#include "../../bcore/src/Profiler.h"
+
+namespace begui {
+
+/**
+ * ProfilerOverlay: a window that shows the data recorded by the Profiler: a flame
+ *		graph of the zones of the last frame, a histogram of the recent frame times
+ *		and the per-frame counters. It can pause recording and export the recorded
+ *		frames as a Chrome trace.
+ *
+ *		Profiling data is only recorded when the libraries are built with
+ *		BCORE_PROFILER defined.
+ */
+class ProfilerOverlay : public Window
+{
+public:
+	// flame graph of the zones of a frame: x is time, y is nesting depth
+	class FlameGraph : public Component {
+	public:
+		virtual void onRender();
+	};
+
+	// distribution of the durations of the frames kept by the profiler
+	class FrameHistogram : public Component {
+	public:
+		virtual void onRender();
+	};
+
+private:
+	FlameGraph		m_flameGraph;
+	FrameHistogram	m_histogram;
+	Label			m_stats;
+	Button			m_pauseBtn, m_exportBtn;
+	std::string		m_traceFilename;
+	size_t			m_lastStatsFrame;
+
+public:
+	ProfilerOverlay();
+
+	virtual void onCreate();
+	virtual void onUpdate();
+
+	void	toggle()								{ setVisible(!isVisible()); }
+	void	setTraceFilename(const std::string &fname)	{ m_traceFilename = fname; }
+
+private:
+	void	onButton(int id);
+};
+
+};
+
+#endif
@@ -23,6 +23,7 @@
 #include "Font.h"
 #include "ResourceManager.h"
 #include "Container.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -43,7 +44,7 @@ void RadioButton::create(int x, int y, const std::string &title, int id, void (*
 	m_bHover = false;
 
 	// load style
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("RadioButton").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("RadioButton").style(style_name);
 	ASSERT(style.hasProp("face_up"));
 	m_faces[SELECTED] = ResourceManager::inst()->loadImage(style.get_img("face_up"));
 	ASSERT(style.hasProp("face_down"));
@@ -67,17 +68,17 @@ void RadioButton::onRender()
 {
 	ResourceManager::ImageRef &img = m_faces[m_state];
 	ASSERT(img.m_texture);
-	glEnable(GL_BLEND);
+	display::enableBlending(true);
 	if (m_bHover)
-		glColor4f(1,1,1,0.7f);
+		display::setColor(1,1,1,0.7f);
 	else
-		glColor4f(1,1,1,1);
+		display::setColor(1,1,1,1);
 	Component::drawImage(img, -m_activeArea.left, -m_activeArea.top);
 
 	// render the text
-	glColor4f(0.3f,0.3f,0.3f,1);
+	display::setColor(0.3f,0.3f,0.3f,1);
 	if (m_state == RadioButton::INACTIVE)
-		glColor4f(0.6f, 0.6f, 0.6f, 1);
+		display::setColor(0.6f, 0.6f, 0.6f, 1);
 	Font::renderString(m_activeArea.getWidth() + 6, FontManager::getCurFont()->getLineHeight()-1, m_title);
 }
 
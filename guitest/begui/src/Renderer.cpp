@@ -0,0 +1,104 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "Renderer.h"
+
+using namespace begui;
+
+void GLRenderer::clear()
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void GLRenderer::startBatch(display::PrimitiveType prim)
+{
+	switch (prim) {
+		case display::POINTS:		glBegin(GL_POINTS); break;
+		case display::LINES:		glBegin(GL_LINES); break;
+		case display::TRIANGLES:	glBegin(GL_TRIANGLES); break;
+		case display::QUADS:		glBegin(GL_QUADS); break;
+		default: ASSERT(0);
+	}
+}
+
+void GLRenderer::endBatch()
+{
+	glEnd();
+}
+
+void GLRenderer::enableBlending(bool bEnable)
+{
+	if (bEnable) {
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	else
+		glDisable(GL_BLEND);
+}
+
+void GLRenderer::enableTexture(bool bEnable)
+{
+	if (bEnable)
+		glEnable(GL_TEXTURE_2D);
+	else
+		glDisable(GL_TEXTURE_2D);
+}
+
+void GLRenderer::bindTexture(Texture *pTex)
+{
+	if (pTex)
+		pTex->set();
+	else
+		glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GLRenderer::pushState()
+{
+	glPushAttrib(GL_TEXTURE_BIT | GL_ENABLE_BIT);
+}
+
+void GLRenderer::popState()
+{
+	glPopAttrib();
+}
+
+void GLRenderer::setScissor(const Rect<int> *pRect)
+{
+	if (pRect) {
+		glScissor(pRect->left, pRect->top, pRect->getWidth(), pRect->getHeight());
+		glEnable(GL_SCISSOR_TEST);
+	}
+	else
+		glDisable(GL_SCISSOR_TEST);
+}
+
+void GLRenderer::pushTranslation(float x, float y)
+{
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glTranslatef(x, y, 0);
+}
+
+void GLRenderer::popTranslation()
+{
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+}
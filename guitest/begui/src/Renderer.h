@@ -0,0 +1,92 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _RENDERER_H42631_INCLUDED_
+#define _RENDERER_H42631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Display.h"
+#include "../../bcore/src/Rect.h"
+
+namespace begui {
+
+/**
+ * Renderer: the backend used by the display:: drawing commands. Components
+ *		draw through display::, which forwards to the active renderer, so the
+ *		same widget code can draw with OpenGL or into an image in memory.
+ *
+ *		Coordinates are in pixels of the current reference frame, with the
+ *		translations pushed by the containers applied to them.
+ */
+class Renderer
+{
+public:
+	virtual ~Renderer() { }
+
+	virtual void clear() = 0;
+	virtual void startBatch(display::PrimitiveType prim) = 0;
+	virtual void endBatch() = 0;
+	virtual void vertex(float x, float y) = 0;
+	virtual void texCoord(float u, float v) = 0;
+	virtual void setColor(float r, float g, float b, float a) = 0;
+	virtual void enableBlending(bool bEnable) = 0;
+	virtual void enableTexture(bool bEnable) = 0;
+	virtual void bindTexture(Texture *pTex) = 0;	// also enables texturing, 0 unbinds
+
+	// save/restore the texture and blending states
+	virtual void pushState() = 0;
+	virtual void popState() = 0;
+
+	// scissor rectangle in window coordinates, with the origin at the bottom-left
+	// corner as in glScissor. A null rectangle disables the scissor test.
+	virtual void setScissor(const Rect<int> *pRect) = 0;
+
+	virtual void pushTranslation(float x, float y) = 0;
+	virtual void popTranslation() = 0;
+};
+
+/**
+ * GLRenderer: draws with OpenGL immediate mode, in the current GL context.
+ */
+class GLRenderer : public Renderer
+{
+public:
+	virtual void clear();
+	virtual void startBatch(display::PrimitiveType prim);
+	virtual void endBatch();
+	virtual void vertex(float x, float y)						{ glVertex2f(x, y); }
+	virtual void texCoord(float u, float v)						{ glTexCoord2f(u, v); }
+	virtual void setColor(float r, float g, float b, float a)	{ glColor4f(r, g, b, a); }
+	virtual void enableBlending(bool bEnable);
+	virtual void enableTexture(bool bEnable);
+	virtual void bindTexture(Texture *pTex);
+	virtual void pushState();
+	virtual void popState();
+	virtual void setScissor(const Rect<int> *pRect);
+	virtual void pushTranslation(float x, float y);
+	virtual void popTranslation();
+};
+
+};
+
+#endif
@@ -20,9 +20,14 @@
 */
 
 #include "ResourceManager.h"
-#include "../../bcore/src/BaseTextFile.h"
+#include "SkinCompiler.h"
 #include "../../bcore/src/Image.h"
+#include "../../bcore/src/TextureBudget.h"
+#include "../../bcore/src/SharedContextLoader.h"
+#ifdef _WIN32
 #include <direct.h>
+#endif
+#include <sys/stat.h>
 
 #pragma warning (disable : 4996)
 
@@ -31,7 +36,41 @@ using namespace begui;
 // The singleton instance
 ResourceManager *ResourceManager::m_instance;
 
-ResourceManager::ResourceManager()
+stdext::hash_map<std::string, ResourceManager::PropId>	ResourceManager::m_propIds;
+std::vector<std::string>	ResourceManager::m_propNames;
+
+namespace {
+	// decodes an image and creates its texture on the loader thread, and hands the
+	// texture over to a texture object that is already in use
+	class StockTextureTask : public SharedContextLoader::Task {
+		Texture		*m_pTarget;
+		Texture		*m_pTexture;
+		std::string	m_filename, m_alphaFilename;
+	public:
+		StockTextureTask(Texture *pTarget, const std::string &filename, const std::string &alphaFilename = "") :
+			m_pTarget(pTarget), m_pTexture(0), m_filename(filename), m_alphaFilename(alphaFilename) { }
+		virtual ~StockTextureTask()	{ SAFE_DELETE(m_pTexture); }
+
+		virtual bool load() {
+			Image img;
+			bool bOk = (m_alphaFilename.empty()) ? img.load(m_filename) : img.loadWithAlpha(m_filename, m_alphaFilename);
+			if (!bOk)
+				return false;
+			m_pTexture = new Texture();
+			m_pTexture->create(img);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			return m_pTexture->isLoaded();
+		}
+		virtual void onLoaded(bool bOk) {
+			if (bOk)
+				m_pTarget->swap(*m_pTexture);
+			else
+				Console::error("ResourceManager: failed to load %s\n", m_filename.c_str());
+		}
+	};
+};
+
+ResourceManager::ResourceManager() : m_stylesGeneration(1)
 {
 }
 
@@ -49,22 +88,29 @@ void ResourceManager::loadResources()
 
 	if (!loadPropertyFile(getResourceDir() + "style.txt"))
 		return;
-	
-	Image img;
-	img.load(getResourceDir() + "bg.png");
+
+	// the stock textures are decoded and created by the loader thread. The texture
+	// objects exist from now on, and get their contents when the loader hands them over.
 	Texture *bgtex = new Texture();
-	bgtex->create(img);
 	m_loadedTextures.push_back(bgtex);
+	SharedContextLoader::inst()->submit(new StockTextureTask(bgtex, getResourceDir() + "bg.png"));
 
 	Texture *wnd_controls = new Texture();
-	img.loadWithAlpha(getResourceDir() + "widgets.bmp", getResourceDir() + "widgets_alpha.bmp");
-	wnd_controls->create(img);
 	m_loadedTextures.push_back(wnd_controls);
+	SharedContextLoader::inst()->submit(new StockTextureTask(wnd_controls, getResourceDir() + "widgets.bmp",
+															getResourceDir() + "widgets_alpha.bmp"));
 }
 
 void ResourceManager::freeResources()
 {
-	// Free all allocated resources
+	// the loader may still be working on the stock textures
+	SharedContextLoader::inst()->finish();
+
+	// Free all allocated resources. The bound styles are bound again when next used.
+	m_stylesGeneration++;
+	for (stdext::hash_map<std::string, AsyncTextureLoader::Handle>::iterator it = m_asyncImages.begin(); it != m_asyncImages.end(); ++it)
+		it->second.cancel();
+	m_asyncImages.clear();
 	m_images.clear();
 	for (size_t i=0; i<m_loadedTextures.size(); ++i)
 		SAFE_DELETE(m_loadedTextures[i]);
@@ -91,6 +137,8 @@ ResourceManager::ImageRef ResourceManager::loadImage(const std::string &filename
 	// if bForceDuplicate is true, then we have to reload the image anyway
 	if (!bForceDuplicate)
 	{
+		finishAsync(filename);
+
 		stdext::hash_map<std::string, ImageRef>::const_iterator it = m_images.find(filename);
 		if (it != m_images.end())
 			return it->second;
@@ -103,6 +151,7 @@ ResourceManager::ImageRef ResourceManager::loadImage(const std::string &filename
 	Texture *tex = new Texture; // TEMP! should try to pack image in other textures, if possible
 	tex->create(img);
 	m_loadedTextures.push_back(tex);
+	TextureBudget::inst()->setReloader(tex->getGLTex(), new TextureBudget::FileReloader(getResourceDir() + filename));
 	
 	iref.m_texture = tex;
 	iref.m_topLeft = Vector2(0,0);
@@ -115,6 +164,50 @@ ResourceManager::ImageRef ResourceManager::loadImage(const std::string &filename
 	return iref;
 }
 
+void ResourceManager::loadImageAsync(const std::string &filename)
+{
+	if (m_images.find(filename) != m_images.end() || isImageLoading(filename))
+		return;
+	m_asyncImages[filename] = AsyncTextureLoader::inst()->load(getResourceDir() + filename);
+}
+
+bool ResourceManager::finishAsync(const std::string &filename)
+{
+	stdext::hash_map<std::string, AsyncTextureLoader::Handle>::iterator it = m_asyncImages.find(filename);
+	if (it == m_asyncImages.end())
+		return false;
+
+	Texture *tex = it->second.releaseTexture();
+	if (!tex) {
+		it->second.cancel();	// not done: loadImage(..) loads the file itself
+		m_asyncImages.erase(it);
+		return false;
+	}
+	m_asyncImages.erase(it);
+	m_loadedTextures.push_back(tex);
+	TextureBudget::inst()->setReloader(tex->getGLTex(), new TextureBudget::FileReloader(getResourceDir() + filename, false));
+
+	// the texture has the size of the image
+	ImageRef iref;
+	iref.m_texture = tex;
+	iref.m_topLeft = Vector2(0,0);
+	iref.m_bottomRight = Vector2(1,1);
+	iref.m_width = tex->getWidth();
+	iref.m_height = tex->getHeight();
+	m_images.insert(std::pair<std::string, ImageRef>(filename, iref));
+	return true;
+}
+
+void ResourceManager::update()
+{
+	std::vector<std::string> done;
+	for (stdext::hash_map<std::string, AsyncTextureLoader::Handle>::const_iterator it = m_asyncImages.begin(); it != m_asyncImages.end(); ++it)
+		if (it->second.isDone())
+			done.push_back(it->first);
+	for (size_t i=0; i<done.size(); ++i)
+		finishAsync(done[i]);
+}
+
 ResourceManager::ImageRef ResourceManager::loadImage(const ResourceManager::ImageDesc &desc)
 {
 	ImageRef iref = loadImage(desc.filename, false, false);
@@ -144,157 +237,63 @@ void ResourceManager::setResourceDir(const std::string &resdir)
 
 bool ResourceManager::loadPropertyFile(const std::string& fname)
 {
-	BaseTextFile file;
-	if (!file.loadFile(fname))
-		throw std::exception(("could not open file: " + fname).c_str());
-	file.addLineCommentDef("#");
-	file.skipComments(true);
-	file.addWordBreakChar('{');
-	file.addWordBreakChar('}');
-	file.addWordBreakChar(',');
-	file.addWordBreakChar('=');
-
-	try {
-		while (!file.eof()) {
-			std::string token;
-
-			file >> token;
-			if (file.eof()) break;	// handle trailing whitespace in the file
-
-			if (token == "class")
-			{
-				// read the class name
-				std::string class_name;
-				file >> class_name;
-
-				// create the new class
-				ClassDef cls;
-				cls.m_name = class_name;
-
-				file >> token;
-				if (token != "{")
-					throw std::exception("'{' expected");
-
-				// read the class definition
-				while (!file.eof())
-				{
-					file >> token;
-					if (token == "}")
-						break;
-
-					if (token == "style") {
-						// read a style for this class
-
-						// read the style name
-						std::string style_name;
-						file >> style_name;
-
-						file >> token;
-						if (token != "{")
-							throw std::exception("'{' expected");
-						
-						// create the new style
-						Style style;
-						style.m_name = style_name;
-
-						// read the class definition
-						while (!file.eof())
-						{
-							file >> token;
-							if (token == "}")
-								break;
-
-							std::string var_type = token;
-							std::string var_name;
-							file >> var_name;
-
-							file >> token;
-							if (token != "=")
-								throw std::exception("'=' expected");
-							if (var_type == "int") {
-								int var_val;
-								file >> var_val;
-								style.m_iVals.insert(std::pair<std::string, int>(var_name, var_val));
-							}
-							else if (var_type == "float") {
-								double var_val;
-								file >> var_val;
-								style.m_fVals.insert(std::pair<std::string, double>(var_name, var_val));
-							}
-							else if (var_type == "string") {
-								std::string var_val = file.getline();
-								style.m_sVals.insert(std::pair<std::string, std::string>(var_name, var_val));
-							}
-							else if (var_type == "color") {
-								Color cl;
-								file >> cl.r;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> cl.g;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> cl.b;
-								style.m_cVals.insert(std::pair<std::string, Color>(var_name, cl/255.0f));
-							}
-							else if (var_type == "image") {
-								ImageDesc desc;
-								file >> desc.left;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> desc.top;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> desc.right;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> desc.bottom;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								desc.filename = file.getline();
-
-								style.m_imgVals.insert(std::pair<std::string, ImageDesc>(var_name, desc));
-							}
-							else if (var_type == "rect") {
-								Rect<int> rect;
-								file >> rect.left;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> rect.top;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> rect.right;
-								file >> token;
-								if (token != ",") throw std::exception(("expected ',', found: " + token).c_str());
-								file >> rect.bottom;
-
-								style.m_riVals.insert(std::pair<std::string, Rect<int> >(var_name, rect));
-							}
-							else
-								throw std::exception(("unknown variable type: " + var_type).c_str());
-						}
-
-						// add the style to the class
-						cls.m_styles.insert(std::pair<std::string, ResourceManager::Style>(style_name, style));
-					}
-				}
-
-				// add the class definition to the list
-				m_classes.insert(std::pair<std::string, ResourceManager::ClassDef>(class_name, cls));
-			}
-			else
-				throw std::exception("'class' expected");
-		}
-	}
-	catch (std::exception e)
+	m_stylesGeneration++;
+
+	// use the compiled skin if it is newer than the style file
+	std::string skinFile = fname.substr(0, fname.find_last_of('.')) + ".skn";
+	struct _stat textStat, skinStat;
+	if (_stat(fname.c_str(), &textStat) != 0 ||
+		(_stat(skinFile.c_str(), &skinStat) == 0 && skinStat.st_mtime > textStat.st_mtime))
 	{
-		char str[1024];
-		sprintf(str, "parsing error (file %s, line %d): %s\n", fname.c_str(), file.getCurLine(), e.what());
-		Console::error(str);
-		file.close();
-		return false;
+		SkinCompiler::ClassMap classes;
+		if (SkinCompiler::load(skinFile, classes)) {
+			m_classes.insert(classes.begin(), classes.end());
+			return true;
+		}
 	}
 
-	file.close();
+	// parse the text, and compile it for the next time
+	SkinCompiler::ClassMap classes;
+	if (!SkinCompiler::parse(fname, classes))
+		return false;
+	m_classes.insert(classes.begin(), classes.end());
+	if (!SkinCompiler::save(classes, skinFile))
+		Console::print("could not write compiled skin: %s\n", skinFile.c_str());
 
 	return true;
-}
\ No newline at end of file
+}
+
+ResourceManager::PropId ResourceManager::propId(const std::string &name)
+{
+	stdext::hash_map<std::string, PropId>::const_iterator it = m_propIds.find(name);
+	if (it != m_propIds.end())
+		return it->second;
+	PropId id = (PropId)m_propNames.size();
+	m_propIds[name] = id;
+	m_propNames.push_back(name);
+	return id;
+}
+
+ResourceManager::PropId ResourceManager::findPropId(const std::string &name)
+{
+	stdext::hash_map<std::string, PropId>::const_iterator it = m_propIds.find(name);
+	return (it != m_propIds.end()) ? it->second : -1;
+}
+
+const std::string& ResourceManager::propName(PropId id)
+{
+	ASSERT(id >= 0 && id < (PropId)m_propNames.size());
+	return m_propNames[id];
+}
+
+void ResourceManager::Style::sortProps()
+{
+	std::stable_sort(m_props.begin(), m_props.end());
+
+	// keep the first value of properties given more than once
+	size_t n = 0;
+	for (size_t i=0; i<m_props.size(); ++i)
+		if (n == 0 || m_props[n-1].id != m_props[i].id)
+			m_props[n++] = m_props[i];
+	m_props.resize(n);
+}
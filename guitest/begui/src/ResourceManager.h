@@ -30,7 +30,9 @@
 
 #include "common.h"
 #include <hash_map>
+#include <algorithm>
 #include "../../bcore/src/Rect.h"
+#include "../../bcore/src/AsyncTextureLoader.h"
 
 namespace begui {
 
@@ -79,36 +81,121 @@ public:
 	};
 
 	/**
-	 * Style: collection of properties that define a visual style for a component class
+	 * Property names are interned to integer ids. Components that create many
+	 * instances can keep the ids (fe. in function statics) and skip the string hashing.
+	 */
+	typedef int PropId;
+	static PropId	propId(const std::string &name);		// the same id for the same name, always
+	static PropId	findPropId(const std::string &name);	// -1 if the name was never interned
+	static const std::string&	propName(PropId id);
+
+	/**
+	 * Style: collection of properties that define a visual style for a component class.
+	 *		Values are kept in one flat array per type, and found by their property id
+	 *		with a binary search.
 	 */
 	class Style {
 		friend class ResourceManager;
+		friend class SkinCompiler;
+	public:
+		enum PropType {
+			PROP_INT,
+			PROP_FLOAT,
+			PROP_STRING,
+			PROP_COLOR,
+			PROP_IMAGE,
+			PROP_RECT
+		};
+
 	protected:
+		struct Prop {
+			PropId		id;
+			PropType	type;
+			int			index;	// in the array of values of its type
+			bool operator < (const Prop &p) const	{ return id < p.id; }
+		};
+
 		std::string m_name;
-		stdext::hash_map<std::string, std::string>	m_sVals;
-		stdext::hash_map<std::string, double>		m_fVals;
-		stdext::hash_map<std::string, int>			m_iVals;
-		stdext::hash_map<std::string, Color>		m_cVals;
-		stdext::hash_map<std::string, ImageDesc>	m_imgVals;
-		stdext::hash_map<std::string, Rect<int> >	m_riVals;
-	public:
-		const std::string& get_name() const					{ return m_name; }
-		int			get_i(const std::string &name) const	{ return m_iVals.find(name)->second; }
-		double		get_s(const std::string &name) const	{ return m_fVals.find(name)->second; }
-		std::string	get_f(const std::string &name) const	{ return m_sVals.find(name)->second; }
-		Color		get_c(const std::string &name) const	{ return m_cVals.find(name)->second; }
-		ImageDesc	get_img(const std::string &name) const	{ return m_imgVals.find(name)->second; }
-		Rect<int>	get_rect(const std::string &name) const	{ return m_riVals.find(name)->second; }
-
-		bool hasProp(const std::string &name) const {
-			if (m_iVals.find(name) != m_iVals.end()) return true;
-			if (m_fVals.find(name) != m_fVals.end()) return true;
-			if (m_sVals.find(name) != m_sVals.end()) return true;
-			if (m_cVals.find(name) != m_cVals.end()) return true;
-			if (m_imgVals.find(name) != m_imgVals.end()) return true;
-			if (m_riVals.find(name) != m_riVals.end()) return true;
-			return false;
+		std::vector<Prop>			m_props;	// sorted by id
+		std::vector<int>			m_iVals;
+		std::vector<double>			m_fVals;
+		std::vector<std::string>	m_sVals;
+		std::vector<Color>			m_cVals;
+		std::vector<ImageDesc>		m_imgVals;
+		std::vector<Rect<int> >		m_riVals;
+
+		const Prop*	find(PropId id) const {
+			Prop key;
+			key.id = id;
+			std::vector<Prop>::const_iterator it = std::lower_bound(m_props.begin(), m_props.end(), key);
+			return (it != m_props.end() && it->id == id) ? &*it : 0;
 		}
+		const Prop&	get(PropId id, PropType type) const {
+			const Prop *pProp = find(id);
+			ASSERT(pProp && pProp->type == type);
+			return *pProp;
+		}
+		template <class T>
+		void add(const std::string &name, PropType type, std::vector<T> &vals, const T &val) {
+			Prop prop;
+			prop.id = propId(name);
+			prop.type = type;
+			prop.index = (int)vals.size();
+			m_props.push_back(prop);
+			vals.push_back(val);
+		}
+		void sortProps();	// after adding: if a property was given twice, the first value is kept
+
+	public:
+		const std::string& get_name() const			{ return m_name; }
+		int			get_i(PropId id) const			{ return m_iVals[get(id, PROP_INT).index]; }
+		double		get_s(PropId id) const			{ return m_fVals[get(id, PROP_FLOAT).index]; }
+		const std::string&	get_f(PropId id) const	{ return m_sVals[get(id, PROP_STRING).index]; }
+		const Color&		get_c(PropId id) const	{ return m_cVals[get(id, PROP_COLOR).index]; }
+		const ImageDesc&	get_img(PropId id) const	{ return m_imgVals[get(id, PROP_IMAGE).index]; }
+		const Rect<int>&	get_rect(PropId id) const	{ return m_riVals[get(id, PROP_RECT).index]; }
+		bool		hasProp(PropId id) const		{ return find(id) != 0; }
+
+		int			get_i(const std::string &name) const	{ return get_i(findPropId(name)); }
+		double		get_s(const std::string &name) const	{ return get_s(findPropId(name)); }
+		const std::string&	get_f(const std::string &name) const	{ return get_f(findPropId(name)); }
+		const Color&		get_c(const std::string &name) const	{ return get_c(findPropId(name)); }
+		const ImageDesc&	get_img(const std::string &name) const	{ return get_img(findPropId(name)); }
+		const Rect<int>&	get_rect(const std::string &name) const	{ return get_rect(findPropId(name)); }
+		bool		hasProp(const std::string &name) const	{ return hasProp(findPropId(name)); }
+	};
+
+	/**
+	 * StyleBinding: the properties of a style resolved to the members of a struct, once.
+	 *		Components derive a struct from it, with a
+	 *			void bind(const Style &style)
+	 *		method, and get it through a BoundStyle<T> handle.
+	 */
+	class StyleBinding {
+	public:
+		virtual ~StyleBinding() { }
+	};
+
+	/**
+	 * BoundStyle: the bindings of the styles of one class to the struct T. Components keep
+	 *		one handle per class (fe. as a static in their create method), which binds each
+	 *		style the first time it is used, and again after the styles are reloaded. The
+	 *		binding of the last style used is returned without any lookup.
+	 */
+	template <class T>
+	class BoundStyle {
+	private:
+		std::string		m_className;
+		std::string		m_lastStyle;
+		const T			*m_pLast;
+		size_t			m_generation;	// of the styles of the resource manager, when bound
+		stdext::hash_map<std::string, T*>	m_bound;
+	public:
+		BoundStyle(const std::string &class_name) : m_className(class_name), m_pLast(0), m_generation(0) { }
+		~BoundStyle()	{ free(); }
+
+		const T&	get(const std::string &style_name);
+		void		free();
 	};
 
 	/**
@@ -116,6 +203,7 @@ public:
 	 */
 	class ClassDef {
 		friend class ResourceManager;
+		friend class SkinCompiler;
 	protected:
 		std::string m_name;
 		stdext::hash_map<std::string, Style>	m_styles;
@@ -129,9 +217,15 @@ private:
 	std::string								m_resourceDir;
 	std::vector<Texture*>					m_loadedTextures;
 	stdext::hash_map<std::string, ImageRef>	m_images;
+	stdext::hash_map<std::string, AsyncTextureLoader::Handle>	m_asyncImages;	// started by loadImageAsync
 
 	stdext::hash_map<std::string, ClassDef> m_classes;
+	size_t		m_stylesGeneration;		// bumped when the styles are reloaded, to bind them again
 
+	static stdext::hash_map<std::string, PropId>	m_propIds;
+	static std::vector<std::string>				m_propNames;
+
+	bool finishAsync(const std::string &filename);	// true if the image was added to m_images
 	
 	ResourceManager();
 
@@ -150,14 +244,57 @@ public:
 	ImageRef	loadImage(const std::string &filename, bool bPack = true, bool bForceDuplicate = false);
 	ImageRef	loadImage(const ImageDesc &desc);
 
+	// loadImageAsync starts loading an image in the background, through the AsyncTextureLoader,
+	// and returns at once. update() adds the images that have finished loading, so that
+	// loadImage(..) then returns them without touching the file; until then, loadImage(..)
+	// cancels the background load and loads the file itself. Call update() once per frame,
+	// after AsyncTextureLoader::update().
+	void		loadImageAsync(const std::string &filename);
+	bool		isImageLoading(const std::string &filename) const	{ return m_asyncImages.find(filename) != m_asyncImages.end(); }
+	void		update();
+
 	std::string getResourceDir() const;
 	void		setResourceDir(const std::string& resdir);
 
-	// Property handling
+	// Property handling. Style files are compiled to a binary skin next to them (see
+	// SkinCompiler), which is loaded instead of the text as long as it is up to date.
 	bool loadPropertyFile(const std::string& fname);
 	const ClassDef& getClassDef(const std::string &class_name) const	{ return m_classes.find(class_name)->second; }
+	size_t			getStylesGeneration() const		{ return m_stylesGeneration; }
 };
 
+template <class T>
+const T& ResourceManager::BoundStyle<T>::get(const std::string &style_name)
+{
+	ResourceManager *pRM = ResourceManager::inst();
+	if (m_generation != pRM->getStylesGeneration()) {
+		free();
+		m_generation = pRM->getStylesGeneration();
+	}
+	if (m_pLast && style_name == m_lastStyle)
+		return *m_pLast;
+
+	typename stdext::hash_map<std::string, T*>::const_iterator it = m_bound.find(style_name);
+	if (it == m_bound.end()) {
+		T *pBound = new T();
+		pBound->bind(pRM->getClassDef(m_className).style(style_name));
+		it = m_bound.insert(std::pair<std::string, T*>(style_name, pBound)).first;
+	}
+	m_lastStyle = style_name;
+	m_pLast = it->second;
+	return *m_pLast;
+}
+
+template <class T>
+void ResourceManager::BoundStyle<T>::free()
+{
+	typename stdext::hash_map<std::string, T*>::iterator it;
+	for (it = m_bound.begin(); it != m_bound.end(); ++it)
+		SAFE_DELETE(it->second);
+	m_bound.clear();
+	m_pLast = 0;
+}
+
 #pragma warning (pop)
 
 };
@@ -22,6 +22,7 @@
 #include "Roller.h"
 #include "Font.h"
 #include "ResourceManager.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -83,52 +84,51 @@ void Roller::onRender()
 	if (f < 0) f = 0;
 	int spos = f*w;
 	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	display::enableBlending(true);
 
 	// render the slider
 	if (!m_bActive)
-		glColor4f(1,1,1, 0.5);
+		display::setColor(1,1,1, 0.5);
 	else
-		glColor4f(1,1,1,1);
+		display::setColor(1,1,1,1);
 	
 	int l = (int)(w*0.3);
 	int r = (int)(w*0.7);
 
-	glBegin(GL_QUADS);
-		glColor3f(0.35, 0.35, 0.37);	glVertex3f(0, 0, 0);
-		glColor3f(1, 1,1);				glVertex3f(l, 0, 0);
-		glColor3f(1, 1,1);				glVertex3f(l, h, 0);
-		glColor3f(0.35, 0.35, 0.37);	glVertex3f(0, h, 0);
+	display::startBatch(display::QUADS);
+		display::setColor(0.35, 0.35, 0.37);	display::vertex(0, 0);
+		display::setColor(1, 1,1);				display::vertex(l, 0);
+		display::setColor(1, 1,1);				display::vertex(l, h);
+		display::setColor(0.35, 0.35, 0.37);	display::vertex(0, h);
 	
-		glColor3f(1, 1, 1);				glVertex3f(l, 0, 0);
-		glColor3f(0.78, 0.78, 0.74);	glVertex3f(r, 0, 0);
-		glColor3f(0.78, 0.78, 0.74);	glVertex3f(r, h, 0);
-		glColor3f(1, 1, 1);				glVertex3f(l, h, 0);
+		display::setColor(1, 1, 1);				display::vertex(l, 0);
+		display::setColor(0.78, 0.78, 0.74);	display::vertex(r, 0);
+		display::setColor(0.78, 0.78, 0.74);	display::vertex(r, h);
+		display::setColor(1, 1, 1);				display::vertex(l, h);
 	
-		glColor3f(0.78, 0.78, 0.74);	glVertex3f(r, 0, 0);
-		glColor3f(0.3, 0.3, 0.3);		glVertex3f(w, 0, 0);
-		glColor3f(0.3, 0.3, 0.3);		glVertex3f(w, h, 0);
-		glColor3f(0.78, 0.78, 0.74);	glVertex3f(r, h, 0);
-	glEnd();
-
-	glColor4f(0.3, 0.3, 0.3, 0.6);
-	glBegin(GL_LINES);
-		glVertex3f(0, 0, 0);
-		glVertex3f(w, 0, 0);
-		glVertex3f(w, 0, 0);
-		glVertex3f(w, h, 0);
-		glVertex3f(w, h, 0);
-		glVertex3f(0, h, 0);
-		glVertex3f(0, h, 0);
-		glVertex3f(0, 0, 0);
-	glEnd();
+		display::setColor(0.78, 0.78, 0.74);	display::vertex(r, 0);
+		display::setColor(0.3, 0.3, 0.3);		display::vertex(w, 0);
+		display::setColor(0.3, 0.3, 0.3);		display::vertex(w, h);
+		display::setColor(0.78, 0.78, 0.74);	display::vertex(r, h);
+	display::endBatch();
+
+	display::setColor(0.3, 0.3, 0.3, 0.6);
+	display::startBatch(display::LINES);
+		display::vertex(0, 0);
+		display::vertex(w, 0);
+		display::vertex(w, 0);
+		display::vertex(w, h);
+		display::vertex(w, h);
+		display::vertex(0, h);
+		display::vertex(0, h);
+		display::vertex(0, 0);
+	display::endBatch();
 
 	// if using steps, draw them
 	if (m_nSteps > 0 && m_bShowSteps)
 	{
-		glColor4f(0.3, 0.3, 0.3, 0.2);
-		glBegin(GL_LINES);
+		display::setColor(0.3, 0.3, 0.3, 0.2);
+		display::startBatch(display::LINES);
 		int steps = m_nSteps;
 		if (steps > 50)
 			steps = 50;
@@ -137,14 +137,14 @@ void Roller::onRender()
 			int lx = i*w/steps;
 			int offs = spos % (w/steps);
 			lx += offs;
-			glVertex3f(lx, 1, 0);
-			glVertex3f(lx, h-2, 0);
+			display::vertex(lx, 1);
+			display::vertex(lx, h-2);
 		}
-		glEnd();
+		display::endBatch();
 	}
 	
 	// render the min/max values
-	glColor4f(0.3, 0.3, 0.3, 0.8);
+	display::setColor(0.3, 0.3, 0.3, 0.8);
 	char valStr[64];
 	if (m_bDispPercentage)
 	{
@@ -164,7 +164,7 @@ void Roller::onRender()
 	// render the current value next to the slider
 	if (m_bShowValue)
 	{
-		glColor4f(0.3, 0.3, 0.3, 0.8);
+		display::setColor(0.3, 0.3, 0.3, 0.8);
 		sprintf(valStr, m_valuePrintFormat.c_str(), m_curValue);
 		Font::renderString(w+5, h-3, valStr);
 	}
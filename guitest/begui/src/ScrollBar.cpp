@@ -52,7 +52,7 @@ void ScrollBar::create(int x, int y, int length, ScrollDir dir, double minPos, d
 	m_curPos = minPos;
 
 	// get the style of the scrollbar
-	ResourceManager::Style barstyle = ResourceManager::inst()->getClassDef("ScrollBar").style(style_name);
+	const ResourceManager::Style &barstyle = ResourceManager::inst()->getClassDef("ScrollBar").style(style_name);
 	m_barBg = ResourceManager::inst()->loadImage(barstyle.get_img("bg"));
 	
 	if (dir == ScrollBar::SCROLL_HORIZONTAL)
@@ -70,13 +70,13 @@ void ScrollBar::create(int x, int y, int length, ScrollDir dir, double minPos, d
 
 	// create the buttons
 	if (dir == ScrollBar::SCROLL_HORIZONTAL) {
-		ResourceManager::Style bstyle = ResourceManager::inst()->getClassDef("Button").style("scroller_btn_left");
-		m_incBtn.create(-bstyle.get_i("padding_left"), -bstyle.get_i("padding_top"), 
+		const ResourceManager::Style &lstyle = ResourceManager::inst()->getClassDef("Button").style("scroller_btn_left");
+		m_incBtn.create(-lstyle.get_i("padding_left"), -lstyle.get_i("padding_top"), 
 						"", 101, makeFunctor(*this, &ScrollBar::handleClick), "scroller_btn_left");
 
-		bstyle = ResourceManager::inst()->getClassDef("Button").style("scroller_btn_right");
-		m_decBtn.create(m_right+bstyle.get_i("padding_right")-bstyle.get_i("default_width"), 
-						-bstyle.get_i("padding_top"), 
+		const ResourceManager::Style &rstyle = ResourceManager::inst()->getClassDef("Button").style("scroller_btn_right");
+		m_decBtn.create(m_right+rstyle.get_i("padding_right")-rstyle.get_i("default_width"), 
+						-rstyle.get_i("padding_top"), 
 						"", 101, makeFunctor(*this, &ScrollBar::handleClick), "scroller_btn_right");
 
 		m_slider.create(0, 0, "", 103, Functor1<int>(), "scroller_slider");
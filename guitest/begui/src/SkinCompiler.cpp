@@ -0,0 +1,517 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SkinCompiler.h"
+#include "../../bcore/src/BaseTextFile.h"
+#include "../../bcore/src/MappedFile.h"
+#include <stdexcept>
+
+#pragma warning (disable : 4996)
+
+using namespace begui;
+
+namespace {
+
+const char SKIN_MAGIC[4] = { 'B', 'S', 'K', 'N' };
+const uint32_t SKIN_VERSION = 1;
+
+// the blob starts with the header, then the doubles (so that they are aligned),
+// then the 32 bit arrays in this order, then the zero-terminated names
+struct SkinHeader {
+	char		magic[4];
+	uint32_t	version;
+	uint32_t	nNames, nameBytes;
+	uint32_t	nClasses, nStyles, nProps;
+	uint32_t	nInts, nFloats, nStrings, nColors, nImages, nRects;
+	uint32_t	padding;
+};
+
+struct ClassRecord {
+	uint32_t	name;
+	uint32_t	firstStyle, nStyles;
+};
+
+struct StyleRecord {
+	uint32_t	name;
+	uint32_t	firstProp, nProps;
+};
+
+struct PropRecord {
+	uint32_t	name;
+	uint32_t	type;
+	uint32_t	index;		// in the array of its type
+};
+
+struct ImageRecord {
+	int32_t		left, top, right, bottom;
+	uint32_t	filename;
+};
+
+// interns the names of a skin while it is compiled
+class NameTable
+{
+	stdext::hash_map<std::string, uint32_t>	m_ids;
+public:
+	std::vector<std::string>	m_names;
+
+	uint32_t id(const std::string &name) {
+		stdext::hash_map<std::string, uint32_t>::const_iterator it = m_ids.find(name);
+		if (it != m_ids.end())
+			return it->second;
+		uint32_t id = (uint32_t)m_names.size();
+		m_ids[name] = id;
+		m_names.push_back(name);
+		return id;
+	}
+};
+
+template <class T>
+void append(std::vector<unsigned char> &out, const std::vector<T> &vals)
+{
+	if (!vals.empty())
+		out.insert(out.end(), (const unsigned char*)&vals[0], (const unsigned char*)&vals[0] + vals.size()*sizeof(T));
+}
+
+// checked access to an array of the blob
+template <class T>
+const T* array(const unsigned char *&p, const unsigned char *end, size_t count)
+{
+	if ((size_t)(end - p) < count*sizeof(T))
+		return 0;
+	const T *arr = (const T*)p;
+	p += count*sizeof(T);
+	return arr;
+}
+
+void expect(BaseTextFile &file, std::string &token, const char *expected)
+{
+	file >> token;
+	if (token != expected)
+		throw std::runtime_error(("expected '" + std::string(expected) + "', found: " + token).c_str());
+}
+
+};
+
+bool SkinCompiler::parse(const std::string &fname, ClassMap &classes)
+{
+	BaseTextFile file;
+	if (!file.loadFile(fname))
+		throw std::runtime_error(("could not open file: " + fname).c_str());
+	file.addLineCommentDef("#");
+	file.skipComments(true);
+	file.addWordBreakChar('{');
+	file.addWordBreakChar('}');
+	file.addWordBreakChar(',');
+	file.addWordBreakChar('=');
+
+	try {
+		while (!file.eof()) {
+			std::string token;
+
+			file >> token;
+			if (file.eof()) break;	// handle trailing whitespace in the file
+
+			if (token != "class")
+				throw std::runtime_error("'class' expected");
+
+			// read the class name
+			std::string class_name;
+			file >> class_name;
+
+			// create the new class
+			ResourceManager::ClassDef cls;
+			cls.m_name = class_name;
+
+			file >> token;
+			if (token != "{")
+				throw std::runtime_error("'{' expected");
+
+			// read the class definition
+			while (!file.eof())
+			{
+				file >> token;
+				if (token == "}")
+					break;
+				if (token != "style")
+					continue;
+
+				// read a style for this class
+				typedef ResourceManager::Style Style;
+				Style style;
+				file >> style.m_name;
+
+				file >> token;
+				if (token != "{")
+					throw std::runtime_error("'{' expected");
+
+				// read the style definition
+				while (!file.eof())
+				{
+					file >> token;
+					if (token == "}")
+						break;
+
+					std::string var_type = token;
+					std::string var_name;
+					file >> var_name;
+
+					file >> token;
+					if (token != "=")
+						throw std::runtime_error("'=' expected");
+					if (var_type == "int") {
+						int var_val;
+						file >> var_val;
+						style.add(var_name, Style::PROP_INT, style.m_iVals, var_val);
+					}
+					else if (var_type == "float") {
+						double var_val;
+						file >> var_val;
+						style.add(var_name, Style::PROP_FLOAT, style.m_fVals, var_val);
+					}
+					else if (var_type == "string") {
+						style.add(var_name, Style::PROP_STRING, style.m_sVals, file.getline());
+					}
+					else if (var_type == "color") {
+						Color cl;
+						file >> cl.r;
+						expect(file, token, ",");
+						file >> cl.g;
+						expect(file, token, ",");
+						file >> cl.b;
+						style.add(var_name, Style::PROP_COLOR, style.m_cVals, cl/255.0f);
+					}
+					else if (var_type == "image") {
+						ResourceManager::ImageDesc desc;
+						file >> desc.left;
+						expect(file, token, ",");
+						file >> desc.top;
+						expect(file, token, ",");
+						file >> desc.right;
+						expect(file, token, ",");
+						file >> desc.bottom;
+						expect(file, token, ",");
+						desc.filename = file.getline();
+						style.add(var_name, Style::PROP_IMAGE, style.m_imgVals, desc);
+					}
+					else if (var_type == "rect") {
+						Rect<int> rect;
+						file >> rect.left;
+						expect(file, token, ",");
+						file >> rect.top;
+						expect(file, token, ",");
+						file >> rect.right;
+						expect(file, token, ",");
+						file >> rect.bottom;
+						style.add(var_name, Style::PROP_RECT, style.m_riVals, rect);
+					}
+					else
+						throw std::runtime_error(("unknown variable type: " + var_type).c_str());
+				}
+
+				// add the style to the class
+				style.sortProps();
+				cls.m_styles.insert(std::pair<std::string, Style>(style.m_name, style));
+			}
+
+			// add the class definition to the list
+			classes.insert(std::pair<std::string, ResourceManager::ClassDef>(class_name, cls));
+		}
+	}
+	catch (std::exception &e)
+	{
+		char str[1024];
+		sprintf(str, "parsing error (file %s, line %d): %s\n", fname.c_str(), file.getCurLine(), e.what());
+		Console::error(str);
+		file.close();
+		return false;
+	}
+
+	file.close();
+	return true;
+}
+
+void SkinCompiler::compile(const ClassMap &classes, std::vector<unsigned char> &out)
+{
+	typedef ResourceManager::Style Style;
+
+	NameTable names;
+	std::vector<ClassRecord> classRecs;
+	std::vector<StyleRecord> styleRecs;
+	std::vector<PropRecord> propRecs;
+	std::vector<int32_t> ints;
+	std::vector<double> floats;
+	std::vector<uint32_t> strings;
+	std::vector<float> colors;
+	std::vector<ImageRecord> images;
+	std::vector<int32_t> rects;
+
+	for (ClassMap::const_iterator ci = classes.begin(); ci != classes.end(); ++ci)
+	{
+		const ResourceManager::ClassDef &cls = ci->second;
+		ClassRecord crec = { names.id(ci->first), (uint32_t)styleRecs.size(), (uint32_t)cls.m_styles.size() };
+		classRecs.push_back(crec);
+
+		stdext::hash_map<std::string, Style>::const_iterator si;
+		for (si = cls.m_styles.begin(); si != cls.m_styles.end(); ++si)
+		{
+			const Style &style = si->second;
+			StyleRecord srec = { names.id(si->first), (uint32_t)propRecs.size(), (uint32_t)style.m_props.size() };
+			styleRecs.push_back(srec);
+
+			for (size_t i=0; i<style.m_props.size(); ++i)
+			{
+				const Style::Prop &prop = style.m_props[i];
+				PropRecord prec = { names.id(ResourceManager::propName(prop.id)), (uint32_t)prop.type, 0 };
+				switch (prop.type) {
+					case Style::PROP_INT:
+						prec.index = (uint32_t)ints.size();
+						ints.push_back(style.m_iVals[prop.index]);
+						break;
+					case Style::PROP_FLOAT:
+						prec.index = (uint32_t)floats.size();
+						floats.push_back(style.m_fVals[prop.index]);
+						break;
+					case Style::PROP_STRING:
+						prec.index = (uint32_t)strings.size();
+						strings.push_back(names.id(style.m_sVals[prop.index]));
+						break;
+					case Style::PROP_COLOR:
+						{
+							const Color &cl = style.m_cVals[prop.index];
+							prec.index = (uint32_t)colors.size()/3;
+							colors.push_back(cl.r);
+							colors.push_back(cl.g);
+							colors.push_back(cl.b);
+						}
+						break;
+					case Style::PROP_IMAGE:
+						{
+							const ResourceManager::ImageDesc &desc = style.m_imgVals[prop.index];
+							ImageRecord irec = { desc.left, desc.top, desc.right, desc.bottom, names.id(desc.filename) };
+							prec.index = (uint32_t)images.size();
+							images.push_back(irec);
+						}
+						break;
+					case Style::PROP_RECT:
+						{
+							const Rect<int> &rect = style.m_riVals[prop.index];
+							prec.index = (uint32_t)rects.size()/4;
+							rects.push_back(rect.left);
+							rects.push_back(rect.top);
+							rects.push_back(rect.right);
+							rects.push_back(rect.bottom);
+						}
+						break;
+				}
+				propRecs.push_back(prec);
+			}
+		}
+	}
+
+	// the names: offsets, then the characters
+	std::vector<uint32_t> nameOffsets;
+	std::vector<char> nameChars;
+	for (size_t i=0; i<names.m_names.size(); ++i) {
+		nameOffsets.push_back((uint32_t)nameChars.size());
+		nameChars.insert(nameChars.end(), names.m_names[i].begin(), names.m_names[i].end());
+		nameChars.push_back(0);
+	}
+
+	SkinHeader header;
+	memcpy(header.magic, SKIN_MAGIC, 4);
+	header.version = SKIN_VERSION;
+	header.nNames = (uint32_t)nameOffsets.size();
+	header.nameBytes = (uint32_t)nameChars.size();
+	header.nClasses = (uint32_t)classRecs.size();
+	header.nStyles = (uint32_t)styleRecs.size();
+	header.nProps = (uint32_t)propRecs.size();
+	header.nInts = (uint32_t)ints.size();
+	header.nFloats = (uint32_t)floats.size();
+	header.nStrings = (uint32_t)strings.size();
+	header.nColors = (uint32_t)colors.size()/3;
+	header.nImages = (uint32_t)images.size();
+	header.nRects = (uint32_t)rects.size()/4;
+	header.padding = 0;
+
+	out.insert(out.end(), (const unsigned char*)&header, (const unsigned char*)&header + sizeof(header));
+	append(out, floats);
+	append(out, classRecs);
+	append(out, styleRecs);
+	append(out, propRecs);
+	append(out, ints);
+	append(out, strings);
+	append(out, colors);
+	append(out, images);
+	append(out, rects);
+	append(out, nameOffsets);
+	append(out, nameChars);
+}
+
+bool SkinCompiler::compile(const std::string &styleFile, const std::string &skinFile)
+{
+	ClassMap classes;
+	if (!parse(styleFile, classes))
+		return false;
+	return save(classes, skinFile);
+}
+
+bool SkinCompiler::save(const ClassMap &classes, const std::string &skinFile)
+{
+	std::vector<unsigned char> blob;
+	compile(classes, blob);
+
+	FILE *fp = fopen(skinFile.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool bOk = (fwrite(&blob[0], 1, blob.size(), fp) == blob.size());
+	fclose(fp);
+	return bOk;
+}
+
+bool SkinCompiler::load(const unsigned char *data, size_t size, ClassMap &classes)
+{
+	typedef ResourceManager::Style Style;
+
+	const unsigned char *p = data, *end = data + size;
+	const SkinHeader *pHeader = array<SkinHeader>(p, end, 1);
+	if (!pHeader || memcmp(pHeader->magic, SKIN_MAGIC, 4) != 0 || pHeader->version != SKIN_VERSION)
+		return false;
+
+	const double		*floats = array<double>(p, end, pHeader->nFloats);
+	const ClassRecord	*classRecs = array<ClassRecord>(p, end, pHeader->nClasses);
+	const StyleRecord	*styleRecs = array<StyleRecord>(p, end, pHeader->nStyles);
+	const PropRecord	*propRecs = array<PropRecord>(p, end, pHeader->nProps);
+	const int32_t		*ints = array<int32_t>(p, end, pHeader->nInts);
+	const uint32_t		*strings = array<uint32_t>(p, end, pHeader->nStrings);
+	const float			*colors = array<float>(p, end, 3*pHeader->nColors);
+	const ImageRecord	*images = array<ImageRecord>(p, end, pHeader->nImages);
+	const int32_t		*rects = array<int32_t>(p, end, 4*pHeader->nRects);
+	const uint32_t		*nameOffsets = array<uint32_t>(p, end, pHeader->nNames);
+	const char			*nameChars = array<char>(p, end, pHeader->nameBytes);
+	if (!nameChars || (pHeader->nameBytes > 0 && nameChars[pHeader->nameBytes-1] != 0))
+		return false;
+
+	// the names are checked once; records are checked when they are used
+	for (uint32_t i=0; i<pHeader->nNames; ++i)
+		if (nameOffsets[i] >= pHeader->nameBytes)
+			return false;
+	#define SKIN_NAME(i) (((i) < pHeader->nNames) ? std::string(nameChars + nameOffsets[i]) : std::string())
+
+	// the names of the properties are interned once, not per style
+	std::vector<ResourceManager::PropId> propIds(pHeader->nNames, -1);
+
+	for (uint32_t c=0; c<pHeader->nClasses; ++c)
+	{
+		const ClassRecord &crec = classRecs[c];
+		if (crec.firstStyle + crec.nStyles > pHeader->nStyles)
+			return false;
+		ResourceManager::ClassDef cls;
+		cls.m_name = SKIN_NAME(crec.name);
+
+		for (uint32_t s=crec.firstStyle; s<crec.firstStyle+crec.nStyles; ++s)
+		{
+			const StyleRecord &srec = styleRecs[s];
+			if (srec.firstProp + srec.nProps > pHeader->nProps)
+				return false;
+			Style style;
+			style.m_name = SKIN_NAME(srec.name);
+
+			for (uint32_t i=srec.firstProp; i<srec.firstProp+srec.nProps; ++i)
+			{
+				const PropRecord &prec = propRecs[i];
+				if (prec.name >= pHeader->nNames)
+					return false;
+				if (propIds[prec.name] < 0)
+					propIds[prec.name] = ResourceManager::propId(SKIN_NAME(prec.name));
+
+				Style::Prop prop;
+				prop.id = propIds[prec.name];
+				prop.type = (Style::PropType)prec.type;
+				uint32_t k = prec.index;
+				switch (prec.type) {
+					case Style::PROP_INT:
+						if (k >= pHeader->nInts) return false;
+						prop.index = (int)style.m_iVals.size();
+						style.m_iVals.push_back(ints[k]);
+						break;
+					case Style::PROP_FLOAT:
+						if (k >= pHeader->nFloats) return false;
+						prop.index = (int)style.m_fVals.size();
+						style.m_fVals.push_back(floats[k]);
+						break;
+					case Style::PROP_STRING:
+						if (k >= pHeader->nStrings) return false;
+						prop.index = (int)style.m_sVals.size();
+						style.m_sVals.push_back(SKIN_NAME(strings[k]));
+						break;
+					case Style::PROP_COLOR:
+						if (k >= pHeader->nColors) return false;
+						prop.index = (int)style.m_cVals.size();
+						style.m_cVals.push_back(Color(colors[3*k], colors[3*k+1], colors[3*k+2]));
+						break;
+					case Style::PROP_IMAGE:
+						{
+							if (k >= pHeader->nImages) return false;
+							ResourceManager::ImageDesc desc;
+							desc.left = images[k].left;
+							desc.top = images[k].top;
+							desc.right = images[k].right;
+							desc.bottom = images[k].bottom;
+							desc.filename = SKIN_NAME(images[k].filename);
+							prop.index = (int)style.m_imgVals.size();
+							style.m_imgVals.push_back(desc);
+						}
+						break;
+					case Style::PROP_RECT:
+						{
+							if (k >= pHeader->nRects) return false;
+							Rect<int> rect;
+							rect.left = rects[4*k];
+							rect.top = rects[4*k+1];
+							rect.right = rects[4*k+2];
+							rect.bottom = rects[4*k+3];
+							prop.index = (int)style.m_riVals.size();
+							style.m_riVals.push_back(rect);
+						}
+						break;
+					default:
+						return false;
+				}
+				style.m_props.push_back(prop);
+			}
+
+			style.sortProps();
+			cls.m_styles.insert(std::pair<std::string, Style>(style.m_name, style));
+		}
+		classes.insert(std::pair<std::string, ResourceManager::ClassDef>(cls.m_name, cls));
+	}
+	#undef SKIN_NAME
+
+	return true;
+}
+
+bool SkinCompiler::load(const std::string &skinFile, ClassMap &classes)
+{
+	MappedFile file;
+	if (!file.open(skinFile))
+		return false;
+	return load(file.getData(), file.getSize(), classes);
+}
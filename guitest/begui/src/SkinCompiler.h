@@ -0,0 +1,66 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SKINCOMPILER_H42631_INCLUDED_
+#define _SKINCOMPILER_H42631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "ResourceManager.h"
+
+namespace begui {
+
+/**
+ *===================================================================================
+ * SkinCompiler: converts style files (the text format of style.txt) to a binary
+ *			skin, and loads binary skins back to class definitions.
+ *
+ *			A binary skin is a single block with no pointers. load() maps it and
+ *			copies it to class definitions in one pass over its tables, with no
+ *			text parsing; the block itself is not kept. It holds a table of all
+ *			names (class, style and property names, strings and image filenames),
+ *			the classes, the styles of each class, the properties of each style as
+ *			(name, type, index) records, and one flat array of values per property
+ *			type.
+ *===================================================================================
+ */
+class SkinCompiler
+{
+public:
+	typedef stdext::hash_map<std::string, ResourceManager::ClassDef>	ClassMap;
+
+	// parse a style text file
+	static bool parse(const std::string &fname, ClassMap &classes);
+
+	// write the classes to a binary skin (the result is appended to out)
+	static void compile(const ClassMap &classes, std::vector<unsigned char> &out);
+	static bool compile(const std::string &styleFile, const std::string &skinFile);
+	static bool save(const ClassMap &classes, const std::string &skinFile);
+
+	// read a binary skin
+	static bool load(const unsigned char *data, size_t size, ClassMap &classes);
+	static bool load(const std::string &skinFile, ClassMap &classes);
+};
+
+};
+
+#endif
@@ -22,6 +22,7 @@
 #include "Slider.h"
 #include "Font.h"
 #include "ResourceManager.h"
+#include "Display.h"
 
 using namespace begui;
 
@@ -52,7 +53,7 @@ void Slider::create(int x, int y, int width, int id, void (*callback)(int id),
 	m_id = id;
 
 	// load the slider style
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("Slider").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("Slider").style(style_name);
 	ASSERT(style.hasProp("slider_bg"));
 	m_sliderBg = ResourceManager::inst()->loadImage(style.get_img("slider_bg"));
 	if (style.hasProp("label_bg"))
@@ -126,8 +127,7 @@ void Slider::onRender()
 	if (f < 0) f = 0;
 	int spos = (int)(f*w);
 	
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	display::enableBlending(true);
 	
 	Font *pFont = FontManager::getCurFont();
 	int text_y = pFont->getLineHeight() - 1;
@@ -137,7 +137,7 @@ void Slider::onRender()
 	sprintf(curValStr, m_valuePrintFormat.c_str(), m_curValue);
 
 	// render the label bg
-	glColor4f(1,1,1,1);
+	display::setColor(1,1,1,1);
 	int label_w = m_labelActiveArea.left + pFont->stringLength(curValStr) + (m_labelBg.m_width - m_labelActiveArea.right) + 8;
 	Component::drawImageWtBorders(m_labelBg, w-m_labelActiveArea.left,
 		-m_labelActiveArea.top,
@@ -147,87 +147,87 @@ void Slider::onRender()
 	// render the current value next to the slider
 	if (m_bShowValue)
 	{
-		glColor4f(m_labelTextColor.r, m_labelTextColor.g, m_labelTextColor.b, 0.8f);
+		display::setColor(m_labelTextColor.r, m_labelTextColor.g, m_labelTextColor.b, 0.8f);
 		Font::renderString(w+3, text_y+1, curValStr);
 	}
 
 	// render the slider
-	glColor4f(1,1,1,1);
+	display::setColor(1,1,1,1);
 	Component::drawImageWtBorders(m_sliderBg, -m_sliderActiveArea.left,
 		-m_sliderActiveArea.top, 
 		w+(m_sliderBg.m_width - m_sliderActiveArea.right), 
 		m_sliderBg.m_height, m_sliderResizableArea);
 /*	if (!m_bIsEnabled)
-		glColor4f(1,1,1, 0.5);
+		display::setColor(1,1,1, 0.5);
 	else
-		glColor4f(1,1,1,1);
+		display::setColor(1,1,1,1);
 	
 	int l = (int)(w*0.3);
 	int r = (int)(w*0.7);
 
 	if (m_bIsEnabled)
-		glColor3f(0.78, 0.78, 0.74);
+		display::setColor(0.78, 0.78, 0.74);
 	else
-		glColor4f(0.6, 0.6, 0.6, 0.5);
-	glBegin(GL_QUADS);
-		glVertex3f(0, 0, 0);
-		glVertex3f(l, 0, 0);
-		glVertex3f(l, h, 0);
-		glVertex3f(0, h, 0);
-	glEnd();
+		display::setColor(0.6, 0.6, 0.6, 0.5);
+	display::startBatch(display::QUADS);
+		display::vertex(0, 0);
+		display::vertex(l, 0);
+		display::vertex(l, h);
+		display::vertex(0, h);
+	display::endBatch();
 	
 	if (m_bIsEnabled)
-		glColor3f(1, 1, 1);
-	glBegin(GL_QUADS);
-		glVertex3f(l, 0, 0);
-		glVertex3f(r, 0, 0);
-		glVertex3f(r, h, 0);
-		glVertex3f(l, h, 0);
-	glEnd();
+		display::setColor(1, 1, 1);
+	display::startBatch(display::QUADS);
+		display::vertex(l, 0);
+		display::vertex(r, 0);
+		display::vertex(r, h);
+		display::vertex(l, h);
+	display::endBatch();
 	
 	if (m_bIsEnabled)
-		glColor3f(0.93, 0.85, 0.79);
-	glBegin(GL_QUADS);
-		glVertex3f(r, 0, 0);
-		glVertex3f(w, 0, 0);
-		glVertex3f(w, h, 0);
-		glVertex3f(r, h, 0);
-	glEnd();
-
-	glColor4f(0.3, 0.3, 0.3, 0.6);
-	glBegin(GL_LINES);
-		glVertex3f(0, 0, 0);
-		glVertex3f(w, 0, 0);
-		glVertex3f(w, 0, 0);
-		glVertex3f(w, h, 0);
-		glVertex3f(w, h, 0);
-		glVertex3f(0, h, 0);
-		glVertex3f(0, h, 0);
-		glVertex3f(0, 0, 0);
+		display::setColor(0.93, 0.85, 0.79);
+	display::startBatch(display::QUADS);
+		display::vertex(r, 0);
+		display::vertex(w, 0);
+		display::vertex(w, h);
+		display::vertex(r, h);
+	display::endBatch();
+
+	display::setColor(0.3, 0.3, 0.3, 0.6);
+	display::startBatch(display::LINES);
+		display::vertex(0, 0);
+		display::vertex(w, 0);
+		display::vertex(w, 0);
+		display::vertex(w, h);
+		display::vertex(w, h);
+		display::vertex(0, h);
+		display::vertex(0, h);
+		display::vertex(0, 0);
 		
-		glVertex3f(spos, h-1, 0);
-		glVertex3f(spos, 1, 0);
-	glEnd();
+		display::vertex(spos, h-1);
+		display::vertex(spos, 1);
+	display::endBatch();
 */
 	// if using steps, draw them
 	if (m_nSteps > 0 && m_bShowSteps)
 	{
-		glColor4f(0.3f, 0.3f, 0.3f, 0.2f);
-		glBegin(GL_LINES);
+		display::setColor(0.3f, 0.3f, 0.3f, 0.2f);
+		display::startBatch(display::LINES);
 		int steps = m_nSteps;
 		if (steps > 50)
 			steps = 50;
 		for (int i=0; i<steps; ++i)
 		{
 			float lx = (float)(i*w/steps);
-			glVertex3f(lx, 2, 0);
-			glVertex3f(lx, (float)h-2, 0);
+			display::vertex(lx, 2);
+			display::vertex(lx, (float)h-2);
 		}
-		glEnd();
+		display::endBatch();
 	}
 	
 	// render the min/max values
-	glColor4f(m_sliderTextColor.r, m_sliderTextColor.g, m_sliderTextColor.b, 0.8f);
+	display::setColor(m_sliderTextColor.r, m_sliderTextColor.g, m_sliderTextColor.b, 0.8f);
 	char valStr[64];
 	if (m_bDispPercentage)
 	{
@@ -248,21 +248,21 @@ void Slider::onRender()
 	if (m_bIsEnabled)
 	{
 		Texture *pTex = ResourceManager::inst()->getStockMap(ResourceManager::STD_CONTROLS);
-		pTex->set();
+		display::bindTexture(pTex);
 
 		int t = - 12;
-		glColor4f(1,1,1,1);
-		glBegin(GL_QUADS);
-			glTexCoord2f(496/512.0f, 1/512.0f);	glVertex3f(spos-4, t, 0);
-			glTexCoord2f(505/512.0f, 1/512.0f);	glVertex3f(spos+5, t, 0);
-			glTexCoord2f(505/512.0f, 19/512.0f);	glVertex3f(spos+5, t+18, 0);
-			glTexCoord2f(496/512.0f, 19/512.0f);	glVertex3f(spos-4, t+18, 0);
-		glEnd();
-
-		glBindTexture(GL_TEXTURE_2D, 0);
+		display::setColor(1,1,1,1);
+		display::startBatch(display::QUADS);
+			display::texCoord(496/512.0f, 1/512.0f);	display::vertex(spos-4, t);
+			display::texCoord(505/512.0f, 1/512.0f);	display::vertex(spos+5, t);
+			display::texCoord(505/512.0f, 19/512.0f);	display::vertex(spos+5, t+18);
+			display::texCoord(496/512.0f, 19/512.0f);	display::vertex(spos-4, t+18);
+		display::endBatch();
+
+		display::bindTexture(0);
 	}
 	
-	glDisable(GL_BLEND);
+	display::enableBlending(false);
 }
 
 bool Slider::onMouseDown(int x, int y, int button)
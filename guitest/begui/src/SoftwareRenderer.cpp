@@ -0,0 +1,186 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SoftwareRenderer.h"
+
+using namespace begui;
+
+SoftwareRenderer::SoftwareRenderer() : m_prim(display::QUADS), m_bInBatch(false),
+	m_tx(0), m_ty(0), m_clearColor(0,0,0), m_clearAlpha(1)
+{
+	m_state.pTexture = 0;
+	m_state.bTexture = false;
+	m_state.bBlend = false;
+
+	// textures need to keep their data around to be sampled by the rasterizer
+	Texture::setKeepShadowCopies(true);
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+}
+
+void SoftwareRenderer::create(int width, int height)
+{
+	ASSERT(width > 0 && height > 0);
+	m_raster.setTarget(0);
+	m_image.create(width, height, 4);
+	m_raster.setTarget(&m_image);
+	applyState();
+}
+
+const Image& SoftwareRenderer::getImage()
+{
+	m_raster.flush();
+	return m_image;
+}
+
+void SoftwareRenderer::clear()
+{
+	m_raster.clear(m_clearColor.r, m_clearColor.g, m_clearColor.b, m_clearAlpha);
+}
+
+void SoftwareRenderer::startBatch(display::PrimitiveType prim)
+{
+	ASSERT(!m_bInBatch);
+	m_prim = prim;
+	m_bInBatch = true;
+	m_batch.clear();
+}
+
+void SoftwareRenderer::endBatch()
+{
+	ASSERT(m_bInBatch);
+	m_bInBatch = false;
+	m_batch.clear();	// incomplete primitives are dropped, as in GL
+}
+
+void SoftwareRenderer::vertex(float x, float y)
+{
+	ASSERT(m_bInBatch);
+	SoftwareRasterizer::Vertex v = m_cur;
+	v.x = x + m_tx;
+	v.y = y + m_ty;
+	m_batch.push_back(v);
+
+	// emit the primitive as soon as all its vertices are there
+	switch (m_prim) {
+		case display::POINTS:
+			{
+				SoftwareRasterizer::Vertex v1 = v, v2 = v, v3 = v;
+				v1.x += 1;
+				v2.x += 1; v2.y += 1;
+				v3.y += 1;
+				m_raster.drawQuad(v, v1, v2, v3);
+				m_batch.clear();
+			}
+			break;
+		case display::LINES:
+			if (m_batch.size() == 2) {
+				m_raster.drawLine(m_batch[0], m_batch[1]);
+				m_batch.clear();
+			}
+			break;
+		case display::TRIANGLES:
+			if (m_batch.size() == 3) {
+				m_raster.drawTriangle(m_batch[0], m_batch[1], m_batch[2]);
+				m_batch.clear();
+			}
+			break;
+		case display::QUADS:
+			if (m_batch.size() == 4) {
+				m_raster.drawQuad(m_batch[0], m_batch[1], m_batch[2], m_batch[3]);
+				m_batch.clear();
+			}
+			break;
+	}
+}
+
+void SoftwareRenderer::enableBlending(bool bEnable)
+{
+	m_state.bBlend = bEnable;
+	applyState();
+}
+
+void SoftwareRenderer::enableTexture(bool bEnable)
+{
+	m_state.bTexture = bEnable;
+	applyState();
+}
+
+void SoftwareRenderer::bindTexture(Texture *pTex)
+{
+	m_state.pTexture = pTex;
+	if (pTex)
+		m_state.bTexture = true;
+	applyState();
+}
+
+void SoftwareRenderer::pushState()
+{
+	m_stateStack.push_back(m_state);
+}
+
+void SoftwareRenderer::popState()
+{
+	ASSERT(!m_stateStack.empty());
+	m_state = m_stateStack.back();
+	m_stateStack.pop_back();
+	applyState();
+}
+
+void SoftwareRenderer::setScissor(const Rect<int> *pRect)
+{
+	if (!pRect) {
+		m_raster.disableScissor();
+		return;
+	}
+
+	// the rectangle has its origin at the bottom of the window, the image at the top
+	int h = (int)m_image.getHeight();
+	m_raster.setScissor(pRect->left, h - pRect->bottom, pRect->right, h - pRect->top);
+}
+
+void SoftwareRenderer::pushTranslation(float x, float y)
+{
+	m_translations.push_back(m_tx);
+	m_translations.push_back(m_ty);
+	m_tx += x;
+	m_ty += y;
+}
+
+void SoftwareRenderer::popTranslation()
+{
+	ASSERT(m_translations.size() >= 2);
+	m_ty = m_translations.back();
+	m_translations.pop_back();
+	m_tx = m_translations.back();
+	m_translations.pop_back();
+}
+
+void SoftwareRenderer::applyState()
+{
+	const Image *pTex = 0;
+	if (m_state.bTexture && m_state.pTexture)
+		pTex = m_state.pTexture->getShadowImage();
+	m_raster.setTexture(pTex);
+	m_raster.setBlending(m_state.bBlend);
+}
@@ -0,0 +1,110 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SOFTWARERENDERER_H42631_INCLUDED_
+#define _SOFTWARERENDERER_H42631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Renderer.h"
+#include "../../bcore/src/Image.h"
+#include "../../bcore/src/SoftwareRasterizer.h"
+
+namespace begui {
+
+/**
+ * SoftwareRenderer: renders the GUI into an RGBA image in system memory with the
+ *		SoftwareRasterizer, without an OpenGL context. Used for headless rendering,
+ *		golden-image tests of the widgets and rendering benchmarks.
+ *
+ *		Textures are sampled from their shadow copies, so the renderer must be
+ *		created before any textures (fonts, skins, images) are loaded. Only
+ *		textures created from 8-bit data can be drawn; other textured primitives
+ *		are drawn with their color only. Queued primitives reference the
+ *		shadow copies, so call finish() or getImage() at the end of each frame,
+ *		before textures are updated again.
+ *
+ *		Usage:
+ *			SoftwareRenderer sw;
+ *			sw.create(w, h);
+ *			display::setRenderer(&sw);
+ *			display::setSize(w, h);
+ *			... load resources, create components, call frameRender() ...
+ *			const Image &result = sw.getImage();
+ */
+class SoftwareRenderer : public Renderer
+{
+	struct State {
+		Texture	*pTexture;
+		bool	bTexture;
+		bool	bBlend;
+	};
+
+	Image				m_image;
+	SoftwareRasterizer	m_raster;
+
+	display::PrimitiveType	m_prim;
+	bool					m_bInBatch;
+	std::vector<SoftwareRasterizer::Vertex>	m_batch;
+
+	SoftwareRasterizer::Vertex	m_cur;		// current color and texture coordinates
+	float				m_tx, m_ty;			// current translation
+	std::vector<float>	m_translations;		// saved (x,y) pairs
+	State				m_state;
+	std::vector<State>	m_stateStack;
+	Color				m_clearColor;
+	float				m_clearAlpha;
+
+public:
+	SoftwareRenderer();
+	virtual ~SoftwareRenderer();
+
+	void	create(int width, int height);
+	void	setClearColor(const Color &cl, float a)	{ m_clearColor = cl; m_clearAlpha = a; }
+	void	setTileSize(int size)					{ m_raster.setTileSize(size); }
+
+	// renders everything submitted so far and returns the result
+	const Image&	getImage();
+	void			finish()						{ m_raster.flush(); }
+
+	virtual void clear();
+	virtual void startBatch(display::PrimitiveType prim);
+	virtual void endBatch();
+	virtual void vertex(float x, float y);
+	virtual void texCoord(float u, float v)						{ m_cur.u = u; m_cur.v = v; }
+	virtual void setColor(float r, float g, float b, float a)	{ m_cur.r = r; m_cur.g = g; m_cur.b = b; m_cur.a = a; }
+	virtual void enableBlending(bool bEnable);
+	virtual void enableTexture(bool bEnable);
+	virtual void bindTexture(Texture *pTex);
+	virtual void pushState();
+	virtual void popState();
+	virtual void setScissor(const Rect<int> *pRect);
+	virtual void pushTranslation(float x, float y);
+	virtual void popTranslation();
+
+private:
+	void	applyState();
+};
+
+};
+
+#endif
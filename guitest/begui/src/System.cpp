@@ -20,9 +20,12 @@
 */
 
 #include "util.h"
-#include <ctime>
+#include "../../bcore/src/Timer.h"
 
 unsigned long begui::system::current_time()	// returns time in msec
 {
-	return 1000*clock()/CLOCKS_PER_SEC;
+	// wall-clock time (clock() measures the cpu time of the process), from the first call,
+	// so that it takes 49 days of running to wrap around
+	static const double start = Timer::now();
+	return (unsigned long)(1000.0*(Timer::now() - start));
 }
\ No newline at end of file
@@ -59,7 +59,7 @@ void TabContainer::create(int left, int top, int width, int height, const std::s
 	m_bCanCloseTabs = bCanCloseTabs;
 
 	// load the associated style
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("TabContainer").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("TabContainer").style(style_name);
 	ASSERT(style.hasProp("tab_active"));
 	m_tabActiveImg = ResourceManager::inst()->loadImage(style.get_img("tab_active"));
 	ASSERT(style.hasProp("tab_inactive"));
@@ -171,13 +171,13 @@ void TabContainer::frameUpdate()
 
 void TabContainer::frameRender()
 {
-	glEnable(GL_BLEND);
+	display::enableBlending(true);
 
 	Font *pFont = FontManager::getCurFont();
 	int header_h = m_tabActiveArea.getHeight();
 
 	// Render the tab bg
-	glColor4f(1,1,1,1);
+	display::setColor(1,1,1,1);
 	Component::drawImageWtBorders(m_clientAreaImg, getLeft()-m_activeArea.left, 
 		header_h + getTop()-m_activeArea.top, 
 		getWidth()+(m_clientAreaImg.m_width - m_activeArea.right)+m_activeArea.left, 
@@ -197,7 +197,7 @@ void TabContainer::frameRender()
 		m_tabs[i]->m_headerRight = tab_x+tab_w - getLeft();
 
 		if (i == m_curTab) {
-			glColor4f(1,1,1,1);
+			display::setColor(1,1,1,1);
 			Component::drawImageWtBorders(m_tabActiveImg, tab_x, 
 				getTop()-m_tabActiveArea.top, 
 				tab_w, 
@@ -205,17 +205,17 @@ void TabContainer::frameRender()
 				m_tabResizableArea);
 
 			// render the text
-			glColor4f(m_activeTabTextColor.r, m_activeTabTextColor.g, m_activeTabTextColor.b,1);
+			display::setColor(m_activeTabTextColor.r, m_activeTabTextColor.g, m_activeTabTextColor.b,1);
 			Font::renderString(tab_x + m_tabTextPadding, getTop()+header_h-4, m_tabs[i]->m_title);
 
 			// render a small indicator that the tab is open
 			if (m_activeBtmImg.m_texture) {
-				glColor4f(1,1,1,1);
+				display::setColor(1,1,1,1);
 				Component::drawImage(m_activeBtmImg, tab_x + tab_w/2 - m_activeBtmImg.m_width/2, getTop()+header_h);
 			}
 		}
 		else {
-			glColor4f(1,1,1,1);
+			display::setColor(1,1,1,1);
 			Component::drawImageWtBorders(m_tabInactiveImg, tab_x, 
 				getTop()-m_tabActiveArea.top, 
 				tab_w, 
@@ -223,7 +223,7 @@ void TabContainer::frameRender()
 				m_tabResizableArea);
 			
 			// render the text
-			glColor4f(m_inactiveTabTextColor.r, m_inactiveTabTextColor.g, m_inactiveTabTextColor.b,1);
+			display::setColor(m_inactiveTabTextColor.r, m_inactiveTabTextColor.g, m_inactiveTabTextColor.b,1);
 			Font::renderString(tab_x + m_tabTextPadding, getTop()+header_h-4, m_tabs[i]->m_title);
 		}
 
@@ -310,32 +310,32 @@ void TabContainer::onKeyUp(int key)
 	return Container::onKeyUp(key);
 }
 
-void TabContainer::handleTabToFront(Functor1<int> &callback)
+void TabContainer::handleTabToFront(const Functor1<int> &callback)
 {
 	m_onTabToFront = callback;
 }
 
-void TabContainer::handleTabToBack(Functor1<int> &callback)
+void TabContainer::handleTabToBack(const Functor1<int> &callback)
 {
 	m_onTabToBack = callback;
 }
 
-void TabContainer::handleTabCreate(Functor1<int> &callback)
+void TabContainer::handleTabCreate(const Functor1<int> &callback)
 {
 	m_onTabCreate = callback;
 }
 
-void TabContainer::handleTabClose(Functor1<int> &callback)
+void TabContainer::handleTabClose(const Functor1<int> &callback)
 {
 	m_onTabClose = callback;
 }
 
-void TabContainer::handleTabDragStart(Functor1<int> &callback)
+void TabContainer::handleTabDragStart(const Functor1<int> &callback)
 {
 	m_onTabDragStart = callback;
 }
 
-void TabContainer::handleTabDragEnd(Functor1<int> &callback)
+void TabContainer::handleTabDragEnd(const Functor1<int> &callback)
 {
 	m_onTabDragEnd = callback;
 }
\ No newline at end of file
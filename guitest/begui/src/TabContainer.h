@@ -76,12 +76,12 @@ public:
 	virtual void onKeyUp(int key);
 
 	// event hooks:
-	void handleTabToFront(Functor1<int> &callback = Functor1<int>());	// called when a tab is selected and made visible
-	void handleTabToBack(Functor1<int> &callback = Functor1<int>());	// called when the previous active tab is made invisible
-	void handleTabCreate(Functor1<int> &callback = Functor1<int>());
-	void handleTabClose(Functor1<int> &callback = Functor1<int>());
-	void handleTabDragStart(Functor1<int> &callback = Functor1<int>());
-	void handleTabDragEnd(Functor1<int> &callback = Functor1<int>());
+	void handleTabToFront(const Functor1<int> &callback = Functor1<int>());	// called when a tab is selected and made visible
+	void handleTabToBack(const Functor1<int> &callback = Functor1<int>());	// called when the previous active tab is made invisible
+	void handleTabCreate(const Functor1<int> &callback = Functor1<int>());
+	void handleTabClose(const Functor1<int> &callback = Functor1<int>());
+	void handleTabDragStart(const Functor1<int> &callback = Functor1<int>());
+	void handleTabDragEnd(const Functor1<int> &callback = Functor1<int>());
 
 protected:
 	class Tab : public Container
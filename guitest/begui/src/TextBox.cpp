@@ -25,6 +25,46 @@
 
 using namespace begui;
 
+namespace {
+
+// the properties of a textbox style, resolved once for all textboxes of that style
+struct TextBoxStyle : public ResourceManager::StyleBinding {
+	ResourceManager::ImageRef	face;
+	Rect<int>	activeArea, resizableArea, textPadding;
+	Color		textColor;
+	bool		bTextPadding, bTextColor;
+
+	void bind(const ResourceManager::Style &style) {
+		static const ResourceManager::PropId FACE = ResourceManager::propId("face");
+		static const ResourceManager::PropId ACTIVE_AREA = ResourceManager::propId("active_area");
+		static const ResourceManager::PropId RESIZABLE_AREA = ResourceManager::propId("resizable_area");
+		static const ResourceManager::PropId TEXT_PADDING = ResourceManager::propId("text_padding");
+		static const ResourceManager::PropId TEXT_COLOR = ResourceManager::propId("text_color");
+
+		face = ResourceManager::inst()->loadImage(style.get_img(FACE));
+		activeArea = style.get_rect(ACTIVE_AREA);
+		resizableArea = style.get_rect(RESIZABLE_AREA);
+		if (bTextPadding = style.hasProp(TEXT_PADDING))
+			textPadding = style.get_rect(TEXT_PADDING);
+		if (bTextColor = style.hasProp(TEXT_COLOR))
+			textColor = style.get_c(TEXT_COLOR);
+	}
+};
+
+// the focus frame, shared by all components
+struct FrameStyle : public ResourceManager::StyleBinding {
+	ResourceManager::ImageRef	frame;
+	Rect<int>	frameResizableArea, frameOffs;
+
+	void bind(const ResourceManager::Style &style) {
+		frame = ResourceManager::inst()->loadImage(style.get_img("active_frame"));
+		frameResizableArea = style.get_rect("frame_resizable_area");
+		frameOffs = style.get_rect("frame_offs");
+	}
+};
+
+};
+
 TextBox::TextBox() : //m_bEditable(false), m_bMultiline(false),
 	m_bTextSelectable(true),
 	m_textPadding(0,0,0,0),
@@ -41,19 +81,21 @@ void TextBox::create(int x, int y, int width, int height, bool bEditable, bool b
 	m_bottom = y+height;
 
 	// load the textbox stylesheet
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("TextBox").style(style_name);
-	m_bg = ResourceManager::inst()->loadImage(style.get_img("face"));
-	m_activeArea = style.get_rect("active_area");
-	m_resizableArea = style.get_rect("resizable_area");
-	if (style.hasProp("text_padding"))
-		m_textPadding = style.get_rect("text_padding");
-	if (style.hasProp("text_color"))
-		m_textColor = style.get_c("text_color");
-
-	ResourceManager::Style style2 = ResourceManager::inst()->getClassDef("Component").style("std");
-	m_frame = ResourceManager::inst()->loadImage(style2.get_img("active_frame"));
-	m_frameResizableArea = style2.get_rect("frame_resizable_area");
-	m_frameOffs = style2.get_rect("frame_offs");
+	static ResourceManager::BoundStyle<TextBoxStyle> styles("TextBox");
+	const TextBoxStyle &style = styles.get(style_name);
+	m_bg = style.face;
+	m_activeArea = style.activeArea;
+	m_resizableArea = style.resizableArea;
+	if (style.bTextPadding)
+		m_textPadding = style.textPadding;
+	if (style.bTextColor)
+		m_textColor = style.textColor;
+
+	static ResourceManager::BoundStyle<FrameStyle> frameStyles("Component");
+	const FrameStyle &style2 = frameStyles.get("std");
+	m_frame = style2.frame;
+	m_frameResizableArea = style2.frameResizableArea;
+	m_frameOffs = style2.frameOffs;
 
 	// create the text object
 	m_text.create(m_textPadding.left, m_textPadding.top, width-m_textPadding.right, bMultiline, bEditable);
@@ -80,8 +122,8 @@ void TextBox::onRender()
 	int h = getHeight();
 
 	// render the background
-	glEnable(GL_BLEND);
-	glColor4f(1,1,1,1);
+	display::enableBlending(true);
+	display::setColor(1,1,1,1);
 	Component::drawImageWtBorders(m_bg, -m_activeArea.left, -m_activeArea.top, 
 		getWidth()+m_activeArea.left + (m_bg.m_width-m_activeArea.right), 
 		getHeight()+m_activeArea.top + (m_bg.m_height-m_activeArea.bottom), 
@@ -104,9 +146,9 @@ void TextBox::onRender()
 
 	// render the text
 	if (m_text.isEditable())
-		glColor4f(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 0.5f);
+		display::setColor(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 0.5f);
 	else
-		glColor4f(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 0.2f);
+		display::setColor(m_textColor.r*255, m_textColor.g*255, m_textColor.b*255, 0.2f);
 	m_text.renderString();
 
 	// unmask
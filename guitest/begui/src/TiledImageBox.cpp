@@ -0,0 +1,386 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TiledImageBox.h"
+#include "Display.h"
+#include "util.h"
+#include <algorithm>
+
+using namespace begui;
+
+namespace {
+
+// orders tiles by distance from the center of the view, so that the
+// tiles the user is looking at are uploaded first
+struct TileDist {
+	int tx, ty;
+	float dist;
+	bool operator < (const TileDist &t) const	{ return dist < t.dist; }
+};
+
+};
+
+TiledImageBox::TiledImageBox() : m_pImage(0),
+	m_internalFormat(0), m_pixelFormat(0), m_dataType(0),
+	m_maxTiles(256), m_maxUploadsPerFrame(4), m_frame(0),
+	m_zoom(1), m_center(0,0)
+{
+}
+
+TiledImageBox::~TiledImageBox()
+{
+	freeTiles();
+}
+
+void TiledImageBox::create(int x, int y, int width, int height, Image *pImg, size_t tileSize)
+{
+	setPos(x,y);
+	setSize(width, height);
+	setImage(pImg, tileSize);
+}
+
+void TiledImageBox::setImage(Image *pImg, size_t tileSize)
+{
+	freeTiles();
+	m_pyramid.free();
+	m_pImage = 0;
+
+	if (!pImg || pImg->isEmpty())
+		return;
+	if (!Texture::getImageFormat(*pImg, m_internalFormat, m_pixelFormat, m_dataType)) {
+		Console::error("TiledImageBox::setImage(): image format is not supported (%d)\n", pImg->getFormat());
+		return;
+	}
+
+	m_pImage = pImg;
+	m_pyramid.create(*pImg, tileSize);
+	fitToView();
+}
+
+void TiledImageBox::freeTiles()
+{
+	for (TileList::iterator it = m_lru.begin(); it != m_lru.end(); ++it)
+		SAFE_DELETE(it->pTex);
+	m_lru.clear();
+	m_tiles.clear();
+}
+
+void TiledImageBox::setZoom(double zoom)
+{
+	// no closer than 32 screen pixels per image pixel, no further than the whole image in one pixel
+	double minZoom = 1.0;
+	if (m_pImage) {
+		size_t maxDim = (m_pImage->getWidth() > m_pImage->getHeight()) ? m_pImage->getWidth() : m_pImage->getHeight();
+		minZoom = 1.0 / maxDim;
+	}
+	if (zoom < minZoom) zoom = minZoom;
+	if (zoom > 32) zoom = 32;
+	m_zoom = zoom;
+}
+
+void TiledImageBox::zoomAt(double factor, const Vector2i &pt)
+{
+	Vector2 before = localToImage(pt);
+	setZoom(m_zoom*factor);
+	Vector2 after = localToImage(pt);
+	m_center.x += before.x - after.x;
+	m_center.y += before.y - after.y;
+}
+
+void TiledImageBox::fitToView()
+{
+	if (!m_pImage || getWidth() <= 0 || getHeight() <= 0)
+		return;
+	double zx = (double)getWidth() / m_pImage->getWidth();
+	double zy = (double)getHeight() / m_pImage->getHeight();
+	setZoom((zx < zy) ? zx : zy);
+	m_center = Vector2(m_pImage->getWidth()/2.0f, m_pImage->getHeight()/2.0f);
+}
+
+Vector2 TiledImageBox::localToImage(const Vector2i &pt) const
+{
+	return Vector2((float)(m_center.x + (pt.x - getWidth()/2.0)/m_zoom),
+					(float)(m_center.y + (pt.y - getHeight()/2.0)/m_zoom));
+}
+
+Vector2i TiledImageBox::imageToLocal(const Vector2 &pt) const
+{
+	return Vector2i((int)floor((pt.x - m_center.x)*m_zoom + getWidth()/2.0),
+					(int)floor((pt.y - m_center.y)*m_zoom + getHeight()/2.0));
+}
+
+size_t TiledImageBox::getDisplayLevel() const
+{
+	// the coarsest level that still has at least one texel per screen pixel
+	size_t level = 0;
+	double scale = 1.0/m_zoom;
+	while (level+1 < m_pyramid.getLevelsNum() && (double)((size_t)1 << (level+1)) <= scale)
+		++level;
+	return level;
+}
+
+void TiledImageBox::getVisibleTiles(size_t level, int &tx0, int &ty0, int &tx1, int &ty1) const
+{
+	Vector2 tl = localToImage(Vector2i(0,0));
+	Vector2 br = localToImage(Vector2i(getWidth(), getHeight()));
+	double span = (double)(m_pyramid.getTileSize() << level);	// tile size in level 0 pixels
+
+	tx0 = (int)floor(tl.x / span);
+	ty0 = (int)floor(tl.y / span);
+	tx1 = (int)floor(br.x / span);
+	ty1 = (int)floor(br.y / span);
+	if (tx0 < 0) tx0 = 0;
+	if (ty0 < 0) ty0 = 0;
+	if (tx1 >= (int)m_pyramid.getTilesX(level)) tx1 = (int)m_pyramid.getTilesX(level)-1;
+	if (ty1 >= (int)m_pyramid.getTilesY(level)) ty1 = (int)m_pyramid.getTilesY(level)-1;
+}
+
+TiledImageBox::Tile* TiledImageBox::findTile(size_t level, size_t tx, size_t ty)
+{
+	stdext::hash_map<TileKey, TileList::iterator>::iterator it = m_tiles.find(makeKey(level, tx, ty));
+	if (it == m_tiles.end())
+		return 0;
+
+	// move to the front of the LRU list
+	m_lru.splice(m_lru.begin(), m_lru, it->second);
+	return &m_lru.front();
+}
+
+bool TiledImageBox::uploadTile(size_t level, size_t tx, size_t ty)
+{
+	Tile tile;
+	tile.key = makeKey(level, tx, ty);
+	tile.pTex = 0;
+	tile.lastUsedFrame = m_frame;
+
+	size_t tileSize = m_pyramid.getTileSize();
+	if (m_lru.size() >= m_maxTiles)
+	{
+		// evict the least recently used tile, unless it is still needed this frame
+		Tile &lru = m_lru.back();
+		if (lru.lastUsedFrame == m_frame)
+			return false;
+		tile.pTex = lru.pTex;
+		m_tiles.erase(lru.key);
+		m_lru.pop_back();
+	}
+	if (!tile.pTex) {
+		// all tiles share the same size, so the texture can be reused for any tile after eviction
+		tile.pTex = new Texture();
+		tile.pTex->create((int)tileSize, (int)tileSize, m_internalFormat);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+
+	// upload straight from the level image, without copying the tile out of it
+	const Image &img = m_pyramid.getLevel(level);
+	size_t x, y, w, h;
+	m_pyramid.getTileRect(level, tx, ty, x, y, w, h);
+
+	glBindTexture(GL_TEXTURE_2D, tile.pTex->getGLTex());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)img.getWidth());
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, (GLsizei)w, (GLsizei)h, m_pixelFormat, m_dataType, img(x,y));
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	tile.u = (float)w / tileSize;
+	tile.v = (float)h / tileSize;
+
+	m_lru.push_front(tile);
+	m_tiles[tile.key] = m_lru.begin();
+	return true;
+}
+
+size_t TiledImageBox::requestTiles(size_t level, int tx0, int ty0, int tx1, int ty1, size_t budget)
+{
+	if (budget == 0 || tx1 < tx0 || ty1 < ty0)
+		return 0;
+
+	// find the missing tiles, keeping the ones already resident from being evicted
+	float cx = (tx0 + tx1)/2.0f, cy = (ty0 + ty1)/2.0f;
+	std::vector<TileDist> missing;
+	for (int ty=ty0; ty<=ty1; ++ty)
+		for (int tx=tx0; tx<=tx1; ++tx) {
+			Tile *pTile = findTile(level, tx, ty);
+			if (pTile)
+				pTile->lastUsedFrame = m_frame;
+			else {
+				TileDist td = { tx, ty, (tx-cx)*(tx-cx) + (ty-cy)*(ty-cy) };
+				missing.push_back(td);
+			}
+		}
+	std::sort(missing.begin(), missing.end());
+
+	size_t nUploaded = 0;
+	for (size_t i=0; i<missing.size() && nUploaded < budget; ++i) {
+		if (!uploadTile(level, missing[i].tx, missing[i].ty))
+			break;	// cache is full of tiles needed this frame
+		++nUploaded;
+	}
+	return nUploaded;
+}
+
+void TiledImageBox::onUpdate()
+{
+	if (!m_pImage)
+		return;
+
+	++m_frame;
+
+	size_t nLevels = m_pyramid.getLevelsNum();
+	size_t level = getDisplayLevel();
+	size_t budget = m_maxUploadsPerFrame;
+
+	// the coarsest level is a single tile that is always available for fallback
+	size_t n = requestTiles(nLevels-1, 0, 0, 0, 0, 1);
+	budget = (budget > n) ? budget-n : 0;
+
+	// the visible tiles
+	int tx0, ty0, tx1, ty1;
+	getVisibleTiles(level, tx0, ty0, tx1, ty1);
+	budget -= requestTiles(level, tx0, ty0, tx1, ty1, budget);
+
+	// prefetch the ring of neighbours at the same level, for panning
+	int ntx0 = (tx0 > 0) ? tx0-1 : 0;
+	int nty0 = (ty0 > 0) ? ty0-1 : 0;
+	int ntx1 = (tx1+1 < (int)m_pyramid.getTilesX(level)) ? tx1+1 : tx1;
+	int nty1 = (ty1+1 < (int)m_pyramid.getTilesY(level)) ? ty1+1 : ty1;
+	budget -= requestTiles(level, ntx0, nty0, ntx1, nty1, budget);
+
+	// and the visible area one level coarser, for zooming out
+	if (level+1 < nLevels) {
+		getVisibleTiles(level+1, tx0, ty0, tx1, ty1);
+		requestTiles(level+1, tx0, ty0, tx1, ty1, budget);
+	}
+}
+
+void TiledImageBox::drawTile(size_t level, size_t tx, size_t ty)
+{
+	// find the finest resident tile covering this one
+	size_t l = level, x = tx, y = ty;
+	Tile *pTile = findTile(l, x, y);
+	while (!pTile && l+1 < m_pyramid.getLevelsNum()) {
+		++l; x /= 2; y /= 2;
+		pTile = findTile(l, x, y);
+	}
+	if (!pTile)
+		return;
+	pTile->lastUsedFrame = m_frame;
+
+	// part of the resident tile that covers the requested one
+	size_t tileSize = m_pyramid.getTileSize();
+	size_t dl = l - level;
+	float sub = 1.0f / (1 << dl);
+	float u0 = (float)(tx - (x << dl)) * sub;
+	float v0 = (float)(ty - (y << dl)) * sub;
+	float u1 = u0 + sub, v1 = v0 + sub;
+
+	// clip to the edge of the image
+	if (u1 > pTile->u) u1 = pTile->u;
+	if (v1 > pTile->v) v1 = pTile->v;
+	if (u0 >= u1 || v0 >= v1)
+		return;
+
+	// position on screen
+	float span = (float)(tileSize << l);	// resident tile size in level 0 pixels
+	Vector2 tl((float)(x*span + u0*span), (float)(y*span + v0*span));
+	Vector2 br((float)(x*span + u1*span), (float)(y*span + v1*span));
+	float sx0 = (float)((tl.x - m_center.x)*m_zoom + getWidth()/2.0);
+	float sy0 = (float)((tl.y - m_center.y)*m_zoom + getHeight()/2.0);
+	float sx1 = (float)((br.x - m_center.x)*m_zoom + getWidth()/2.0);
+	float sy1 = (float)((br.y - m_center.y)*m_zoom + getHeight()/2.0);
+
+	display::bindTexture(pTile->pTex);
+	display::startBatch(display::QUADS);
+		display::texCoord(u0,v0); display::vertex(sx0, sy0);
+		display::texCoord(u1,v0); display::vertex(sx1, sy0);
+		display::texCoord(u1,v1); display::vertex(sx1, sy1);
+		display::texCoord(u0,v1); display::vertex(sx0, sy1);
+	display::endBatch();
+}
+
+void TiledImageBox::onRender()
+{
+	int w = getWidth();
+	int h = getHeight();
+
+	display::setColor(0,0,0,0.5f);
+	display::startBatch(display::QUADS);
+		display::vertex(0, 0);
+		display::vertex((float)w, 0);
+		display::vertex((float)w, (float)h);
+		display::vertex(0, (float)h);
+	display::endBatch();
+
+	if (m_pImage)
+	{
+		Vector2i wpos = localToWorld(Vector2i(0,0));
+		display::pushMask(wpos.x, wpos.y, w, h);
+
+		size_t level = getDisplayLevel();
+		int tx0, ty0, tx1, ty1;
+		getVisibleTiles(level, tx0, ty0, tx1, ty1);
+
+		display::enableTexture(0, true);
+		display::setColor(1,1,1,1);
+		for (int ty=ty0; ty<=ty1; ++ty)
+			for (int tx=tx0; tx<=tx1; ++tx)
+				drawTile(level, tx, ty);
+		display::bindTexture(0);
+
+		display::popMask();
+	}
+
+	// additional rendering, controlled by the application
+	m_onRender();
+}
+
+bool TiledImageBox::onMouseMove(int x, int y, int prevx, int prevy)
+{
+	// pan
+	if (input::isMouseButtonDown(MOUSE_BUTTON_LEFT) && m_zoom > 0) {
+		m_center.x -= (float)((x - prevx)/m_zoom);
+		m_center.y -= (float)((y - prevy)/m_zoom);
+	}
+
+	return Component::onMouseMove(x,y,prevx,prevy);
+}
+
+void TiledImageBox::onKeyDown(int key)
+{
+	Vector2i mid(getWidth()/2, getHeight()/2);
+	switch (key) {
+		case '+':
+		case '=':		zoomAt(1.25, mid); break;
+		case '-':		zoomAt(0.8, mid); break;
+		case KEY_HOME:	fitToView(); break;
+	}
+}
+
+bool TiledImageBox::isPtInside(int x, int y)
+{
+	if (x<m_left || x>m_right)
+		return false;
+	if (y<m_top || y>m_bottom)
+		return false;
+	return true;
+}
@@ -0,0 +1,118 @@
+/* 
+// Copyright 2008 Alexandros Panagopoulos
+//
+// This software is distributed under the terms of the GNU Lesser General Public Licence
+//
+// This file is part of BeGUI library.
+//
+//    BeGUI is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    BeGUI is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with BeGUI.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TILEDIMAGEBOX_H42631_INCLUDED_
+#define _TILEDIMAGEBOX_H42631_INCLUDED_
+
+#pragma once
+
+#include "common.h"
+#include "Component.h"
+#include "../../bcore/src/ImagePyramid.h"
+#include <hash_map>
+
+namespace begui {
+
+/**
+ * TiledImageBox: displays images too large for a single texture (or for video
+ *		memory). The image is cut in a pyramid of tiles, and only the tiles seen at
+ *		the current zoom and pan are uploaded to the GPU, into a fixed-size cache
+ *		of tile textures with LRU eviction. A limited number of tiles is uploaded
+ *		each frame (visible tiles first, then their neighbours); until a tile is
+ *		resident, the area is drawn from the nearest coarser level that is.
+ *
+ *		Drag with the left mouse button to pan, +/- to zoom, HOME to fit.
+ */
+class TiledImageBox : public Component
+{
+private:
+	typedef uint64_t TileKey;
+
+	struct Tile {
+		TileKey		key;
+		Texture		*pTex;
+		float		u, v;			// texcoords of the bottom right corner (edge tiles are smaller)
+		size_t		lastUsedFrame;
+	};
+	typedef std::list<Tile>	TileList;
+
+	ImagePyramid	m_pyramid;
+	Image			*m_pImage;
+	GLenum			m_internalFormat, m_pixelFormat, m_dataType;
+
+	TileList								m_lru;		// most recently used first
+	stdext::hash_map<TileKey, TileList::iterator>	m_tiles;
+	size_t			m_maxTiles;
+	size_t			m_maxUploadsPerFrame;
+	size_t			m_frame;
+
+	double			m_zoom;			// screen pixels per image pixel
+	Vector2			m_center;		// image point shown at the center of the component
+
+	Functor0		m_onRender;
+
+public:
+	TiledImageBox();
+	virtual ~TiledImageBox();
+
+	virtual void create(int x, int y, int width, int height, Image *pImg, size_t tileSize = 256);
+
+	// the image must outlive the component, or be replaced with setImage(0)
+	virtual void setImage(Image *pImg, size_t tileSize = 256);
+	Image*		 getImage() const				{ return m_pImage; }
+
+	void	setZoom(double zoom);
+	double	getZoom() const						{ return m_zoom; }
+	void	zoomAt(double factor, const Vector2i &pt);	// pt in local coordinates stays fixed
+	void	setCenter(const Vector2 &center)	{ m_center = center; }
+	const Vector2& getCenter() const			{ return m_center; }
+	void	fitToView();
+
+	Vector2	localToImage(const Vector2i &pt) const;
+	Vector2i imageToLocal(const Vector2 &pt) const;
+
+	// tile cache settings
+	void	setMaxResidentTiles(size_t n)		{ m_maxTiles = (n > 1) ? n : 1; }
+	void	setMaxUploadsPerFrame(size_t n)		{ m_maxUploadsPerFrame = n; }
+	size_t	getResidentTilesNum() const			{ return m_lru.size(); }
+	void	freeTiles();
+
+	virtual void handleRender(const Functor0 fun)	{ m_onRender = fun; }
+
+	virtual void onUpdate();
+	virtual void onRender();
+	virtual bool onMouseMove(int x, int y, int prevx, int prevy);
+	virtual void onKeyDown(int key);
+	virtual bool isPtInside(int x, int y);
+
+private:
+	static TileKey makeKey(size_t level, size_t tx, size_t ty)	{ return ((TileKey)level << 56) | ((TileKey)ty << 28) | (TileKey)tx; }
+	size_t	getDisplayLevel() const;
+	void	getVisibleTiles(size_t level, int &tx0, int &ty0, int &tx1, int &ty1) const;
+	Tile*	findTile(size_t level, size_t tx, size_t ty);
+	bool	uploadTile(size_t level, size_t tx, size_t ty);
+	size_t	requestTiles(size_t level, int tx0, int ty0, int tx1, int ty1, size_t budget);
+	void	drawTile(size_t level, size_t tx, size_t ty);
+};
+
+};
+
+#endif
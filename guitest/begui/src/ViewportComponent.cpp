@@ -29,7 +29,7 @@ ViewportComponent::ViewportComponent() : m_bNavigationEnabled(false)
 {
 }
 
-void ViewportComponent::create(int x, int y, int w, int h, const Viewport& vp, Functor0 &render_callback)
+void ViewportComponent::create(int x, int y, int w, int h, const Viewport& vp, const Functor0 &render_callback)
 {
 	setPos(x,y);
 	setSize(w, h);
@@ -46,7 +46,7 @@ private:
 public:
 	ViewportComponent();
 
-	void create(int x, int y, int w, int h, const Viewport& vp, Functor0 &render_callback = Functor0());
+	void create(int x, int y, int w, int h, const Viewport& vp, const Functor0 &render_callback = Functor0());
 	void enableNavigation(bool bEnable)		{ m_bNavigationEnabled = bEnable; }
 
 	Viewport&	getViewport()				{ return m_viewport; }
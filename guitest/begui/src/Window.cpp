@@ -67,7 +67,7 @@ void Window::create(int left, int top, int width, int height, const std::string
 	m_state = VISIBLE;
 
 	// load the window style
-	ResourceManager::Style style = ResourceManager::inst()->getClassDef("Window").style(style_name);
+	const ResourceManager::Style &style = ResourceManager::inst()->getClassDef("Window").style(style_name);
 	ASSERT(style.hasProp("window_bg"));
 	m_windowFace = ResourceManager::inst()->loadImage(style.get_img("window_bg"));
 	ASSERT(style.hasProp("caption"));
@@ -203,10 +203,10 @@ void Window::frameRender()
 
 	int wnd_top = getTop() + border.top + ((m_bHasCaption)? m_captionActiveArea.getHeight() : 0);
 
-	glEnable(GL_BLEND);
+	display::enableBlending(true);
 
 	// render the window caption
-	glColor4f(1,1,1,1);
+	display::setColor(1,1,1,1);
 	if (m_bHasCaption) {
 		Component::drawImageWtBorders(m_captionFace, border.left + getLeft() - m_captionActiveArea.left,
 			border.top + getTop() - m_captionActiveArea.top,
@@ -215,7 +215,7 @@ void Window::frameRender()
 			m_captionResizableArea);
 		
 		// render the caption title
-		glColor4f(m_captionTextColor.r, m_captionTextColor.g, m_captionTextColor.b, 1);
+		display::setColor(m_captionTextColor.r, m_captionTextColor.g, m_captionTextColor.b, 1);
 		FontManager::getCurFont()->renderString(border.left + getLeft() + m_captionTextPadLeft, 
 												border.top + getTop() + m_captionTextYPos, m_title);
 	}
@@ -223,9 +223,9 @@ void Window::frameRender()
 	// render the window main area
 	float alpha = (m_bMoving)?0.5f:1.0f;
 	if (m_style == Window::MULTIPLE)
-		glColor4f(0.5f,0.5f,0.5f,alpha);
+		display::setColor(0.5f,0.5f,0.5f,alpha);
 	else
-		glColor4f(1,1,1,alpha);
+		display::setColor(1,1,1,alpha);
 	if (m_bHasBorders) {
 		Component::drawImageWtBorders(m_windowFace, getLeft()/* - m_windowActiveArea.left*/,
 			wnd_top - m_windowActiveArea.top,
@@ -245,25 +245,23 @@ void Window::frameRender()
 	Container::frameRender();
 
 	// setup the translation
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glTranslatef((float)getLeft(), (float)getTop(), 0.0f);
+	display::pushTranslation((float)getLeft(), (float)getTop());
 
 /*// DEBUG: render the client area frame
-glColor4f(1,0,0,1);
-glBegin(GL_LINES);
-	glVertex2f(m_clientArea.left, m_clientArea.top);
-	glVertex2f(m_clientArea.right, m_clientArea.top);
+display::setColor(1,0,0,1);
+display::startBatch(display::LINES);
+	display::vertex(m_clientArea.left, m_clientArea.top);
+	display::vertex(m_clientArea.right, m_clientArea.top);
 	
-	glVertex2f(m_clientArea.right, m_clientArea.top);
-	glVertex2f(m_clientArea.right, m_clientArea.bottom);
+	display::vertex(m_clientArea.right, m_clientArea.top);
+	display::vertex(m_clientArea.right, m_clientArea.bottom);
 	
-	glVertex2f(m_clientArea.right, m_clientArea.bottom);
-	glVertex2f(m_clientArea.left, m_clientArea.bottom);
+	display::vertex(m_clientArea.right, m_clientArea.bottom);
+	display::vertex(m_clientArea.left, m_clientArea.bottom);
 	
-	glVertex2f(m_clientArea.left, m_clientArea.bottom);
-	glVertex2f(m_clientArea.left, m_clientArea.top);
-glEnd();*/
+	display::vertex(m_clientArea.left, m_clientArea.bottom);
+	display::vertex(m_clientArea.left, m_clientArea.top);
+display::endBatch();*/
 
 	Vector2i wpos = Component::localToWorld(Vector2i(m_clientArea.left, m_clientArea.top));
 	display::pushMask(wpos.x, wpos.y+1, m_clientArea.getWidth(), m_clientArea.getHeight());
@@ -274,8 +272,7 @@ glEnd();*/
 	display::popMask();
 	
 	// Reset the coordinate system
-	glMatrixMode(GL_MODELVIEW);
-	glPopMatrix();
+	display::popTranslation();
 }
 
 void Window::onRender()
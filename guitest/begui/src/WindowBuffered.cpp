@@ -1,13 +1,18 @@
 #include "WindowBuffered.h"
 #include "util.h"
+#include "../../bcore/src/RenderTargetPool.h"
 #include <limits.h>
 
 using namespace begui;
 
-Texture *WindowBuffered::m_pSharedRenderTarget = 0;
-int WindowBuffered::m_SRTRefCount = 0;
-
-WindowBuffered::WindowBuffered() : 
+WindowBuffered::WindowBuffered() : m_pPrivateTarget(0),
+	m_bSharedRenderBuffer(true),
+	m_bFixedContentWhileFX(false),
+	m_bSelectiveUpdate(false),
+	m_fxOnMove(false),
+	m_fxOnResize(false),
+	m_fxOnStateChange(false),
+	m_bEnableClothSimulation(false),
 	m_prevMoveStepTime(0),
 	m_moveSpeed(0,0)
 {
@@ -15,65 +20,88 @@ WindowBuffered::WindowBuffered() :
 
 WindowBuffered::~WindowBuffered()
 {
-	m_renderPass.free();
+	RenderTargetPool::inst()->release(m_pPrivateTarget);
+}
+
+void WindowBuffered::usePrivateRenderBuffer(bool bEnable)
+{
+	m_bSharedRenderBuffer = !bEnable;
 	if (m_bSharedRenderBuffer) {
-		m_SRTRefCount--;
-		if (m_SRTRefCount == 0) {
-			SAFE_DELETE(m_pSharedRenderTarget);
-		}
+		RenderTargetPool::inst()->release(m_pPrivateTarget);
+		m_pPrivateTarget = 0;
 	}
 }
 
+void WindowBuffered::getBufferSize(int &w, int &h) const
+{
+	Rect<int> border = getInactiveBorders();
+	w = getWidth() + border.left + border.right;
+	h = getHeight() + border.top + border.bottom;
+}
+
 void WindowBuffered::frameUpdate()
 {
 	Window::frameUpdate();
 
-	// update the render buffer
-	int rw = display::getWidth();
-	int rh = display::getHeight();
-	if (rw != m_renderPass.getWidth() || rh != m_renderPass.getHeight()) {
-		// setup the render-to-texture pass again
-		if (m_bSharedRenderBuffer)
-		{
-			// if the shared render target texture does not exist, create it
-			if (!m_pSharedRenderTarget) {
-				ASSERT(m_SRTRefCount == 0);
-				m_pSharedRenderTarget = new Texture;
-				m_SRTRefCount = 1;
-			}
-			m_pSharedRenderTarget->create(rw, rh, GL_RGBA8, 0);
-
-			// setup the render pass
-			if (!m_renderPass.setup(RenderPass::PIXEL_RGBA8, rw, rh, m_pSharedRenderTarget)) {
-				Console::error("WindowBuffered: Could not create render pass!\n");
-				return;
-			}
-		}
-		else {
-			if (!m_renderPass.setup(RenderPass::PIXEL_RGBA8, rw, rh)) {
+	// a private buffer is set up again only if the window does not fit in it any more, or
+	// has become much smaller. It is created by the loader thread, so that opening or
+	// resizing the window does not stall the frame.
+	if (!m_bSharedRenderBuffer)
+	{
+		int w, h;
+		getBufferSize(w, h);
+		if (w > 0 && h > 0 && !RenderTargetPool::fits(m_pPrivateTarget, w, h)) {
+			RenderTargetPool::inst()->release(m_pPrivateTarget);
+			m_pPrivateTarget = RenderTargetPool::inst()->acquire(w, h, RenderPass::PIXEL_RGBA8, false, true);
+			if (!m_pPrivateTarget)
 				Console::error("WindowBuffered: Could not create render pass!\n");
-				return;
-			}
 		}
 	}
+}
 
-	// do the rendering HERE (not inside the main rendering loop, because we cannot have nested render passes)!
+void WindowBuffered::frameRender()
+{
+	int w, h;
+	getBufferSize(w, h);
+	if (w <= 0 || h <= 0)
+		return;
+
+	RenderPass *pPass = (m_bSharedRenderBuffer) ? RenderTargetPool::inst()->acquire(w, h) : m_pPrivateTarget;
+	if (pPass && pPass->isReady()) {
+		renderContents(pPass, w, h);
+		drawBuffer(pPass, w, h);
+	}
+	else
+		Window::frameRender();	// until the render buffer is there, the window is rendered directly
+
+	// the next window can render to the same buffer: this one has been drawn already
+	if (m_bSharedRenderBuffer)
+		RenderTargetPool::inst()->release(pPass);
+}
+
+void WindowBuffered::renderContents(RenderPass *pPass, int w, int h)
+{
 	Rect<int> border = getInactiveBorders();
-	m_renderPass.beginPass();
+
+	// render the window in a pass of its own, nested in the current one. Only the w x h
+	// corner of the buffer is used, and the masks of the enclosing pass do not apply to it.
+	pPass->beginPass();
+	glPushAttrib(GL_SCISSOR_BIT);
+	glDisable(GL_SCISSOR_TEST);
+	glViewport(0,0,w,h);
 	
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glMatrixMode(GL_PROJECTION);
 	glPushMatrix();
 	glLoadIdentity();
-	glOrtho(0, rw, rh, 0, 0.0, 1.0);
-	glViewport(0,0,rw,rh);
+	glOrtho(0, w, h, 0, 0.0, 1.0);
 	
 	glMatrixMode(GL_MODELVIEW);
 	glPushMatrix();
 	glLoadIdentity();
 	glTranslatef(-(float)getLeft(), -(float)getTop(), 0);
 
-	display::pushRefFrame(getLeft()+border.left, getTop()+border.top, rw, rh);
+	display::pushRefFrame(getLeft()+border.left, getTop()+border.top, w, h);
 	
 	Window::frameRender();
 
@@ -82,31 +110,25 @@ void WindowBuffered::frameUpdate()
 	glPopMatrix();
 	glMatrixMode(GL_PROJECTION);
 	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
 
-	m_renderPass.endPass();
+	glPopAttrib();
+	pPass->endPass();
 }
 
-void WindowBuffered::frameRender()
+void WindowBuffered::drawBuffer(RenderPass *pPass, int w, int h)
 {
-	Rect<int> border = getInactiveBorders();
-
-	// display the render target
+	// display the render target. The top of the window is the top row of the used area.
 	glColor4f(1,1,1,1);
-	m_renderPass.getFrameData()->set();
-	int ww = getWidth() + border.left + border.right;
-	int hh = getHeight() + border.top + border.bottom;
-	float rh = (float)m_renderPass.getFrameData()->getHeight();
-	float rw = (float)m_renderPass.getFrameData()->getWidth();
-	float tx = 0;
-	float ty = 0;
-	float tw = (float)ww/rw;
-	float th = (float)hh/rh;
+	pPass->getFrameData()->set();
+	float tw = (float)w/pPass->getWidth();
+	float th = (float)h/pPass->getHeight();
 	float dx = -m_moveSpeed.x*50;
 	glBegin(GL_QUADS);
-		glTexCoord2f(tx,rh-ty);	glVertex2f((float)getLeft(), (float)getTop());
-		glTexCoord2f(tx+tw,rh-ty);	glVertex2f((float)getLeft()+ww, (float)getTop());
-		glTexCoord2f(tx+tw,rh-th-ty);	glVertex2f((float)getLeft()+ww+dx, (float)getTop()+hh);
-		glTexCoord2f(tx,rh-th-ty);	glVertex2f((float)getLeft()+dx, (float)getTop()+hh);
+		glTexCoord2f(0,th);		glVertex2f((float)getLeft(), (float)getTop());
+		glTexCoord2f(tw,th);	glVertex2f((float)getLeft()+w, (float)getTop());
+		glTexCoord2f(tw,0);		glVertex2f((float)getLeft()+w+dx, (float)getTop()+h);
+		glTexCoord2f(0,0);		glVertex2f((float)getLeft()+dx, (float)getTop()+h);
 	glEnd();
 }
 
@@ -35,6 +35,12 @@ namespace begui {
  *		window and contents, as well as the ability not to re-render the contents of
  *		a window unless they have changed.
  *
+ *		The render buffers come from the RenderTargetPool, sized to the window (with
+ *		its borders) rather than to the display. By default a window renders its
+ *		contents when it is rendered itself, in a pass nested in the current one, to
+ *		a buffer that it returns to the pool right after drawing it: windows of similar
+ *		size share the same buffer. With usePrivateRenderBuffer, a window keeps its
+ *		buffer, which is set up again only when the window outgrows it.
  */
 class WindowBuffered : public Window
 {
@@ -55,9 +61,7 @@ protected:
 	virtual void onUserMove(int dx, int dy);
 
 private:
-	RenderPass m_renderPass;
-	static Texture *m_pSharedRenderTarget;
-	static int		m_SRTRefCount;	// ref counter for the shared render target pointer
+	RenderPass	*m_pPrivateTarget;	// from the RenderTargetPool, if the render buffer is not shared
 	bool	m_bSharedRenderBuffer;	// the render buffer where the contents of this window are rendered to is shared
 									// between multiple buffered window instances.
 
@@ -75,6 +79,10 @@ private:
 
 	unsigned long	m_prevMoveStepTime;
 	Vector2			m_moveSpeed;
+
+	void	getBufferSize(int &w, int &h) const;	// the window, with its borders
+	void	renderContents(RenderPass *pPass, int w, int h);
+	void	drawBuffer(RenderPass *pPass, int w, int h);
 };
 
 };
@@ -22,7 +22,9 @@
 #include "WindowResourceManager.h"
 #include "../../b3d_lib/src/BaseTextFile.h"
 #include "../../b3d_lib/src/Image.h"
+#ifdef _WIN32
 #include <direct.h>
+#endif
 
 #pragma warning (disable : 4996)
 
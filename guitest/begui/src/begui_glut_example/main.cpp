@@ -19,9 +19,43 @@ float lightdiffuse[] = {1,1,1,1};
 float lightspecular[] = {0.5f,0.5f,0.5f,1};
 float lightambient[] = {0.1f,0.1f,0.1f,1};
 
+float angle = 0;
+bool bSpin = true;		// the teapot keeps turning: frames are rendered continuously
+bool bFrameTimerPending = false;
+
+void onFrameTimer(int)
+{
+	bFrameTimerPending = false;
+	glutPostRedisplay();
+}
+
+// Frames are rendered only when needed: after input, and while something moves,
+// paced to the target frame rate of the FrameScheduler (instead of rendering from
+// the idle callback, which keeps a core busy)
+void scheduleFrame()
+{
+	double wait = FrameScheduler::inst()->getWaitTime();
+	if (wait >= 0 && !bFrameTimerPending) {
+		bFrameTimerPending = true;
+		glutTimerFunc((unsigned int)(1000*wait), onFrameTimer, 0);
+	}
+}
+
+void requestFrame()
+{
+	FrameScheduler::inst()->requestFrame();
+	scheduleFrame();
+}
+
 void renderScene(void)
 {
-	static float angle = 0;
+	FrameScheduler *pScheduler = FrameScheduler::inst();
+	pScheduler->beginFrame();
+
+	// the teapot turns by a degree per fixed step, whatever the frame rate
+	if (bSpin)
+		angle += pScheduler->getStepsNum();
+	bool bAnimating = Updater::inst()->update_all_current_time();
 
 	glClearColor(0.1f, 0.3f, 0.4f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -88,8 +122,10 @@ void renderScene(void)
 	mainContainer.frameRender();
 	
 	glutSwapBuffers();
-	
-	angle++;
+
+	pScheduler->setAnimating(bAnimating || bSpin);
+	pScheduler->endFrame();
+	scheduleFrame();
 }
 
 void changeSize(int w, int h) {
@@ -97,6 +133,7 @@ void changeSize(int w, int h) {
 	width = w;
 	height = h;
 	mainContainer.setSize(w,h);
+	requestFrame();
 }
 
 int prevx = 0, prevy = 0;
@@ -113,6 +150,7 @@ void processMouse(int button, int state, int x, int y)
 		input::mouseButtonUp(x, y, MOUSE_BUTTON_LEFT);
 		mainContainer.onMouseUp(x, y, MOUSE_BUTTON_LEFT);
 	}
+	requestFrame();
 }
 
 void processMouseActiveMotion(int x, int y)
@@ -121,6 +159,7 @@ void processMouseActiveMotion(int x, int y)
 	mainContainer.onMouseMove(x, y, prevx, prevy);
 	prevx = x;
 	prevy = y;
+	requestFrame();
 }
 
 void processMousePassiveMotion(int x, int y)
@@ -129,6 +168,7 @@ void processMousePassiveMotion(int x, int y)
 	mainContainer.onMouseMove(x, y, prevx, prevy);
 	prevx = x;
 	prevy = y;
+	requestFrame();
 }
 
 void onButtonClick(int id)
@@ -172,9 +212,9 @@ void initBeGUI()
 
 	// Initialize font subsystem
 	if (!FontManager::initialize())
-		throw std::exception("failed to initialize font subsystem");
+		throw std::runtime_error("failed to initialize font subsystem");
 	if (!FontManager::setFont(strcat(win_dir, "\\Fonts\\tahoma.ttf"), 11))
-		throw std::exception("failed to set default font");
+		throw std::runtime_error("failed to set default font");
 	
 	// Initialize the window manager and load resources
 	ResourceManager::inst()->setResourceDir("..\\resources\\");
@@ -197,9 +237,8 @@ int main(int argc, char *argv[])
 	glutInitWindowSize(800,600);
 	glutCreateWindow("beGUI GLUT Example");
 
-	// set the display function
+	// set the display function. Frames are scheduled with timers, not on idle
 	glutDisplayFunc(renderScene);
-	glutIdleFunc(renderScene);
 
 	// resize function
 	glutReshapeFunc(changeSize);
@@ -238,7 +277,9 @@ int main(int argc, char *argv[])
 	myDlgBtn1.create(30, 30, "Close Dialog", 10001, makeFunctor((Functor1<int>*)0, &onCloseDlg));
 	myModalDlg.addComponent(&myDlgBtn1);
 
-	// start the main loop
+	// render frames in idle mode, at up to 60 fps, and start the main loop
+	FrameScheduler::inst()->setIdleMode(true);
+	FrameScheduler::inst()->setTargetFPS(60);
 	glutMainLoop();
 
 	return 0;
@@ -26,17 +26,21 @@
 Updater* Updater::m_inst = 0;
 
 
-void Updater::update_all(double time)
+bool Updater::update_all(double time)
 {
+	bool bAnimating = false;
 	std::list< Updateable* >::iterator it;
 	for (it=m_vars.begin(); it!=m_vars.end(); ++it) {
 		(*it)->update(time);
+		if ((*it)->isAnimating())
+			bAnimating = true;
 	}
+	return bAnimating;
 }
 
-void Updater::update_all_current_time()
+bool Updater::update_all_current_time()
 {
-	update_all(begui::system::current_time() / 1000.0);
+	return update_all(Timer::now());
 }
 
 void Updater::register_var(Updateable *variable)
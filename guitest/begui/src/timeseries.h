@@ -26,11 +26,12 @@
 
 #include <vector>
 #include <list>
-#include <ctime>
+#include "../../bcore/src/Timer.h"
 
 class Updateable {
 public:
 	virtual void update(double time) = 0;
+	virtual bool isAnimating() const	{ return false; }	// still changing, as of the last update
 };
 
 class Updater {
@@ -40,8 +41,8 @@ class Updater {
 public:
 	inline static Updater* inst()	{ if (!m_inst) m_inst = new Updater(); return m_inst; }
 
-	void update_all(double time);	// updates all timeseries variables in the application
-	void update_all_current_time();		// updates all timeseries using the current time in seconds
+	bool update_all(double time);	// updates all timeseries variables in the application. Returns true if any is still animating
+	bool update_all_current_time();		// updates all timeseries using the current time in seconds
 	void register_var(Updateable *variable);
 	void unregister_var(Updateable *variable);
 };
@@ -63,6 +64,7 @@ private:
 	bool				m_bLoop;
 	T					m_curValue;
 	double				m_timeOffset;
+	bool				m_bAnimating;
 
 	static std::list< TimeSeries<T>* > m_vars;
 
@@ -88,6 +90,8 @@ public:
 	operator T ();	// cast operator
 	operator T () const;
 
+	virtual bool isAnimating() const	{ return m_bAnimating; }
+
 private:
 	virtual void update(double time);
 };
@@ -95,13 +99,13 @@ private:
 /////////////////////////////////////////////////////////////////////
 
 template <class T>
-TimeSeries<T>::TimeSeries() : m_interpolation(CLOSEST), m_bLoop(false), m_timeOffset(0)
+TimeSeries<T>::TimeSeries() : m_interpolation(CLOSEST), m_bLoop(false), m_timeOffset(0), m_bAnimating(false)
 {
 	Updater::inst()->register_var(this);
 }
 
 template <class T>
-TimeSeries<T>::TimeSeries(const T &value) : m_interpolation(CLOSEST), m_bLoop(false), m_timeOffset(0) {
+TimeSeries<T>::TimeSeries(const T &value) : m_interpolation(CLOSEST), m_bLoop(false), m_timeOffset(0), m_bAnimating(false) {
 	m_values.push_back(value);
 	m_timestamps.push_back(0);
 	m_curValue = value;
@@ -114,7 +118,8 @@ TimeSeries<T>::TimeSeries(const TimeSeries<T> &ts) : m_interpolation(ts.m_interp
 	m_timestamps(ts.m_timestamps),
 	m_bLoop(ts.m_bLoop),
 	m_curValue(ts.m_curValue),
-	m_timeOffset(ts.m_timeOffset)
+	m_timeOffset(ts.m_timeOffset),
+	m_bAnimating(ts.m_bAnimating)
 {
 	Updater::inst()->register_var(this);
 }
@@ -129,6 +134,7 @@ void TimeSeries<T>::clear() {
 	m_values.clear();
 	m_timestamps.clear();
 	m_timeOffset = 0;
+	m_bAnimating = false;
 }
 
 template <class T>
@@ -139,6 +145,7 @@ TimeSeries<T>& TimeSeries<T>::operator = (const TimeSeries<T> &ts) {
 	m_bLoop = ts.m_bLoop;
 	m_curValue = ts.m_curValue;
 	m_timeOffset = ts.m_timeOffset;
+	m_bAnimating = ts.m_bAnimating;
 	return *this;
 }
 
@@ -173,12 +180,16 @@ void TimeSeries<T>::push_back(const T &value, double time)
 template <class T>
 void TimeSeries<T>::update(double time)
 {
+	m_bAnimating = false;
 	if (m_timestamps.empty())
 		return;
 
 	// use m_timeOffset (in secs) as the starting time of the animation
 	time -= m_timeOffset;
 
+	// a looping animation never ends, others until the last key (or the start, if delayed)
+	m_bAnimating = (m_timestamps.size() > 1 && (m_bLoop || time < m_timestamps.back()));
+
 	// take care of looping animation
 	if (m_bLoop) {
 		double dt = m_timestamps.back() - m_timestamps.front();
@@ -221,7 +232,8 @@ void TimeSeries<T>::update(double time)
 template <class T>
 void TimeSeries<T>::start(double delay)
 {
-	m_timeOffset = (double)(1000*clock()/CLOCKS_PER_SEC / 1000.0);
+	m_timeOffset = Timer::now() + delay;
+	m_bAnimating = true;	// until the next update tells
 }
 
 template <class T>